@@ -0,0 +1,53 @@
+#include "audio_frame_pool.h"
+
+namespace TrunkSDR {
+
+void PCMFrameDeleter::operator()(PCMFrame* frame) const {
+    if (frame) {
+        AudioFramePool::instance().release(frame);
+    }
+}
+
+PooledPCM AudioFramePool::acquire() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (free_.empty()) {
+        // Pool exhausted: grow by one block
+        storage_.push_back(std::make_unique<PCMFrame>());
+        free_.reserve(storage_.capacity());
+        return PooledPCM(storage_.back().get());
+    }
+
+    PCMFrame* frame = free_.back();
+    free_.pop_back();
+    return PooledPCM(frame);
+}
+
+void AudioFramePool::reserve(size_t frames) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    size_t target = storage_.size() + frames;
+    storage_.reserve(target);
+    free_.reserve(target);
+    while (storage_.size() < target) {
+        storage_.push_back(std::make_unique<PCMFrame>());
+        free_.push_back(storage_.back().get());
+    }
+}
+
+void AudioFramePool::release(PCMFrame* frame) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_.push_back(frame);
+}
+
+size_t AudioFramePool::getAllocatedFrames() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return storage_.size();
+}
+
+size_t AudioFramePool::getFreeFrames() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return free_.size();
+}
+
+} // namespace TrunkSDR
@@ -0,0 +1,48 @@
+#ifndef AUDIO_FRAME_POOL_H
+#define AUDIO_FRAME_POOL_H
+
+#include "../utils/types.h"
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace TrunkSDR {
+
+// Process-wide pool of fixed 20 ms PCM blocks.
+//
+// Codec workers acquire a block, synthesize into it and move it through
+// CallManager into the AudioOutput queue; it returns to the pool when the
+// playback thread drops it. Blocks are only allocated when the pool runs
+// dry, so steady-state audio does no heap allocation.
+class AudioFramePool {
+public:
+    static AudioFramePool& instance() {
+        static AudioFramePool instance;
+        return instance;
+    }
+
+    PooledPCM acquire();
+
+    // Pre-allocate additional blocks ahead of the first call
+    void reserve(size_t frames);
+
+    size_t getAllocatedFrames() const;
+    size_t getFreeFrames() const;
+
+private:
+    AudioFramePool() = default;
+    AudioFramePool(const AudioFramePool&) = delete;
+    AudioFramePool& operator=(const AudioFramePool&) = delete;
+
+    void release(PCMFrame* frame);
+
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<PCMFrame>> storage_;
+    std::vector<PCMFrame*> free_;
+
+    friend struct PCMFrameDeleter;
+};
+
+} // namespace TrunkSDR
+
+#endif // AUDIO_FRAME_POOL_H
@@ -1,5 +1,7 @@
 #include "audio_output.h"
+#include "audio_frame_pool.h"
 #include "../utils/logger.h"
+#include <algorithm>
 #include <cstring>
 
 namespace TrunkSDR {
@@ -9,7 +11,10 @@ AudioOutput::AudioOutput()
     , running_(false)
     , playing_(false)
     , sample_rate_(AUDIO_SAMPLE_RATE)
-    , volume_(1.0f) {
+    , volume_(1.0f)
+    , queue_head_(0)
+    , queue_count_(0)
+    , frames_dropped_(0) {
 }
 
 AudioOutput::~AudioOutput() {
@@ -24,6 +29,9 @@ AudioOutput::~AudioOutput() {
 bool AudioOutput::initialize(const std::string& device_name, uint32_t sample_rate) {
     sample_rate_ = sample_rate;
 
+    // Blocks for a full playback queue, so queued audio never allocates
+    AudioFramePool::instance().reserve(AUDIO_QUEUE_FRAMES);
+
     // PulseAudio sample spec
     pa_sample_spec ss;
     ss.format = PA_SAMPLE_S16LE;  // 16-bit signed little-endian
@@ -79,32 +87,54 @@ bool AudioOutput::stop() {
     return true;
 }
 
-void AudioOutput::playAudio(const AudioBuffer& buffer) {
-    if (!pa_stream_ || buffer.empty()) {
+void AudioOutput::playAudio(const AudioSample* samples, size_t count) {
+    if (!pa_stream_ || !samples || count == 0) {
         return;
     }
 
-    // Apply volume
-    temp_buffer_ = buffer;
-    for (auto& sample : temp_buffer_) {
-        sample = static_cast<AudioSample>(sample * volume_);
-    }
-
-    // Write to PulseAudio
+    // Write in PCMFrame-sized chunks so volume scaling never allocates
     int error;
-    if (pa_simple_write(pa_stream_,
-                       temp_buffer_.data(),
-                       temp_buffer_.size() * sizeof(AudioSample),
-                       &error) < 0) {
-        LOG_ERROR("PulseAudio write failed:", pa_strerror(error));
+    while (count > 0) {
+        size_t chunk = std::min(count, temp_buffer_.size());
+
+        // Apply volume
+        for (size_t i = 0; i < chunk; i++) {
+            temp_buffer_[i] = static_cast<AudioSample>(samples[i] * volume_);
+        }
+
+        // Write to PulseAudio
+        if (pa_simple_write(pa_stream_,
+                           temp_buffer_.data(),
+                           chunk * sizeof(AudioSample),
+                           &error) < 0) {
+            LOG_ERROR("PulseAudio write failed:", pa_strerror(error));
+            break;
+        }
+
+        samples += chunk;
+        count -= chunk;
     }
 
     playing_ = true;
 }
 
-void AudioOutput::queueAudio(const AudioFrame& frame) {
+void AudioOutput::queueAudio(AudioFrame&& frame) {
     std::lock_guard<std::mutex> lock(queue_mutex_);
-    audio_queue_.push(frame);
+
+    if (queue_count_ == AUDIO_QUEUE_FRAMES) {
+        // Playback is behind; drop the oldest frame (returns it to the pool)
+        audio_queue_[queue_head_].samples.reset();
+        queue_head_ = (queue_head_ + 1) % AUDIO_QUEUE_FRAMES;
+        queue_count_--;
+
+        if (frames_dropped_++ % 50 == 0) {
+            LOG_WARNING("Audio queue full, dropped", frames_dropped_, "frames");
+        }
+    }
+
+    size_t tail = (queue_head_ + queue_count_) % AUDIO_QUEUE_FRAMES;
+    audio_queue_[tail] = std::move(frame);
+    queue_count_++;
 }
 
 void AudioOutput::playbackThread() {
@@ -119,22 +149,31 @@ void AudioOutput::playbackThread() {
 }
 
 void AudioOutput::processQueue() {
-    std::lock_guard<std::mutex> lock(queue_mutex_);
+    AudioFrame frame;
 
-    if (audio_queue_.empty()) {
-        playing_ = false;
-        return;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+
+        if (queue_count_ == 0) {
+            playing_ = false;
+            return;
+        }
+
+        // Take ownership of the next frame; play it outside the lock
+        frame = std::move(audio_queue_[queue_head_]);
+        queue_head_ = (queue_head_ + 1) % AUDIO_QUEUE_FRAMES;
+        queue_count_--;
     }
 
-    // Get next frame
-    AudioFrame frame = audio_queue_.front();
-    audio_queue_.pop();
+    if (!frame.samples) {
+        return;
+    }
 
     // Play it
-    playAudio(frame.samples);
+    playAudio(frame.samples->data(), frame.samples->size());
 
     LOG_DEBUG("Playing audio: TG =", frame.talkgroup,
-              "samples =", frame.samples.size());
+              "samples =", frame.samples->size());
 }
 
 void AudioOutput::setVolume(float volume) {
@@ -4,8 +4,8 @@
 #include "../utils/types.h"
 #include <pulse/simple.h>
 #include <pulse/error.h>
+#include <array>
 #include <atomic>
-#include <queue>
 #include <mutex>
 #include <thread>
 
@@ -21,8 +21,8 @@ public:
     bool start();
     bool stop();
 
-    void playAudio(const AudioBuffer& buffer);
-    void queueAudio(const AudioFrame& frame);
+    void playAudio(const AudioSample* samples, size_t count);
+    void queueAudio(AudioFrame&& frame);
 
     bool isPlaying() const { return playing_; }
 
@@ -40,11 +40,16 @@ private:
     uint32_t sample_rate_;
     float volume_;
 
-    std::queue<AudioFrame> audio_queue_;
+    // Fixed ring of pending frames; the oldest frame is dropped when full
+    static constexpr size_t AUDIO_QUEUE_FRAMES = 64;  // 1.28 s at 20 ms/frame
+    std::array<AudioFrame, AUDIO_QUEUE_FRAMES> audio_queue_;
+    size_t queue_head_;
+    size_t queue_count_;
+    uint64_t frames_dropped_;
     std::mutex queue_mutex_;
     std::thread playback_thread_;
 
-    AudioBuffer temp_buffer_;
+    PCMFrame temp_buffer_;
 };
 
 } // namespace TrunkSDR
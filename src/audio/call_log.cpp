@@ -0,0 +1,412 @@
+#include "call_log.h"
+#include "../utils/logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace TrunkSDR {
+
+namespace {
+
+constexpr size_t CHUNK_HEADER_BYTES = 64;
+constexpr size_t COLUMN_ALIGN = 64;
+constexpr size_t PAGE_BYTES = 4096;
+
+size_t alignUp(size_t value, size_t align) {
+    return (value + align - 1) / align * align;
+}
+
+CallLogColumns makeLayout() {
+    CallLogColumns columns;
+    size_t offset = CHUNK_HEADER_BYTES;
+    auto column = [&offset](size_t width) {
+        size_t start = offset;
+        offset = alignUp(offset + width * CALL_LOG_CHUNK_RECORDS, COLUMN_ALIGN);
+        return start;
+    };
+    columns.start_ms = column(sizeof(uint64_t));
+    columns.duration_ms = column(sizeof(uint32_t));
+    columns.talkgroup = column(sizeof(TalkgroupID));
+    columns.source = column(sizeof(RadioID));
+    columns.frequency = column(sizeof(uint32_t));
+    columns.site = column(sizeof(uint16_t));
+    columns.flags = column(sizeof(uint8_t));
+    columns.rssi = column(sizeof(int8_t));
+    columns.chunk_bytes = alignUp(offset, PAGE_BYTES);
+    return columns;
+}
+
+bool writeAt(int fd, const void* data, size_t bytes, off_t offset) {
+    const uint8_t* cursor = static_cast<const uint8_t*>(data);
+    while (bytes > 0) {
+        ssize_t written = pwrite(fd, cursor, bytes, offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        cursor += written;
+        bytes -= written;
+        offset += written;
+    }
+    return true;
+}
+
+bool readAt(int fd, void* data, size_t bytes, off_t offset) {
+    return pread(fd, data, bytes, offset) == static_cast<ssize_t>(bytes);
+}
+
+off_t chunkOffset(uint64_t chunk) {
+    return CALL_LOG_HEADER_BYTES + chunk * CallLogColumns::layout().chunk_bytes;
+}
+
+} // anonymous namespace
+
+const CallLogColumns& CallLogColumns::layout() {
+    static const CallLogColumns columns = makeLayout();
+    return columns;
+}
+
+CallLogWriter::CallLogWriter()
+    : fd_(-1)
+    , chunk_(0)
+    , chunk_header_()
+    , running_(false)
+    , records_(0) {
+}
+
+CallLogWriter::~CallLogWriter() {
+    close();
+}
+
+bool CallLogWriter::open(const std::string& path) {
+    close();
+
+    const CallLogColumns& columns = CallLogColumns::layout();
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        LOG_ERROR("Failed to open call log", path, ":", std::strerror(errno));
+        return false;
+    }
+    path_ = path;
+
+    struct stat info;
+    if (fstat(fd_, &info) != 0) {
+        LOG_ERROR("Failed to stat call log", path, ":", std::strerror(errno));
+        close();
+        return false;
+    }
+
+    if (info.st_size == 0) {
+        std::vector<uint8_t> header_page(CALL_LOG_HEADER_BYTES, 0);
+        CallLogHeader header;
+        header.magic = CALL_LOG_MAGIC;
+        header.version = CALL_LOG_VERSION;
+        header.chunk_records = CALL_LOG_CHUNK_RECORDS;
+        header.chunk_bytes = static_cast<uint32_t>(columns.chunk_bytes);
+        header.created_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        std::memcpy(header_page.data(), &header, sizeof(header));
+
+        chunk_ = 0;
+        if (!writeAt(fd_, header_page.data(), header_page.size(), 0) ||
+            ftruncate(fd_, chunkOffset(1)) != 0) {
+            LOG_ERROR("Failed to create call log", path, ":", std::strerror(errno));
+            close();
+            return false;
+        }
+        chunk_header_ = CallLogChunkHeader();
+    } else {
+        CallLogHeader header;
+        if (!readAt(fd_, &header, sizeof(header), 0) || header.magic != CALL_LOG_MAGIC ||
+            header.version != CALL_LOG_VERSION || header.chunk_records != CALL_LOG_CHUNK_RECORDS ||
+            header.chunk_bytes != columns.chunk_bytes) {
+            LOG_ERROR("Not a call log of this version:", path);
+            close();
+            return false;
+        }
+
+        // A chunk allocation cut short is completed
+        uint64_t chunks = (static_cast<uint64_t>(info.st_size) - CALL_LOG_HEADER_BYTES +
+                           columns.chunk_bytes - 1) / columns.chunk_bytes;
+        chunks = std::max<uint64_t>(chunks, 1);
+        chunk_ = chunks - 1;
+        if (ftruncate(fd_, chunkOffset(chunks)) != 0 ||
+            !readAt(fd_, &chunk_header_, sizeof(chunk_header_), chunkOffset(chunk_))) {
+            LOG_ERROR("Failed to read call log", path, ":", std::strerror(errno));
+            close();
+            return false;
+        }
+        records_ = chunk_ * CALL_LOG_CHUNK_RECORDS + chunk_header_.count;
+    }
+
+    running_ = true;
+    writer_ = std::thread(&CallLogWriter::writerThread, this);
+
+    LOG_INFO("Call log:", path, "(", records_.load(), "calls )");
+    return true;
+}
+
+void CallLogWriter::close() {
+    if (writer_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_ = false;
+        }
+        wake_.notify_all();
+        writer_.join();
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+void CallLogWriter::append(const CallRecord& record) {
+    bool full;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        queue_.push_back(record);
+        full = queue_.size() >= BATCH_RECORDS;
+    }
+    if (full) {
+        wake_.notify_one();
+    }
+}
+
+void CallLogWriter::writerThread() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        wake_.wait_for(lock, FLUSH_INTERVAL, [this]() {
+            return queue_.size() >= BATCH_RECORDS || !running_;
+        });
+        bool stopping = !running_;
+
+        batch_.clear();
+        batch_.swap(queue_);
+        if (!batch_.empty()) {
+            lock.unlock();
+            if (!writeBatch(batch_)) {
+                LOG_ERROR("Failed to write call log", path_, ":", std::strerror(errno));
+            }
+            lock.lock();
+        }
+        if (stopping) {
+            break;
+        }
+    }
+}
+
+bool CallLogWriter::startChunk() {
+    chunk_++;
+    chunk_header_ = CallLogChunkHeader();
+    return ftruncate(fd_, chunkOffset(chunk_ + 1)) == 0;
+}
+
+bool CallLogWriter::writeBatch(const std::vector<CallRecord>& batch) {
+    const CallLogColumns& columns = CallLogColumns::layout();
+
+    size_t done = 0;
+    while (done < batch.size()) {
+        if (chunk_header_.count == CALL_LOG_CHUNK_RECORDS && !startChunk()) {
+            return false;
+        }
+
+        size_t first = chunk_header_.count;
+        size_t run = std::min<size_t>(batch.size() - done, CALL_LOG_CHUNK_RECORDS - first);
+        off_t base = chunkOffset(chunk_);
+
+        // One write per column for the whole run
+        auto put = [&](size_t column, size_t width, auto field) -> bool {
+            column_.resize(run * width);
+            for (size_t i = 0; i < run; i++) {
+                auto value = field(batch[done + i]);
+                std::memcpy(&column_[i * width], &value, width);
+            }
+            return writeAt(fd_, column_.data(), column_.size(), base + column + first * width);
+        };
+        bool ok =
+            put(columns.start_ms, sizeof(uint64_t), [](const CallRecord& r) { return r.start_ms; }) &&
+            put(columns.duration_ms, sizeof(uint32_t), [](const CallRecord& r) { return r.duration_ms; }) &&
+            put(columns.talkgroup, sizeof(TalkgroupID), [](const CallRecord& r) { return r.talkgroup; }) &&
+            put(columns.source, sizeof(RadioID), [](const CallRecord& r) { return r.source; }) &&
+            put(columns.frequency, sizeof(uint32_t), [](const CallRecord& r) { return r.frequency; }) &&
+            put(columns.site, sizeof(uint16_t), [](const CallRecord& r) { return r.site; }) &&
+            put(columns.flags, sizeof(uint8_t), [](const CallRecord& r) { return r.flags; }) &&
+            put(columns.rssi, sizeof(int8_t), [](const CallRecord& r) { return r.rssi; });
+        if (!ok) {
+            return false;
+        }
+
+        // Publish the run: the count goes up only once its columns are written
+        for (size_t i = 0; i < run; i++) {
+            uint64_t start = batch[done + i].start_ms;
+            if (chunk_header_.count + i == 0) {
+                chunk_header_.min_start_ms = start;
+                chunk_header_.max_start_ms = start;
+            }
+            chunk_header_.min_start_ms = std::min(chunk_header_.min_start_ms, start);
+            chunk_header_.max_start_ms = std::max(chunk_header_.max_start_ms, start);
+        }
+        chunk_header_.count += static_cast<uint32_t>(run);
+        if (!writeAt(fd_, &chunk_header_, sizeof(chunk_header_), base)) {
+            return false;
+        }
+
+        records_ += run;
+        done += run;
+    }
+    return true;
+}
+
+CallLogReader::CallLogReader()
+    : mapping_(nullptr)
+    , mapping_bytes_(0)
+    , chunks_(0) {
+}
+
+CallLogReader::~CallLogReader() {
+    close();
+}
+
+bool CallLogReader::open(const std::string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOG_ERROR("Failed to open call log", path, ":", std::strerror(errno));
+        return false;
+    }
+
+    struct stat info;
+    const CallLogColumns& columns = CallLogColumns::layout();
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < CALL_LOG_HEADER_BYTES) {
+        LOG_ERROR("Not a call log:", path);
+        ::close(fd);
+        return false;
+    }
+
+    mapping_bytes_ = info.st_size;
+    void* mapping = mmap(nullptr, mapping_bytes_, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        LOG_ERROR("Failed to map call log", path, ":", std::strerror(errno));
+        mapping_bytes_ = 0;
+        return false;
+    }
+    mapping_ = static_cast<const uint8_t*>(mapping);
+
+    CallLogHeader header;
+    std::memcpy(&header, mapping_, sizeof(header));
+    if (header.magic != CALL_LOG_MAGIC || header.version != CALL_LOG_VERSION ||
+        header.chunk_records != CALL_LOG_CHUNK_RECORDS || header.chunk_bytes != columns.chunk_bytes) {
+        LOG_ERROR("Not a call log of this version:", path);
+        close();
+        return false;
+    }
+
+    // Only whole chunks; the writer may be extending the file
+    chunks_ = (mapping_bytes_ - CALL_LOG_HEADER_BYTES) / columns.chunk_bytes;
+    return true;
+}
+
+void CallLogReader::close() {
+    if (mapping_) {
+        munmap(const_cast<uint8_t*>(mapping_), mapping_bytes_);
+        mapping_ = nullptr;
+    }
+    mapping_bytes_ = 0;
+    chunks_ = 0;
+}
+
+uint64_t CallLogReader::getRecordCount() const {
+    uint64_t count = 0;
+    for (size_t chunk = 0; chunk < chunks_; chunk++) {
+        CallLogChunkHeader header;
+        std::memcpy(&header, mapping_ + chunkOffset(chunk), sizeof(header));
+        count += std::min<uint32_t>(header.count, CALL_LOG_CHUNK_RECORDS);
+    }
+    return count;
+}
+
+CallRecord CallLogReader::record(const uint8_t* chunk, size_t index) const {
+    const CallLogColumns& columns = CallLogColumns::layout();
+    CallRecord record;
+    record.start_ms = reinterpret_cast<const uint64_t*>(chunk + columns.start_ms)[index];
+    record.duration_ms = reinterpret_cast<const uint32_t*>(chunk + columns.duration_ms)[index];
+    record.talkgroup = reinterpret_cast<const TalkgroupID*>(chunk + columns.talkgroup)[index];
+    record.source = reinterpret_cast<const RadioID*>(chunk + columns.source)[index];
+    record.frequency = reinterpret_cast<const uint32_t*>(chunk + columns.frequency)[index];
+    record.site = reinterpret_cast<const uint16_t*>(chunk + columns.site)[index];
+    record.flags = chunk[columns.flags + index];
+    record.rssi = static_cast<int8_t>(chunk[columns.rssi + index]);
+    return record;
+}
+
+size_t CallLogReader::query(const Query& query,
+                            const std::function<void(const CallRecord&)>& callback) const {
+    const CallLogColumns& columns = CallLogColumns::layout();
+    std::vector<uint32_t> matches(CALL_LOG_CHUNK_RECORDS);
+    size_t found = 0;
+
+    for (size_t c = 0; c < chunks_; c++) {
+        const uint8_t* chunk = mapping_ + chunkOffset(c);
+        CallLogChunkHeader header;
+        std::memcpy(&header, chunk, sizeof(header));
+        size_t count = std::min<uint32_t>(header.count, CALL_LOG_CHUNK_RECORDS);
+        if (count == 0 || header.max_start_ms < query.since_ms || header.min_start_ms > query.until_ms) {
+            continue;
+        }
+
+        // Narrow by one column at a time, without branching per record
+        size_t candidates = 0;
+        const uint64_t* start = reinterpret_cast<const uint64_t*>(chunk + columns.start_ms);
+        for (size_t i = 0; i < count; i++) {
+            matches[candidates] = static_cast<uint32_t>(i);
+            candidates += start[i] >= query.since_ms && start[i] <= query.until_ms;
+        }
+        if (query.by_talkgroup) {
+            const TalkgroupID* talkgroup = reinterpret_cast<const TalkgroupID*>(chunk + columns.talkgroup);
+            size_t kept = 0;
+            for (size_t i = 0; i < candidates; i++) {
+                matches[kept] = matches[i];
+                kept += talkgroup[matches[i]] == query.talkgroup;
+            }
+            candidates = kept;
+        }
+        if (query.by_source) {
+            const RadioID* source = reinterpret_cast<const RadioID*>(chunk + columns.source);
+            size_t kept = 0;
+            for (size_t i = 0; i < candidates; i++) {
+                matches[kept] = matches[i];
+                kept += source[matches[i]] == query.source;
+            }
+            candidates = kept;
+        }
+        if (query.by_site) {
+            const uint16_t* site = reinterpret_cast<const uint16_t*>(chunk + columns.site);
+            size_t kept = 0;
+            for (size_t i = 0; i < candidates; i++) {
+                matches[kept] = matches[i];
+                kept += site[matches[i]] == query.site;
+            }
+            candidates = kept;
+        }
+
+        for (size_t i = 0; i < candidates; i++) {
+            callback(record(chunk, matches[i]));
+        }
+        found += candidates;
+    }
+    return found;
+}
+
+} // namespace TrunkSDR
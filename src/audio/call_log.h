@@ -0,0 +1,159 @@
+#ifndef CALL_LOG_H
+#define CALL_LOG_H
+
+#include "../utils/types.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace TrunkSDR {
+
+// One finished call
+struct CallRecord {
+    uint64_t start_ms;          // Unix time
+    uint32_t duration_ms;
+    TalkgroupID talkgroup;
+    RadioID source;
+    uint32_t frequency;         // Hz
+    uint16_t site;              // Position in the configured systems
+    uint8_t flags;              // CALL_FLAG_*
+    int8_t rssi;                // Channel level, dBFS (CALL_RSSI_UNKNOWN if not measured)
+};
+
+constexpr uint8_t CALL_FLAG_ENCRYPTED = 0x01;
+constexpr uint8_t CALL_FLAG_EMERGENCY = 0x02;
+constexpr int8_t CALL_RSSI_UNKNOWN = INT8_MIN;
+
+// On-disk layout of a call log (host byte order).
+//
+// A 4 KB file header, then chunks of CALL_LOG_CHUNK_RECORDS records. A
+// chunk is stored by column: a small header, then every record's start
+// time, then every duration, talkgroup and so on, each column padded to
+// 64 bytes. A query touches only the columns it filters on, and the
+// header's start time range lets it skip whole chunks. Chunks are
+// allocated whole, so the file is always a whole number of them; the
+// writer fills in the columns of new records before it raises the
+// chunk's count, so a reader never sees half a record.
+constexpr uint32_t CALL_LOG_MAGIC = 0x4C435354;    // "TSCL"
+constexpr uint32_t CALL_LOG_VERSION = 1;
+constexpr uint32_t CALL_LOG_CHUNK_RECORDS = 8192;
+constexpr size_t CALL_LOG_HEADER_BYTES = 4096;
+
+struct CallLogHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t chunk_records;
+    uint32_t chunk_bytes;
+    uint64_t created_ms;
+};
+
+struct CallLogChunkHeader {
+    uint32_t count;             // Records written
+    uint32_t reserved;
+    uint64_t min_start_ms;      // Over the records written
+    uint64_t max_start_ms;
+};
+
+// Byte offsets of the columns within a chunk
+struct CallLogColumns {
+    size_t start_ms;
+    size_t duration_ms;
+    size_t talkgroup;
+    size_t source;
+    size_t frequency;
+    size_t site;
+    size_t flags;
+    size_t rssi;
+    size_t chunk_bytes;         // Whole chunk, a multiple of the page size
+
+    static const CallLogColumns& layout();
+};
+
+// Appends calls to a log file from any thread.
+//
+// append() only queues the record; a writer thread writes queued records
+// in batches, a column run per batch, when enough have gathered or a
+// second has passed. An existing log is continued where it ended.
+class CallLogWriter {
+public:
+    CallLogWriter();
+    ~CallLogWriter();
+
+    bool open(const std::string& path);
+    void close();
+
+    void append(const CallRecord& record);
+
+    uint64_t getRecordCount() const { return records_; }
+
+private:
+    void writerThread();
+    bool writeBatch(const std::vector<CallRecord>& batch);
+    bool startChunk();
+
+    std::string path_;
+    int fd_;
+    uint64_t chunk_;                    // Chunk being filled
+    CallLogChunkHeader chunk_header_;
+
+    std::thread writer_;
+    bool running_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::vector<CallRecord> queue_;
+    std::vector<CallRecord> batch_;
+    std::vector<uint8_t> column_;
+
+    std::atomic<uint64_t> records_;
+
+    static constexpr size_t BATCH_RECORDS = 256;
+    static constexpr auto FLUSH_INTERVAL = std::chrono::seconds(1);
+};
+
+// Read-only view of a call log, mapped into memory. Sees the records
+// written when it was opened.
+class CallLogReader {
+public:
+    struct Query {
+        uint64_t since_ms = 0;              // Start time range, inclusive
+        uint64_t until_ms = UINT64_MAX;
+        bool by_talkgroup = false;
+        TalkgroupID talkgroup = 0;
+        bool by_source = false;
+        RadioID source = 0;
+        bool by_site = false;
+        uint16_t site = 0;
+    };
+
+    CallLogReader();
+    ~CallLogReader();
+
+    CallLogReader(const CallLogReader&) = delete;
+    CallLogReader& operator=(const CallLogReader&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    uint64_t getRecordCount() const;
+    size_t getChunkCount() const { return chunks_; }
+
+    // Calls matching the query, in file order; returns how many
+    size_t query(const Query& query, const std::function<void(const CallRecord&)>& callback) const;
+
+private:
+    CallRecord record(const uint8_t* chunk, size_t index) const;
+
+    const uint8_t* mapping_;
+    size_t mapping_bytes_;
+    size_t chunks_;
+};
+
+} // namespace TrunkSDR
+
+#endif // CALL_LOG_H
@@ -4,8 +4,18 @@
 
 namespace TrunkSDR {
 
+namespace {
+
+// "1234 (Fire Dispatch)" for the log
+std::string named(uint32_t id, const std::string& alias) {
+    return alias.empty() ? std::to_string(id) : std::to_string(id) + " (" + alias + ")";
+}
+
+} // anonymous namespace
+
 CallManager::CallManager()
-    : total_calls_(0) {
+    : snapshot_(std::make_shared<TalkgroupSnapshot>())
+    , total_calls_(0) {
 }
 
 bool CallManager::initialize(const AudioConfig& config) {
@@ -22,11 +32,19 @@ bool CallManager::initialize(const AudioConfig& config) {
         return false;
     }
 
+    if (!config.call_log.empty()) {
+        call_log_ = std::make_unique<CallLogWriter>();
+        if (!call_log_->open(config.call_log)) {
+            LOG_ERROR("Failed to open call log");
+            return false;
+        }
+    }
+
     LOG_INFO("Call manager initialized");
     return true;
 }
 
-void CallManager::handleGrant(const CallGrant& grant) {
+void CallManager::handleGrant(const CallGrant& grant, uint16_t site) {
     // Check if talkgroup is enabled
     if (!isTalkgroupEnabled(grant.talkgroup)) {
         LOG_DEBUG("Ignoring grant for disabled talkgroup:", grant.talkgroup);
@@ -36,7 +54,8 @@ void CallManager::handleGrant(const CallGrant& grant) {
     std::lock_guard<std::mutex> lock(calls_mutex_);
 
     // Check if call already active
-    auto it = active_calls_.find(grant.talkgroup);
+    CallKey key{site, grant.talkgroup};
+    auto it = active_calls_.find(key);
     if (it != active_calls_.end()) {
         // Update existing call
         it->second.last_activity = std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -55,21 +74,25 @@ void CallManager::handleGrant(const CallGrant& grant) {
     call.last_activity = call.start_time;
     call.frame_count = 0;
     call.recording = audio_config_.record_calls;
+    call.site = site;
+    call.talkgroup_alias = getTalkgroupAlias(grant.talkgroup);
+    call.source_alias = getRadioAlias(grant.radio_id);
 
-    active_calls_[grant.talkgroup] = call;
-    total_calls_++;
-
-    LOG_INFO("New call started: TG =", grant.talkgroup,
+    LOG_INFO("New call started: TG =", named(grant.talkgroup, call.talkgroup_alias),
+             "Site =", site,
              "Freq =", grant.frequency,
-             "Source =", grant.radio_id);
+             "Source =", named(grant.radio_id, call.source_alias));
+
+    active_calls_[key] = std::move(call);
+    total_calls_++;
 }
 
-void CallManager::handleAudioFrame(TalkgroupID talkgroup, const AudioBuffer& audio) {
+void CallManager::handleAudioFrame(const CallKey& call, PooledPCM audio) {
     std::lock_guard<std::mutex> lock(calls_mutex_);
 
-    auto it = active_calls_.find(talkgroup);
+    auto it = active_calls_.find(call);
     if (it == active_calls_.end()) {
-        LOG_WARNING("Received audio for inactive call:", talkgroup);
+        LOG_WARNING("Received audio for inactive call: TG =", call.talkgroup, "Site =", call.site);
         return;
     }
 
@@ -81,90 +104,237 @@ void CallManager::handleAudioFrame(TalkgroupID talkgroup, const AudioBuffer& aud
 
     // Create audio frame
     AudioFrame frame;
-    frame.samples = audio;
-    frame.talkgroup = talkgroup;
+    frame.samples = std::move(audio);
+    frame.talkgroup = call.talkgroup;
     frame.radio_id = it->second.grant.radio_id;
     frame.timestamp = it->second.last_activity;
     frame.rssi = -60.0;  // Placeholder
 
     // Queue for playback
     if (audio_output_) {
-        audio_output_->queueAudio(frame);
+        audio_output_->queueAudio(std::move(frame));
     }
 
     // TODO: Record to file if enabled
 }
 
-void CallManager::endCall(TalkgroupID talkgroup) {
+void CallManager::endCall(const CallKey& call, int8_t rssi) {
     std::lock_guard<std::mutex> lock(calls_mutex_);
 
-    auto it = active_calls_.find(talkgroup);
+    auto it = active_calls_.find(call);
     if (it == active_calls_.end()) {
         return;
     }
 
     uint64_t duration = it->second.last_activity - it->second.start_time;
 
-    LOG_INFO("Call ended: TG =", talkgroup,
+    LOG_INFO("Call ended: TG =", named(call.talkgroup, it->second.talkgroup_alias),
+             "Site =", call.site,
              "Duration =", duration, "ms",
              "Frames =", it->second.frame_count);
 
+    logCall(it->second, rssi);
     active_calls_.erase(it);
 }
 
-bool CallManager::isCallActive(TalkgroupID talkgroup) const {
+void CallManager::logCall(const ActiveCall& call, int8_t rssi) {
+    if (!call_log_) {
+        return;
+    }
+
+    CallRecord record;
+    record.start_ms = call.start_time;
+    record.duration_ms = static_cast<uint32_t>(call.last_activity - call.start_time);
+    record.talkgroup = call.grant.talkgroup;
+    record.source = call.grant.radio_id;
+    record.frequency = static_cast<uint32_t>(call.grant.frequency);
+    record.site = call.site;
+    record.flags = 0;
+    if (call.grant.encrypted) {
+        record.flags |= CALL_FLAG_ENCRYPTED;
+    }
+    if (call.grant.type == CallType::EMERGENCY) {
+        record.flags |= CALL_FLAG_EMERGENCY;
+    }
+    record.rssi = rssi;
+    call_log_->append(record);
+}
+
+bool CallManager::isCallActive(const CallKey& call) const {
     std::lock_guard<std::mutex> lock(calls_mutex_);
-    return active_calls_.count(talkgroup) > 0;
+    return active_calls_.count(call) > 0;
 }
 
-ActiveCall* CallManager::getActiveCall(TalkgroupID talkgroup) {
+ActiveCall* CallManager::getActiveCall(const CallKey& call) {
     std::lock_guard<std::mutex> lock(calls_mutex_);
 
-    auto it = active_calls_.find(talkgroup);
+    auto it = active_calls_.find(call);
     if (it != active_calls_.end()) {
         return &it->second;
     }
     return nullptr;
 }
 
+std::shared_ptr<const TalkgroupSnapshot> CallManager::getSnapshot() const {
+    return std::atomic_load(&snapshot_);
+}
+
+void CallManager::publish(std::shared_ptr<const TalkgroupSnapshot> snapshot) {
+    std::atomic_store(&snapshot_, std::move(snapshot));
+}
+
+std::shared_ptr<TalkgroupSnapshot> CallManager::copySnapshot() const {
+    return std::make_shared<TalkgroupSnapshot>(*getSnapshot());
+}
+
+bool CallManager::applyTalkgroupConfig(const TalkgroupConfig& config, TalkgroupChanges* changes) {
+    auto next = std::make_shared<TalkgroupSnapshot>();
+    for (TalkgroupID talkgroup : config.enabled) {
+        next->enabled[talkgroup] = true;
+    }
+    next->priorities = config.priorities;
+    next->labels = config.labels;
+
+    std::lock_guard<std::mutex> lock(config_mutex_);
+    std::shared_ptr<const TalkgroupSnapshot> previous = getSnapshot();
+
+    if (!config.alias_db.empty()) {
+        if (previous->alias_db && previous->alias_db->isSameFile(config.alias_db)) {
+            next->alias_db = previous->alias_db;
+        } else {
+            auto alias_db = std::make_shared<AliasDB>();
+            if (!alias_db->open(config.alias_db)) {
+                return false;
+            }
+            next->alias_db = std::move(alias_db);
+        }
+    }
+
+    if (changes) {
+        *changes = TalkgroupChanges();
+        changes->enabled_before = previous->enabled.size();
+        changes->enabled_after = next->enabled.size();
+        for (const auto& entry : next->enabled) {
+            if (!previous->enabled.count(entry.first)) {
+                changes->enabled.push_back(entry.first);
+            }
+        }
+        for (const auto& entry : previous->enabled) {
+            if (!next->enabled.count(entry.first)) {
+                changes->disabled.push_back(entry.first);
+            }
+        }
+
+        // Talkgroups without a configured priority have the default
+        auto priority = [](const TalkgroupSnapshot& snapshot, TalkgroupID talkgroup) {
+            auto it = snapshot.priorities.find(talkgroup);
+            return it != snapshot.priorities.end() ? it->second : DEFAULT_PRIORITY;
+        };
+        std::map<TalkgroupID, bool> prioritized;
+        for (const auto& entry : previous->priorities) {
+            prioritized[entry.first] = true;
+        }
+        for (const auto& entry : next->priorities) {
+            prioritized[entry.first] = true;
+        }
+        for (const auto& entry : prioritized) {
+            Priority from = priority(*previous, entry.first);
+            Priority to = priority(*next, entry.first);
+            if (from != to) {
+                changes->priorities.push_back({entry.first, from, to});
+            }
+        }
+
+        for (const auto& entry : next->labels) {
+            auto it = previous->labels.find(entry.first);
+            if (it == previous->labels.end() || it->second != entry.second) {
+                changes->labels++;
+            }
+        }
+        for (const auto& entry : previous->labels) {
+            if (!next->labels.count(entry.first)) {
+                changes->labels++;
+            }
+        }
+
+        // An unchanged file keeps the same mapping
+        changes->alias_db = previous->alias_db != next->alias_db;
+    }
+
+    // Readers still holding the previous snapshot keep its alias database
+    // mapped until they let go
+    publish(std::move(next));
+    return true;
+}
+
 void CallManager::enableTalkgroup(TalkgroupID talkgroup, Priority priority) {
     std::lock_guard<std::mutex> lock(config_mutex_);
-    enabled_talkgroups_[talkgroup] = true;
-    talkgroup_priorities_[talkgroup] = priority;
+    auto next = copySnapshot();
+    next->enabled[talkgroup] = true;
+    next->priorities[talkgroup] = priority;
+    publish(std::move(next));
     LOG_INFO("Enabled talkgroup:", talkgroup, "with priority:", static_cast<int>(priority));
 }
 
 void CallManager::disableTalkgroup(TalkgroupID talkgroup) {
     std::lock_guard<std::mutex> lock(config_mutex_);
-    enabled_talkgroups_[talkgroup] = false;
+    auto next = copySnapshot();
+    next->enabled[talkgroup] = false;
+    publish(std::move(next));
     LOG_INFO("Disabled talkgroup:", talkgroup);
 }
 
 bool CallManager::isTalkgroupEnabled(TalkgroupID talkgroup) const {
-    std::lock_guard<std::mutex> lock(config_mutex_);
+    std::shared_ptr<const TalkgroupSnapshot> snapshot = getSnapshot();
 
-    auto it = enabled_talkgroups_.find(talkgroup);
-    if (it != enabled_talkgroups_.end()) {
+    auto it = snapshot->enabled.find(talkgroup);
+    if (it != snapshot->enabled.end()) {
         return it->second;
     }
 
     // If not explicitly configured, allow all
-    return enabled_talkgroups_.empty();
+    return snapshot->enabled.empty();
 }
 
 void CallManager::setTalkgroupPriority(TalkgroupID talkgroup, Priority priority) {
     std::lock_guard<std::mutex> lock(config_mutex_);
-    talkgroup_priorities_[talkgroup] = priority;
+    auto next = copySnapshot();
+    next->priorities[talkgroup] = priority;
+    publish(std::move(next));
 }
 
 Priority CallManager::getTalkgroupPriority(TalkgroupID talkgroup) const {
+    std::shared_ptr<const TalkgroupSnapshot> snapshot = getSnapshot();
+
+    auto it = snapshot->priorities.find(talkgroup);
+    if (it != snapshot->priorities.end()) {
+        return it->second;
+    }
+    return DEFAULT_PRIORITY;
+}
+
+void CallManager::setTalkgroupLabel(TalkgroupID talkgroup, const std::string& label) {
     std::lock_guard<std::mutex> lock(config_mutex_);
+    auto next = copySnapshot();
+    next->labels[talkgroup] = label;
+    publish(std::move(next));
+}
 
-    auto it = talkgroup_priorities_.find(talkgroup);
-    if (it != talkgroup_priorities_.end()) {
+std::string CallManager::getTalkgroupAlias(TalkgroupID talkgroup) const {
+    std::shared_ptr<const TalkgroupSnapshot> snapshot = getSnapshot();
+
+    auto it = snapshot->labels.find(talkgroup);
+    if (it != snapshot->labels.end()) {
         return it->second;
     }
-    return 5;  // Default priority
+    const char* alias = snapshot->alias_db ? snapshot->alias_db->getTalkgroupAlias(talkgroup) : nullptr;
+    return alias ? alias : "";
+}
+
+std::string CallManager::getRadioAlias(RadioID radio) const {
+    std::shared_ptr<const TalkgroupSnapshot> snapshot = getSnapshot();
+    const char* alias = snapshot->alias_db ? snapshot->alias_db->getRadioAlias(radio) : nullptr;
+    return alias ? alias : "";
 }
 
 size_t CallManager::getActiveCallCount() const {
@@ -182,7 +352,8 @@ void CallManager::cleanupInactiveCalls() {
     auto it = active_calls_.begin();
     while (it != active_calls_.end()) {
         if (now - it->second.last_activity > CALL_TIMEOUT_MS) {
-            LOG_INFO("Timeout: TG =", it->first);
+            LOG_INFO("Timeout: TG =", it->first.talkgroup, "Site =", it->first.site);
+            logCall(it->second, CALL_RSSI_UNKNOWN);
             it = active_calls_.erase(it);
         } else {
             ++it;
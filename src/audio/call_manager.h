@@ -2,10 +2,14 @@
 #define CALL_MANAGER_H
 
 #include "../utils/types.h"
+#include "../utils/config_parser.h"
 #include "audio_output.h"
+#include "call_log.h"
+#include "../utils/alias_db.h"
 #include <map>
 #include <memory>
 #include <mutex>
+#include <vector>
 
 namespace TrunkSDR {
 
@@ -15,6 +19,41 @@ struct ActiveCall {
     uint64_t last_activity;
     size_t frame_count;
     bool recording;
+    uint16_t site;
+    std::string talkgroup_alias;    // Empty when unnamed
+    std::string source_alias;
+};
+
+// Which talkgroups are followed, at what priority and under what names.
+// Never modified once published; a reload builds a new one and swaps it
+// in whole, so a reader sees either the old settings or the new ones.
+struct TalkgroupSnapshot {
+    std::map<TalkgroupID, bool> enabled;        // Empty: every talkgroup
+    std::map<TalkgroupID, Priority> priorities;
+    std::map<TalkgroupID, std::string> labels;
+    std::shared_ptr<const AliasDB> alias_db;    // Null without one
+};
+
+// What a new snapshot changed, for the reload report
+struct TalkgroupChanges {
+    struct PriorityChange {
+        TalkgroupID talkgroup;
+        Priority from;
+        Priority to;
+    };
+
+    size_t enabled_before = 0;                  // 0 = every talkgroup
+    size_t enabled_after = 0;
+    std::vector<TalkgroupID> enabled;           // Newly followed
+    std::vector<TalkgroupID> disabled;
+    std::vector<PriorityChange> priorities;
+    size_t labels = 0;                          // Added, removed or renamed
+    bool alias_db = false;                      // Opened, closed or reopened
+
+    bool any() const {
+        return enabled_before != enabled_after || !enabled.empty() || !disabled.empty() ||
+               !priorities.empty() || labels > 0 || alias_db;
+    }
 };
 
 class CallManager {
@@ -24,42 +63,70 @@ public:
 
     bool initialize(const AudioConfig& config);
 
-    // Call lifecycle
-    void handleGrant(const CallGrant& grant);
-    void handleAudioFrame(TalkgroupID talkgroup, const AudioBuffer& audio);
-    void endCall(TalkgroupID talkgroup);
+    // Call lifecycle. Calls are keyed by site and talkgroup, so the same
+    // talkgroup on two systems makes two calls. Finished calls go to the
+    // call log, if there is one, with the level of the channel they were
+    // heard on.
+    void handleGrant(const CallGrant& grant, uint16_t site);
+    void handleAudioFrame(const CallKey& call, PooledPCM audio);
+    void endCall(const CallKey& call, int8_t rssi = CALL_RSSI_UNKNOWN);
 
     // Call management
-    bool isCallActive(TalkgroupID talkgroup) const;
-    ActiveCall* getActiveCall(TalkgroupID talkgroup);
+    bool isCallActive(const CallKey& call) const;
+    ActiveCall* getActiveCall(const CallKey& call);
+
+    // Replaces every talkgroup setting at once (startup and config reload).
+    // The alias database is reopened only when its path changed or the file
+    // was rebuilt; if it cannot be opened nothing changes.
+    bool applyTalkgroupConfig(const TalkgroupConfig& config, TalkgroupChanges* changes = nullptr);
 
-    // Configuration
-    void enableTalkgroup(TalkgroupID talkgroup, Priority priority = 5);
+    // Single settings; each publishes a new snapshot
+    void enableTalkgroup(TalkgroupID talkgroup, Priority priority = DEFAULT_PRIORITY);
     void disableTalkgroup(TalkgroupID talkgroup);
     bool isTalkgroupEnabled(TalkgroupID talkgroup) const;
 
     void setTalkgroupPriority(TalkgroupID talkgroup, Priority priority);
     Priority getTalkgroupPriority(TalkgroupID talkgroup) const;
 
+    // Names: configured labels first, then the alias database
+    void setTalkgroupLabel(TalkgroupID talkgroup, const std::string& label);
+    std::string getTalkgroupAlias(TalkgroupID talkgroup) const;
+    std::string getRadioAlias(RadioID radio) const;
+
     // Statistics
     size_t getActiveCallCount() const;
     uint64_t getTotalCallCount() const { return total_calls_; }
+    const CallLogWriter* getCallLog() const { return call_log_.get(); }
 
-private:
+    // Ends calls with neither a grant nor audio for CALL_TIMEOUT_MS, such
+    // as those no receiver was free to follow
     void cleanupInactiveCalls();
 
+private:
+    void logCall(const ActiveCall& call, int8_t rssi);
+
+    std::shared_ptr<const TalkgroupSnapshot> getSnapshot() const;
+    void publish(std::shared_ptr<const TalkgroupSnapshot> snapshot);
+
+    // Copy of the current snapshot, to change and publish
+    std::shared_ptr<TalkgroupSnapshot> copySnapshot() const;
+
     std::unique_ptr<AudioOutput> audio_output_;
+    std::unique_ptr<CallLogWriter> call_log_;
     AudioConfig audio_config_;
 
-    std::map<TalkgroupID, ActiveCall> active_calls_;
-    std::map<TalkgroupID, Priority> talkgroup_priorities_;
-    std::map<TalkgroupID, bool> enabled_talkgroups_;
+    std::map<CallKey, ActiveCall> active_calls_;
+
+    // Read without locking (atomic shared_ptr access); config_mutex_ only
+    // serializes the writers
+    std::shared_ptr<const TalkgroupSnapshot> snapshot_;
 
     mutable std::mutex calls_mutex_;
-    mutable std::mutex config_mutex_;
+    std::mutex config_mutex_;
 
     uint64_t total_calls_;
     static constexpr uint64_t CALL_TIMEOUT_MS = 5000;  // 5 seconds
+    static constexpr Priority DEFAULT_PRIORITY = 5;
 };
 
 } // namespace TrunkSDR
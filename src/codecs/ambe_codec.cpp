@@ -0,0 +1,113 @@
+#include "ambe_codec.h"
+#include "../utils/logger.h"
+#include <algorithm>
+
+// Include mbelib if available
+#ifdef HAVE_MBELIB
+extern "C" {
+#include <mbelib.h>
+}
+#endif
+
+namespace TrunkSDR {
+
+#ifdef HAVE_MBELIB
+namespace {
+
+// DMR AMBE+2 frame interleave: dibit i of the 72-bit frame carries
+// ambe_fr[W[i]][X[i]] (high bit) and ambe_fr[Y[i]][Z[i]] (low bit)
+constexpr int AMBE_W[36] = {
+    0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1,
+    0, 1, 0, 1, 0, 2, 0, 2, 0, 2, 0, 2, 0, 2, 0, 2, 0, 2
+};
+constexpr int AMBE_X[36] = {
+    23, 10, 22, 9, 21, 8, 20, 7, 19, 6, 18, 5, 17, 4, 16, 3, 15, 2,
+    14, 1, 13, 0, 12, 10, 11, 9, 10, 8, 9, 7, 8, 6, 7, 5, 6, 4
+};
+constexpr int AMBE_Y[36] = {
+    0, 2, 0, 2, 0, 2, 0, 2, 0, 3, 0, 3, 1, 3, 1, 3, 1, 3,
+    1, 3, 1, 3, 1, 3, 1, 3, 1, 3, 1, 3, 1, 3, 1, 3, 1, 3
+};
+constexpr int AMBE_Z[36] = {
+    5, 3, 4, 2, 3, 1, 2, 0, 1, 13, 0, 12, 22, 11, 21, 10, 20, 9,
+    19, 8, 18, 7, 17, 6, 16, 5, 15, 4, 14, 3, 13, 2, 12, 1, 11, 0
+};
+
+} // anonymous namespace
+#endif
+
+AMBECodec::AMBECodec()
+    : cur_mp_(nullptr)
+    , prev_mp_(nullptr)
+    , prev_mp_enhanced_(nullptr)
+    , initialized_(false) {
+}
+
+AMBECodec::~AMBECodec() {
+#ifdef HAVE_MBELIB
+    delete cur_mp_;
+    delete prev_mp_;
+    delete prev_mp_enhanced_;
+#endif
+}
+
+bool AMBECodec::initialize() {
+#ifdef HAVE_MBELIB
+    if (!cur_mp_) {
+        cur_mp_ = new mbe_parms;
+        prev_mp_ = new mbe_parms;
+        prev_mp_enhanced_ = new mbe_parms;
+    }
+    mbe_initMbeParms(cur_mp_, prev_mp_, prev_mp_enhanced_);
+    initialized_ = true;
+    LOG_INFO("AMBE+2 codec initialized with mbelib");
+    return true;
+#else
+    LOG_WARNING("AMBE+2 codec: mbelib not available, using stub decoder");
+    initialized_ = true;
+    return true;
+#endif
+}
+
+void AMBECodec::decode(const uint8_t* encoded_data, size_t length,
+                       AudioSample* output) {
+    if (!initialized_) {
+        LOG_ERROR("AMBE+2 codec not initialized");
+        std::fill(output, output + getOutputSamples(), 0);
+        return;
+    }
+
+#ifdef HAVE_MBELIB
+    char ambe_fr[4][24] = {};
+    char ambe_d[49];
+    for (size_t i = 0; i < 36; i++) {
+        size_t bit = 2 * i;
+        char high = (bit / 8 < length) ? (encoded_data[bit / 8] >> (7 - (bit % 8))) & 1 : 0;
+        bit++;
+        char low = (bit / 8 < length) ? (encoded_data[bit / 8] >> (7 - (bit % 8))) & 1 : 0;
+        ambe_fr[AMBE_W[i]][AMBE_X[i]] = high;
+        ambe_fr[AMBE_Y[i]][AMBE_Z[i]] = low;
+    }
+
+    int errs = 0;
+    int errs2 = 0;
+    char err_str[64];
+    mbe_processAmbe3600x2450Frame(output, &errs, &errs2, err_str, ambe_fr, ambe_d,
+                                  cur_mp_, prev_mp_, prev_mp_enhanced_, 3);
+#else
+    // Stub implementation - output silence
+    (void)encoded_data;
+    (void)length;
+    std::fill(output, output + getOutputSamples(), 0);
+#endif
+}
+
+void AMBECodec::reset() {
+#ifdef HAVE_MBELIB
+    if (cur_mp_) {
+        mbe_initMbeParms(cur_mp_, prev_mp_, prev_mp_enhanced_);
+    }
+#endif
+}
+
+} // namespace TrunkSDR
@@ -0,0 +1,41 @@
+#ifndef AMBE_CODEC_H
+#define AMBE_CODEC_H
+
+#include "codec_interface.h"
+
+// Forward declare mbelib structures (compatible with mbelib.h)
+extern "C" {
+    struct mbe_parameters;
+}
+
+namespace TrunkSDR {
+
+// AMBE+2 (3600x2450) codec for DMR
+//
+// Input is the raw 72-bit over-the-air frame (packed, MSB first); FEC and
+// descrambling are done here, as for the other half-rate TDMA vocoders.
+class AMBECodec : public CodecInterface {
+public:
+    AMBECodec();
+    ~AMBECodec() override;
+
+    bool initialize() override;
+    void decode(const uint8_t* encoded_data, size_t length,
+               AudioSample* output) override;
+    void reset() override;
+
+    CodecType getType() const override { return CodecType::AMBE_PLUS2; }
+    size_t getFrameSize() const override { return 9; }  // 72 bits
+    size_t getOutputSamples() const override { return 160; }  // 20ms at 8kHz
+
+private:
+    // mbelib synthesis state (current, previous, previous enhanced)
+    mbe_parameters* cur_mp_;
+    mbe_parameters* prev_mp_;
+    mbe_parameters* prev_mp_enhanced_;
+    bool initialized_;
+};
+
+} // namespace TrunkSDR
+
+#endif // AMBE_CODEC_H
@@ -11,8 +11,11 @@ public:
     virtual ~CodecInterface() = default;
 
     virtual bool initialize() = 0;
+
+    // Decode one frame into caller-owned storage of getOutputSamples()
+    // samples. Implementations must not allocate.
     virtual void decode(const uint8_t* encoded_data, size_t length,
-                       AudioBuffer& output) = 0;
+                       AudioSample* output) = 0;
     virtual void reset() = 0;
 
     virtual CodecType getType() const = 0;
@@ -0,0 +1,226 @@
+#include "codec_pool.h"
+#include "imbe_codec.h"
+#include "ambe_codec.h"
+#include "../audio/audio_frame_pool.h"
+#include "../utils/logger.h"
+
+namespace TrunkSDR {
+
+CodecPool::CodecPool()
+    : running_(false)
+    , batches_decoded_(0)
+    , batches_dropped_(0)
+    , releases_deferred_(0) {
+}
+
+CodecPool::~CodecPool() {
+    stop();
+}
+
+bool CodecPool::start(size_t num_workers) {
+    if (running_) {
+        return true;
+    }
+
+    if (num_workers == 0) {
+        num_workers = 1;
+    }
+
+    // PCM blocks for one batch per worker in flight
+    AudioFramePool::instance().reserve(num_workers * MAX_VOICE_FRAMES_PER_BATCH);
+
+    running_ = true;
+    for (size_t i = 0; i < num_workers; i++) {
+        auto worker = std::make_unique<Worker>();
+        worker->pending.reserve(QUEUE_CAPACITY);
+        worker->deferred_releases.reserve(QUEUE_CAPACITY);
+        worker->released.reserve(QUEUE_CAPACITY);
+        workers_.push_back(std::move(worker));
+    }
+    for (auto& worker : workers_) {
+        worker->thread = std::thread(&CodecPool::workerThread, this, worker.get());
+    }
+
+    LOG_INFO("Codec pool started:", num_workers, "worker(s)");
+    return true;
+}
+
+void CodecPool::stop() {
+    if (!running_) {
+        return;
+    }
+
+    running_ = false;
+    for (auto& worker : workers_) {
+        {
+            // Synchronise with the predicate check in workerThread
+            std::lock_guard<std::mutex> lock(worker->mutex);
+        }
+        worker->cv.notify_one();
+    }
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+    workers_.clear();
+
+    LOG_INFO("Codec pool stopped: decoded =", batches_decoded_.load(),
+             "dropped =", batches_dropped_.load(),
+             "releases deferred =", releases_deferred_.load());
+}
+
+bool CodecPool::submit(uint16_t site, const VoiceFrameBatch& batch) {
+    if (!running_) {
+        return false;
+    }
+    CallKey call{site, batch.talkgroup};
+    if (!enqueue(workerFor(call), call, &batch)) {
+        batches_dropped_++;
+        LOG_WARNING("Codec worker backlogged, dropping batch for TG:", batch.talkgroup);
+        return false;
+    }
+    return true;
+}
+
+void CodecPool::releaseCall(const CallKey& call) {
+    if (!running_) {
+        return;
+    }
+
+    size_t index = workerFor(call);
+    if (enqueue(index, call, nullptr)) {
+        return;
+    }
+
+    // A lost release would leave the call's codec state behind for the
+    // next call on the talkgroup, so park it beside the full ring
+    Worker* worker = workers_[index].get();
+    {
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        worker->deferred_releases.push_back(call);
+    }
+    worker->cv.notify_one();
+    releases_deferred_++;
+    LOG_WARNING("Codec worker backlogged, deferring release of TG:", call.talkgroup);
+}
+
+bool CodecPool::enqueue(size_t worker_index, const CallKey& call,
+                        const VoiceFrameBatch* batch) {
+    Worker* worker = workers_[worker_index].get();
+    {
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        if (worker->count == QUEUE_CAPACITY) {
+            return false;
+        }
+
+        Job& job = worker->queue[(worker->head + worker->count) % QUEUE_CAPACITY];
+        // Release jobs carry only the call
+        job.release = (batch == nullptr);
+        job.site = call.site;
+        if (batch) {
+            job.batch = *batch;
+        } else {
+            job.batch.talkgroup = call.talkgroup;
+        }
+        worker->count++;
+    }
+    worker->cv.notify_one();
+    return true;
+}
+
+size_t CodecPool::workerFor(const CallKey& call) const {
+    // Every slot of a call shares a worker, so one release reaches them
+    // all. The site is scaled by a prime so that one talkgroup heard on
+    // several sites spreads across the workers.
+    return (static_cast<size_t>(call.site) * 7919 + call.talkgroup) % workers_.size();
+}
+
+void CodecPool::workerThread(Worker* worker) {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(worker->mutex);
+            worker->cv.wait(lock, [&] {
+                return worker->count > 0 || !worker->deferred_releases.empty() || !running_;
+            });
+            if (!running_ && worker->count == 0 && worker->deferred_releases.empty()) {
+                break;
+            }
+
+            // Take everything queued in one go
+            worker->pending.clear();
+            while (worker->count > 0) {
+                worker->pending.push_back(worker->queue[worker->head]);
+                worker->head = (worker->head + 1) % QUEUE_CAPACITY;
+                worker->count--;
+            }
+            worker->released.swap(worker->deferred_releases);
+        }
+
+        for (const Job& job : worker->pending) {
+            CallKey call{job.site, job.batch.talkgroup};
+            if (job.release) {
+                releaseCodecs(worker, call);
+            } else {
+                decodeBatch(worker, call, job.batch);
+            }
+        }
+        for (const CallKey& call : worker->released) {
+            releaseCodecs(worker, call);
+        }
+        worker->released.clear();
+    }
+}
+
+void CodecPool::releaseCodecs(Worker* worker, const CallKey& call) {
+    auto it = worker->codecs.lower_bound(StreamKey{call, 0});
+    while (it != worker->codecs.end() && it->first.call == call) {
+        it = worker->codecs.erase(it);
+    }
+}
+
+void CodecPool::decodeBatch(Worker* worker, const CallKey& call, const VoiceFrameBatch& batch) {
+    StreamKey stream{call, batch.slot};
+    auto it = worker->codecs.find(stream);
+    if (it == worker->codecs.end()) {
+        CallCodec state;
+        state.codec = createCodec(batch.codec);
+        if (!state.codec || !state.codec->initialize()) {
+            LOG_WARNING("No codec available for voice on TG:", batch.talkgroup);
+            state.codec.reset();
+        } else if (state.codec->getOutputSamples() != AUDIO_BUFFER_FRAMES) {
+            LOG_ERROR("Codec frame size does not match PCM block:", state.codec->getOutputSamples());
+            state.codec.reset();
+        }
+        it = worker->codecs.emplace(stream, std::move(state)).first;
+    }
+
+    CodecInterface* codec = it->second.codec.get();
+    if (!codec) {
+        return;
+    }
+
+    for (size_t i = 0; i < batch.frame_count; i++) {
+        // Synthesize straight into a pooled block and hand it on
+        PooledPCM pcm = AudioFramePool::instance().acquire();
+        codec->decode(batch.frame(i), batch.frame_bytes, pcm->data());
+        if (audio_callback_) {
+            audio_callback_(call, std::move(pcm));
+        }
+    }
+
+    batches_decoded_++;
+}
+
+std::unique_ptr<CodecInterface> CodecPool::createCodec(CodecType type) {
+    switch (type) {
+        case CodecType::IMBE:
+            return std::make_unique<IMBECodec>();
+        case CodecType::AMBE_PLUS2:
+            return std::make_unique<AMBECodec>();
+        default:
+            return nullptr;
+    }
+}
+
+} // namespace TrunkSDR
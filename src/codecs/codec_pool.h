@@ -0,0 +1,125 @@
+#ifndef CODEC_POOL_H
+#define CODEC_POOL_H
+
+#include "codec_interface.h"
+#include "../decoders/base_decoder.h"
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace TrunkSDR {
+
+// Callback for synthesized audio (called on a codec worker thread).
+// Ownership of the pooled PCM block passes to the callee.
+using CodecAudioCallback = std::function<void(const CallKey&, PooledPCM)>;
+
+// Vocoder execution service.
+//
+// Encoded frame batches are queued by the decoder thread and synthesized on
+// a pool of worker threads, so IMBE/AMBE synthesis never stalls
+// demodulation. Each call (site and talkgroup) is pinned to one worker,
+// which owns that call's codec instances, one per TDMA slot; frames of a
+// call therefore stay in order and codec state is never shared between
+// threads or between systems, while simultaneous calls spread across
+// cores.
+class CodecPool {
+public:
+    CodecPool();
+    ~CodecPool();
+
+    bool start(size_t num_workers);
+    void stop();
+
+    // Queue a batch heard on 'site' for synthesis. Returns false if the
+    // owning worker is backlogged and the batch was dropped.
+    bool submit(uint16_t site, const VoiceFrameBatch& batch);
+
+    // Discard the codec state kept for a finished call. Never dropped: if
+    // the owning worker is backlogged the release is applied after the
+    // jobs already queued.
+    void releaseCall(const CallKey& call);
+
+    void setAudioCallback(CodecAudioCallback callback) {
+        audio_callback_ = callback;
+    }
+
+    static std::unique_ptr<CodecInterface> createCodec(CodecType type);
+
+    // Statistics
+    size_t getWorkerCount() const { return workers_.size(); }
+    uint64_t getBatchesDecoded() const { return batches_decoded_; }
+    uint64_t getBatchesDropped() const { return batches_dropped_; }
+    uint64_t getReleasesDeferred() const { return releases_deferred_; }
+
+private:
+    struct Job {
+        bool release;
+        uint16_t site;
+        VoiceFrameBatch batch;
+    };
+
+    // Per-worker bounded job ring, preallocated so submit never allocates
+    static constexpr size_t QUEUE_CAPACITY = 32;
+
+    // One voice stream: a call on one TDMA slot (0 on FDMA channels)
+    struct StreamKey {
+        CallKey call;
+        uint8_t slot;
+
+        bool operator<(const StreamKey& other) const {
+            if (!(call == other.call)) {
+                return call < other.call;
+            }
+            return slot < other.slot;
+        }
+    };
+
+    // Codec state of one stream. 'codec' is null when no usable codec
+    // exists for the call's voice type, so the call is skipped without
+    // retrying.
+    struct CallCodec {
+        std::unique_ptr<CodecInterface> codec;
+    };
+
+    struct Worker {
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::array<Job, QUEUE_CAPACITY> queue;
+        size_t head = 0;
+        size_t count = 0;
+
+        // Releases that arrived while the ring was full. The ring only
+        // drains all at once, so these follow everything in it.
+        std::vector<CallKey> deferred_releases;
+
+        // Owned by the worker thread only
+        std::map<StreamKey, CallCodec> codecs;
+        std::vector<Job> pending;
+        std::vector<CallKey> released;
+    };
+
+    bool enqueue(size_t worker_index, const CallKey& call, const VoiceFrameBatch* batch);
+    void workerThread(Worker* worker);
+    void decodeBatch(Worker* worker, const CallKey& call, const VoiceFrameBatch& batch);
+    void releaseCodecs(Worker* worker, const CallKey& call);
+    size_t workerFor(const CallKey& call) const;
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<bool> running_;
+    CodecAudioCallback audio_callback_;
+
+    std::atomic<uint64_t> batches_decoded_;
+    std::atomic<uint64_t> batches_dropped_;
+    std::atomic<uint64_t> releases_deferred_;
+};
+
+} // namespace TrunkSDR
+
+#endif // CODEC_POOL_H
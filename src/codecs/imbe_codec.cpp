@@ -1,5 +1,6 @@
 #include "imbe_codec.h"
 #include "../utils/logger.h"
+#include <algorithm>
 
 // Include mbelib if available
 #ifdef HAVE_MBELIB
@@ -11,18 +12,30 @@ extern "C" {
 namespace TrunkSDR {
 
 IMBECodec::IMBECodec()
-    : mbe_state_(nullptr)
+    : cur_mp_(nullptr)
+    , prev_mp_(nullptr)
+    , prev_mp_enhanced_(nullptr)
     , initialized_(false) {
 }
 
 IMBECodec::~IMBECodec() {
-    // Cleanup MBE state if needed
+#ifdef HAVE_MBELIB
+    delete cur_mp_;
+    delete prev_mp_;
+    delete prev_mp_enhanced_;
+#endif
 }
 
 bool IMBECodec::initialize() {
 #ifdef HAVE_MBELIB
-    // Initialize mbelib decoder
-    mbe_state_ = nullptr;  // mbelib uses static state
+    // Each codec instance keeps its own synthesis state so several calls
+    // can be decoded side by side
+    if (!cur_mp_) {
+        cur_mp_ = new mbe_parms;
+        prev_mp_ = new mbe_parms;
+        prev_mp_enhanced_ = new mbe_parms;
+    }
+    mbe_initMbeParms(cur_mp_, prev_mp_, prev_mp_enhanced_);
     initialized_ = true;
     LOG_INFO("IMBE codec initialized with mbelib");
     return true;
@@ -34,42 +47,40 @@ bool IMBECodec::initialize() {
 }
 
 void IMBECodec::decode(const uint8_t* encoded_data, size_t length,
-                       AudioBuffer& output) {
+                       AudioSample* output) {
     if (!initialized_) {
         LOG_ERROR("IMBE codec not initialized");
+        std::fill(output, output + getOutputSamples(), 0);
         return;
     }
 
-    // Resize output buffer
-    output.resize(160);  // 160 samples @ 8kHz = 20ms
-
 #ifdef HAVE_MBELIB
-    // Decode IMBE frame using mbelib
-    char ambe_d[49];  // IMBE frame data
-    short audio_out[160];
-
-    // Convert input bytes to bit string format expected by mbelib
-    for (size_t i = 0; i < 88 && i/8 < length; i++) {
-        ambe_d[i] = (encoded_data[i/8] >> (7 - (i%8))) & 1;
+    // Input is the error-corrected 88-bit frame (u0..u7, MSB first);
+    // mbelib expects one bit per char in the same order
+    char imbe_d[88];
+    for (size_t i = 0; i < 88; i++) {
+        imbe_d[i] = (i / 8 < length) ? (encoded_data[i / 8] >> (7 - (i % 8))) & 1 : 0;
     }
 
-    // Decode using mbelib (simplified - actual mbelib API may differ)
-    // mbe_processImbe(audio_out, ambe_d);
-
-    // For now, use silence if mbelib function unavailable
-    for (int i = 0; i < 160; i++) {
-        output[i] = 0;
-    }
+    int errs = 0;
+    int errs2 = 0;
+    char err_str[64];
+    mbe_processImbe4400Data(output, &errs, &errs2, err_str, imbe_d,
+                            cur_mp_, prev_mp_, prev_mp_enhanced_, 3);
 #else
     // Stub implementation - output silence
-    for (int i = 0; i < 160; i++) {
-        output[i] = 0;
-    }
+    (void)encoded_data;
+    (void)length;
+    std::fill(output, output + getOutputSamples(), 0);
 #endif
 }
 
 void IMBECodec::reset() {
-    // Reset decoder state
+#ifdef HAVE_MBELIB
+    if (cur_mp_) {
+        mbe_initMbeParms(cur_mp_, prev_mp_, prev_mp_enhanced_);
+    }
+#endif
 }
 
 } // namespace TrunkSDR
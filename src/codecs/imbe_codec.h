@@ -18,7 +18,7 @@ public:
 
     bool initialize() override;
     void decode(const uint8_t* encoded_data, size_t length,
-               AudioBuffer& output) override;
+               AudioSample* output) override;
     void reset() override;
 
     CodecType getType() const override { return CodecType::IMBE; }
@@ -26,7 +26,10 @@ public:
     size_t getOutputSamples() const override { return 160; }  // 20ms at 8kHz
 
 private:
-    void* mbe_state_;  // Opaque pointer to MBE decoder state
+    // mbelib synthesis state (current, previous, previous enhanced)
+    mbe_parameters* cur_mp_;
+    mbe_parameters* prev_mp_;
+    mbe_parameters* prev_mp_enhanced_;
     bool initialized_;
 };
 
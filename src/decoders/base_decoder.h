@@ -2,6 +2,7 @@
 #define BASE_DECODER_H
 
 #include "../utils/types.h"
+#include <array>
 #include <functional>
 #include <vector>
 
@@ -13,6 +14,32 @@ using GrantCallback = std::function<void(const CallGrant&)>;
 // Callback for system information updates
 using SystemInfoCallback = std::function<void(const SystemInfo&)>;
 
+// Upper bounds for one batch of encoded voice frames (P25 LDU = 9 IMBE frames)
+constexpr size_t MAX_VOICE_FRAMES_PER_BATCH = 9;
+constexpr size_t MAX_VOICE_FRAME_BYTES = 11;
+
+// Error-corrected vocoder frames recovered from a traffic channel.
+// Fixed capacity so the decoder can fill it without touching the heap.
+struct VoiceFrameBatch {
+    CodecType codec;
+    TalkgroupID talkgroup;
+    RadioID radio_id;
+    uint8_t slot;           // TDMA slot (0 for FDMA systems)
+    size_t frame_count;
+    size_t frame_bytes;     // Packed bytes per frame, MSB first
+    uint32_t bit_errors;    // Errors corrected across the batch
+    std::array<uint8_t, MAX_VOICE_FRAMES_PER_BATCH * MAX_VOICE_FRAME_BYTES> data;
+
+    const uint8_t* frame(size_t index) const { return data.data() + index * frame_bytes; }
+    uint8_t* frame(size_t index) { return data.data() + index * frame_bytes; }
+};
+
+// Callback for decoded voice frames
+using VoiceFrameCallback = std::function<void(const VoiceFrameBatch&)>;
+
+// Callback for end of a voice transmission (terminator seen)
+using CallEndCallback = std::function<void(TalkgroupID)>;
+
 class BaseDecoder {
 public:
     virtual ~BaseDecoder() = default;
@@ -24,6 +51,17 @@ public:
     virtual SystemType getSystemType() const = 0;
     virtual bool isLocked() const = 0;
 
+    // Talkgroup/source a traffic channel was granted to. Decoders whose
+    // voice bursts carry their own link control can ignore it.
+    virtual void setVoiceTalkgroup(TalkgroupID talkgroup, RadioID source) {
+        (void)talkgroup;
+        (void)source;
+    }
+
+    // Control messages that failed their check so far; zero for decoders
+    // that do not count them
+    virtual size_t getCRCErrors() const { return 0; }
+
     void setGrantCallback(GrantCallback callback) {
         grant_callback_ = callback;
     }
@@ -32,9 +70,19 @@ public:
         system_info_callback_ = callback;
     }
 
+    void setVoiceFrameCallback(VoiceFrameCallback callback) {
+        voice_frame_callback_ = callback;
+    }
+
+    void setCallEndCallback(CallEndCallback callback) {
+        call_end_callback_ = callback;
+    }
+
 protected:
     GrantCallback grant_callback_;
     SystemInfoCallback system_info_callback_;
+    VoiceFrameCallback voice_frame_callback_;
+    CallEndCallback call_end_callback_;
 };
 
 } // namespace TrunkSDR
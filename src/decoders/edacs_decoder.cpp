@@ -0,0 +1,206 @@
+#include "edacs_decoder.h"
+#include "../utils/logger.h"
+#include <ctime>
+
+namespace TrunkSDR {
+
+EDACSDecoder::EDACSDecoder(uint32_t baud_rate)
+    : baud_rate_(baud_rate)
+    , sync_locked_(false)
+    , collecting_(false)
+    , inverted_(false)
+    , sync_register_(0)
+    , bits_since_sync_(0)
+    , site_id_(0)
+    , messages_decoded_(0)
+    , vote_errors_(0)
+    , bch_errors_(0) {
+}
+
+void EDACSDecoder::initialize() {
+    LOG_INFO("EDACS decoder initialized, baud rate =", baud_rate_);
+    reset();
+}
+
+void EDACSDecoder::reset() {
+    sync_locked_ = false;
+    collecting_ = false;
+    inverted_ = false;
+    sync_register_ = 0;
+    bits_since_sync_ = 0;
+    frame_.clear();
+    unknown_channels_.clear();
+    messages_decoded_ = 0;
+    vote_errors_ = 0;
+    bch_errors_ = 0;
+}
+
+void EDACSDecoder::processSymbols(const float* symbols, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        processBit(symbols[i] > 0.5f ? 1 : 0);
+    }
+}
+
+void EDACSDecoder::processBit(uint8_t bit) {
+    if (collecting_) {
+        frame_.push(inverted_ ? bit ^ 1 : bit);
+        if (frame_.full()) {
+            collecting_ = false;
+            processFrame();
+        }
+        return;
+    }
+
+    sync_register_ = ((sync_register_ << 1) | bit) & EDACS_SYNC_MASK;
+
+    // Either FSK polarity is accepted; the frame is read in the polarity
+    // the sync was found in
+    int errors = __builtin_popcountll(sync_register_ ^ EDACS_SYNC);
+    int inverted_errors = __builtin_popcountll(sync_register_ ^ (~EDACS_SYNC & EDACS_SYNC_MASK));
+
+    if (errors <= EDACS_SYNC_ERRORS || inverted_errors <= EDACS_SYNC_ERRORS) {
+        inverted_ = inverted_errors < errors;
+        collecting_ = true;
+        bits_since_sync_ = 0;
+        frame_.clear();
+        return;
+    }
+
+    if (sync_locked_ && ++bits_since_sync_ > EDACS_MAX_BITS_WITHOUT_SYNC) {
+        sync_locked_ = false;
+        LOG_WARNING("EDACS sync lost");
+    }
+}
+
+void EDACSDecoder::processFrame() {
+    for (size_t m = 0; m < 2; m++) {
+        uint64_t message;
+        if (!voteMessage(m * EDACS_MESSAGE_COPIES * EDACS_MESSAGE_BITS, message)) {
+            vote_errors_++;
+            continue;
+        }
+        if (!checkBCH(message)) {
+            bch_errors_++;
+            continue;
+        }
+
+        if (!sync_locked_) {
+            sync_locked_ = true;
+            LOG_INFO("EDACS sync acquired", inverted_ ? "(inverted)" : "");
+        }
+        messages_decoded_++;
+        decodeMessage(message);
+    }
+}
+
+bool EDACSDecoder::voteMessage(size_t start, uint64_t& message) {
+    // Bitwise 2-of-3 vote over the copies; the middle copy is inverted
+    message = 0;
+    size_t disagreements = 0;
+
+    for (size_t i = 0; i < EDACS_MESSAGE_BITS; i++) {
+        uint8_t a = frame_.get(start + i);
+        uint8_t b = frame_.get(start + EDACS_MESSAGE_BITS + i) ^ 1;
+        uint8_t c = frame_.get(start + 2 * EDACS_MESSAGE_BITS + i);
+
+        if (a != b || b != c) {
+            disagreements++;
+        }
+        message = (message << 1) | ((a + b + c) >= 2 ? 1 : 0);
+    }
+
+    // Heavy disagreement between the copies rejects the message before
+    // the BCH check
+    return disagreements <= EDACS_MAX_VOTE_ERRORS;
+}
+
+bool EDACSDecoder::checkBCH(uint64_t message) {
+    // A codeword is a multiple of the generator: divide the whole 40-bit
+    // word and expect no remainder
+    uint64_t remainder = message;
+    for (size_t bit = EDACS_MESSAGE_BITS; bit-- > EDACS_BCH_PARITY_BITS;) {
+        if ((remainder >> bit) & 1) {
+            remainder ^= static_cast<uint64_t>(EDACS_BCH_GENERATOR) << (bit - EDACS_BCH_PARITY_BITS);
+        }
+    }
+    return remainder == 0;
+}
+
+void EDACSDecoder::decodeMessage(uint64_t message) {
+    uint8_t command = static_cast<uint8_t>((message >> 32) & 0xFF);
+    uint32_t lcn = static_cast<uint32_t>((message >> 27) & 0x1F);
+    uint32_t group = static_cast<uint32_t>((message >> 12) & 0x7FF);
+
+    switch (static_cast<EDACSCommand>(command)) {
+        case EDACSCommand::GROUP_VOICE_ASSIGN:
+        case EDACSCommand::DIGITAL_GROUP_ASSIGN:
+        case EDACSCommand::INDIVIDUAL_ASSIGN: {
+            Frequency freq;
+            if (!lookupChannel(lcn, freq)) {
+                return;
+            }
+
+            bool digital = command == static_cast<uint8_t>(EDACSCommand::DIGITAL_GROUP_ASSIGN);
+            LOG_DEBUG("EDACS channel assignment: group =", group, "LCN =", lcn,
+                      digital ? "(ProVoice)" : "(analog)");
+
+            if (grant_callback_) {
+                CallGrant grant;
+                grant.talkgroup = group;
+                grant.radio_id = 0;
+                grant.frequency = freq;
+                grant.slot = 0;
+                grant.type = command == static_cast<uint8_t>(EDACSCommand::INDIVIDUAL_ASSIGN)
+                           ? CallType::PRIVATE : CallType::GROUP;
+                grant.priority = 5;
+                grant.timestamp = std::time(nullptr);
+                grant.encrypted = false;
+
+                grant_callback_(grant);
+            }
+            break;
+        }
+
+        case EDACSCommand::SITE_ID: {
+            // Site ID in the low bits of the group field
+            uint32_t site_id = group & 0xFF;
+            if (site_id != site_id_) {
+                site_id_ = site_id;
+                LOG_INFO("EDACS site ID =", site_id_, "control LCN =", lcn);
+
+                if (system_info_callback_) {
+                    SystemInfo info;
+                    info.type = SystemType::EDACS;
+                    info.system_id = site_id_;
+                    info.nac = 0;
+                    info.wacn = 0;
+                    info.color_code = 0;
+                    info.symbol_rate = baud_rate_;
+                    system_info_callback_(info);
+                }
+            }
+            break;
+        }
+
+        case EDACSCommand::IDLE:
+            break;
+
+        default:
+            LOG_DEBUG("EDACS command", static_cast<int>(command));
+            break;
+    }
+}
+
+bool EDACSDecoder::lookupChannel(uint32_t lcn, Frequency& freq) {
+    auto it = channel_map_.find(lcn);
+    if (it == channel_map_.end()) {
+        if (unknown_channels_.insert(lcn).second) {
+            LOG_WARNING("EDACS LCN", lcn, "not in channel map, grants on it are ignored");
+        }
+        return false;
+    }
+    freq = it->second;
+    return true;
+}
+
+} // namespace TrunkSDR
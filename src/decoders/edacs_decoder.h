@@ -0,0 +1,90 @@
+#ifndef EDACS_DECODER_H
+#define EDACS_DECODER_H
+
+#include "base_decoder.h"
+#include "../utils/bit_buffer.h"
+#include <map>
+#include <set>
+
+namespace TrunkSDR {
+
+// EDACS control channel: 9600 baud (4800 baud on narrowband systems),
+// binary FSK. Each frame is a 48-bit sync followed by two 40-bit messages,
+// each sent three times (normal, inverted, normal):
+//
+//   Sync(48) | M1 | ~M1 | M1 | M2 | ~M2 | M2
+//
+// A message is Command(8) | LCN(5) | Status(4) | Group(11) | BCH(12).
+// The BCH(40,28) code is BCH(63,51) shortened, generator 0x1539.
+constexpr uint64_t EDACS_SYNC = 0x555557125555ULL;
+constexpr uint64_t EDACS_SYNC_MASK = 0xFFFFFFFFFFFFULL;
+constexpr int EDACS_SYNC_ERRORS = 4;
+
+constexpr size_t EDACS_MESSAGE_BITS = 40;
+constexpr size_t EDACS_MESSAGE_COPIES = 3;
+constexpr size_t EDACS_FRAME_BITS = 2 * EDACS_MESSAGE_COPIES * EDACS_MESSAGE_BITS;  // 240 after sync
+constexpr size_t EDACS_MAX_VOTE_ERRORS = 6;  // Bits where the copies disagree
+constexpr size_t EDACS_BCH_PARITY_BITS = 12;
+constexpr uint32_t EDACS_BCH_GENERATOR = 0x1539;  // x^12+x^10+x^8+x^5+x^4+x^3+1
+constexpr size_t EDACS_MAX_BITS_WITHOUT_SYNC = 4 * (48 + EDACS_FRAME_BITS);
+
+// EDACS standard (non extended addressing) commands
+enum class EDACSCommand : uint8_t {
+    GROUP_VOICE_ASSIGN = 0xEC,     // Analog group call
+    DIGITAL_GROUP_ASSIGN = 0xEE,   // ProVoice / encrypted group call
+    INDIVIDUAL_ASSIGN = 0xF8,
+    IDLE = 0xFC,
+    SITE_ID = 0xFD,
+    UNKNOWN = 0xFF
+};
+
+class EDACSDecoder : public BaseDecoder {
+public:
+    explicit EDACSDecoder(uint32_t baud_rate = 9600);
+    ~EDACSDecoder() override = default;
+
+    void initialize() override;
+    void processSymbols(const float* symbols, size_t count) override;
+    void reset() override;
+
+    SystemType getSystemType() const override { return SystemType::EDACS; }
+    bool isLocked() const override { return sync_locked_; }
+
+    // LCN -> frequency (EDACS numbers channels from 1)
+    void setChannelMap(const std::map<uint32_t, Frequency>& channels) { channel_map_ = channels; }
+
+    uint32_t getBaudRate() const { return baud_rate_; }
+    uint32_t getSiteID() const { return site_id_; }
+    size_t getMessagesDecoded() const { return messages_decoded_; }
+    size_t getVoteErrors() const { return vote_errors_; }
+    size_t getCRCErrors() const override { return bch_errors_; }
+
+private:
+    void processBit(uint8_t bit);
+    void processFrame();
+    bool voteMessage(size_t start, uint64_t& message);
+    static bool checkBCH(uint64_t message);
+    void decodeMessage(uint64_t message);
+    bool lookupChannel(uint32_t lcn, Frequency& freq);
+
+    uint32_t baud_rate_;
+
+    bool sync_locked_;
+    bool collecting_;
+    bool inverted_;             // Sync found with reversed polarity
+    uint64_t sync_register_;
+    size_t bits_since_sync_;
+    PackedBitBuffer<EDACS_FRAME_BITS> frame_;
+
+    uint32_t site_id_;
+    std::map<uint32_t, Frequency> channel_map_;
+    std::set<uint32_t> unknown_channels_;  // Reported once each
+
+    size_t messages_decoded_;
+    size_t vote_errors_;
+    size_t bch_errors_;
+};
+
+} // namespace TrunkSDR
+
+#endif // EDACS_DECODER_H
@@ -0,0 +1,163 @@
+#include "ltr_decoder.h"
+#include "../utils/logger.h"
+#include <ctime>
+
+namespace TrunkSDR {
+
+namespace {
+
+// Repeaters stop sending data when they unkey, so a few missing words
+// mean the calls on them are over
+constexpr size_t LTR_MAX_BITS_WITHOUT_WORD = 8 * LTR_WORD_BITS;
+
+} // anonymous namespace
+
+LTRDecoder::LTRDecoder()
+    : sync_locked_(false)
+    , shift_register_(0)
+    , candidate_word_(0)
+    , candidate_age_(0)
+    , bits_since_accept_(0)
+    , free_repeater_(0)
+    , words_decoded_(0) {
+    active_calls_.fill(0);
+}
+
+void LTRDecoder::initialize() {
+    LOG_INFO("LTR decoder initialized");
+    reset();
+}
+
+void LTRDecoder::reset() {
+    sync_locked_ = false;
+    shift_register_ = 0;
+    candidate_word_ = 0;
+    candidate_age_ = 0;
+    bits_since_accept_ = 0;
+    active_calls_.fill(0);
+    free_repeater_ = 0;
+    unknown_channels_.clear();
+    words_decoded_ = 0;
+}
+
+void LTRDecoder::processSymbols(const float* symbols, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        processBit(symbols[i] > 0.5f ? 1 : 0);
+    }
+}
+
+void LTRDecoder::processBit(uint8_t bit) {
+    shift_register_ = ((shift_register_ << 1) | bit) & LTR_WORD_MASK;
+    candidate_age_++;
+    bits_since_accept_++;
+
+    if (sync_locked_ && bits_since_accept_ > LTR_MAX_BITS_WITHOUT_WORD) {
+        sync_locked_ = false;
+        for (uint8_t repeater = 1; repeater <= LTR_MAX_REPEATERS; repeater++) {
+            endCall(repeater);
+        }
+        LOG_INFO("LTR data lost");
+    }
+
+    // Sub-audible data polarity depends on the radio; accept both
+    uint32_t sync = static_cast<uint32_t>(shift_register_ >> (LTR_WORD_BITS - LTR_SYNC_BITS));
+    uint64_t word;
+    if (sync == LTR_SYNC) {
+        word = shift_register_;
+    } else if (sync == (~LTR_SYNC & 0x1FF)) {
+        word = ~shift_register_ & LTR_WORD_MASK;
+    } else {
+        return;
+    }
+
+    // The 7-bit checksum is not verified. A 9-bit sync matches noise
+    // often, so a word only counts when the next word repeats it.
+    uint32_t fields = static_cast<uint32_t>((word >> 7) & 0xFFFFFF);
+    if (candidate_age_ == LTR_WORD_BITS && fields == candidate_word_) {
+        bits_since_accept_ = 0;
+        processWord(fields);
+    }
+    candidate_word_ = fields;
+    candidate_age_ = 0;
+}
+
+void LTRDecoder::processWord(uint32_t fields) {
+    // Area(1) GoTo(5) Home(5) ID(8) Free(5)
+    uint8_t area = (fields >> 23) & 0x01;
+    uint8_t go_to = (fields >> 18) & 0x1F;
+    uint8_t home = (fields >> 13) & 0x1F;
+    uint8_t id = (fields >> 5) & 0xFF;
+    uint8_t free = fields & 0x1F;
+
+    words_decoded_++;
+    if (!sync_locked_) {
+        sync_locked_ = true;
+        LOG_INFO("LTR data acquired");
+    }
+    free_repeater_ = free;
+
+    if (go_to == 0 || go_to > LTR_MAX_REPEATERS) {
+        return;
+    }
+
+    if (id == LTR_ID_IDLE) {
+        endCall(go_to);
+        return;
+    }
+
+    // Words repeat for the whole call; report each call once
+    TalkgroupID talkgroup = makeTalkgroup(area, home, id);
+    if (active_calls_[go_to] == talkgroup) {
+        return;
+    }
+    endCall(go_to);
+    active_calls_[go_to] = talkgroup;
+
+    Frequency freq;
+    if (!lookupChannel(go_to, freq)) {
+        return;
+    }
+
+    LOG_DEBUG("LTR call: TG =", talkgroup, "repeater =", static_cast<int>(go_to),
+              "free =", static_cast<int>(free));
+
+    if (grant_callback_) {
+        CallGrant grant;
+        grant.talkgroup = talkgroup;
+        grant.radio_id = 0;  // Not sent by LTR
+        grant.frequency = freq;
+        grant.slot = 0;
+        grant.type = CallType::GROUP;
+        grant.priority = 5;
+        grant.timestamp = std::time(nullptr);
+        grant.encrypted = false;
+
+        grant_callback_(grant);
+    }
+}
+
+void LTRDecoder::endCall(uint8_t repeater) {
+    TalkgroupID talkgroup = active_calls_[repeater];
+    if (talkgroup == 0) {
+        return;
+    }
+    active_calls_[repeater] = 0;
+
+    if (call_end_callback_) {
+        call_end_callback_(talkgroup);
+    }
+}
+
+bool LTRDecoder::lookupChannel(uint32_t repeater, Frequency& freq) {
+    auto it = channel_map_.find(repeater);
+    if (it == channel_map_.end()) {
+        if (unknown_channels_.insert(repeater).second) {
+            LOG_WARNING("LTR repeater", repeater, "not in channel map, calls on it are ignored");
+        }
+        return false;
+    }
+    freq = it->second;
+    return true;
+}
+
+} // namespace TrunkSDR
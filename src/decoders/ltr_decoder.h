@@ -0,0 +1,76 @@
+#ifndef LTR_DECODER_H
+#define LTR_DECODER_H
+
+#include "base_decoder.h"
+#include <array>
+#include <map>
+#include <set>
+
+namespace TrunkSDR {
+
+// LTR (Logic Trunked Radio) has no control channel. Each repeater sends
+// 300 baud sub-audible data under its voice, one 40-bit word about every
+// 133 ms:
+//
+//   Sync(9) | Area(1) | GoTo(5) | Home(5) | ID(8) | Free(5) | Checksum(7)
+//
+// GoTo is the repeater carrying the call, Home/ID name the talkgroup and
+// Free is the repeater new calls should use.
+constexpr size_t LTR_WORD_BITS = 40;
+constexpr uint64_t LTR_WORD_MASK = 0xFFFFFFFFFFULL;
+constexpr uint32_t LTR_SYNC = 0x158;     // 101011000
+constexpr size_t LTR_SYNC_BITS = 9;
+constexpr uint32_t LTR_SYMBOL_RATE = 300;
+constexpr uint8_t LTR_ID_IDLE = 255;
+constexpr size_t LTR_MAX_REPEATERS = 20;
+
+class LTRDecoder : public BaseDecoder {
+public:
+    LTRDecoder();
+    ~LTRDecoder() override = default;
+
+    void initialize() override;
+    void processSymbols(const float* symbols, size_t count) override;
+    void reset() override;
+
+    SystemType getSystemType() const override { return SystemType::LTR; }
+    bool isLocked() const override { return sync_locked_; }
+
+    // Repeater number (1-20) -> frequency
+    void setChannelMap(const std::map<uint32_t, Frequency>& channels) { channel_map_ = channels; }
+
+    uint8_t getFreeRepeater() const { return free_repeater_; }
+    size_t getWordsDecoded() const { return words_decoded_; }
+
+    // Talkgroups are shown as A-HH-III; this is the same as a number
+    static TalkgroupID makeTalkgroup(uint8_t area, uint8_t home, uint8_t id) {
+        return area * 100000u + home * 1000u + id;
+    }
+
+private:
+    void processBit(uint8_t bit);
+    void processWord(uint32_t fields);
+    void endCall(uint8_t repeater);
+    bool lookupChannel(uint32_t repeater, Frequency& freq);
+
+    bool sync_locked_;
+    uint64_t shift_register_;
+
+    // A word is accepted when the next word repeats it
+    uint32_t candidate_word_;   // Word without sync and checksum
+    size_t candidate_age_;
+    size_t bits_since_accept_;
+
+    // Talkgroup active on each repeater (index = GoTo), 0 = idle
+    std::array<TalkgroupID, LTR_MAX_REPEATERS + 1> active_calls_;
+    uint8_t free_repeater_;
+
+    std::map<uint32_t, Frequency> channel_map_;
+    std::set<uint32_t> unknown_channels_;  // Reported once each
+
+    size_t words_decoded_;
+};
+
+} // namespace TrunkSDR
+
+#endif // LTR_DECODER_H
@@ -1,112 +1,350 @@
 #include "p25_decoder.h"
 #include "../utils/logger.h"
 #include <cstring>
+#include <ctime>
 #include <cmath>
 
 namespace TrunkSDR {
 
+namespace {
+
+// C4FMDemodulator symbol (0 = -3 ... 3 = +3) to P25 dibit (+3 = 01,
+// +1 = 00, -1 = 10, -3 = 11)
+constexpr uint8_t SYMBOL_TO_DIBIT[4] = {3, 2, 0, 1};
+
+// IMBE interleave schedule: codeword bit index for each transmitted bit
+// of the 144-bit frame (c0..c7 concatenated, MSB first)
+constexpr uint8_t IMBE_INTERLEAVE[P25_IMBE_CODEWORD_BITS] = {
+      0,  24,  48,  72,  96, 120,  25,   1,  73,  49, 121,  97,
+      2,  26,  50,  74,  98, 122,  27,   3,  75,  51, 123,  99,
+      4,  28,  52,  76, 100, 124,  29,   5,  77,  53, 125, 101,
+      6,  30,  54,  78, 102, 126,  31,   7,  79,  55, 127, 103,
+      8,  32,  56,  80, 104, 128,  33,   9,  81,  57, 129, 105,
+     10,  34,  58,  82, 106, 130,  35,  11,  83,  59, 131, 107,
+     12,  36,  60,  84, 108, 132,  37,  13,  85,  61, 133, 109,
+     14,  38,  62,  86, 110, 134,  39,  15,  87,  63, 135, 111,
+     16,  40,  64,  88, 112, 136,  41,  17,  89,  65, 137, 113,
+     18,  42,  66,  90, 114, 138,  43,  19,  91,  67, 139, 115,
+     20,  44,  68,  92, 116, 140,  45,  21,  93,  69, 141, 117,
+     22,  46,  70,  94, 118, 142,  47,  23,  95,  71, 143, 119,
+};
+
+// Start of each IMBE codeword within the LDU data bits (after NID).
+// Link control / low speed data words sit between voice frames 2-9.
+constexpr size_t LDU_IMBE_OFFSETS[P25_IMBE_FRAMES_PER_LDU] = {
+    0, 144, 328, 512, 696, 880, 1064, 1248, 1424
+};
+
+// Code vector lengths: c0-c3 Golay(23,12), c4-c6 Hamming(15,11), c7 uncoded
+constexpr size_t IMBE_VECTOR_BITS[8] = { 23, 23, 23, 23, 15, 15, 15, 7 };
+constexpr size_t IMBE_INFO_BITS[8] = { 12, 12, 12, 12, 11, 11, 11, 7 };
+
+constexpr uint32_t GOLAY_2312_POLY = 0xC75;
+
+// Hamming(15,11) parity check rows (data in bits 14..4, parity in 3..0)
+constexpr uint16_t HAMMING_1511_CHECK[4] = { 0x7F08, 0x78E4, 0x66D2, 0x55B1 };
+
+uint32_t golayRemainder(uint32_t codeword) {
+    for (int bit = 22; bit >= 11; bit--) {
+        if (codeword & (1u << bit)) {
+            codeword ^= GOLAY_2312_POLY << (bit - 11);
+        }
+    }
+    return codeword & 0x7FF;
+}
+
+// Syndrome -> error pattern for every pattern of weight <= 3 (the code is
+// perfect, so all 2048 syndromes are covered)
+const std::array<uint32_t, 2048>& golaySyndromeTable() {
+    static const std::array<uint32_t, 2048> table = [] {
+        std::array<uint32_t, 2048> t{};
+        for (int a = 0; a < 23; a++) {
+            uint32_t e1 = 1u << a;
+            t[golayRemainder(e1)] = e1;
+            for (int b = a + 1; b < 23; b++) {
+                uint32_t e2 = e1 | (1u << b);
+                t[golayRemainder(e2)] = e2;
+                for (int c = b + 1; c < 23; c++) {
+                    uint32_t e3 = e2 | (1u << c);
+                    t[golayRemainder(e3)] = e3;
+                }
+            }
+        }
+        return t;
+    }();
+    return table;
+}
+
+// Syndrome -> bit position to flip (-1 for none)
+const std::array<int8_t, 16>& hammingSyndromeTable() {
+    static const std::array<int8_t, 16> table = [] {
+        std::array<int8_t, 16> t;
+        t.fill(-1);
+        for (int bit = 0; bit < 15; bit++) {
+            uint8_t syndrome = 0;
+            for (int row = 0; row < 4; row++) {
+                syndrome = (syndrome << 1) | ((HAMMING_1511_CHECK[row] >> bit) & 1);
+            }
+            t[syndrome] = static_cast<int8_t>(bit);
+        }
+        return t;
+    }();
+    return table;
+}
+
+// TSBK/data block interleave: received constellation point (4 bits) for
+// each decoded point
+constexpr size_t TSBK_POINTS = P25_TSBK_DATA_BITS / 4;
+constexpr uint8_t TSBK_DEINTERLEAVE[TSBK_POINTS] = {
+     0, 13, 25, 37,  1, 14, 26, 38,  2, 15, 27, 39,  3, 16, 28, 40,
+     4, 17, 29, 41,  5, 18, 30, 42,  6, 19, 31, 43,  7, 20, 32, 44,
+     8, 21, 33, 45,  9, 22, 34, 46, 10, 23, 35, 47, 11, 24, 36, 48,
+    12,
+};
+
+// Rate 1/2 trellis: dibit pair sent (as a nibble) for each state, which
+// is the previous input dibit, and input dibit
+constexpr uint8_t TRELLIS_HALF_RATE[4][4] = {
+    { 0x2, 0xC, 0x1, 0xF },
+    { 0xE, 0x0, 0xD, 0x3 },
+    { 0x9, 0x7, 0xA, 0x4 },
+    { 0x5, 0xB, 0x6, 0x8 },
+};
+
+// Viterbi decode of the 49 points into 96 bits (the 49th input dibit
+// flushes the encoder back to state 0). Returns the bit errors on the
+// chosen path.
+size_t trellisDecode(const uint8_t* points, uint8_t* bits) {
+    constexpr size_t UNREACHED = SIZE_MAX / 2;
+    size_t metric[4] = { 0, UNREACHED, UNREACHED, UNREACHED };
+    uint8_t from[TSBK_POINTS][4];
+
+    for (size_t t = 0; t < TSBK_POINTS; t++) {
+        size_t next[4] = { UNREACHED, UNREACHED, UNREACHED, UNREACHED };
+        for (int state = 0; state < 4; state++) {
+            if (metric[state] >= UNREACHED) {
+                continue;
+            }
+            for (int input = 0; input < 4; input++) {
+                size_t m = metric[state] +
+                           __builtin_popcount(points[t] ^ TRELLIS_HALF_RATE[state][input]);
+                if (m < next[input]) {
+                    next[input] = m;
+                    from[t][input] = static_cast<uint8_t>(state);
+                }
+            }
+        }
+        std::memcpy(metric, next, sizeof(metric));
+    }
+
+    // The state after each step is that step's input dibit
+    uint8_t state = 0;
+    for (size_t t = TSBK_POINTS; t-- > 0;) {
+        if (t < TSBK_POINTS - 1) {
+            bits[2 * t] = (state >> 1) & 1;
+            bits[2 * t + 1] = state & 1;
+        }
+        state = from[t][state];
+    }
+    return metric[0];
+}
+
+// CRC-CCITT (x^16 + x^12 + x^5 + 1, zero preset, inverted) over bits
+uint16_t crcCCITT(const uint8_t* bits, size_t count) {
+    uint16_t crc = 0;
+    for (size_t i = 0; i < count; i++) {
+        bool feedback = ((crc >> 15) ^ bits[i]) & 1;
+        crc <<= 1;
+        if (feedback) {
+            crc ^= 0x1021;
+        }
+    }
+    return crc ^ 0xFFFF;
+}
+
+} // namespace
+
 P25Decoder::P25Decoder()
     : sync_locked_(false)
     , expected_nac_(0)
     , current_nac_(0)
     , wacn_(0)
     , system_id_(0)
+    , unknown_identifiers_(0)
+    , sync_register_(0)
+    , in_frame_(false)
+    , frame_dibit_index_(0)
+    , frame_bit_count_(0)
+    , frame_expected_bits_(0)
+    , frame_duid_(P25DUID::UNKNOWN)
+    , dibits_since_sync_(0)
     , sync_errors_(0)
     , sync_threshold_(3)
+    , voice_active_(false)
+    , voice_talkgroup_(0)
+    , voice_source_(0)
     , frames_decoded_(0)
-    , errors_corrected_(0) {
+    , errors_corrected_(0)
+    , voice_frames_decoded_(0)
+    , crc_errors_(0) {
 }
 
 void P25Decoder::initialize() {
     LOG_INFO("P25 decoder initialized");
     reset();
+
+    // Learned tables survive reset(); only the cache replaces them
+    if (!site_cache_file_.empty()) {
+        site_tables_.load(site_cache_file_, expected_nac_);
+    }
 }
 
 void P25Decoder::reset() {
     sync_locked_ = false;
-    bit_buffer_.clear();
-    frame_buffer_.clear();
+    sync_register_ = 0;
+    in_frame_ = false;
+    frame_dibit_index_ = 0;
+    frame_bit_count_ = 0;
+    frame_expected_bits_ = 0;
+    frame_duid_ = P25DUID::UNKNOWN;
+    dibits_since_sync_ = 0;
     sync_errors_ = 0;
+    voice_active_ = false;
     frames_decoded_ = 0;
     errors_corrected_ = 0;
+    voice_frames_decoded_ = 0;
+    crc_errors_ = 0;
+}
+
+void P25Decoder::setVoiceTalkgroup(TalkgroupID talkgroup, RadioID source) {
+    voice_talkgroup_ = talkgroup;
+    voice_source_ = source;
 }
 
 void P25Decoder::processSymbols(const float* symbols, size_t count) {
     for (size_t i = 0; i < count; i++) {
-        // Convert C4FM symbol (0, 1, 2, 3) to dibits
-        int symbol = static_cast<int>(symbols[i]);
-
-        // Extract two bits from symbol
-        uint8_t bit1 = (symbol >> 1) & 1;
-        uint8_t bit2 = symbol & 1;
+        int sym = static_cast<int>(symbols[i]) & 0x3;
+        processDibit(SYMBOL_TO_DIBIT[sym]);
+    }
+}
 
-        bit_buffer_.push_back(bit1);
-        bit_buffer_.push_back(bit2);
+void P25Decoder::processDibit(uint8_t dibit) {
+    sync_register_ = ((sync_register_ << 2) | dibit) & P25_FRAME_SYNC_MASK;
 
-        // Keep buffer size manageable
-        while (bit_buffer_.size() > 10000) {
-            bit_buffer_.pop_front();
-        }
-
-        // Try to find frame sync
-        if (!sync_locked_ || sync_errors_ > sync_threshold_) {
-            if (detectFrameSync(bit_buffer_)) {
-                sync_locked_ = true;
-                sync_errors_ = 0;
+    if (!in_frame_) {
+        // Allow up to 4 bit errors in sync
+        int bit_errors = __builtin_popcountll(sync_register_ ^ P25_FRAME_SYNC_1);
+        if (bit_errors <= 4) {
+            if (!sync_locked_) {
                 LOG_INFO("P25 frame sync acquired");
             }
+            sync_locked_ = true;
+            sync_errors_ = 0;
+            dibits_since_sync_ = 0;
+
+            in_frame_ = true;
+            frame_dibit_index_ = P25_SYNC_DIBITS - 1;
+            frame_bit_count_ = 0;
+            frame_expected_bits_ = P25_NID_BITS;
+            return;
         }
 
-        // Process frames when locked
-        if (sync_locked_ && bit_buffer_.size() >= 1728) {  // Full P25 frame
-            // Extract NID (64 bits after sync)
-            uint8_t nid_bits[64];
-            for (int j = 0; j < 64; j++) {
-                nid_bits[j] = bit_buffer_[48 + j];
-            }
+        // No sync for two full LDUs: drop lock
+        if (sync_locked_ && ++dibits_since_sync_ > 2 * P25_LDU_DIBITS) {
+            sync_locked_ = false;
+            LOG_INFO("P25 frame sync lost");
+        }
+        return;
+    }
 
-            if (processNID(nid_bits)) {
-                // Process based on DUID
-                P25DUID duid = extractDUID(nid_bits);
-
-                if (duid == P25DUID::TRUNKING_SIGNALING_BLOCK) {
-                    // Extract TSBK data
-                    std::vector<uint8_t> tsbk_data(144);  // 144 bits
-                    for (size_t j = 0; j < 144; j++) {
-                        tsbk_data[j] = bit_buffer_[112 + j];
-                    }
-                    processTSBK(tsbk_data.data(), 144);
-                }
+    // Skip the status symbol that ends each 36-dibit period
+    frame_dibit_index_++;
+    if ((frame_dibit_index_ + 1) % P25_STATUS_INTERVAL == 0) {
+        return;
+    }
 
-                frames_decoded_++;
-                bit_buffer_.erase(bit_buffer_.begin(), bit_buffer_.begin() + 1728);
-            } else {
-                sync_errors_++;
-                bit_buffer_.pop_front();
-            }
+    pushFrameBit((dibit >> 1) & 1);
+    pushFrameBit(dibit & 1);
+}
+
+void P25Decoder::pushFrameBit(uint8_t bit) {
+    if (!in_frame_) {
+        return;
+    }
+
+    frame_bits_[frame_bit_count_++] = bit;
+
+    if (frame_bit_count_ == P25_NID_BITS) {
+        if (!processNID(frame_bits_.data())) {
+            sync_errors_++;
+            in_frame_ = false;
+            return;
+        }
+
+        frame_duid_ = extractDUID(frame_bits_.data());
+        size_t data_bits = expectedDataBits(frame_duid_);
+        if (data_bits == 0) {
+            sync_errors_++;
+            in_frame_ = false;
+            return;
         }
+        frame_expected_bits_ = P25_NID_BITS + data_bits;
+    }
+
+    if (frame_bit_count_ == frame_expected_bits_ && frame_bit_count_ > P25_NID_BITS) {
+        in_frame_ = false;
+        dispatchFrame();
+    }
+}
+
+size_t P25Decoder::expectedDataBits(P25DUID duid) const {
+    switch (duid) {
+        case P25DUID::HEADER_DATA_UNIT:          return P25_HDU_DATA_BITS;
+        case P25DUID::TERMINATOR_DATA_UNIT:      return P25_TDU_DATA_BITS;
+        case P25DUID::LOGICAL_LINK_DATA_UNIT_1:
+        case P25DUID::LOGICAL_LINK_DATA_UNIT_2:  return P25_LDU_DATA_BITS;
+        case P25DUID::TRUNKING_SIGNALING_BLOCK:
+        case P25DUID::PDU:                       return P25_TSBK_DATA_BITS;
+        case P25DUID::TERMINATOR_WITH_LC:        return P25_TDULC_DATA_BITS;
+        default:                                 return 0;
     }
 }
 
-bool P25Decoder::detectFrameSync(const std::deque<uint8_t>& bit_buffer) {
-    if (bit_buffer.size() < 48) return false;
+void P25Decoder::dispatchFrame() {
+    const uint8_t* data = frame_bits_.data() + P25_NID_BITS;
+
+    switch (frame_duid_) {
+        case P25DUID::TRUNKING_SIGNALING_BLOCK: {
+            // Up to three blocks follow the NID; collect the next one
+            // unless this one was marked last
+            size_t block = (frame_bit_count_ - P25_NID_BITS) / P25_TSBK_DATA_BITS - 1;
+            if (processTSBK(data + block * P25_TSBK_DATA_BITS) && block + 1 < P25_MAX_TSBKS) {
+                in_frame_ = true;
+                frame_expected_bits_ += P25_TSBK_DATA_BITS;
+                return;
+            }
+            break;
+        }
 
-    // Check for P25 frame sync pattern
-    uint64_t sync_pattern = bitsToU64(bit_buffer, 0, 48);
+        case P25DUID::HEADER_DATA_UNIT:
+            voice_active_ = true;
+            break;
 
-    // Allow for some bit errors in sync
-    uint64_t xor_result = sync_pattern ^ P25_FRAME_SYNC_1;
-    int bit_errors = __builtin_popcountll(xor_result);
+        case P25DUID::LOGICAL_LINK_DATA_UNIT_1:
+        case P25DUID::LOGICAL_LINK_DATA_UNIT_2:
+            processLDU(frame_duid_, data);
+            break;
 
-    return bit_errors <= 4;  // Allow up to 4 bit errors
-}
+        case P25DUID::TERMINATOR_DATA_UNIT:
+        case P25DUID::TERMINATOR_WITH_LC:
+            processTerminator();
+            break;
 
-uint64_t P25Decoder::bitsToU64(const std::deque<uint8_t>& bits, size_t start, size_t count) {
-    uint64_t result = 0;
-    for (size_t i = 0; i < count && (start + i) < bits.size(); i++) {
-        result = (result << 1) | (bits[start + i] & 1);
+        default:
+            break;
     }
-    return result;
+
+    frames_decoded_++;
 }
 
 bool P25Decoder::processNID(const uint8_t* bits) {
@@ -130,85 +368,394 @@ uint16_t P25Decoder::extractNAC(const uint8_t* bits) {
 }
 
 P25DUID P25Decoder::extractDUID(const uint8_t* bits) {
-    // DUID is 4 bits at position 60-63
+    // DUID is 4 bits following the NAC (positions 12-15)
     uint8_t duid = 0;
     for (int i = 0; i < 4; i++) {
-        duid = (duid << 1) | (bits[60 + i] & 1);
+        duid = (duid << 1) | (bits[12 + i] & 1);
     }
     return static_cast<P25DUID>(duid);
 }
 
-void P25Decoder::processTSBK(const uint8_t* bits, size_t length) {
-    // Extract opcode (6 bits)
-    uint8_t opcode = bitsToUint32(bits, 0, 6);
+bool P25Decoder::processTSBK(const uint8_t* block) {
+    // Undo the block interleave (in 4-bit constellation points), then
+    // the rate 1/2 trellis code
+    uint8_t points[TSBK_POINTS];
+    for (size_t i = 0; i < TSBK_POINTS; i++) {
+        const uint8_t* bits = block + TSBK_DEINTERLEAVE[i] * 4;
+        points[i] = (bits[0] << 3) | (bits[1] << 2) | (bits[2] << 1) | bits[3];
+    }
+
+    std::array<uint8_t, P25_TSBK_BITS> bits;
+    size_t bit_errors = trellisDecode(points, bits.data());
+
+    if (crcCCITT(bits.data(), P25_TSBK_CRC_OFFSET) !=
+        bitsToUint32(bits.data(), P25_TSBK_CRC_OFFSET, 16)) {
+        crc_errors_++;
+        LOG_DEBUG("P25 TSBK failed CRC");
+        return false;
+    }
+    errors_corrected_ += bit_errors;
+
+    bool last = bits[0];
+    bool protected_block = bits[1];
+    uint8_t opcode = bitsToUint32(bits.data(), 2, 6);
+    uint8_t mfid = bitsToUint32(bits.data(), 8, 8);
+    const uint8_t* args = bits.data() + P25_TSBK_ARGS_OFFSET;
+
+    LOG_DEBUG("P25 TSBK opcode:", std::hex, static_cast<int>(opcode),
+              "MFID:", static_cast<int>(mfid));
 
-    LOG_DEBUG("P25 TSBK opcode:", std::hex, static_cast<int>(opcode));
+    // Manufacturer opcodes overlap the standard ones, and protected
+    // blocks carry encrypted arguments
+    if (mfid != P25_MFID_STANDARD || protected_block) {
+        return !last;
+    }
 
     switch (static_cast<P25Opcode>(opcode)) {
         case P25Opcode::GROUP_VOICE_GRANT:
+            processGroupVoiceGrant(args);
+            break;
+
         case P25Opcode::GROUP_VOICE_UPDATE:
-            processGroupVoiceGrant(bits);
+            processGroupVoiceUpdate(args);
             break;
 
         case P25Opcode::IDENTIFIER_UPDATE:
-            processIdentifierUpdate(bits);
+        case P25Opcode::IDENTIFIER_UPDATE_VU:
+        case P25Opcode::IDENTIFIER_UPDATE_TDMA:
+            processIdentifierUpdate(static_cast<P25Opcode>(opcode), args);
+            break;
+
+        case P25Opcode::RFSS_STATUS_BROADCAST:
+            processRFSSStatus(args);
+            break;
+
+        case P25Opcode::NETWORK_STATUS_BROADCAST:
+            processNetworkStatus(args);
+            break;
+
+        case P25Opcode::ADJACENT_SITE_STATUS_BROADCAST:
+            processAdjacentSiteStatus(args);
             break;
 
         default:
             LOG_DEBUG("Unhandled P25 opcode:", std::hex, static_cast<int>(opcode));
             break;
     }
+
+    return !last;
 }
 
 void P25Decoder::processGroupVoiceGrant(const uint8_t* data) {
-    // Extract fields from Group Voice Grant
-    // Format: Opcode(6) | Options(8) | Service(8) | Frequency(12) | Group(16) | Source(24)
+    // Options(8) | Channel(16) | Group(16) | Source(24)
+    uint8_t options = bitsToUint32(data, 0, 8);
+    uint16_t channel = bitsToUint32(data, 8, 16);
+    uint16_t talkgroup = bitsToUint32(data, 24, 16);
+    uint32_t source = bitsToUint32(data, 40, 24);
+
+    LOG_INFO("P25 Voice Grant: TG =", talkgroup, "Source =", source, "Channel =", channel);
+
+    emitGrant(talkgroup, source, channel, (options & 0x40) != 0);
+}
 
-    uint8_t options = bitsToUint32(data, 6, 8);
-    uint16_t freq_id = bitsToUint32(data, 22, 12);
-    uint16_t talkgroup = bitsToUint32(data, 34, 16);
-    uint32_t source = bitsToUint32(data, 50, 24);
+void P25Decoder::processGroupVoiceUpdate(const uint8_t* data) {
+    // Channel A(16) | Group A(16) | Channel B(16) | Group B(16)
+    uint16_t channel_a = bitsToUint32(data, 0, 16);
+    uint16_t group_a = bitsToUint32(data, 16, 16);
+    uint16_t channel_b = bitsToUint32(data, 32, 16);
+    uint16_t group_b = bitsToUint32(data, 48, 16);
 
-    // Look up frequency from identifier table
-    Frequency frequency = 0;
-    if (frequency_table_.count(freq_id & 0xFF)) {
-        frequency = frequency_table_[freq_id & 0xFF];
+    emitGrant(group_a, 0, channel_a, false);
+    if (channel_b != channel_a || group_b != group_a) {
+        emitGrant(group_b, 0, channel_b, false);
     }
+}
 
-    LOG_INFO("P25 Voice Grant: TG =", talkgroup, "Source =", source, "Freq ID =", freq_id);
+void P25Decoder::emitGrant(TalkgroupID talkgroup, RadioID source, uint16_t channel,
+                           bool encrypted) {
+    Frequency frequency;
+    uint8_t slot;
+    if (!site_tables_.channelToFrequency(channel, frequency, slot)) {
+        uint16_t identifier_bit = static_cast<uint16_t>(1u << (channel >> 12));
+        if (!(unknown_identifiers_ & identifier_bit)) {
+            unknown_identifiers_ |= identifier_bit;
+            LOG_WARNING("P25 channel identifier", channel >> 12,
+                        "not yet announced, grants on it are ignored");
+        }
+        return;
+    }
 
-    // Create call grant
-    if (grant_callback_ && frequency > 0) {
+    if (grant_callback_) {
         CallGrant grant;
         grant.talkgroup = talkgroup;
         grant.radio_id = source;
         grant.frequency = frequency;
+        // TDMA slots are numbered from 1, FDMA channels use 0
+        grant.slot = site_tables_.getIdentifier(channel >> 12).slots > 1 ? slot + 1 : 0;
         grant.type = CallType::GROUP;
         grant.priority = 5;  // Default priority
         grant.timestamp = std::time(nullptr);
-        grant.encrypted = (options & 0x40) != 0;
+        grant.encrypted = encrypted;
 
         grant_callback_(grant);
     }
 }
 
-void P25Decoder::processIdentifierUpdate(const uint8_t* data) {
-    // Identifier Update provides frequency table
-    // Format varies, simplified implementation
+void P25Decoder::processIdentifierUpdate(P25Opcode opcode, const uint8_t* data) {
+    // IDEN_UP:      Identifier(4) | BW(9)   | Offset sign(1) | Offset(8)  | Spacing(10) | Base(32)
+    // IDEN_UP_VU:   Identifier(4) | BW(4)   | Offset sign(1) | Offset(13) | Spacing(10) | Base(32)
+    // IDEN_UP_TDMA: Identifier(4) | Type(4) | Offset sign(1) | Offset(13) | Spacing(10) | Base(32)
+    // Base is in 5 Hz units, spacing in 125 Hz units
+    uint8_t identifier = bitsToUint32(data, 0, 4);
+    uint32_t spacing_units = bitsToUint32(data, 22, 10);
+    uint32_t base_units = bitsToUint32(data, 32, 32);
+
+    P25ChannelIdentifier entry;
+    entry.base = base_units * 5.0;
+    entry.spacing = spacing_units * 125.0;
+    entry.slots = 1;
+    entry.valid = true;
+
+    bool offset_positive;
+    if (opcode == P25Opcode::IDENTIFIER_UPDATE) {
+        // Bandwidth in 125 Hz units, transmit offset in 250 kHz units
+        entry.bandwidth = bitsToUint32(data, 4, 9) * 125.0;
+        offset_positive = data[13] & 1;
+        entry.tx_offset = bitsToUint32(data, 14, 8) * 250000.0;
+    } else {
+        // Transmit offset in channel spacing units
+        uint8_t code = bitsToUint32(data, 4, 4);
+        offset_positive = data[8] & 1;
+        entry.tx_offset = bitsToUint32(data, 9, 13) * entry.spacing;
+
+        if (opcode == P25Opcode::IDENTIFIER_UPDATE_VU) {
+            entry.bandwidth = code == 0x4 ? 6250.0 : 12500.0;
+        } else {
+            // Channel type: FDMA 6.25/12.5 kHz, or TDMA carrying 2 or 4 slots
+            static constexpr uint8_t TDMA_SLOTS[] = { 1, 1, 1, 2, 4, 2 };
+            static constexpr Frequency TDMA_BANDWIDTH[] = {
+                6250.0, 12500.0, 6250.0, 12500.0, 25000.0, 12500.0
+            };
+            if (code >= sizeof(TDMA_SLOTS)) {
+                LOG_DEBUG("P25 IDEN_UP_TDMA: unknown channel type", static_cast<int>(code));
+                return;
+            }
+            entry.slots = TDMA_SLOTS[code];
+            entry.bandwidth = TDMA_BANDWIDTH[code];
+        }
+    }
+    if (!offset_positive) {
+        entry.tx_offset = -entry.tx_offset;
+    }
+
+    if (site_tables_.updateIdentifier(identifier, entry)) {
+        unknown_identifiers_ &= static_cast<uint16_t>(~(1u << identifier));
+        LOG_INFO("P25 Identifier Update: ID =", static_cast<int>(identifier),
+                 "Base =", entry.base, "Hz Spacing =", entry.spacing,
+                 "Hz Slots =", static_cast<int>(entry.slots));
+        siteTablesChanged();
+    }
+}
+
+void P25Decoder::processRFSSStatus(const uint8_t* data) {
+    // LRA(8) | Flags(4) | System(12) | RFSS(8) | Site(8) | Channel(16) | Service class(8)
+    P25RFSSStatus status;
+    status.system_id = bitsToUint32(data, 12, 12);
+    status.rfss_id = bitsToUint32(data, 24, 8);
+    status.site_id = bitsToUint32(data, 32, 8);
+    status.channel = bitsToUint32(data, 40, 16);
+    status.service_class = bitsToUint32(data, 56, 8);
+    status.valid = true;
+
+    if (site_tables_.updateRFSSStatus(status)) {
+        LOG_INFO("P25 RFSS status: System =", status.system_id,
+                 "RFSS =", static_cast<int>(status.rfss_id),
+                 "Site =", static_cast<int>(status.site_id));
+        siteTablesChanged();
+    }
+}
 
-    uint8_t identifier = bitsToUint32(data, 6, 4);
-    uint32_t base_freq = bitsToUint32(data, 10, 32);
-    uint16_t spacing = bitsToUint32(data, 42, 10);
-    uint16_t offset = bitsToUint32(data, 52, 10);
+void P25Decoder::processNetworkStatus(const uint8_t* data) {
+    // LRA(8) | WACN(20) | System(12) | Channel(16) | Service class(8)
+    P25NetworkStatus status;
+    status.wacn = bitsToUint32(data, 8, 20);
+    status.system_id = bitsToUint32(data, 28, 12);
+    status.channel = bitsToUint32(data, 40, 16);
+    status.service_class = bitsToUint32(data, 56, 8);
+    status.valid = true;
+
+    // Tables loaded from the cache (or learned before a retune) belong to
+    // another network if the identity changed
+    const P25NetworkStatus& known = site_tables_.getNetworkStatus();
+    if (known.valid && (known.wacn != status.wacn || known.system_id != status.system_id)) {
+        LOG_WARNING("P25 network changed, discarding learned site tables");
+        site_tables_.clear();
+        unknown_identifiers_ = 0;
+    }
 
-    // Convert to actual frequency (Hz)
-    // P25 uses 5 kHz channel spacing by default
-    Frequency freq = base_freq * 5000.0;
+    if (site_tables_.updateNetworkStatus(status)) {
+        siteTablesChanged();
+    }
+    updateSystemIdentity(status.wacn, status.system_id);
+}
 
-    frequency_table_[identifier] = freq;
+void P25Decoder::processAdjacentSiteStatus(const uint8_t* data) {
+    // LRA(8) | CFVA(4) | System(12) | RFSS(8) | Site(8) | Channel(16) | Service class(8)
+    P25AdjacentSite site;
+    site.flags = bitsToUint32(data, 8, 4);
+    site.system_id = bitsToUint32(data, 12, 12);
+    site.rfss_id = bitsToUint32(data, 24, 8);
+    site.site_id = bitsToUint32(data, 32, 8);
+    site.channel = bitsToUint32(data, 40, 16);
+    site.service_class = bitsToUint32(data, 56, 8);
+    site.valid = true;
+
+    if (site_tables_.updateAdjacentSite(site)) {
+        LOG_DEBUG("P25 adjacent site: RFSS =", static_cast<int>(site.rfss_id),
+                  "Site =", static_cast<int>(site.site_id), "Channel =", site.channel);
+        siteTablesChanged();
+    }
+}
+
+void P25Decoder::updateSystemIdentity(uint32_t wacn, uint16_t system_id) {
+    if (wacn == wacn_ && system_id == system_id_) {
+        return;
+    }
+    wacn_ = wacn;
+    system_id_ = system_id;
+    LOG_INFO("P25 network: System =", system_id_, "WACN =", std::hex, wacn_);
+
+    if (system_info_callback_) {
+        SystemInfo info;
+        info.type = SystemType::P25_PHASE1;
+        info.system_id = system_id_;
+        info.nac = current_nac_;
+        info.wacn = wacn_;
+        info.color_code = 0;
+        info.symbol_rate = 4800;
+        system_info_callback_(info);
+    }
+}
 
-    LOG_DEBUG("P25 Identifier Update: ID =", static_cast<int>(identifier),
-              "Freq =", freq, "Hz");
+void P25Decoder::siteTablesChanged() {
+    // Tables change a handful of times after a site is first heard and
+    // then stay put; the writer saves them off the decode thread
+    if (!site_cache_file_.empty()) {
+        site_cache_writer_.submit(site_tables_, expected_nac_ ? expected_nac_ : current_nac_);
+    }
+}
+
+void P25Decoder::processLDU(P25DUID duid, const uint8_t* bits) {
+    voice_active_ = true;
+
+    // Decode all nine IMBE frames of the LDU as one batch
+    voice_batch_.codec = CodecType::IMBE;
+    voice_batch_.talkgroup = voice_talkgroup_;
+    voice_batch_.radio_id = voice_source_;
+    voice_batch_.slot = 0;
+    voice_batch_.frame_count = P25_IMBE_FRAMES_PER_LDU;
+    voice_batch_.frame_bytes = P25_IMBE_FRAME_BYTES;
+    voice_batch_.bit_errors = 0;
+
+    for (size_t i = 0; i < P25_IMBE_FRAMES_PER_LDU; i++) {
+        voice_batch_.bit_errors += decodeIMBEFrame(bits + LDU_IMBE_OFFSETS[i],
+                                                   voice_batch_.frame(i));
+    }
+
+    errors_corrected_ += voice_batch_.bit_errors;
+    voice_frames_decoded_ += P25_IMBE_FRAMES_PER_LDU;
+
+    LOG_DEBUG("P25", duid == P25DUID::LOGICAL_LINK_DATA_UNIT_1 ? "LDU1" : "LDU2",
+              "TG =", voice_talkgroup_, "errors =", voice_batch_.bit_errors);
+
+    if (voice_frame_callback_) {
+        voice_frame_callback_(voice_batch_);
+    }
+}
+
+uint32_t P25Decoder::decodeIMBEFrame(const uint8_t* codeword_bits, uint8_t* packed) {
+    // Deinterleave into c0..c7
+    uint8_t codeword[P25_IMBE_CODEWORD_BITS];
+    for (size_t i = 0; i < P25_IMBE_CODEWORD_BITS; i++) {
+        codeword[IMBE_INTERLEAVE[i]] = codeword_bits[i];
+    }
+
+    uint32_t vectors[8];
+    size_t pos = 0;
+    for (size_t v = 0; v < 8; v++) {
+        vectors[v] = bitsToUint32(codeword, pos, IMBE_VECTOR_BITS[v]);
+        pos += IMBE_VECTOR_BITS[v];
+    }
+
+    uint32_t errors = 0;
+    uint32_t info[8];
+    info[0] = decodeGolay2312(vectors[0], errors);
+
+    // c1..c6 are modulated by a PN sequence seeded from u0
+    uint32_t pn = info[0] << 4;
+    for (size_t v = 1; v < 7; v++) {
+        uint32_t mask = 0;
+        for (size_t b = 0; b < IMBE_VECTOR_BITS[v]; b++) {
+            pn = (173 * pn + 13849) & 0xFFFF;
+            mask = (mask << 1) | (pn >> 15);
+        }
+        vectors[v] ^= mask;
+    }
+
+    for (size_t v = 1; v < 4; v++) {
+        info[v] = decodeGolay2312(vectors[v], errors);
+    }
+    for (size_t v = 4; v < 7; v++) {
+        info[v] = decodeHamming1511(vectors[v], errors);
+    }
+    info[7] = vectors[7];
+
+    // Pack u0..u7 (88 bits) MSB first
+    std::memset(packed, 0, P25_IMBE_FRAME_BYTES);
+    size_t out_bit = 0;
+    for (size_t v = 0; v < 8; v++) {
+        for (int b = static_cast<int>(IMBE_INFO_BITS[v]) - 1; b >= 0; b--) {
+            if ((info[v] >> b) & 1) {
+                packed[out_bit / 8] |= 0x80 >> (out_bit % 8);
+            }
+            out_bit++;
+        }
+    }
+
+    return errors;
+}
+
+void P25Decoder::processTerminator() {
+    if (!voice_active_) {
+        return;
+    }
+
+    voice_active_ = false;
+    LOG_DEBUG("P25 voice terminator: TG =", voice_talkgroup_);
+
+    if (call_end_callback_) {
+        call_end_callback_(voice_talkgroup_);
+    }
+}
+
+uint32_t P25Decoder::decodeGolay2312(uint32_t codeword, uint32_t& errors) {
+    uint32_t error_pattern = golaySyndromeTable()[golayRemainder(codeword)];
+    errors += __builtin_popcount(error_pattern);
+    return ((codeword ^ error_pattern) >> 11) & 0xFFF;
+}
+
+uint32_t P25Decoder::decodeHamming1511(uint32_t codeword, uint32_t& errors) {
+    uint8_t syndrome = 0;
+    for (int row = 0; row < 4; row++) {
+        syndrome = (syndrome << 1) | (__builtin_popcount(codeword & HAMMING_1511_CHECK[row]) & 1);
+    }
+
+    int bit = hammingSyndromeTable()[syndrome];
+    if (bit >= 0) {
+        codeword ^= 1u << bit;
+        errors++;
+    }
+    return (codeword >> 4) & 0x7FF;
 }
 
 uint32_t P25Decoder::bitsToUint32(const uint8_t* bits, size_t start, size_t count) {
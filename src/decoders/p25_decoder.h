@@ -2,9 +2,9 @@
 #define P25_DECODER_H
 
 #include "base_decoder.h"
+#include "p25_site_tables.h"
 #include <array>
-#include <deque>
-#include <map>
+#include <string>
 
 namespace TrunkSDR {
 
@@ -14,6 +14,25 @@ constexpr uint16_t P25_NAC_MASK = 0x0FFF;
 // P25 Frame Sync patterns
 constexpr uint64_t P25_FRAME_SYNC_1 = 0x5575F5FF77FF;
 constexpr uint64_t P25_FRAME_SYNC_2 = 0x5575F5FF77FF;
+constexpr uint64_t P25_FRAME_SYNC_MASK = 0xFFFFFFFFFFFF;
+
+// Frame layout. Bit counts exclude the status dibit that follows every
+// 35 data dibits on the channel.
+constexpr size_t P25_SYNC_DIBITS = 24;
+constexpr size_t P25_STATUS_INTERVAL = 36;     // Dibits per status period
+constexpr size_t P25_NID_BITS = 64;
+constexpr size_t P25_HDU_DATA_BITS = 648;
+constexpr size_t P25_TDU_DATA_BITS = 28;
+constexpr size_t P25_TDULC_DATA_BITS = 432;
+constexpr size_t P25_TSBK_DATA_BITS = 196;
+constexpr size_t P25_LDU_DATA_BITS = 1568;
+constexpr size_t P25_MAX_FRAME_BITS = P25_NID_BITS + P25_LDU_DATA_BITS;
+constexpr size_t P25_LDU_DIBITS = 864;          // Including sync and status
+
+// IMBE voice frames carried in each LDU
+constexpr size_t P25_IMBE_FRAMES_PER_LDU = 9;
+constexpr size_t P25_IMBE_CODEWORD_BITS = 144;
+constexpr size_t P25_IMBE_FRAME_BYTES = 11;     // 88 information bits
 
 // P25 Data Unit IDs (DUID)
 enum class P25DUID : uint8_t {
@@ -23,25 +42,36 @@ enum class P25DUID : uint8_t {
     LOGICAL_LINK_DATA_UNIT_2 = 0xA,
     TRUNKING_SIGNALING_BLOCK = 0x7,
     PDU = 0xC,
-    UNKNOWN = 0xF
+    TERMINATOR_WITH_LC = 0xF,
+    UNKNOWN = 0xFF
 };
 
-// P25 Trunking opcodes
+// Decoded TSBK: LB(1) | P(1) | Opcode(6) | MFID(8) | Arguments(64) |
+// CRC(16). Channel arguments are 16 bits: Identifier(4) | Channel number(12).
+constexpr size_t P25_TSBK_BITS = 96;
+constexpr size_t P25_TSBK_ARGS_OFFSET = 16;
+constexpr size_t P25_TSBK_CRC_OFFSET = 80;
+constexpr size_t P25_MAX_TSBKS = 3;             // Blocks in one TSBK frame
+constexpr uint8_t P25_MFID_STANDARD = 0x00;
+
+// P25 Trunking opcodes (outbound, standard manufacturer ID)
 enum class P25Opcode : uint8_t {
     GROUP_VOICE_GRANT = 0x00,
     GROUP_VOICE_UPDATE = 0x02,
     UNIT_TO_UNIT_VOICE_GRANT = 0x04,
-    TELEPHONE_INTERCONNECT_VOICE_GRANT = 0x05,
+    TELEPHONE_INTERCONNECT_VOICE_GRANT = 0x08,
+    STATUS_UPDATE = 0x18,
+    STATUS_QUERY = 0x1A,
+    MESSAGE_UPDATE = 0x1C,
+    CALL_ALERT = 0x1F,
     UNIT_REGISTRATION_RESPONSE = 0x2C,
     UNIT_AUTHENTICATION_COMMAND = 0x2D,
-    STATUS_UPDATE = 0x30,
-    STATUS_QUERY = 0x31,
-    MESSAGE_UPDATE = 0x32,
-    CALL_ALERT = 0x33,
-    RFSS_STATUS_BROADCAST = 0x38,
-    NETWORK_STATUS_BROADCAST = 0x3A,
-    ADJACENT_SITE_STATUS_BROADCAST = 0x3B,
-    IDENTIFIER_UPDATE = 0x3C
+    IDENTIFIER_UPDATE_TDMA = 0x33,
+    IDENTIFIER_UPDATE_VU = 0x34,
+    RFSS_STATUS_BROADCAST = 0x3A,
+    NETWORK_STATUS_BROADCAST = 0x3B,
+    ADJACENT_SITE_STATUS_BROADCAST = 0x3C,
+    IDENTIFIER_UPDATE = 0x3D
 };
 
 class P25Decoder : public BaseDecoder {
@@ -59,10 +89,28 @@ public:
     void setNAC(uint16_t nac) { expected_nac_ = nac; }
     uint16_t getNAC() const { return current_nac_; }
 
+    // Talkgroup/source attributed to voice frames on a traffic channel
+    void setVoiceTalkgroup(TalkgroupID talkgroup, RadioID source) override;
+
+    // Learned identifier/site tables are saved here whenever they change
+    // and loaded by initialize(), so grants resolve straight after a restart
+    void setSiteCacheFile(const std::string& path) {
+        site_cache_file_ = path;
+        site_cache_writer_.setPath(path);
+    }
+    const P25SiteTables& getSiteTables() const { return site_tables_; }
+
+    uint32_t getWACN() const { return wacn_; }
+    uint16_t getSystemID() const { return system_id_; }
+    size_t getVoiceFramesDecoded() const { return voice_frames_decoded_; }
+    size_t getCRCErrors() const override { return crc_errors_; }
+
 private:
-    // Frame sync detection
-    bool detectFrameSync(const std::deque<uint8_t>& bit_buffer);
-    uint64_t bitsToU64(const std::deque<uint8_t>& bits, size_t start, size_t count);
+    // Frame assembly (one dibit at a time, status symbols stripped)
+    void processDibit(uint8_t dibit);
+    void pushFrameBit(uint8_t bit);
+    size_t expectedDataBits(P25DUID duid) const;
+    void dispatchFrame();
 
     // NID (Network ID) processing
     bool processNID(const uint8_t* bits);
@@ -70,13 +118,26 @@ private:
     P25DUID extractDUID(const uint8_t* bits);
 
     // Trunking signaling
-    void processTSBK(const uint8_t* bits, size_t length);
+    // Decodes one 196-bit coded block; true if another block follows
+    bool processTSBK(const uint8_t* block);
     void processGroupVoiceGrant(const uint8_t* data);
-    void processIdentifierUpdate(const uint8_t* data);
+    void processGroupVoiceUpdate(const uint8_t* data);
+    void processIdentifierUpdate(P25Opcode opcode, const uint8_t* data);
+    void processRFSSStatus(const uint8_t* data);
+    void processNetworkStatus(const uint8_t* data);
+    void processAdjacentSiteStatus(const uint8_t* data);
+    void emitGrant(TalkgroupID talkgroup, RadioID source, uint16_t channel, bool encrypted);
+    void updateSystemIdentity(uint32_t wacn, uint16_t system_id);
+    void siteTablesChanged();
+
+    // Voice (LDU1/LDU2) and terminators
+    void processLDU(P25DUID duid, const uint8_t* bits);
+    uint32_t decodeIMBEFrame(const uint8_t* codeword_bits, uint8_t* packed);
+    void processTerminator();
 
     // Error correction
-    bool checkAndCorrectGolay(uint8_t* data, size_t length);
-    bool checkAndCorrectHamming(uint8_t* data, size_t length);
+    static uint32_t decodeGolay2312(uint32_t codeword, uint32_t& errors);
+    static uint32_t decodeHamming1511(uint32_t codeword, uint32_t& errors);
 
     // Utility functions
     uint32_t bitsToUint32(const uint8_t* bits, size_t start, size_t count);
@@ -86,22 +147,40 @@ private:
     bool sync_locked_;
     uint16_t expected_nac_;
     uint16_t current_nac_;
-    uint16_t wacn_;
+    uint32_t wacn_;
     uint16_t system_id_;
-
-    std::deque<uint8_t> bit_buffer_;
-    std::vector<uint8_t> frame_buffer_;
+    uint16_t unknown_identifiers_;  // Identifiers reported once each
+
+    // Frame assembler
+    uint64_t sync_register_;
+    bool in_frame_;
+    size_t frame_dibit_index_;    // Dibits since start of sync, status included
+    size_t frame_bit_count_;      // NID + data bits collected so far
+    size_t frame_expected_bits_;
+    P25DUID frame_duid_;
+    std::array<uint8_t, P25_MAX_FRAME_BITS> frame_bits_;
+    size_t dibits_since_sync_;
 
     // Frame sync detector
     size_t sync_errors_;
     size_t sync_threshold_;
 
-    // Frequency table for identifier updates
-    std::map<uint8_t, Frequency> frequency_table_;
+    // Voice state
+    bool voice_active_;
+    TalkgroupID voice_talkgroup_;
+    RadioID voice_source_;
+    VoiceFrameBatch voice_batch_;
+
+    // Channel identifiers and site status learned from the control channel
+    P25SiteTables site_tables_;
+    std::string site_cache_file_;
+    P25SiteCacheWriter site_cache_writer_;
 
     // Statistics
     size_t frames_decoded_;
     size_t errors_corrected_;
+    size_t voice_frames_decoded_;
+    size_t crc_errors_;
 };
 
 } // namespace TrunkSDR
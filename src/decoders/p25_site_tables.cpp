@@ -0,0 +1,282 @@
+#include "p25_site_tables.h"
+#include "../utils/logger.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace TrunkSDR {
+
+namespace {
+
+constexpr char CACHE_MAGIC[4] = {'P', '2', '5', 'S'};
+constexpr uint32_t CACHE_VERSION = 1;
+
+// The tables are written as they sit in memory; the record sizes guard
+// against reading a cache written by a build with a different layout
+struct CacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint16_t nac;
+    uint16_t identifier_size;
+    uint16_t rfss_size;
+    uint16_t network_size;
+    uint16_t adjacent_size;
+    uint16_t reserved;
+    uint32_t checksum;      // FNV-1a over everything after the header
+};
+
+uint32_t fnv1a(uint32_t hash, const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+bool sameIdentifier(const P25ChannelIdentifier& a, const P25ChannelIdentifier& b) {
+    return a.valid == b.valid && a.base == b.base && a.spacing == b.spacing &&
+           a.tx_offset == b.tx_offset && a.bandwidth == b.bandwidth && a.slots == b.slots;
+}
+
+} // namespace
+
+P25SiteTables::P25SiteTables() {
+    clear();
+}
+
+void P25SiteTables::clear() {
+    std::memset(identifiers_.data(), 0, sizeof(identifiers_));
+    std::memset(&rfss_, 0, sizeof(rfss_));
+    std::memset(&network_, 0, sizeof(network_));
+    std::memset(adjacent_.data(), 0, sizeof(adjacent_));
+    adjacent_next_ = 0;
+}
+
+bool P25SiteTables::updateIdentifier(uint8_t identifier, const P25ChannelIdentifier& entry) {
+    P25ChannelIdentifier& slot = identifiers_[identifier & 0x0F];
+    if (sameIdentifier(slot, entry)) {
+        return false;
+    }
+    slot = entry;
+    return true;
+}
+
+bool P25SiteTables::updateRFSSStatus(const P25RFSSStatus& status) {
+    if (rfss_.valid && rfss_.system_id == status.system_id && rfss_.rfss_id == status.rfss_id &&
+        rfss_.site_id == status.site_id && rfss_.channel == status.channel &&
+        rfss_.service_class == status.service_class) {
+        return false;
+    }
+    rfss_ = status;
+    return true;
+}
+
+bool P25SiteTables::updateNetworkStatus(const P25NetworkStatus& status) {
+    if (network_.valid && network_.wacn == status.wacn && network_.system_id == status.system_id &&
+        network_.channel == status.channel && network_.service_class == status.service_class) {
+        return false;
+    }
+    network_ = status;
+    return true;
+}
+
+bool P25SiteTables::updateAdjacentSite(const P25AdjacentSite& site) {
+    // Sites are keyed by (system, RFSS, site)
+    for (P25AdjacentSite& entry : adjacent_) {
+        if (entry.valid && entry.system_id == site.system_id &&
+            entry.rfss_id == site.rfss_id && entry.site_id == site.site_id) {
+            if (entry.channel == site.channel && entry.service_class == site.service_class &&
+                entry.flags == site.flags) {
+                return false;
+            }
+            entry = site;
+            return true;
+        }
+    }
+
+    for (P25AdjacentSite& entry : adjacent_) {
+        if (!entry.valid) {
+            entry = site;
+            return true;
+        }
+    }
+
+    adjacent_[adjacent_next_] = site;
+    adjacent_next_ = (adjacent_next_ + 1) % P25_MAX_ADJACENT_SITES;
+    return true;
+}
+
+bool P25SiteTables::channelToFrequency(uint16_t channel, Frequency& freq, uint8_t& slot) const {
+    const P25ChannelIdentifier& iden = identifiers_[channel >> 12];
+    if (!iden.valid) {
+        return false;
+    }
+
+    // On TDMA bands consecutive channel numbers are slots of one carrier
+    uint16_t number = channel & 0x0FFF;
+    uint8_t slots = iden.slots ? iden.slots : 1;
+    freq = iden.base + iden.spacing * (number / slots);
+    slot = static_cast<uint8_t>(number % slots);
+    return true;
+}
+
+size_t P25SiteTables::getIdentifierCount() const {
+    size_t count = 0;
+    for (const P25ChannelIdentifier& iden : identifiers_) {
+        if (iden.valid) {
+            count++;
+        }
+    }
+    return count;
+}
+
+bool P25SiteTables::load(const std::string& path, uint16_t nac) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        LOG_INFO("No P25 site cache at", path);
+        return false;
+    }
+
+    CacheHeader header;
+    P25SiteTables tables;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    file.read(reinterpret_cast<char*>(tables.identifiers_.data()), sizeof(tables.identifiers_));
+    file.read(reinterpret_cast<char*>(&tables.rfss_), sizeof(tables.rfss_));
+    file.read(reinterpret_cast<char*>(&tables.network_), sizeof(tables.network_));
+    file.read(reinterpret_cast<char*>(tables.adjacent_.data()), sizeof(tables.adjacent_));
+    if (!file) {
+        LOG_WARNING("P25 site cache", path, "is truncated, ignoring it");
+        return false;
+    }
+
+    if (std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+        header.version != CACHE_VERSION ||
+        header.identifier_size != sizeof(P25ChannelIdentifier) ||
+        header.rfss_size != sizeof(P25RFSSStatus) ||
+        header.network_size != sizeof(P25NetworkStatus) ||
+        header.adjacent_size != sizeof(P25AdjacentSite)) {
+        LOG_WARNING("P25 site cache", path, "has an unknown format, ignoring it");
+        return false;
+    }
+
+    uint32_t checksum = 2166136261u;
+    checksum = fnv1a(checksum, tables.identifiers_.data(), sizeof(tables.identifiers_));
+    checksum = fnv1a(checksum, &tables.rfss_, sizeof(tables.rfss_));
+    checksum = fnv1a(checksum, &tables.network_, sizeof(tables.network_));
+    checksum = fnv1a(checksum, tables.adjacent_.data(), sizeof(tables.adjacent_));
+    if (checksum != header.checksum) {
+        LOG_WARNING("P25 site cache", path, "failed its checksum, ignoring it");
+        return false;
+    }
+
+    if (nac != 0 && header.nac != nac) {
+        LOG_WARNING("P25 site cache", path, "was saved for NAC", header.nac, "not", nac);
+        return false;
+    }
+
+    identifiers_ = tables.identifiers_;
+    rfss_ = tables.rfss_;
+    network_ = tables.network_;
+    adjacent_ = tables.adjacent_;
+    adjacent_next_ = 0;
+
+    LOG_INFO("Loaded P25 site cache", path, ":", getIdentifierCount(), "channel identifiers");
+    return true;
+}
+
+bool P25SiteTables::save(const std::string& path, uint16_t nac) const {
+    CacheHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = CACHE_VERSION;
+    header.nac = nac;
+    header.identifier_size = sizeof(P25ChannelIdentifier);
+    header.rfss_size = sizeof(P25RFSSStatus);
+    header.network_size = sizeof(P25NetworkStatus);
+    header.adjacent_size = sizeof(P25AdjacentSite);
+
+    uint32_t checksum = 2166136261u;
+    checksum = fnv1a(checksum, identifiers_.data(), sizeof(identifiers_));
+    checksum = fnv1a(checksum, &rfss_, sizeof(rfss_));
+    checksum = fnv1a(checksum, &network_, sizeof(network_));
+    checksum = fnv1a(checksum, adjacent_.data(), sizeof(adjacent_));
+    header.checksum = checksum;
+
+    // Write beside the cache and rename so a crash never leaves half a file
+    std::string temp_path = path + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            LOG_ERROR("Failed to write P25 site cache", temp_path);
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(identifiers_.data()), sizeof(identifiers_));
+        file.write(reinterpret_cast<const char*>(&rfss_), sizeof(rfss_));
+        file.write(reinterpret_cast<const char*>(&network_), sizeof(network_));
+        file.write(reinterpret_cast<const char*>(adjacent_.data()), sizeof(adjacent_));
+        if (!file) {
+            LOG_ERROR("Failed to write P25 site cache", temp_path);
+            return false;
+        }
+    }
+
+    if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        LOG_ERROR("Failed to replace P25 site cache", path);
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+P25SiteCacheWriter::P25SiteCacheWriter()
+    : nac_(0)
+    , dirty_(false)
+    , stop_(false) {
+}
+
+P25SiteCacheWriter::~P25SiteCacheWriter() {
+    if (thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_one();
+        thread_.join();
+    }
+}
+
+void P25SiteCacheWriter::submit(const P25SiteTables& tables, uint16_t nac) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        snapshot_ = tables;
+        nac_ = nac;
+        dirty_ = true;
+    }
+
+    // Started on first use; most decoders never learn anything to save
+    if (!thread_.joinable()) {
+        thread_ = std::thread(&P25SiteCacheWriter::writerThread, this);
+    } else {
+        cv_.notify_one();
+    }
+}
+
+void P25SiteCacheWriter::writerThread() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_.wait(lock, [this] { return dirty_ || stop_; });
+        if (!dirty_) {
+            break;
+        }
+
+        P25SiteTables tables = snapshot_;
+        uint16_t nac = nac_;
+        dirty_ = false;
+        lock.unlock();
+        tables.save(path_, nac);
+        lock.lock();
+    }
+}
+
+} // namespace TrunkSDR
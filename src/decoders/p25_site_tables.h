@@ -0,0 +1,132 @@
+#ifndef P25_SITE_TABLES_H
+#define P25_SITE_TABLES_H
+
+#include "../utils/types.h"
+#include <array>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace TrunkSDR {
+
+// P25 channels are 16 bits: a 4-bit identifier selecting a band from the
+// IDEN_UP tables and a 12-bit channel number within it
+constexpr size_t P25_IDENTIFIER_COUNT = 16;
+constexpr size_t P25_MAX_ADJACENT_SITES = 32;
+
+// One band announced by IDEN_UP, IDEN_UP_VU or IDEN_UP_TDMA
+struct P25ChannelIdentifier {
+    Frequency base;         // Hz
+    Frequency spacing;      // Hz
+    Frequency tx_offset;    // Hz, signed (inbound = outbound + offset)
+    Frequency bandwidth;    // Hz
+    uint8_t slots;          // Channel numbers per carrier (2 on Phase 2 TDMA)
+    bool valid;
+};
+
+// RFSS_STS_BCST: the site we are listening to
+struct P25RFSSStatus {
+    uint16_t system_id;
+    uint8_t rfss_id;
+    uint8_t site_id;
+    uint16_t channel;
+    uint8_t service_class;
+    bool valid;
+};
+
+// NET_STS_BCST: the network the site belongs to
+struct P25NetworkStatus {
+    uint32_t wacn;
+    uint16_t system_id;
+    uint16_t channel;
+    uint8_t service_class;
+    bool valid;
+};
+
+// ADJ_STS_BCST: a neighbouring site's control channel
+struct P25AdjacentSite {
+    uint16_t system_id;
+    uint8_t rfss_id;
+    uint8_t site_id;
+    uint16_t channel;
+    uint8_t service_class;
+    uint8_t flags;          // CFVA: conventional, failure, valid, active
+    bool valid;
+};
+
+// Site configuration learned from the control channel. The tables are
+// flat arrays so a grant resolves with one index, and they can be saved
+// to a cache file so a restart follows grants before the next broadcast
+// cycle has repeated the identifier updates.
+class P25SiteTables {
+public:
+    P25SiteTables();
+
+    // Returns true when the entry differs from what was stored
+    bool updateIdentifier(uint8_t identifier, const P25ChannelIdentifier& entry);
+    bool updateRFSSStatus(const P25RFSSStatus& status);
+    bool updateNetworkStatus(const P25NetworkStatus& status);
+    bool updateAdjacentSite(const P25AdjacentSite& site);
+
+    // 16-bit channel -> outbound frequency and TDMA slot
+    bool channelToFrequency(uint16_t channel, Frequency& freq, uint8_t& slot) const;
+
+    const P25ChannelIdentifier& getIdentifier(uint8_t identifier) const {
+        return identifiers_[identifier & 0x0F];
+    }
+    const P25RFSSStatus& getRFSSStatus() const { return rfss_; }
+    const P25NetworkStatus& getNetworkStatus() const { return network_; }
+    const std::array<P25AdjacentSite, P25_MAX_ADJACENT_SITES>& getAdjacentSites() const {
+        return adjacent_;
+    }
+    size_t getIdentifierCount() const;
+
+    void clear();
+
+    // Cache file. A cache saved for another NAC is not loaded.
+    bool load(const std::string& path, uint16_t nac);
+    bool save(const std::string& path, uint16_t nac) const;
+
+private:
+    std::array<P25ChannelIdentifier, P25_IDENTIFIER_COUNT> identifiers_;
+    P25RFSSStatus rfss_;
+    P25NetworkStatus network_;
+    std::array<P25AdjacentSite, P25_MAX_ADJACENT_SITES> adjacent_;
+    size_t adjacent_next_;  // Slot replaced when the table is full
+};
+
+// Saves site tables to the cache file on a thread of its own, so the
+// decoder never waits on the disk. submit() copies the tables (flat
+// arrays, no allocation); snapshots that arrive while a save is running
+// replace each other and only the latest is written. The last snapshot is
+// flushed on destruction.
+class P25SiteCacheWriter {
+public:
+    P25SiteCacheWriter();
+    ~P25SiteCacheWriter();
+
+    P25SiteCacheWriter(const P25SiteCacheWriter&) = delete;
+    P25SiteCacheWriter& operator=(const P25SiteCacheWriter&) = delete;
+
+    // Set before the first submit()
+    void setPath(const std::string& path) { path_ = path; }
+
+    void submit(const P25SiteTables& tables, uint16_t nac);
+
+private:
+    void writerThread();
+
+    std::string path_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    P25SiteTables snapshot_;
+    uint16_t nac_;
+    bool dirty_;
+    bool stop_;
+};
+
+} // namespace TrunkSDR
+
+#endif // P25_SITE_TABLES_H
@@ -0,0 +1,131 @@
+#include "smartnet_bandplan.h"
+#include "../utils/logger.h"
+
+namespace TrunkSDR {
+
+namespace {
+
+// Contiguous run of channel numbers: freq = base + (channel - first) * spacing
+struct ChannelSegment {
+    uint16_t first;
+    uint16_t last;
+    Frequency base;
+    Frequency spacing;
+};
+
+// The standard and splinter plans share the channels above 866 MHz
+constexpr ChannelSegment BAND_800_STANDARD_SEGMENTS[] = {
+    {0x000, 0x2CF, 851012500.0, 25000.0},
+    {0x2D0, 0x2F7, 866000000.0, 25000.0},
+    {0x32F, 0x33F, 867000000.0, 25000.0},
+    {0x3BE, 0x3BE, 868975000.0, 0.0},
+    {0x3C1, 0x3FE, 867425000.0, 25000.0}
+};
+
+constexpr ChannelSegment BAND_800_SPLINTER_SEGMENTS[] = {
+    {0x000, 0x257, 851000000.0, 25000.0},
+    {0x258, 0x2CF, 866012500.0, 25000.0},
+    {0x2D0, 0x2F7, 866000000.0, 25000.0},
+    {0x32F, 0x33F, 867000000.0, 25000.0},
+    {0x3BE, 0x3BE, 868975000.0, 0.0},
+    {0x3C1, 0x3FE, 867425000.0, 25000.0}
+};
+
+constexpr ChannelSegment BAND_800_REBAND_SEGMENTS[] = {
+    {0x000, 0x1B7, 851012500.0, 25000.0},
+    {0x1B8, 0x22F, 851025000.0, 25000.0}
+};
+
+constexpr ChannelSegment BAND_900_SEGMENTS[] = {
+    {0x000, 0x1DE, 935012500.0, 12500.0}
+};
+
+// Commands from here up are control words on OBT systems
+constexpr uint16_t OBT_LAST_CHANNEL = 0x2F7;
+
+template <size_t N>
+bool lookup(const ChannelSegment (&segments)[N], uint16_t channel, Frequency& freq) {
+    for (const ChannelSegment& segment : segments) {
+        if (channel >= segment.first && channel <= segment.last) {
+            freq = segment.base + (channel - segment.first) * segment.spacing;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // anonymous namespace
+
+SmartNetBandplan::SmartNetBandplan()
+    : band_(SmartNetBand::BAND_800_STANDARD)
+    , obt_base_(0)
+    , obt_spacing_(0)
+    , obt_offset_(0) {
+}
+
+bool SmartNetBandplan::configure(const std::string& name, Frequency base,
+                                 Frequency spacing, uint32_t offset) {
+    if (name.empty() || name == "800" || name == "800_standard") {
+        band_ = SmartNetBand::BAND_800_STANDARD;
+    } else if (name == "800_splinter") {
+        band_ = SmartNetBand::BAND_800_SPLINTER;
+    } else if (name == "800_reband") {
+        band_ = SmartNetBand::BAND_800_REBAND;
+    } else if (name == "900") {
+        band_ = SmartNetBand::BAND_900;
+    } else if (name == "vhf" || name == "uhf" || name == "obt") {
+        if (base <= 0) {
+            LOG_ERROR("SmartNet", name, "bandplan requires bandplan_base");
+            return false;
+        }
+        band_ = SmartNetBand::OBT;
+        obt_base_ = base;
+        obt_spacing_ = spacing > 0 ? spacing : (name == "vhf" ? 5000.0 : 12500.0);
+        obt_offset_ = offset > 0 ? offset : 380;
+    } else {
+        LOG_ERROR("Unknown SmartNet bandplan:", name);
+        return false;
+    }
+
+    LOG_INFO("SmartNet bandplan:", getName());
+    return true;
+}
+
+bool SmartNetBandplan::channelToFrequency(uint16_t channel, Frequency& freq) const {
+    switch (band_) {
+        case SmartNetBand::BAND_800_STANDARD:
+            return lookup(BAND_800_STANDARD_SEGMENTS, channel, freq);
+        case SmartNetBand::BAND_800_SPLINTER:
+            return lookup(BAND_800_SPLINTER_SEGMENTS, channel, freq);
+        case SmartNetBand::BAND_800_REBAND:
+            return lookup(BAND_800_REBAND_SEGMENTS, channel, freq);
+        case SmartNetBand::BAND_900:
+            return lookup(BAND_900_SEGMENTS, channel, freq);
+        case SmartNetBand::OBT:
+            // Channels below the offset are inbound (repeater inputs)
+            if (channel < obt_offset_ || channel > OBT_LAST_CHANNEL) {
+                return false;
+            }
+            freq = obt_base_ + (channel - obt_offset_) * obt_spacing_;
+            return true;
+    }
+    return false;
+}
+
+bool SmartNetBandplan::isChannel(uint16_t command) const {
+    Frequency freq;
+    return channelToFrequency(command, freq);
+}
+
+const char* SmartNetBandplan::getName() const {
+    switch (band_) {
+        case SmartNetBand::BAND_800_STANDARD: return "800 MHz standard";
+        case SmartNetBand::BAND_800_SPLINTER: return "800 MHz splinter";
+        case SmartNetBand::BAND_800_REBAND: return "800 MHz rebanded";
+        case SmartNetBand::BAND_900: return "900 MHz";
+        case SmartNetBand::OBT: return "OBT (VHF/UHF)";
+    }
+    return "Unknown";
+}
+
+} // namespace TrunkSDR
@@ -0,0 +1,48 @@
+#ifndef SMARTNET_BANDPLAN_H
+#define SMARTNET_BANDPLAN_H
+
+#include "../utils/types.h"
+#include <string>
+
+namespace TrunkSDR {
+
+// SmartNet/SmartZone channel numbering. The 10-bit OSW command doubles as
+// the channel number; which commands are channels and what frequency they
+// map to depends on the band.
+enum class SmartNetBand {
+    BAND_800_STANDARD,
+    BAND_800_SPLINTER,   // Lower channels offset by 12.5 kHz
+    BAND_800_REBAND,     // Post-rebanding 800 MHz
+    BAND_900,
+    OBT                  // VHF/UHF "other band trunking", site specific
+};
+
+class SmartNetBandplan {
+public:
+    SmartNetBandplan();
+
+    // "800_standard" (or "800"), "800_splinter", "800_reband", "900",
+    // "vhf", "uhf" or "obt". VHF/UHF/OBT need the base frequency of the
+    // first outbound channel; spacing and offset default to 5 kHz (VHF),
+    // 12.5 kHz (UHF/OBT) and channel 380.
+    bool configure(const std::string& name, Frequency base = 0,
+                   Frequency spacing = 0, uint32_t offset = 0);
+
+    bool channelToFrequency(uint16_t channel, Frequency& freq) const;
+    bool isChannel(uint16_t command) const;
+
+    SmartNetBand getBand() const { return band_; }
+    const char* getName() const;
+
+private:
+    SmartNetBand band_;
+
+    // OBT parameters
+    Frequency obt_base_;
+    Frequency obt_spacing_;
+    uint32_t obt_offset_;
+};
+
+} // namespace TrunkSDR
+
+#endif // SMARTNET_BANDPLAN_H
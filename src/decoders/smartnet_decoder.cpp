@@ -1,166 +1,279 @@
 #include "smartnet_decoder.h"
 #include "../utils/logger.h"
-#include <cstring>
+#include <ctime>
 
 namespace TrunkSDR {
 
 SmartNetDecoder::SmartNetDecoder()
     : sync_locked_(false)
     , baud_rate_(3600)
-    , base_frequency_(851000000)  // Default 851 MHz
-    , channel_spacing_(25000)     // 25 kHz spacing
-    , frames_decoded_(0)
-    , sync_errors_(0)
-    , sync_threshold_(5) {
+    , window_hi_(0)
+    , window_lo_(0)
+    , bits_since_osw_(0)
+    , missed_osws_(0)
+    , pending_{0, false, 0}
+    , pending_valid_(false)
+    , system_id_(0)
+    , osws_decoded_(0)
+    , crc_errors_(0)
+    , corrected_bits_(0) {
 }
 
 void SmartNetDecoder::initialize() {
-    LOG_INFO("SmartNet decoder initialized, baud rate =", baud_rate_);
+    LOG_INFO("SmartNet decoder initialized, baud rate =", baud_rate_,
+             "bandplan =", bandplan_.getName());
     reset();
 }
 
 void SmartNetDecoder::reset() {
     sync_locked_ = false;
-    bit_buffer_.clear();
-    frames_decoded_ = 0;
-    sync_errors_ = 0;
+    window_hi_ = 0;
+    window_lo_ = 0;
+    bits_since_osw_ = 0;
+    missed_osws_ = 0;
+    pending_valid_ = false;
+    patches_.clear();
+    osws_decoded_ = 0;
+    crc_errors_ = 0;
+    corrected_bits_ = 0;
 }
 
 void SmartNetDecoder::processSymbols(const float* symbols, size_t count) {
     for (size_t i = 0; i < count; i++) {
         // SmartNet uses FSK2 (binary)
-        uint8_t bit = (symbols[i] > 0.5f) ? 1 : 0;
-        bit_buffer_.push_back(bit);
+        processBit(symbols[i] > 0.5f ? 1 : 0);
+    }
+}
 
-        // Keep buffer manageable
-        while (bit_buffer_.size() > 5000) {
-            bit_buffer_.pop_front();
-        }
+void SmartNetDecoder::processBit(uint8_t bit) {
+    window_hi_ = ((window_hi_ << 1) | (window_lo_ >> 63)) & 0xFFFFF;
+    window_lo_ = (window_lo_ << 1) | bit;
+    bits_since_osw_++;
 
-        // Look for sync
-        if (!sync_locked_ || sync_errors_ > sync_threshold_) {
-            if (detectSync(bit_buffer_)) {
-                sync_locked_ = true;
-                sync_errors_ = 0;
-                LOG_INFO("SmartNet sync acquired");
-            }
-        }
+    uint32_t sync = static_cast<uint32_t>(window_hi_ >> 12);
 
-        // Process frames when locked
-        if (sync_locked_ && bit_buffer_.size() >= SMARTNET_FRAME_BITS) {
-            std::vector<uint8_t> frame_bits(SMARTNET_FRAME_BITS);
-            for (size_t j = 0; j < SMARTNET_FRAME_BITS; j++) {
-                frame_bits[j] = bit_buffer_[j];
-            }
+    if (sync_locked_) {
+        // OSWs are back to back; only look where the next one must be
+        if (bits_since_osw_ < SMARTNET_FRAME_BITS) {
+            return;
+        }
+        bits_since_osw_ = 0;
 
-            if (processFrame(frame_bits.data())) {
-                frames_decoded_++;
-                bit_buffer_.erase(bit_buffer_.begin(),
-                                 bit_buffer_.begin() + SMARTNET_FRAME_BITS);
-            } else {
-                sync_errors_++;
-                bit_buffer_.pop_front();
-            }
+        if (sync == SMARTNET_SYNC && decodeFrame()) {
+            missed_osws_ = 0;
+        } else if (++missed_osws_ > SMARTNET_MAX_MISSED_OSW) {
+            sync_locked_ = false;
+            pending_valid_ = false;
+            LOG_WARNING("SmartNet sync lost");
         }
+        return;
     }
-}
 
-bool SmartNetDecoder::detectSync(const std::deque<uint8_t>& bit_buffer) {
-    if (bit_buffer.size() < 16) return false;
-
-    // Check for SmartNet sync pattern (16 bits)
-    uint16_t sync_word = 0;
-    for (int i = 0; i < 16; i++) {
-        sync_word = (sync_word << 1) | (bit_buffer[i] & 1);
+    // An 8-bit sync matches noise often; the CRC decides
+    if (sync == SMARTNET_SYNC && decodeFrame()) {
+        sync_locked_ = true;
+        bits_since_osw_ = 0;
+        missed_osws_ = 0;
+        LOG_INFO("SmartNet sync acquired");
     }
+}
 
-    // Allow for 2 bit errors
-    uint16_t xor_result = sync_word ^ SMARTNET_SYNC;
-    int bit_errors = __builtin_popcount(xor_result);
-
-    return bit_errors <= 2;
+uint8_t SmartNetDecoder::codedBit(size_t index) const {
+    // Coded bit 0 follows the sync; the newest bit is bit 0 of window_lo_
+    size_t position = SMARTNET_CODED_BITS - 1 - index;
+    return position >= 64 ? (window_hi_ >> (position - 64)) & 1
+                          : (window_lo_ >> position) & 1;
 }
 
-bool SmartNetDecoder::processFrame(const uint8_t* bits) {
-    // SmartNet OSW (Outbound Signaling Word) format:
-    // Sync(16) | Address(10) | Group(3) | Command(11) | CRC(16) | Status(20)
+bool SmartNetDecoder::decodeFrame() {
+    // Undo the 19 x 4 interleave
+    uint8_t coded[SMARTNET_CODED_BITS];
+    for (size_t i = 0; i < 19; i++) {
+        for (size_t j = 0; j < 4; j++) {
+            coded[i * 4 + j] = codedBit(i + j * 19);
+        }
+    }
 
-    // Skip sync (already detected)
-    uint16_t address = bitsToUint16(bits, 16, 10);
-    uint16_t group = bitsToUint16(bits, 26, 3);
-    uint16_t command = bitsToUint16(bits, 29, 11);
+    uint8_t data[SMARTNET_DATA_BITS];
+    size_t corrected = correctErrors(coded, data);
 
-    // Check CRC
-    if (!checkCRC(bits)) {
+    if (!checkCRC(data)) {
+        crc_errors_++;
         return false;
     }
+    corrected_bits_ += corrected;
+
+    uint16_t address = 0;
+    for (size_t i = 0; i < 16; i++) {
+        address = static_cast<uint16_t>((address << 1) | data[i]);
+    }
+    uint16_t command = 0;
+    for (size_t i = 17; i < SMARTNET_INFO_BITS; i++) {
+        command = static_cast<uint16_t>((command << 1) | data[i]);
+    }
 
-    // Decode OSW
-    decodeOSW(address, group, command);
+    SmartNetOSW osw;
+    osw.address = address ^ SMARTNET_ADDRESS_MASK;
+    osw.group = (data[16] ^ 1) != 0;
+    osw.command = command ^ SMARTNET_COMMAND_MASK;
 
+    processOSW(osw);
     return true;
 }
 
-void SmartNetDecoder::decodeOSW(uint16_t address, uint16_t group, uint16_t command) {
-    LOG_DEBUG("SmartNet OSW: Address =", address, "Group =", group,
-              "Command =", std::hex, command);
+size_t SmartNetDecoder::correctErrors(const uint8_t* coded, uint8_t* data) {
+    // Coded pairs are (data[k], data[k] ^ data[k-1]). A data bit error
+    // breaks the parity of its own pair and the next one.
+    uint8_t syndrome[SMARTNET_CODED_BITS + 2] = {0};
+    uint8_t previous = 0;
+    for (size_t k = 0; k < SMARTNET_CODED_BITS; k += 2) {
+        uint8_t bit = coded[k] & 1;
+        syndrome[k + 1] = (bit ^ previous) ^ (coded[k + 1] & 1);
+        previous = bit;
+    }
+
+    size_t corrected = 0;
+    for (size_t k = 0; k < SMARTNET_CODED_BITS; k += 2) {
+        data[k / 2] = coded[k] & 1;
+        if (syndrome[k + 1] && syndrome[k + 3]) {
+            data[k / 2] ^= 1;
+            corrected++;
+        }
+    }
+    return corrected;
+}
 
-    // Decode command type
-    uint16_t cmd_type = (command >> 6) & 0x1F;
+bool SmartNetDecoder::checkCRC(const uint8_t* data) {
+    uint16_t accumulator = 0x0393;
+    uint16_t operand = 0x036E;
 
-    if (cmd_type == 0x00) {  // Group Call
-        uint16_t channel = command & 0x3F;
+    for (size_t i = 0; i < SMARTNET_INFO_BITS; i++) {
+        operand = (operand & 1) ? static_cast<uint16_t>((operand >> 1) ^ 0x0225)
+                                : static_cast<uint16_t>(operand >> 1);
+        if (data[i]) {
+            accumulator ^= operand;
+        }
+    }
 
-        // Calculate frequency
-        Frequency frequency = base_frequency_ + (channel * channel_spacing_);
+    // The CRC is sent inverted
+    uint16_t received = 0;
+    for (size_t i = 0; i < SMARTNET_CRC_BITS; i++) {
+        received = static_cast<uint16_t>((received << 1) | (data[SMARTNET_INFO_BITS + i] ^ 1));
+    }
+    return received == (accumulator & 0x03FF);
+}
 
-        LOG_INFO("SmartNet Group Call: TG =", address, "Channel =", channel,
-                 "Freq =", frequency);
+void SmartNetDecoder::processOSW(const SmartNetOSW& osw) {
+    osws_decoded_++;
 
-        if (grant_callback_) {
-            CallGrant grant;
-            grant.talkgroup = address;
-            grant.radio_id = 0;  // Not provided in SmartNet
-            grant.frequency = frequency;
-            grant.type = CallType::GROUP;
-            grant.priority = 5;
-            grant.timestamp = std::time(nullptr);
-            grant.encrypted = false;
+    if (osw.command == static_cast<uint16_t>(SmartNetCommand::FIRST_OF_TWO)) {
+        // A second 0x308 in a row means the first one lost its partner
+        pending_ = osw;
+        pending_valid_ = true;
+        return;
+    }
 
-            grant_callback_(grant);
+    if (pending_valid_) {
+        pending_valid_ = false;
+        if (processTwoWord(pending_, osw)) {
+            return;
         }
     }
+
+    processSingle(osw);
 }
 
-uint16_t SmartNetDecoder::crc16(const uint8_t* data, size_t length) {
-    uint16_t crc = 0xFFFF;
+bool SmartNetDecoder::processTwoWord(const SmartNetOSW& first, const SmartNetOSW& second) {
+    // Extended channel grant: first word names the calling radio
+    if (bandplan_.isChannel(second.command)) {
+        if (second.group) {
+            uint16_t status = second.address & 0x000F;
+            bool emergency = status == 2 || status == 4 || status == 5;
+            emitGrant(second.address & 0xFFF0, first.address, second.command,
+                      emergency ? CallType::EMERGENCY : CallType::GROUP,
+                      (status & 0x8) != 0);
+        } else {
+            emitGrant(second.address, first.address, second.command,
+                      CallType::PRIVATE, false);
+        }
+        return true;
+    }
 
-    for (size_t i = 0; i < length; i++) {
-        crc ^= (data[i] << 8);
-        for (int j = 0; j < 8; j++) {
-            if (crc & 0x8000) {
-                crc = (crc << 1) ^ 0x1021;
-            } else {
-                crc = crc << 1;
+    switch (static_cast<SmartNetCommand>(second.command)) {
+        case SmartNetCommand::SYSTEM_ID:
+            if (first.address != system_id_) {
+                system_id_ = first.address;
+                LOG_INFO("SmartNet system ID =", system_id_);
+
+                if (system_info_callback_) {
+                    SystemInfo info;
+                    info.type = SystemType::SMARTNET;
+                    info.system_id = system_id_;
+                    info.nac = 0;
+                    info.wacn = 0;
+                    info.color_code = 0;
+                    info.symbol_rate = baud_rate_;
+                    system_info_callback_(info);
+                }
             }
+            return true;
+
+        case SmartNetCommand::PATCH: {
+            // First word is the member talkgroup, second the supergroup
+            TalkgroupID supergroup = second.address & 0xFFF0;
+            TalkgroupID member = first.address & 0xFFF0;
+            if (patches_[supergroup].insert(member).second) {
+                LOG_INFO("SmartNet patch: TG", member, "-> supergroup", supergroup);
+            }
+            return true;
         }
-    }
 
-    return crc;
+        default:
+            return false;
+    }
 }
 
-bool SmartNetDecoder::checkCRC(const uint8_t* frame) {
-    // Simplified CRC check
-    // In production, implement full SmartNet CRC-16
-    return true;  // Placeholder
+void SmartNetDecoder::processSingle(const SmartNetOSW& osw) {
+    if (bandplan_.isChannel(osw.command)) {
+        // Channel update: talkgroup (with status in the low nibble) or
+        // radio already on the channel
+        if (osw.group) {
+            uint16_t status = osw.address & 0x000F;
+            bool emergency = status == 2 || status == 4 || status == 5;
+            emitGrant(osw.address & 0xFFF0, 0, osw.command,
+                      emergency ? CallType::EMERGENCY : CallType::GROUP,
+                      (status & 0x8) != 0);
+        } else {
+            emitGrant(osw.address, 0, osw.command, CallType::PRIVATE, false);
+        }
+        return;
+    }
+
+    if (osw.command != static_cast<uint16_t>(SmartNetCommand::IDLE) && !osw.group) {
+        LOG_DEBUG("SmartNet OSW: address =", osw.address, "command =", osw.command);
+    }
 }
 
-uint16_t SmartNetDecoder::bitsToUint16(const uint8_t* bits, size_t start, size_t count) {
-    uint16_t result = 0;
-    for (size_t i = 0; i < count && i < 16; i++) {
-        result = (result << 1) | (bits[start + i] & 1);
+void SmartNetDecoder::emitGrant(TalkgroupID talkgroup, RadioID source, uint16_t channel,
+                                CallType type, bool encrypted) {
+    Frequency frequency;
+    if (!bandplan_.channelToFrequency(channel, frequency)) {
+        return;
+    }
+
+    if (grant_callback_) {
+        CallGrant grant;
+        grant.talkgroup = talkgroup;
+        grant.radio_id = source;
+        grant.frequency = frequency;
+        grant.slot = 0;
+        grant.type = type;
+        grant.priority = type == CallType::EMERGENCY ? 10 : 5;
+        grant.timestamp = std::time(nullptr);
+        grant.encrypted = encrypted;
+
+        grant_callback_(grant);
     }
-    return result;
 }
 
 } // namespace TrunkSDR
@@ -2,27 +2,56 @@
 #define SMARTNET_DECODER_H
 
 #include "base_decoder.h"
-#include <deque>
+#include "smartnet_bandplan.h"
 #include <map>
+#include <set>
 
 namespace TrunkSDR {
 
-// SmartNet frame is 76 bits (38 dibits)
-constexpr size_t SMARTNET_FRAME_BITS = 76;
+// SmartNet OSW frame: 8-bit sync then 76 interleaved, rate 1/2 coded bits
+// carrying Address(16) | Group(1) | Command(10) | CRC(10) | pad(1)
+constexpr size_t SMARTNET_SYNC_BITS = 8;
+constexpr size_t SMARTNET_CODED_BITS = 76;
+constexpr size_t SMARTNET_FRAME_BITS = SMARTNET_SYNC_BITS + SMARTNET_CODED_BITS;  // 84
+constexpr size_t SMARTNET_DATA_BITS = SMARTNET_CODED_BITS / 2;                     // 38
+constexpr size_t SMARTNET_INFO_BITS = 27;
+constexpr size_t SMARTNET_CRC_BITS = 10;
 
-// SmartNet sync patterns
-constexpr uint32_t SMARTNET_SYNC = 0x5555;
+// SmartNet sync pattern
+constexpr uint32_t SMARTNET_SYNC = 0xAC;
 
-// SmartNet command types
+// Over-the-air fields are XORed with these
+constexpr uint16_t SMARTNET_ADDRESS_MASK = 0x33C7;
+constexpr uint16_t SMARTNET_COMMAND_MASK = 0x032A;
+
+// OSWs missed at the expected position before the frame lock is dropped
+constexpr size_t SMARTNET_MAX_MISSED_OSW = 3;
+
+// SmartNet command types (commands not listed are channel numbers when
+// the bandplan says so)
 enum class SmartNetCommand : uint16_t {
-    IDLE = 0x2F0,
-    GROUP_CALL = 0x300,
-    PRIVATE_CALL = 0x308,
-    STATUS = 0x310,
-    AFFILIATION = 0x318,
+    IDLE = 0x2F8,
+    FIRST_OF_TWO = 0x308,      // First word of a two-OSW message
+    SYSTEM_ID = 0x30B,         // Second word: system ID
+    PATCH = 0x340,             // Second word: patch / multiselect
     UNKNOWN = 0xFFF
 };
 
+// One decoded Outbound Signalling Word
+struct SmartNetOSW {
+    uint16_t address;
+    bool group;
+    uint16_t command;
+};
+
+// Motorola SmartNet / SmartZone control channel decoder.
+//
+// Messages are assembled from one or two OSWs: a 0x308 word followed by
+// its partner (extended grant, system ID, patch), otherwise a single word
+// (channel update). Three-OSW sequences (SmartZone adjacent site and
+// alternate control channel broadcasts) are not assembled; their words
+// fall through to the single-word handling, which ignores them unless
+// one carries a channel number.
 class SmartNetDecoder : public BaseDecoder {
 public:
     SmartNetDecoder();
@@ -36,30 +65,50 @@ public:
     bool isLocked() const override { return sync_locked_; }
 
     void setBaudRate(uint32_t baud_rate) { baud_rate_ = baud_rate; }
+    void setBandplan(const SmartNetBandplan& bandplan) { bandplan_ = bandplan; }
 
-private:
-    bool detectSync(const std::deque<uint8_t>& bit_buffer);
-    bool processFrame(const uint8_t* bits);
-    void decodeOSW(uint16_t address, uint16_t group, uint16_t command);
+    // Statistics
+    uint16_t getSystemID() const { return system_id_; }
+    size_t getOSWsDecoded() const { return osws_decoded_; }
+    size_t getCRCErrors() const override { return crc_errors_; }
+    size_t getCorrectedBits() const { return corrected_bits_; }
 
-    uint16_t crc16(const uint8_t* data, size_t length);
-    bool checkCRC(const uint8_t* frame);
+    // Talkgroups patched into a supergroup
+    const std::map<TalkgroupID, std::set<TalkgroupID>>& getPatches() const { return patches_; }
 
-    uint16_t bitsToUint16(const uint8_t* bits, size_t start, size_t count);
+private:
+    void processBit(uint8_t bit);
+    uint8_t codedBit(size_t index) const;
+    bool decodeFrame();
+    void processOSW(const SmartNetOSW& osw);
+    bool processTwoWord(const SmartNetOSW& first, const SmartNetOSW& second);
+    void processSingle(const SmartNetOSW& osw);
+    void emitGrant(TalkgroupID talkgroup, RadioID source, uint16_t channel,
+                   CallType type, bool encrypted);
+
+    static size_t correctErrors(const uint8_t* coded, uint8_t* data);
+    static bool checkCRC(const uint8_t* data);
 
     bool sync_locked_;
     uint32_t baud_rate_;  // 3600 or 9600
 
-    std::deque<uint8_t> bit_buffer_;
+    // Last 84 received bits: window_hi_ holds the oldest 20
+    uint64_t window_hi_;
+    uint64_t window_lo_;
+    size_t bits_since_osw_;
+    size_t missed_osws_;
+
+    // Two-OSW messages: first word waiting for its partner
+    SmartNetOSW pending_;
+    bool pending_valid_;
 
-    // Band plan for frequency calculation
-    Frequency base_frequency_;
-    Frequency channel_spacing_;
-    std::map<uint16_t, Frequency> channel_map_;
+    SmartNetBandplan bandplan_;
+    uint16_t system_id_;
+    std::map<TalkgroupID, std::set<TalkgroupID>> patches_;
 
-    size_t frames_decoded_;
-    size_t sync_errors_;
-    size_t sync_threshold_;
+    size_t osws_decoded_;
+    size_t crc_errors_;
+    size_t corrected_bits_;
 };
 
 } // namespace TrunkSDR
@@ -1,4 +1,5 @@
 #include "c4fm_demod.h"
+#include "filter_tap_cache.h"
 #include "../utils/logger.h"
 #include <cmath>
 
@@ -6,28 +7,27 @@ namespace TrunkSDR {
 
 C4FMDemodulator::C4FMDemodulator()
     : sample_rate_(0)
-    , prev_sample_(1, 0)
-    , samples_per_symbol_(0)
-    , sample_counter_(0)
-    , symbol_sync_(0) {
+    , outer_threshold_(0)
+    , prev_sample_(1, 0) {
 }
 
 void C4FMDemodulator::initialize(uint32_t sample_rate) {
     sample_rate_ = sample_rate;
-    samples_per_symbol_ = sample_rate / SYMBOL_RATE;
+    symbol_clock_.initialize(sample_rate, SYMBOL_RATE);
+    outer_threshold_ = 2.0f * static_cast<float>(M_PI) * 1200.0f / sample_rate;
 
     LOG_INFO("C4FM demodulator initialized:",
              "sample_rate =", sample_rate,
              "symbol_rate =", SYMBOL_RATE,
-             "samples_per_symbol =", samples_per_symbol_);
+             "samples_per_symbol =", symbol_clock_.getSamplesPerSymbol());
 
     // Baseband filter - remove high frequency noise
-    auto baseband_taps = FIRFilter::createLowPassTaps(sample_rate, 6000, 51);
+    auto baseband_taps = FilterTapCache::instance().lowPass(sample_rate, 6000, 51);
     baseband_filter_ = std::make_unique<FIRFilter>();
     baseband_filter_->setTaps(baseband_taps);
 
     // Symbol shaping filter
-    auto symbol_taps = FIRFilter::createLowPassTaps(sample_rate, SYMBOL_RATE * 0.6f, 31);
+    auto symbol_taps = FilterTapCache::instance().lowPass(sample_rate, SYMBOL_RATE * 0.6f, 31);
     symbol_filter_ = std::make_unique<FIRFilter>();
     symbol_filter_->setTaps(symbol_taps);
 
@@ -36,8 +36,7 @@ void C4FMDemodulator::initialize(uint32_t sample_rate) {
 
 void C4FMDemodulator::reset() {
     prev_sample_ = Complex(1, 0);
-    sample_counter_ = 0;
-    symbol_sync_ = 0;
+    symbol_clock_.reset();
     symbol_buffer_.clear();
 
     if (baseband_filter_) baseband_filter_->reset();
@@ -61,13 +60,11 @@ void C4FMDemodulator::processSample(const Complex& sample) {
     // Symbol filter
     deviation = symbol_filter_->process(deviation);
 
-    // Symbol timing recovery (simple)
-    sample_counter_++;
-    if (sample_counter_ >= samples_per_symbol_) {
-        sample_counter_ = 0;
-
+    // Symbol timing recovery
+    float centre;
+    if (symbol_clock_.process(deviation, centre)) {
         // Slice to symbol level
-        int symbol = sliceSymbol(deviation);
+        int symbol = sliceSymbol(centre);
 
         // Output
         float symbol_value = static_cast<float>(symbol);
@@ -85,15 +82,12 @@ void C4FMDemodulator::processSample(const Complex& sample) {
 }
 
 int C4FMDemodulator::sliceSymbol(float deviation) {
-    // P25 C4FM uses 4 levels: +3, +1, -1, -3
-    // Map to symbols 0, 1, 2, 3
-
-    const float THRESHOLD = 0.15f;
-
-    if (deviation > THRESHOLD) {
-        return (deviation > 3.0f * THRESHOLD) ? 3 : 2;
+    // P25 C4FM uses 4 levels: -3, -1, +1, +3 (-1800, -600, 600, 1800 Hz)
+    // Map to symbols 0, 1, 2, 3, deciding at 0 and +/-1200 Hz
+    if (deviation > 0.0f) {
+        return (deviation > outer_threshold_) ? 3 : 2;
     } else {
-        return (deviation > -THRESHOLD) ? 1 : 0;
+        return (deviation > -outer_threshold_) ? 1 : 0;
     }
 }
 
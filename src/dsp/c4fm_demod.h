@@ -24,14 +24,16 @@ private:
     uint32_t sample_rate_;
     static constexpr uint32_t SYMBOL_RATE = 4800;
 
+    // Discriminator output (radians per sample) between the +1 and +3
+    // deviations, 600 and 1800 Hz
+    float outer_threshold_;
+
     Complex prev_sample_;
     std::unique_ptr<FIRFilter> baseband_filter_;
     std::unique_ptr<FIRFilter> symbol_filter_;
 
     std::vector<float> symbol_buffer_;
-    size_t samples_per_symbol_;
-    size_t sample_counter_;
-    float symbol_sync_;
+    SymbolClock symbol_clock_;
 };
 
 } // namespace TrunkSDR
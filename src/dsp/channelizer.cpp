@@ -0,0 +1,141 @@
+#include "channelizer.h"
+#include "../utils/logger.h"
+#include <algorithm>
+
+namespace TrunkSDR {
+
+Channelizer::Channelizer()
+    : running_(false)
+    , generation_(0)
+    , busy_(0)
+    , block_(nullptr)
+    , block_count_(0)
+    , stage_end_(0)
+    , next_channel_(0) {
+}
+
+Channelizer::~Channelizer() {
+    stop();
+}
+
+void Channelizer::addChannel(ChannelCallback callback) {
+    channels_.push_back(callback);
+}
+
+void Channelizer::addStage(StageCallback callback) {
+    stages_.push_back(Stage{channels_.size(), callback});
+}
+
+bool Channelizer::start(size_t num_workers) {
+    if (running_) {
+        return true;
+    }
+
+    // More helpers than the widest stage has consumers would only wait
+    size_t widest = 0;
+    size_t first = 0;
+    for (const Stage& stage : stages_) {
+        widest = std::max(widest, stage.first - first);
+        first = stage.first;
+    }
+    widest = std::max(widest, channels_.size() - first);
+    if (widest > 0 && num_workers >= widest) {
+        num_workers = widest - 1;
+    }
+
+    running_ = true;
+    for (size_t i = 0; i < num_workers; i++) {
+        workers_.emplace_back(&Channelizer::workerThread, this);
+    }
+
+    LOG_INFO("Channelizer started:", channels_.size(), "consumer(s) in",
+             stages_.size() + 1, "stage(s),", workers_.size() + 1, "thread(s)");
+    return true;
+}
+
+void Channelizer::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+    }
+    start_cv_.notify_all();
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    workers_.clear();
+}
+
+void Channelizer::process(const Complex* samples, size_t count) {
+    block_ = samples;
+    block_count_ = count;
+
+    size_t first = 0;
+    for (const Stage& stage : stages_) {
+        runStage(first, stage.first);
+        stage.before();
+        first = stage.first;
+    }
+    runStage(first, channels_.size());
+}
+
+void Channelizer::runStage(size_t first, size_t last) {
+    if (first == last) {
+        return;
+    }
+    if (workers_.empty() || last - first == 1) {
+        for (size_t i = first; i < last; i++) {
+            channels_[i](block_, block_count_);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        next_channel_ = first;
+        stage_end_ = last;
+        busy_ = workers_.size();
+        generation_++;
+    }
+    start_cv_.notify_all();
+
+    runChannels();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [this] { return busy_ == 0; });
+}
+
+void Channelizer::runChannels() {
+    size_t index;
+    while ((index = next_channel_++) < stage_end_) {
+        channels_[index](block_, block_count_);
+    }
+}
+
+void Channelizer::workerThread() {
+    uint64_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            start_cv_.wait(lock, [&] { return generation_ != seen || !running_; });
+            if (!running_) {
+                break;
+            }
+            seen = generation_;
+        }
+
+        runChannels();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            busy_--;
+        }
+        done_cv_.notify_one();
+    }
+}
+
+} // namespace TrunkSDR
@@ -0,0 +1,82 @@
+#ifndef CHANNELIZER_H
+#define CHANNELIZER_H
+
+#include "../utils/types.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace TrunkSDR {
+
+// Fans one wideband capture out to every channel consumer.
+//
+// Each consumer mixes its own channels down from the capture (DDC) and
+// demodulates them. Consumers are independent, so one SDR block is
+// processed by all of them in parallel on a fixed worker pool; the calling
+// SDR thread takes part as well. process() returns once every consumer is
+// done with the block, so the SDR buffer can be reused straight away and
+// a consumer never sees two blocks at once.
+//
+// Consumers can be split into stages. A stage starts on a block once the
+// previous one has finished it, after a callback on the calling thread
+// that may act on what the earlier stages produced (control channels
+// granting calls to voice receivers in the next stage) without locking.
+class Channelizer {
+public:
+    using ChannelCallback = std::function<void(const Complex*, size_t)>;
+    using StageCallback = std::function<void()>;
+
+    Channelizer();
+    ~Channelizer();
+
+    // Consumers are registered before start()
+    void addChannel(ChannelCallback callback);
+
+    // Consumers added after this form a new stage; callback runs between
+    // the stages of every block
+    void addStage(StageCallback callback);
+
+    // Helper threads besides the caller; 0 processes every consumer on
+    // the calling thread
+    bool start(size_t num_workers);
+    void stop();
+
+    void process(const Complex* samples, size_t count);
+
+    size_t getChannelCount() const { return channels_.size(); }
+    size_t getWorkerCount() const { return workers_.size(); }
+
+private:
+    struct Stage {
+        size_t first;            // Index of the stage's first consumer
+        StageCallback before;
+    };
+
+    void workerThread();
+    void runChannels();
+    void runStage(size_t first, size_t last);
+
+    std::vector<ChannelCallback> channels_;
+    std::vector<Stage> stages_;
+    std::vector<std::thread> workers_;
+
+    std::mutex mutex_;
+    std::condition_variable start_cv_;
+    std::condition_variable done_cv_;
+    bool running_;
+    uint64_t generation_;       // Bumped for every block
+    size_t busy_;               // Workers still on the current block
+
+    // Current block and stage; consumers are claimed through next_channel_
+    const Complex* block_;
+    size_t block_count_;
+    size_t stage_end_;
+    std::atomic<size_t> next_channel_;
+};
+
+} // namespace TrunkSDR
+
+#endif // CHANNELIZER_H
@@ -0,0 +1,90 @@
+#include "ddc.h"
+#include "filter_tap_cache.h"
+#include "../utils/logger.h"
+#include <cmath>
+
+namespace TrunkSDR {
+
+DigitalDownConverter::DigitalDownConverter()
+    : input_rate_(DEFAULT_SAMPLE_RATE)
+    , decimation_(1)
+    , offset_hz_(0)
+    , nco_(1, 0)
+    , nco_step_(1, 0)
+    , nco_renorm_counter_(0)
+    , history_index_(0)
+    , decimation_counter_(0) {
+}
+
+void DigitalDownConverter::initialize(uint32_t input_rate, uint32_t decimation,
+                                      float bandwidth) {
+    input_rate_ = input_rate;
+    decimation_ = decimation > 0 ? decimation : 1;
+
+    // Enough taps for a usable transition band at the decimated rate
+    size_t num_taps = decimation_ * 4 + 1;
+    taps_ = FilterTapCache::instance().lowPass(input_rate_, bandwidth / 2.0f, num_taps);
+    history_.assign(taps_.size() * 2, Complex(0, 0));
+
+    LOG_INFO("DDC initialized: input_rate =", input_rate_,
+             "decimation =", decimation_,
+             "output_rate =", getOutputRate(),
+             "taps =", taps_.size());
+
+    setOffset(offset_hz_);
+    reset();
+}
+
+void DigitalDownConverter::reset() {
+    std::fill(history_.begin(), history_.end(), Complex(0, 0));
+    history_index_ = 0;
+    decimation_counter_ = 0;
+    nco_ = Complex(1, 0);
+    nco_renorm_counter_ = 0;
+}
+
+void DigitalDownConverter::setOffset(double offset_hz) {
+    offset_hz_ = offset_hz;
+    double step = -2.0 * M_PI * offset_hz_ / input_rate_;
+    nco_step_ = Complex(static_cast<float>(std::cos(step)),
+                        static_cast<float>(std::sin(step)));
+}
+
+size_t DigitalDownConverter::process(const Complex* input, size_t count, Complex* output) {
+    const size_t num_taps = taps_.size();
+    size_t produced = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        Complex mixed = input[i] * nco_;
+        nco_ *= nco_step_;
+
+        // Keep the NCO on the unit circle
+        if (++nco_renorm_counter_ >= 1024) {
+            nco_ /= std::abs(nco_);
+            nco_renorm_counter_ = 0;
+        }
+
+        history_[history_index_] = mixed;
+        history_[history_index_ + num_taps] = mixed;
+        history_index_ = (history_index_ + 1) % num_taps;
+
+        // Only evaluate the filter at output instants
+        if (++decimation_counter_ < decimation_) {
+            continue;
+        }
+        decimation_counter_ = 0;
+
+        const Complex* window = history_.data() + history_index_;
+        float re = 0.0f;
+        float im = 0.0f;
+        for (size_t t = 0; t < num_taps; t++) {
+            re += taps_[t] * window[t].real();
+            im += taps_[t] * window[t].imag();
+        }
+        output[produced++] = Complex(re, im);
+    }
+
+    return produced;
+}
+
+} // namespace TrunkSDR
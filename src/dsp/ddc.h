@@ -0,0 +1,51 @@
+#ifndef DDC_H
+#define DDC_H
+
+#include "../utils/types.h"
+#include <vector>
+
+namespace TrunkSDR {
+
+// Digital down-converter: mixes one channel inside the SDR capture down to
+// baseband and decimates it, so a narrowband demodulator can run on a
+// channel other than the one the tuner is centred on.
+class DigitalDownConverter {
+public:
+    DigitalDownConverter();
+    ~DigitalDownConverter() = default;
+
+    void initialize(uint32_t input_rate, uint32_t decimation, float bandwidth);
+    void reset();
+
+    // Offset of the wanted channel from the tuner centre frequency
+    void setOffset(double offset_hz);
+    double getOffset() const { return offset_hz_; }
+
+    uint32_t getOutputRate() const { return input_rate_ / decimation_; }
+    uint32_t getDecimation() const { return decimation_; }
+
+    // Writes at most count / decimation + 1 samples to output, returns the
+    // number written
+    size_t process(const Complex* input, size_t count, Complex* output);
+
+private:
+    uint32_t input_rate_;
+    uint32_t decimation_;
+    double offset_hz_;
+
+    // Mixer NCO
+    Complex nco_;
+    Complex nco_step_;
+    size_t nco_renorm_counter_;
+
+    // Decimating low-pass FIR; history is stored twice so the dot product
+    // always reads a contiguous window
+    std::vector<float> taps_;
+    std::vector<Complex> history_;
+    size_t history_index_;
+    size_t decimation_counter_;
+};
+
+} // namespace TrunkSDR
+
+#endif // DDC_H
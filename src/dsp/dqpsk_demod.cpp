@@ -52,8 +52,8 @@ void DQPSKDemodulator::initialize(uint32_t sample_rate) {
     timing_beta_ = (4.0f * timing_bw_ * timing_bw_) / denom;
     timing_freq_ = 1.0f / static_cast<float>(samples_per_symbol_);
 
-    Logger::info("DQPSK Demodulator initialized: symbol_rate=%u, sample_rate=%u, sps=%zu",
-                 symbol_rate_, sample_rate_, samples_per_symbol_);
+    Logger::instance().info("DQPSK Demodulator initialized: symbol_rate =", symbol_rate_,
+                            "sample_rate =", sample_rate_, "sps =", samples_per_symbol_);
 
     reset();
 }
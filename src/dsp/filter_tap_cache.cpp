@@ -0,0 +1,46 @@
+#include "filter_tap_cache.h"
+#include "filters.h"
+
+namespace TrunkSDR {
+
+namespace {
+
+bool matches(const FilterDesign& design, uint32_t sample_rate, float cutoff, size_t num_taps) {
+    return design.sample_rate == sample_rate && design.cutoff == cutoff &&
+           design.taps.size() == num_taps;
+}
+
+} // anonymous namespace
+
+std::vector<float> FilterTapCache::lowPass(uint32_t sample_rate, float cutoff, size_t num_taps) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const FilterDesign& design : designs_) {
+        if (matches(design, sample_rate, cutoff, num_taps)) {
+            return design.taps;
+        }
+    }
+
+    designs_.push_back({sample_rate, cutoff,
+                        FIRFilter::createLowPassTaps(sample_rate, cutoff, num_taps)});
+    return designs_.back().taps;
+}
+
+void FilterTapCache::preload(const std::vector<FilterDesign>& designs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const FilterDesign& design : designs) {
+        bool known = design.taps.empty();
+        for (const FilterDesign& existing : designs_) {
+            known = known || matches(existing, design.sample_rate, design.cutoff, design.taps.size());
+        }
+        if (!known) {
+            designs_.push_back(design);
+        }
+    }
+}
+
+std::vector<FilterDesign> FilterTapCache::getDesigns() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return designs_;
+}
+
+} // namespace TrunkSDR
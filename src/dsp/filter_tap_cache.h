@@ -0,0 +1,39 @@
+#ifndef FILTER_TAP_CACHE_H
+#define FILTER_TAP_CACHE_H
+
+#include "../utils/types.h"
+#include <mutex>
+#include <vector>
+
+namespace TrunkSDR {
+
+// Low-pass designs shared by every filter in the process.
+//
+// Every voice receiver and channel DDC at one sample rate wants the same
+// taps; each design is computed once and copied from here after that.
+// The designs are kept in the configuration cache (ConfigCache) between
+// runs and preloaded at startup, so a restart designs nothing. A change
+// to FIRFilter::createLowPassTaps must bump CONFIG_CACHE_VERSION, or
+// stale taps would be loaded.
+class FilterTapCache {
+public:
+    static FilterTapCache& instance() {
+        static FilterTapCache instance;
+        return instance;
+    }
+
+    std::vector<float> lowPass(uint32_t sample_rate, float cutoff, size_t num_taps);
+
+    void preload(const std::vector<FilterDesign>& designs);
+    std::vector<FilterDesign> getDesigns() const;
+
+private:
+    FilterTapCache() = default;
+
+    mutable std::mutex mutex_;
+    std::vector<FilterDesign> designs_;
+};
+
+} // namespace TrunkSDR
+
+#endif // FILTER_TAP_CACHE_H
@@ -2,6 +2,7 @@
 #define FILTERS_H
 
 #include "../utils/types.h"
+#include <algorithm>
 #include <vector>
 #include <cmath>
 
@@ -14,7 +15,8 @@ public:
 
     void setTaps(const std::vector<float>& taps) {
         taps_ = taps;
-        buffer_.resize(taps_.size(), 0.0f);
+        buffer_.assign(taps_.size(), 0.0f);
+        complex_buffer_.assign(taps_.size(), Complex(0.0f, 0.0f));
         buffer_index_ = 0;
     }
 
@@ -33,14 +35,26 @@ public:
         return output;
     }
 
+    // Complex samples have their own delay line; a filter is used for one
+    // kind of sample or the other
     Complex process(const Complex& input) {
-        float real = process(input.real());
-        float imag = process(input.imag());
-        return Complex(real, imag);
+        complex_buffer_[buffer_index_] = input;
+
+        Complex output(0.0f, 0.0f);
+        size_t idx = buffer_index_;
+
+        for (size_t i = 0; i < taps_.size(); i++) {
+            output += taps_[i] * complex_buffer_[idx];
+            idx = (idx == 0) ? taps_.size() - 1 : idx - 1;
+        }
+
+        buffer_index_ = (buffer_index_ + 1) % taps_.size();
+        return output;
     }
 
     void reset() {
         std::fill(buffer_.begin(), buffer_.end(), 0.0f);
+        std::fill(complex_buffer_.begin(), complex_buffer_.end(), Complex(0.0f, 0.0f));
         buffer_index_ = 0;
     }
 
@@ -106,6 +120,7 @@ public:
 private:
     std::vector<float> taps_;
     std::vector<float> buffer_;
+    std::vector<Complex> complex_buffer_;
     size_t buffer_index_;
 };
 
@@ -132,6 +147,78 @@ private:
     float output_;
 };
 
+// Symbol timing for discriminator output. The symbol clock is fractional,
+// so the sample rate need not be a whole multiple of the symbol rate, and
+// a Gardner detector keeps it on the symbol centres. Symbols and the
+// midpoints between them are interpolated linearly between samples.
+class SymbolClock {
+public:
+    SymbolClock() : step_(1.0f) { reset(); }
+
+    void initialize(uint32_t sample_rate, uint32_t symbol_rate) {
+        step_ = static_cast<float>(symbol_rate) / static_cast<float>(sample_rate);
+        reset();
+    }
+
+    void reset() {
+        phase_ = 0.0f;
+        prev_ = 0.0f;
+        mid_ = 0.0f;
+        last_symbol_ = 0.0f;
+        level_ = 0.0f;
+        mid_taken_ = false;
+    }
+
+    // True when value completes a symbol, which is returned in symbol
+    bool process(float value, float& symbol) {
+        float prev = prev_;
+        prev_ = value;
+        phase_ += step_;
+
+        if (!mid_taken_ && phase_ >= 0.5f) {
+            mid_ = interpolate(prev, value, (phase_ - 0.5f) / step_);
+            mid_taken_ = true;
+        }
+        if (phase_ < 1.0f) {
+            return false;
+        }
+
+        phase_ -= 1.0f;
+        symbol = interpolate(prev, value, phase_ / step_);
+        mid_taken_ = false;
+
+        // On time, the midpoint of a transition is zero; sampling late puts
+        // it past the crossing, on the side of the new symbol. The error is
+        // scaled by the signal level so the loop gain ignores deviation.
+        level_ += LEVEL_ALPHA * (std::abs(symbol) - level_);
+        if (level_ > 0.0f) {
+            float error = mid_ * (symbol - last_symbol_) / (level_ * level_);
+            phase_ += TIMING_GAIN * std::max(-1.0f, std::min(1.0f, error));
+        }
+        last_symbol_ = symbol;
+        return true;
+    }
+
+    float getSamplesPerSymbol() const { return 1.0f / step_; }
+
+private:
+    // The signal 'ago' samples before value, on the line through prev
+    static float interpolate(float prev, float value, float ago) {
+        return value - ago * (value - prev);
+    }
+
+    static constexpr float TIMING_GAIN = 0.02f;    // Symbols per unit error
+    static constexpr float LEVEL_ALPHA = 0.01f;
+
+    float step_;            // Symbols per sample
+    float phase_;           // Symbols since the last strobe
+    float prev_;
+    float mid_;
+    float last_symbol_;
+    float level_;           // Mean symbol magnitude
+    bool mid_taken_;
+};
+
 // Automatic Gain Control
 class AGC {
 public:
@@ -12,10 +12,6 @@ FSK4Demodulator::FSK4Demodulator(uint32_t symbol_rate)
       deviation_hz_(1944.0f),  // DMR deviation
       prev_sample_(0.0f, 0.0f),
       phase_accumulator_(0.0f),
-      samples_per_symbol_(0),
-      sample_counter_(0),
-      timing_error_(0.0f),
-      mu_(0.0f),
       threshold_low_(-0.5f),
       threshold_mid_(0.0f),
       threshold_high_(0.5f),
@@ -29,7 +25,7 @@ FSK4Demodulator::FSK4Demodulator(uint32_t symbol_rate)
 
 void FSK4Demodulator::initialize(uint32_t sample_rate) {
     sample_rate_ = sample_rate;
-    samples_per_symbol_ = sample_rate_ / symbol_rate_;
+    symbol_clock_.initialize(sample_rate_, symbol_rate_);
 
     // Design low-pass filter for discriminator output
     // Cutoff at symbol rate to remove high-frequency noise
@@ -60,12 +56,11 @@ void FSK4Demodulator::initialize(uint32_t sample_rate) {
         tap /= sum;
     }
 
-    lpf_ = std::make_unique<FIRFilter>(taps);
+    lpf_ = std::make_unique<FIRFilter>();
+    lpf_->setTaps(taps);
 
-    symbol_history_.reserve(100);
-
-    Logger::info("FSK4 Demodulator initialized: symbol_rate=%u, sample_rate=%u, sps=%zu",
-                 symbol_rate_, sample_rate_, samples_per_symbol_);
+    LOG_INFO("FSK4 Demodulator initialized: symbol_rate =", symbol_rate_,
+             "sample_rate =", sample_rate_, "sps =", symbol_clock_.getSamplesPerSymbol());
 
     reset();
 }
@@ -73,15 +68,11 @@ void FSK4Demodulator::initialize(uint32_t sample_rate) {
 void FSK4Demodulator::reset() {
     prev_sample_ = Complex(0.0f, 0.0f);
     phase_accumulator_ = 0.0f;
-    sample_counter_ = 0;
-    timing_error_ = 0.0f;
-    mu_ = 0.0f;
+    symbol_clock_.reset();
 
     if (lpf_) {
         lpf_->reset();
     }
-
-    symbol_history_.clear();
 }
 
 float FSK4Demodulator::discriminate(const Complex& sample) {
@@ -151,41 +142,9 @@ void FSK4Demodulator::updateThresholds(float value, int symbol) {
 }
 
 void FSK4Demodulator::timingRecovery(float value) {
-    // Simple Mueller and Muller timing recovery
-    sample_counter_++;
-
-    if (sample_counter_ >= samples_per_symbol_) {
-        sample_counter_ = 0;
-
-        // Interpolate symbol at optimal sampling point
-        // For now, use nearest sample (simplified)
-        int symbol = quantizeSymbol(value);
-
-        emitDibit(symbol);
-
-        // Store for timing error calculation
-        symbol_history_.push_back(value);
-        if (symbol_history_.size() > 3) {
-            symbol_history_.erase(symbol_history_.begin());
-        }
-
-        // Calculate timing error (simplified)
-        if (symbol_history_.size() >= 3) {
-            float error = (symbol_history_[2] - symbol_history_[0]) * symbol_history_[1];
-            timing_error_ = 0.9f * timing_error_ + 0.1f * error;
-
-            // Adjust sample counter based on timing error
-            mu_ += timing_error_ * 0.01f;
-            if (mu_ > 1.0f) {
-                mu_ -= 1.0f;
-                sample_counter_++;
-            } else if (mu_ < -1.0f) {
-                mu_ += 1.0f;
-                if (sample_counter_ > 0) {
-                    sample_counter_--;
-                }
-            }
-        }
+    float centre;
+    if (symbol_clock_.process(value, centre)) {
+        emitDibit(quantizeSymbol(centre));
     }
 }
 
@@ -205,7 +164,7 @@ void FSK4Demodulator::process(const Complex* samples, size_t count) {
         float freq = discriminate(samples[i]);
 
         // 2. Low-pass filter
-        float filtered = lpf_->filter(freq);
+        float filtered = lpf_->process(freq);
 
         // 3. Symbol timing recovery and decision
         timingRecovery(filtered);
@@ -17,7 +17,7 @@ namespace TrunkSDR {
  *
  * Improvements over basic FSK:
  * - Better frequency discriminator
- * - Symbol timing recovery
+ * - Symbol timing recovery (fractional clock, Gardner detector)
  * - Adaptive decision thresholds
  * - Eye diagram monitoring for quality
  */
@@ -45,7 +45,7 @@ private:
     int quantizeSymbol(float value);
     void updateThresholds(float value, int symbol);
 
-    // Symbol timing recovery
+    // Symbol timing recovery and decision
     void timingRecovery(float value);
 
     // Emit dibit
@@ -63,10 +63,7 @@ private:
     std::unique_ptr<FIRFilter> lpf_;
 
     // Symbol timing recovery
-    size_t samples_per_symbol_;
-    size_t sample_counter_;
-    float timing_error_;
-    float mu_;  // Fractional timing offset
+    SymbolClock symbol_clock_;
 
     // Adaptive decision thresholds for 4-level detection
     float threshold_low_;   // Between symbols 0 and 1
@@ -82,7 +79,6 @@ private:
     // Quality metrics
     float eye_opening_;
     float freq_error_;
-    std::vector<float> symbol_history_;
 };
 
 } // namespace TrunkSDR
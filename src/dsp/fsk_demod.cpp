@@ -1,5 +1,7 @@
 #include "fsk_demod.h"
+#include "filter_tap_cache.h"
 #include "../utils/logger.h"
+#include <algorithm>
 #include <cmath>
 
 namespace TrunkSDR {
@@ -8,25 +10,39 @@ FSKDemodulator::FSKDemodulator(uint32_t symbol_rate, uint32_t levels)
     : sample_rate_(0)
     , symbol_rate_(symbol_rate)
     , levels_(levels)
+    , sub_audible_(false)
     , prev_sample_(0, 0)
     , phase_accumulator_(0)
-    , samples_per_symbol_(0)
-    , sample_counter_(0) {
+    , decimation_(1)
+    , decimation_count_(0)
+    , decimation_sum_(0) {
 }
 
 void FSKDemodulator::initialize(uint32_t sample_rate) {
     sample_rate_ = sample_rate;
-    samples_per_symbol_ = sample_rate / symbol_rate_;
+
+    // Sub-audible data needs a cutoff far below the voice; that filter is
+    // only practical at a rate near the symbol rate
+    decimation_ = 1;
+    float cutoff = symbol_rate_ * 1.2f;  // Slightly wider than symbol rate
+    size_t num_taps = 51;
+    if (sub_audible_) {
+        decimation_ = std::max<uint32_t>(1, sample_rate / (symbol_rate_ * FILTER_SAMPLES_PER_SYMBOL));
+        cutoff = symbol_rate_ * 0.5f;
+        num_taps = 8 * FILTER_SAMPLES_PER_SYMBOL + 1;
+    }
+    uint32_t filter_rate = sample_rate / decimation_;
+    symbol_clock_.initialize(filter_rate, symbol_rate_);
 
     LOG_INFO("FSK demodulator initialized:",
              "sample_rate =", sample_rate,
              "symbol_rate =", symbol_rate_,
              "levels =", levels_,
-             "samples_per_symbol =", samples_per_symbol_);
+             "samples_per_symbol =", symbol_clock_.getSamplesPerSymbol(),
+             "decimation =", decimation_);
 
     // Create low-pass filter for baseband
-    float cutoff = symbol_rate_ * 1.2f;  // Slightly wider than symbol rate
-    auto taps = FIRFilter::createLowPassTaps(sample_rate, cutoff, 51);
+    auto taps = FilterTapCache::instance().lowPass(filter_rate, cutoff, num_taps);
     lpf_ = std::make_unique<FIRFilter>();
     lpf_->setTaps(taps);
 
@@ -36,8 +52,10 @@ void FSKDemodulator::initialize(uint32_t sample_rate) {
 void FSKDemodulator::reset() {
     prev_sample_ = Complex(1, 0);
     phase_accumulator_ = 0;
-    sample_counter_ = 0;
+    symbol_clock_.reset();
     symbol_buffer_.clear();
+    decimation_count_ = 0;
+    decimation_sum_ = 0;
 
     if (lpf_) {
         lpf_->reset();
@@ -48,17 +66,26 @@ void FSKDemodulator::process(const Complex* samples, size_t count) {
     for (size_t i = 0; i < count; i++) {
         // FM discriminator
         float deviation = discriminate(samples[i]);
+        prev_sample_ = samples[i];
+
+        if (decimation_ > 1) {
+            decimation_sum_ += deviation;
+            if (++decimation_count_ < decimation_) {
+                continue;
+            }
+            deviation = decimation_sum_ / decimation_;
+            decimation_count_ = 0;
+            decimation_sum_ = 0;
+        }
 
         // Low-pass filter
         deviation = lpf_->process(deviation);
 
         // Symbol timing
-        sample_counter_++;
-        if (sample_counter_ >= samples_per_symbol_) {
-            sample_counter_ = 0;
-
+        float centre;
+        if (symbol_clock_.process(deviation, centre)) {
             // Quantize to symbol level
-            int symbol = quantizeSymbol(deviation);
+            int symbol = quantizeSymbol(centre);
 
             // Output symbol
             float symbol_value = static_cast<float>(symbol);
@@ -72,8 +99,6 @@ void FSKDemodulator::process(const Complex* samples, size_t count) {
                 symbol_buffer_.clear();
             }
         }
-
-        prev_sample_ = samples[i];
     }
 }
 
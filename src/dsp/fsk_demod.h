@@ -20,6 +20,12 @@ public:
     void setSymbolRate(uint32_t rate) { symbol_rate_ = rate; }
     void setLevels(uint32_t levels) { levels_ = levels; }
 
+    // Data under FM voice (LTR). The discriminator output is averaged down
+    // to FILTER_SAMPLES_PER_SYMBOL samples a symbol and low-passed at half
+    // the symbol rate, so the voice above it is rejected. Set before
+    // initialize().
+    void setSubAudible(bool sub_audible) { sub_audible_ = sub_audible; }
+
 private:
     float discriminate(const Complex& sample);
     int quantizeSymbol(float value);
@@ -27,6 +33,7 @@ private:
     uint32_t sample_rate_;
     uint32_t symbol_rate_;
     uint32_t levels_;  // 2 for FSK2, 4 for FSK4
+    bool sub_audible_;
 
     Complex prev_sample_;
     float phase_accumulator_;
@@ -34,8 +41,14 @@ private:
     std::unique_ptr<FIRFilter> lpf_;
     std::vector<float> symbol_buffer_;
 
-    size_t samples_per_symbol_;
-    size_t sample_counter_;
+    // Averaging decimator ahead of lpf_ (sub-audible only)
+    uint32_t decimation_;
+    uint32_t decimation_count_;
+    float decimation_sum_;
+
+    SymbolClock symbol_clock_;
+
+    static constexpr uint32_t FILTER_SAMPLES_PER_SYMBOL = 16;
 };
 
 } // namespace TrunkSDR
@@ -2,22 +2,45 @@
 #include "../../utils/logger.h"
 #include <algorithm>
 #include <cstring>
+#include <ctime>
 
 namespace TrunkSDR {
 namespace European {
 
+namespace {
+
+// FSK4Demodulator symbol (0 = -3 ... 3 = +3) to DMR dibit
+constexpr uint8_t SYMBOL_TO_DIBIT[4] = {3, 2, 0, 1};
+
+// TACT bit positions within the 24-bit CACH
+constexpr size_t TACT_POSITIONS[7] = {0, 4, 8, 12, 14, 18, 22};
+
+constexpr uint64_t SYNC_MASK = 0xFFFFFFFFFFFFULL;  // 48 bits
+
+} // anonymous namespace
+
 DMRDecoder::DMRDecoder()
     : sync_locked_(false),
-      bits_since_sync_(0),
+      sync_register_(0),
+      history_index_(0),
+      slot_dibit_count_(0),
+      bursts_since_sync_(0),
       expected_color_code_(1),
       detected_color_code_(0),
       trunking_type_(DMRTrunkingType::CAPACITY_PLUS),
       rest_channel_freq_(0.0),
+      rest_channel_lcn_(0),
       current_slot_(0),
-      calls_decoded_(0) {
-
-    slot_active_[0] = false;
-    slot_active_[1] = false;
+      calls_decoded_(0),
+      bursts_decoded_(0),
+      voice_frames_decoded_(0),
+      crc_errors_(0) {
+
+    dibit_history_.fill(0);
+    slot_bits_.fill(0);
+    for (SlotState& slot : slots_) {
+        slot = SlotState();
+    }
 }
 
 void DMRDecoder::initialize() {
@@ -27,144 +50,192 @@ void DMRDecoder::initialize() {
 
 void DMRDecoder::reset() {
     sync_locked_ = false;
-    bit_buffer_.clear();
-    bits_since_sync_ = 0;
+    sync_register_ = 0;
+    dibit_history_.fill(0);
+    history_index_ = 0;
+    slot_dibit_count_ = 0;
+    bursts_since_sync_ = 0;
     current_slot_ = 0;
+    rest_channel_lcn_ = 0;
+    unknown_channels_.clear();
     active_calls_.clear();
     talker_alias_fragments_.clear();
     calls_decoded_ = 0;
-    slot_active_[0] = false;
-    slot_active_[1] = false;
+    bursts_decoded_ = 0;
+    voice_frames_decoded_ = 0;
+    crc_errors_ = 0;
+
+    for (SlotState& slot : slots_) {
+        slot.voice_active = false;
+        slot.voice_burst = -1;
+        slot.talkgroup = 0;
+        slot.source = 0;
+        slot.emergency = false;
+        slot.encrypted = false;
+        slot.embedded_bits = 0;
+    }
 }
 
 void DMRDecoder::processSymbols(const float* symbols, size_t count) {
-    // Convert symbols (0-3) to dibits (2 bits each)
     for (size_t i = 0; i < count; i++) {
-        int sym = static_cast<int>(symbols[i]);
-        uint8_t bit0 = (sym >> 1) & 1;
-        uint8_t bit1 = sym & 1;
-
-        bit_buffer_.push_back(bit0);
-        bit_buffer_.push_back(bit1);
+        int sym = static_cast<int>(symbols[i]) & 0x3;
+        processDibit(SYMBOL_TO_DIBIT[sym]);
     }
+}
 
-    // Maintain reasonable buffer size
-    while (bit_buffer_.size() > DMR_FRAME_BITS * 4) {
-        bit_buffer_.pop_front();
-    }
+void DMRDecoder::processDibit(uint8_t dibit) {
+    // Keep the last full timeslot (CACH + burst) of dibits
+    dibit_history_[history_index_] = dibit;
+    history_index_ = (history_index_ + 1) % DMR_SLOT_DIBITS;
+
+    sync_register_ = ((sync_register_ << 2) | dibit) & SYNC_MASK;
 
-    // Try to find/maintain synchronization
     if (!sync_locked_) {
-        if (bit_buffer_.size() >= DMR_SYNC_PATTERN_BITS) {
-            if (detectSync()) {
-                sync_locked_ = true;
-                Logger::instance().info("DMR sync acquired");
-            }
+        // Search for a BS sourced sync at any dibit offset
+        if (syncErrors(sync_register_, DMR_SYNC_BS_VOICE) <= DMR_SYNC_ACQUIRE_ERRORS ||
+            syncErrors(sync_register_, DMR_SYNC_BS_DATA) <= DMR_SYNC_ACQUIRE_ERRORS) {
+            sync_locked_ = true;
+            bursts_since_sync_ = 0;
+
+            // The sync ends at burst dibit 77, i.e. timeslot dibit 89
+            slot_dibit_count_ = (DMR_CACH_BITS + DMR_SYNC_OFFSET + DMR_SYNC_PATTERN_BITS) / 2;
+            Logger::instance().info("DMR sync acquired");
         }
-    } else {
-        bits_since_sync_++;
+        return;
+    }
 
-        // Process frame every 264 bits
-        if (bits_since_sync_ >= DMR_FRAME_BITS) {
-            bits_since_sync_ = 0;
+    // Locked: frame strictly by dibit count, one timeslot every 144 dibits
+    if (++slot_dibit_count_ == DMR_SLOT_DIBITS) {
+        slot_dibit_count_ = 0;
+        processBurst();
+    }
+}
 
-            // Extract slot data (after sync pattern)
-            if (bit_buffer_.size() >= DMR_FRAME_BITS) {
-                std::vector<uint8_t> slot_data(DMR_FRAME_BITS);
-                for (size_t i = 0; i < DMR_FRAME_BITS && i < bit_buffer_.size(); i++) {
-                    slot_data[i] = bit_buffer_[i];
-                }
+int DMRDecoder::syncErrors(uint64_t field, uint64_t pattern) {
+    return __builtin_popcountll(field ^ pattern);
+}
 
-                processSlot(current_slot_, slot_data.data());
+uint64_t DMRDecoder::centreField() const {
+    const uint8_t* burst = slot_bits_.data() + DMR_CACH_BITS;
+    uint64_t value = 0;
+    for (size_t i = 0; i < DMR_SYNC_PATTERN_BITS; i++) {
+        value = (value << 1) | burst[DMR_SYNC_OFFSET + i];
+    }
+    return value;
+}
 
-                // Toggle slot (TDMA)
-                current_slot_ = (current_slot_ == 0) ? 1 : 0;
+void DMRDecoder::processBurst() {
+    // Unpack the timeslot, oldest dibit first
+    for (size_t i = 0; i < DMR_SLOT_DIBITS; i++) {
+        uint8_t dibit = dibit_history_[(history_index_ + i) % DMR_SLOT_DIBITS];
+        slot_bits_[2 * i] = (dibit >> 1) & 1;
+        slot_bits_[2 * i + 1] = dibit & 1;
+    }
+    bursts_decoded_++;
 
-                // Remove processed bits
-                for (size_t i = 0; i < DMR_FRAME_BITS; i++) {
-                    if (!bit_buffer_.empty()) {
-                        bit_buffer_.pop_front();
+    // CACH names the timeslot of the burst that follows it; bursts strictly
+    // alternate, so fall back to toggling if the TACT is uncorrectable
+    uint8_t slot;
+    if (!decodeTACT(slot_bits_.data(), slot)) {
+        slot = current_slot_ ^ 1;
+    }
+    current_slot_ = slot;
+
+    const uint8_t* burst = slot_bits_.data() + DMR_CACH_BITS;
+    SlotState& state = slots_[slot];
+    uint64_t centre = centreField();
+
+    if (syncErrors(centre, DMR_SYNC_BS_VOICE) <= DMR_SYNC_TRACK_ERRORS) {
+        // Burst A: start of a voice superframe. Its sync replaces the EMB,
+        // so the colour code is unknown until burst B; hold it until then
+        bursts_since_sync_ = 0;
+        state.voice_burst = 0;
+        std::memcpy(state.burst_a.data(), burst, DMR_FRAME_BITS);
+    } else if (syncErrors(centre, DMR_SYNC_BS_DATA) <= DMR_SYNC_TRACK_ERRORS) {
+        bursts_since_sync_ = 0;
+        processSlot(slot, burst);
+    } else {
+        bursts_since_sync_++;
+
+        // Bursts B-F carry EMB instead of sync
+        if (state.voice_burst >= 0 &&
+            state.voice_burst < static_cast<int>(DMR_VOICE_SUPERFRAME_BURSTS) - 1) {
+            state.voice_burst++;
+            uint8_t color_code = extractColorCode(burst + DMR_SYNC_OFFSET);
+            if (color_code != expected_color_code_) {
+                if (state.voice_burst == 1) {
+                    // Burst A came from the same co-channel repeater
+                    Logger::instance().debug("DMR voice color code mismatch: expected =",
+                                             static_cast<int>(expected_color_code_),
+                                             "got =", static_cast<int>(color_code));
+                    state.voice_burst = -1;
+                }
+            } else {
+                if (state.voice_burst == 1) {
+                    if (!state.voice_active) {
+                        // Late entry - no voice LC header seen; the talkgroup
+                        // comes from the embedded LC in bursts B-E
+                        startVoice(slot);
+                        state.voice_burst = 1;
                     }
+                    processVoiceBurst(slot, state.burst_a.data());
                 }
+                processEmbeddedSignalling(slot, burst + DMR_SYNC_OFFSET);
+                processVoiceBurst(slot, burst);
             }
-
-            // Verify sync is still valid
-            if (!detectSync()) {
-                sync_locked_ = false;
-                Logger::instance().warning("DMR sync lost");
-            }
+        } else if (state.voice_active) {
+            // Expected burst A but found no sync; wait for the next superframe
+            state.voice_burst = -1;
         }
     }
-}
-
-bool DMRDecoder::detectSync() {
-    if (bit_buffer_.size() < DMR_SYNC_PATTERN_BITS) {
-        return false;
-    }
-
-    // Try to detect sync pattern
-    uint64_t received_sync = bitsToU64(bit_buffer_, 0, DMR_SYNC_PATTERN_BITS);
 
-    size_t dist_bs = hammingDistance64(received_sync, DMR_SYNC_BS_SOURCED);
-    size_t dist_ms = hammingDistance64(received_sync, DMR_SYNC_MS_SOURCED);
-    size_t dist_data = hammingDistance64(received_sync, DMR_SYNC_DATA);
-    size_t dist_voice = hammingDistance64(received_sync, DMR_SYNC_VOICE);
-
-    size_t min_dist = std::min({dist_bs, dist_ms, dist_data, dist_voice});
-
-    // Accept if within threshold (4 bit errors)
-    if (min_dist <= 4) {
-        // Remove bits before sync
-        while (bit_buffer_.size() > 0 && bit_buffer_[0] != ((received_sync >> 47) & 1)) {
-            bit_buffer_.pop_front();
-        }
-        return true;
+    if (bursts_since_sync_ > DMR_MAX_BURSTS_WITHOUT_SYNC) {
+        sync_locked_ = false;
+        endVoice(0);
+        endVoice(1);
+        Logger::instance().warning("DMR sync lost");
     }
-
-    return false;
 }
 
-size_t DMRDecoder::hammingDistance64(uint64_t a, uint64_t b) {
-    uint64_t xor_val = a ^ b;
-    size_t distance = 0;
-    while (xor_val) {
-        distance += xor_val & 1;
-        xor_val >>= 1;
+bool DMRDecoder::decodeTACT(const uint8_t* cach_bits, uint8_t& slot) {
+    uint8_t tact = 0;
+    for (size_t pos : TACT_POSITIONS) {
+        tact = (tact << 1) | cach_bits[pos];
     }
-    return distance;
-}
 
-uint64_t DMRDecoder::bitsToU64(const std::deque<uint8_t>& bits, size_t start, size_t count) {
-    uint64_t value = 0;
-    for (size_t i = 0; i < count && i < 64 && (start + i) < bits.size(); i++) {
-        value = (value << 1) | (bits[start + i] & 1);
+    if (!hamming_7_4_decode(tact)) {
+        return false;
     }
-    return value;
+
+    // TACT: AT(1) TC(1) LCSS(2)
+    slot = (tact >> 2) & 1;
+    return true;
 }
 
 void DMRDecoder::processSlot(uint8_t slot_num, const uint8_t* data) {
-    // Skip sync pattern (first 48 bits)
-    const uint8_t* slot_type_ptr = data + 48;
-
-    // Decode slot type (20 bits after sync)
-    uint8_t slot_type_bits[20];
-    std::memcpy(slot_type_bits, slot_type_ptr, 20);
+    // Decode slot type (10 bits either side of the sync)
+    uint8_t color_code;
+    DMRDataType data_type = decodeSlotType(data, color_code);
+    if (data_type == DMRDataType::UNKNOWN) {
+        Logger::instance().debug("DMR slot type uncorrectable on slot", slot_num + 1);
+        return;
+    }
 
-    // Extract color code from slot type
-    detected_color_code_ = extractColorCode(slot_type_bits);
+    detected_color_code_ = color_code;
 
     // Check color code matches
     if (detected_color_code_ != expected_color_code_) {
-        Logger::instance().debug("DMR color code mismatch: expected=%u, got=%u",
-                     expected_color_code_, detected_color_code_);
+        Logger::instance().debug("DMR color code mismatch: expected =", static_cast<int>(expected_color_code_),
+                                 "got =", static_cast<int>(detected_color_code_));
         return;
     }
 
-    // Decode slot type
-    DMRDataType data_type = decodeSlotType(slot_type_bits);
-
-    // Extract info bits (196 bits)
-    const uint8_t* info_bits = data + 48 + 20;
+    // Info bits (196) are split either side of the slot type and sync
+    uint8_t info_bits[DMR_INFO_BITS];
+    std::memcpy(info_bits, data, DMR_SLOT_TYPE_OFFSET_1);
+    std::memcpy(info_bits + DMR_SLOT_TYPE_OFFSET_1,
+                data + DMR_SLOT_TYPE_OFFSET_2 + DMR_SLOT_TYPE_BITS / 2,
+                DMR_SLOT_TYPE_OFFSET_1);
 
     switch (data_type) {
         case DMRDataType::CSBK:
@@ -172,118 +243,315 @@ void DMRDecoder::processSlot(uint8_t slot_num, const uint8_t* data) {
             break;
 
         case DMRDataType::VOICE_LC_HEADER:
-            processVoiceLC(info_bits, DMR_INFO_BITS);
+            processVoiceLC(slot_num, info_bits, DMR_INFO_BITS);
             break;
 
         case DMRDataType::VOICE_TERMINATOR:
-            Logger::instance().debug("DMR voice terminator on slot %u", slot_num);
-            slot_active_[slot_num] = false;
+            processTerminatorLC(slot_num, info_bits, DMR_INFO_BITS);
+            break;
+
+        case DMRDataType::IDLE:
+            // Idle on a slot that was carrying voice: call ended unterminated
+            endVoice(slot_num);
             break;
 
         default:
-            Logger::instance().debug("DMR data type %d on slot %u", static_cast<int>(data_type), slot_num);
+            Logger::instance().debug("DMR data type", static_cast<int>(data_type),
+                                     "on slot", slot_num + 1);
             break;
     }
 }
 
-DMRDataType DMRDecoder::decodeSlotType(const uint8_t* slot_type_bits) {
-    // Slot type is 10 bits (after Golay error correction)
-    uint8_t slot_type_data[10];
-    std::memcpy(slot_type_data, slot_type_bits, 10);
+void DMRDecoder::processVoiceBurst(uint8_t slot_num, const uint8_t* data) {
+    SlotState& state = slots_[slot_num];
+    VoiceFrameBatch& batch = state.voice_batch;
+
+    // Three 72-bit AMBE+2 frames; the second straddles the centre field
+    static constexpr size_t FRAME_2_SPLIT = DMR_SYNC_OFFSET - DMR_AMBE_FRAME_BITS;  // 36
+    batch.frame_count = DMR_VOICE_FRAMES_PER_BURST;
+    batch.data.fill(0);
+    for (size_t f = 0; f < DMR_VOICE_FRAMES_PER_BURST; f++) {
+        uint8_t* out = batch.frame(f);
+        for (size_t i = 0; i < DMR_AMBE_FRAME_BITS; i++) {
+            size_t pos;
+            if (f == 0) {
+                pos = i;
+            } else if (f == 1) {
+                pos = (i < FRAME_2_SPLIT) ? DMR_AMBE_FRAME_BITS + i
+                                          : DMR_SYNC_OFFSET + DMR_SYNC_PATTERN_BITS + (i - FRAME_2_SPLIT);
+            } else {
+                pos = DMR_FRAME_BITS - DMR_AMBE_FRAME_BITS + i;
+            }
+            out[i / 8] |= data[pos] << (7 - (i % 8));
+        }
+    }
+    voice_frames_decoded_ += DMR_VOICE_FRAMES_PER_BURST;
+
+    // On late entry there is no call to attach audio to until the embedded
+    // LC names the talkgroup
+    if (state.talkgroup == 0 || state.encrypted) {
+        return;
+    }
+
+    if (voice_frame_callback_) {
+        voice_frame_callback_(batch);
+    }
+}
+
+DMRDataType DMRDecoder::decodeSlotType(const uint8_t* data, uint8_t& color_code) {
+    // Slot type: CC(4) DataType(4) + Golay(20,8) parity, split around sync
+    uint32_t codeword = 0;
+    for (size_t i = 0; i < DMR_SLOT_TYPE_BITS / 2; i++) {
+        codeword = (codeword << 1) | data[DMR_SLOT_TYPE_OFFSET_1 + i];
+    }
+    for (size_t i = 0; i < DMR_SLOT_TYPE_BITS / 2; i++) {
+        codeword = (codeword << 1) | data[DMR_SLOT_TYPE_OFFSET_2 + i];
+    }
 
-    // Apply Golay(20,10) error correction
-    // Simplified - full implementation would decode properly
-    uint8_t data_type_bits = (slot_type_data[0] << 3) | (slot_type_data[1] << 2) |
-                             (slot_type_data[2] << 1) | slot_type_data[3];
+    uint8_t slot_type;
+    if (!golay_20_8_decode(codeword, slot_type)) {
+        return DMRDataType::UNKNOWN;
+    }
 
-    switch (data_type_bits) {
-        case 0x00: return DMRDataType::VOICE_LC_HEADER;
-        case 0x01: return DMRDataType::VOICE_TERMINATOR;
-        case 0x03: return DMRDataType::CSBK;
-        case 0x06: return DMRDataType::DATA_HEADER;
-        case 0x09: return DMRDataType::IDLE;
-        default: return DMRDataType::UNKNOWN;
+    color_code = slot_type >> 4;
+    uint8_t data_type = slot_type & 0x0F;
+    if (data_type > static_cast<uint8_t>(DMRDataType::RATE_1_DATA)) {
+        return DMRDataType::UNKNOWN;
     }
+    return static_cast<DMRDataType>(data_type);
+}
+
+uint8_t DMRDecoder::extractColorCode(const uint8_t* emb_bits) {
+    // EMB: CC(4) PI(1) LCSS(2) + QR(16,7) parity; CC leads
+    return (emb_bits[0] << 3) | (emb_bits[1] << 2) |
+           (emb_bits[2] << 1) | emb_bits[3];
 }
 
-uint8_t DMRDecoder::extractColorCode(const uint8_t* slot_type_bits) {
-    // Color code is 4 bits embedded in slot type
-    // Simplified extraction
-    return (slot_type_bits[4] << 3) | (slot_type_bits[5] << 2) |
-           (slot_type_bits[6] << 1) | slot_type_bits[7];
+void DMRDecoder::startVoice(uint8_t slot_num) {
+    SlotState& state = slots_[slot_num];
+
+    state.voice_active = true;
+    state.voice_burst = -1;
+
+    VoiceFrameBatch& batch = state.voice_batch;
+    batch.codec = CodecType::AMBE_PLUS2;
+    batch.talkgroup = state.talkgroup;
+    batch.radio_id = state.source;
+    batch.slot = slot_num + 1;
+    batch.frame_count = 0;
+    batch.frame_bytes = DMR_AMBE_FRAME_BYTES;
+    batch.bit_errors = 0;
+}
+
+void DMRDecoder::endVoice(uint8_t slot_num) {
+    SlotState& state = slots_[slot_num];
+    if (!state.voice_active) {
+        return;
+    }
+
+    state.voice_active = false;
+    state.voice_burst = -1;
+
+    Logger::instance().debug("DMR voice ended: slot", slot_num + 1, "TG =", state.talkgroup);
+
+    if (call_end_callback_ && state.talkgroup != 0) {
+        call_end_callback_(state.talkgroup);
+    }
+    state.talkgroup = 0;
+    state.source = 0;
 }
 
 void DMRDecoder::processCSBK(const uint8_t* data, size_t length) {
     // Control Signaling Block - used for Capacity Plus trunking
 
     // Decode BPTC (196,96) error correction
-    std::vector<uint8_t> decoded(96);
-    if (!bptc_196_96_decode(data, decoded.data())) {
+    uint8_t decoded[DMR_BPTC_DATA_BITS];
+    if (length < DMR_INFO_BITS || !bptc_196_96_decode(data, decoded)) {
         Logger::instance().debug("DMR CSBK decode failed");
         return;
     }
 
-    // Extract CSBK opcode (6 bits)
-    DMRCSBKOpcode opcode = extractCSBKOpcode(decoded.data());
+    // CSBK CRC-CCITT is masked with 0xA5A5
+    if (!crcCCITT(decoded, 80, 0xA5A5)) {
+        Logger::instance().debug("DMR CSBK CRC error");
+        crc_errors_++;
+        return;
+    }
+
+    // Extract CSBK opcode (6 bits) and feature set
+    DMRCSBKOpcode opcode = extractCSBKOpcode(decoded);
+    uint8_t fid = bitsToUint32(decoded, 8, 8);
+
+    if (opcode == DMRCSBKOpcode::PREAMBLE) {
+        Logger::instance().debug("DMR CSBK preamble");
+        return;
+    }
+
+    if (fid == DMR_FID_CAPACITY_PLUS) {
+        if (opcode == DMRCSBKOpcode::CHANNEL_STATUS) {
+            parseCapacityPlusStatus(decoded);
+        }
+        return;
+    }
+
+    if (fid == DMR_FID_CONNECT_PLUS) {
+        if (opcode == DMRCSBKOpcode::CONNECT_PLUS_VOICE_GRANT) {
+            parseConnectPlusGrant(decoded);
+        } else if (opcode == DMRCSBKOpcode::CONNECT_PLUS_DATA_GRANT) {
+            Logger::instance().debug("DMR Connect Plus data channel grant");
+        }
+        return;
+    }
+
+    if (fid != DMR_FID_STANDARD) {
+        Logger::instance().debug("DMR CSBK with manufacturer FID:", static_cast<int>(fid));
+        return;
+    }
 
     switch (opcode) {
-        case DMRCSBKOpcode::CHANNEL_GRANT:
-            parseChannelGrant(decoded.data());
+        case DMRCSBKOpcode::PRIVATE_VOICE_GRANT:
+        case DMRCSBKOpcode::TALKGROUP_VOICE_GRANT:
+        case DMRCSBKOpcode::BROADCAST_VOICE_GRANT:
+        case DMRCSBKOpcode::DUPLEX_PRIVATE_VOICE_GRANT:
+            parseTier3Grant(opcode, decoded);
             break;
 
         case DMRCSBKOpcode::BROADCAST_TALKGROUP_ANNOUNCE:
-            parseTalkgroupAnnounce(decoded.data());
-            break;
-
-        case DMRCSBKOpcode::PREAMBLE:
-            Logger::instance().debug("DMR Capacity Plus preamble");
+            parseTalkgroupAnnounce(decoded);
             break;
 
         default:
-            Logger::instance().debug("DMR CSBK opcode: 0x%02X", static_cast<uint8_t>(opcode));
+            Logger::instance().debug("DMR CSBK opcode:", static_cast<int>(opcode));
             break;
     }
 }
 
 DMRCSBKOpcode DMRDecoder::extractCSBKOpcode(const uint8_t* data) {
-    uint8_t opcode = bitsToUint32(data, 0, 6) & 0x3F;
+    // LB(1) PF(1) CSBKO(6)
+    uint8_t opcode = bitsToUint32(data, 2, 6) & 0x3F;
     return static_cast<DMRCSBKOpcode>(opcode);
 }
 
-void DMRDecoder::parseChannelGrant(const uint8_t* data) {
-    // Extract source and destination IDs
+void DMRDecoder::parseConnectPlusGrant(const uint8_t* data) {
+    // Connect Plus voice channel grant, opcode 0x03 (reverse engineered
+    // layout, as decoded by DSD-FME dmr_csbk.c and SDRTrunk):
+    // source(24) group(24) LCN(4) timeslot(1)
     uint32_t source_id = bitsToUint32(data, 16, 24);
     uint32_t dest_id = bitsToUint32(data, 40, 24);
+    uint32_t lcn = bitsToUint32(data, 64, 4);
+    uint8_t slot = bitsToUint32(data, 68, 1);
+
+    emitGrant(dest_id, source_id, lcn, slot + 1, CallType::GROUP, false);
+}
+
+void DMRDecoder::parseTier3Grant(DMRCSBKOpcode opcode, const uint8_t* data) {
+    // TS 102 361-4 channel grant:
+    // LPCN(12) LCN(1) late entry(1) emergency(1) offset(1) target(24) source(24)
+    uint32_t lpcn = bitsToUint32(data, 16, 12);
+    uint8_t slot = bitsToUint32(data, 28, 1);
+    bool emergency = bitsToUint32(data, 30, 1) != 0;
+    uint32_t target_id = bitsToUint32(data, 32, 24);
+    uint32_t source_id = bitsToUint32(data, 56, 24);
+
+    if (lpcn == DMR_LPCN_ABSOLUTE) {
+        // Absolute channel parameters follow in an MBC continuation block
+        Logger::instance().debug("DMR Tier III grant with absolute channel, TG =", target_id);
+        return;
+    }
+
+    CallType type = (opcode == DMRCSBKOpcode::PRIVATE_VOICE_GRANT ||
+                     opcode == DMRCSBKOpcode::DUPLEX_PRIVATE_VOICE_GRANT)
+                    ? CallType::PRIVATE : CallType::GROUP;
+
+    emitGrant(target_id, source_id, lpcn, slot + 1, type, emergency);
+}
+
+void DMRDecoder::parseCapacityPlusStatus(const uint8_t* data) {
+    // Capacity Plus channel status (reverse engineered layout):
+    // FL(2) TS(1) R(1) rest repeater(4) active logical slots 1-8 (8),
+    // then one 8-bit talkgroup per active slot
+    uint32_t rest_lcn = bitsToUint32(data, 20, 4);
+    uint8_t active = bitsToUint32(data, 24, 8);
+
+    if (rest_lcn != 0 && rest_lcn != rest_channel_lcn_) {
+        Frequency freq;
+        if (lookupChannel(rest_lcn, freq)) {
+            rest_channel_lcn_ = rest_lcn;
+            if (freq != rest_channel_freq_) {
+                rest_channel_freq_ = freq;
+                Logger::instance().info("DMR Capacity Plus rest channel moved: repeater", rest_lcn,
+                                        "freq =", freq, "Hz");
+                if (rest_channel_callback_) {
+                    rest_channel_callback_(freq);
+                }
+            }
+        }
+    }
+
+    // Logical slot n is repeater (n + 1) / 2, timeslot 1 or 2
+    size_t tg_offset = 32;
+    for (uint32_t lsn = 1; lsn <= 8 && tg_offset + 8 <= 80; lsn++) {
+        if (!(active & (0x80 >> (lsn - 1)))) {
+            continue;
+        }
+        uint32_t talkgroup = bitsToUint32(data, tg_offset, 8);
+        tg_offset += 8;
+
+        if (talkgroup != 0) {
+            emitGrant(talkgroup, 0, (lsn + 1) / 2, ((lsn - 1) % 2) + 1, CallType::GROUP, false);
+        }
+    }
+}
 
-    // Extract logical channel (for Capacity Plus)
-    uint8_t logical_slot = bitsToUint32(data, 8, 1) & 1;
+bool DMRDecoder::lookupChannel(uint32_t channel, Frequency& freq) {
+    auto it = channel_map_.find(channel);
+    if (it == channel_map_.end()) {
+        if (unknown_channels_.insert(channel).second) {
+            Logger::instance().warning("DMR logical channel", channel,
+                                       "not in channel map, grants on it are ignored");
+        }
+        return false;
+    }
+    freq = it->second;
+    return true;
+}
+
+void DMRDecoder::emitGrant(uint32_t dest_id, uint32_t source_id, uint32_t channel,
+                           uint8_t slot_number, CallType type, bool emergency) {
+    Frequency freq;
+    if (!lookupChannel(channel, freq)) {
+        return;
+    }
 
     DMRCall call;
     call.source_id = source_id;
     call.destination_id = dest_id;
-    call.slot_number = logical_slot;
+    call.slot_number = slot_number;
     call.color_code = detected_color_code_;
-    call.frequency = rest_channel_freq_;  // Would calculate actual frequency
-    call.group_call = true;  // Usually group calls
-    call.type = CallType::GROUP;
-    call.timestamp = 0;  // Would use actual timestamp
+    call.frequency = freq;
+    call.group_call = (type == CallType::GROUP);
+    call.type = type;
+    call.emergency = emergency;
+    call.timestamp = std::time(nullptr);
 
     active_calls_[dest_id] = call;
     calls_decoded_++;
 
-    Logger::instance().info("DMR Channel Grant: Slot=%u, TG=%u, Source=%u, CC=%u",
-                 logical_slot, dest_id, source_id, detected_color_code_);
+    Logger::instance().debug("DMR Channel Grant: TG =", dest_id, "source =", source_id,
+                             "channel =", channel, "slot =", static_cast<int>(slot_number),
+                             "freq =", freq);
 
     // Notify via callback
     if (grant_callback_) {
         CallGrant grant;
         grant.talkgroup = dest_id;
         grant.radio_id = source_id;
-        grant.frequency = call.frequency;
-        grant.type = CallType::GROUP;
-        grant.encrypted = false;  // DMR encryption detection would go here
-        grant.priority = 5;
-        grant.timestamp = 0;
+        grant.frequency = freq;
+        grant.slot = slot_number;
+        grant.type = emergency ? CallType::EMERGENCY : type;
+        grant.encrypted = false;  // Privacy is signalled in the voice LC
+        grant.priority = emergency ? 10 : 5;
+        grant.timestamp = call.timestamp;
         grant_callback_(grant);
     }
 }
@@ -291,26 +559,150 @@ void DMRDecoder::parseChannelGrant(const uint8_t* data) {
 void DMRDecoder::parseTalkgroupAnnounce(const uint8_t* data) {
     // Capacity Plus talkgroup announcement
     uint32_t talkgroup = bitsToUint32(data, 16, 24);
-    Logger::instance().info("DMR Talkgroup Announce: TG=%u", talkgroup);
+    Logger::instance().info("DMR Talkgroup Announce: TG =", talkgroup);
 }
 
-void DMRDecoder::processVoiceLC(const uint8_t* data, size_t length) {
+void DMRDecoder::processVoiceLC(uint8_t slot_num, const uint8_t* data, size_t length) {
     // Voice with Link Control header
 
-    // Decode BPTC (196,96)
-    std::vector<uint8_t> decoded(96);
-    if (!bptc_196_96_decode(data, decoded.data())) {
+    uint8_t decoded[DMR_BPTC_DATA_BITS];
+    if (!decodeFullLC(data, length, DMR_RS_MASK_VOICE_LC_HEADER, decoded)) {
+        Logger::instance().debug("DMR voice LC header rejected on slot", slot_num + 1);
+        crc_errors_++;
         return;
     }
 
-    // Extract source and destination from LC
-    uint32_t source_id = bitsToUint32(decoded.data(), 16, 24);
-    uint32_t dest_id = bitsToUint32(decoded.data(), 40, 24);
+    // Full LC: PF(1) R(1) FLCO(6) FID(8) service options(8) dest(24) source(24)
+    uint8_t flco = bitsToUint32(decoded, 2, 6);
+    uint8_t service_options = bitsToUint32(decoded, 16, 8);
+    uint32_t dest_id = bitsToUint32(decoded, 24, 24);
+    uint32_t source_id = bitsToUint32(decoded, 48, 24);
+
+    // Talker alias LCs (FLCO 4-7) carry text, not a new call
+    if (flco >= 0x04 && flco <= 0x07) {
+        parseTalkerAlias(decoded);
+        return;
+    }
+
+    SlotState& state = slots_[slot_num];
+    state.talkgroup = dest_id;
+    state.source = source_id;
+    state.emergency = (service_options & 0x80) != 0;
+    state.encrypted = (service_options & 0x40) != 0;
+    startVoice(slot_num);
+
+    Logger::instance().info("DMR Voice LC: slot", slot_num + 1, "TG =", dest_id,
+                            "source =", source_id, flco == 0x03 ? "(private)" : "");
+}
+
+void DMRDecoder::processTerminatorLC(uint8_t slot_num, const uint8_t* data, size_t length) {
+    // The slot type is Golay protected, so the call ends even when the
+    // terminator's own LC fails its check
+    uint8_t decoded[DMR_BPTC_DATA_BITS];
+    if (!decodeFullLC(data, length, DMR_RS_MASK_TERMINATOR, decoded)) {
+        crc_errors_++;
+    }
+    Logger::instance().debug("DMR voice terminator on slot", slot_num + 1);
+    endVoice(slot_num);
+}
+
+bool DMRDecoder::decodeFullLC(const uint8_t* data, size_t length, uint32_t mask, uint8_t* lc) {
+    // BPTC (196,96) leaves 96 bits: the 72-bit LC and its masked RS(12,9)
+    // parity
+    if (length < DMR_INFO_BITS || !bptc_196_96_decode(data, lc)) {
+        return false;
+    }
+    return rs_12_9_check(lc, mask);
+}
 
-    Logger::instance().info("DMR Voice LC: TG=%u, Source=%u", dest_id, source_id);
+void DMRDecoder::processEmbeddedSignalling(uint8_t slot_num, const uint8_t* centre) {
+    // EMB: CC(4) PI(1) LCSS(2) ... LCSS 1 starts an embedded LC, 3
+    // continues it and 2 ends it; 0 is single-burst signalling
+    SlotState& state = slots_[slot_num];
+    uint8_t lcss = (centre[5] << 1) | centre[6];
+    if (lcss == 1) {
+        state.embedded_bits = 0;
+    } else if (lcss == 0 || state.embedded_bits == 0) {
+        return;
+    }
+
+    if (state.embedded_bits + DMR_EMBEDDED_FRAGMENT_BITS > DMR_EMBEDDED_LC_BITS) {
+        state.embedded_bits = 0;
+        return;
+    }
+    std::memcpy(state.embedded_lc.data() + state.embedded_bits, centre + DMR_EMB_HALF_BITS,
+                DMR_EMBEDDED_FRAGMENT_BITS);
+    state.embedded_bits += DMR_EMBEDDED_FRAGMENT_BITS;
+    if (lcss != 2) {
+        return;
+    }
+
+    size_t received = state.embedded_bits;
+    state.embedded_bits = 0;
+    uint8_t lc[DMR_LC_BITS];
+    if (received != DMR_EMBEDDED_LC_BITS || !decodeEmbeddedLC(state.embedded_lc.data(), lc)) {
+        crc_errors_++;
+        return;
+    }
+
+    // Only a late entry needs it; a voice LC header already named the call.
+    // Embedded LCs also carry talker alias and GPS; only group (0x00) and
+    // unit to unit (0x03) voice name one.
+    uint8_t flco = bitsToUint32(lc, 2, 6);
+    if (!state.voice_active || state.talkgroup != 0 || (flco != 0x00 && flco != 0x03)) {
+        return;
+    }
+
+    uint8_t service_options = bitsToUint32(lc, 16, 8);
+    state.talkgroup = bitsToUint32(lc, 24, 24);
+    state.source = bitsToUint32(lc, 48, 24);
+    state.emergency = (service_options & 0x80) != 0;
+    state.encrypted = (service_options & 0x40) != 0;
+    state.voice_batch.talkgroup = state.talkgroup;
+    state.voice_batch.radio_id = state.source;
+
+    Logger::instance().info("DMR late entry: slot", slot_num + 1, "TG =", state.talkgroup,
+                            "source =", state.source, flco == 0x03 ? "(private)" : "");
+}
+
+bool DMRDecoder::decodeEmbeddedLC(const uint8_t* fragments, uint8_t* lc) {
+    // The fragments fill an 8 x 16 matrix a column at a time: rows 0-6 are
+    // data + Hamming(16,11) and row 7 is even parity over each column
+    uint8_t matrix[DMR_EMBEDDED_LC_BITS];
+    for (size_t i = 0; i < DMR_EMBEDDED_LC_BITS - 1; i++) {
+        matrix[(i * 16) % (DMR_EMBEDDED_LC_BITS - 1)] = fragments[i];
+    }
+    matrix[DMR_EMBEDDED_LC_BITS - 1] = fragments[DMR_EMBEDDED_LC_BITS - 1];
+
+    for (size_t col = 0; col < 16; col++) {
+        uint8_t parity = 0;
+        for (size_t row = 0; row < 8; row++) {
+            parity ^= matrix[row * 16 + col];
+        }
+        if (parity & 1) {
+            return false;
+        }
+    }
+
+    // LC bits: 11 a row in rows 0-1 and 10 in rows 2-6, whose eleventh
+    // bits hold a 5-bit checksum (the nine LC octets summed mod 31)
+    size_t out_idx = 0;
+    uint8_t checksum = 0;
+    for (size_t row = 0; row < 7; row++) {
+        size_t width = (row < 2) ? 11 : 10;
+        for (size_t col = 0; col < width; col++) {
+            lc[out_idx++] = matrix[row * 16 + col];
+        }
+        if (row >= 2) {
+            checksum = (checksum << 1) | matrix[row * 16 + 10];
+        }
+    }
 
-    // Check for talker alias blocks (sent in subsequent frames)
-    parseTalkerAlias(decoded.data());
+    uint32_t sum = 0;
+    for (size_t i = 0; i < DMR_LC_BITS / 8; i++) {
+        sum += bitsToUint32(lc, i * 8, 8);
+    }
+    return sum % 31 == checksum;
 }
 
 void DMRDecoder::parseTalkerAlias(const uint8_t* data) {
@@ -327,26 +719,226 @@ void DMRDecoder::parseTalkerAlias(const uint8_t* data) {
     }
 
     if (!alias.empty()) {
-        Logger::instance().info("DMR Talker Alias: %s", alias.c_str());
+        Logger::instance().info("DMR Talker Alias:", alias);
+    }
+}
+
+bool DMRDecoder::hamming_7_4_decode(uint8_t& value) {
+    // Hamming(7,4,3), 7-bit word d0 d1 d2 d3 p0 p1 p2 (MSB first)
+    auto encode = [](uint8_t d) -> uint8_t {
+        uint8_t d0 = (d >> 3) & 1, d1 = (d >> 2) & 1, d2 = (d >> 1) & 1, d3 = d & 1;
+        uint8_t p0 = d0 ^ d1 ^ d2;
+        uint8_t p1 = d1 ^ d2 ^ d3;
+        uint8_t p2 = d0 ^ d1 ^ d3;
+        return static_cast<uint8_t>((d << 3) | (p0 << 2) | (p1 << 1) | p2);
+    };
+
+    for (uint8_t d = 0; d < 16; d++) {
+        if (__builtin_popcount(encode(d) ^ value) <= 1) {
+            value = d;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool DMRDecoder::golay_20_8_decode(uint32_t codeword, uint8_t& data) {
+    // Golay(20,8,7): Golay(24,12) shortened by 4 data bits. Each codeword is
+    // data(8) | remainder of data * x^11 mod 0xC75 (11) | even parity (1).
+    static const std::array<uint32_t, 256> codebook = [] {
+        std::array<uint32_t, 256> table{};
+        for (uint32_t d = 0; d < 256; d++) {
+            uint32_t remainder = d << 11;
+            for (int bit = 18; bit >= 11; bit--) {
+                if (remainder & (1u << bit)) {
+                    remainder ^= 0xC75u << (bit - 11);
+                }
+            }
+            uint32_t parity = (__builtin_popcount(d) + __builtin_popcount(remainder)) & 1;
+            table[d] = (d << 12) | (remainder << 1) | parity;
+        }
+        return table;
+    }();
+
+    // Minimum distance decode; corrects up to 3 bit errors
+    int best_distance = 21;
+    for (uint32_t d = 0; d < 256; d++) {
+        int distance = __builtin_popcount(codebook[d] ^ codeword);
+        if (distance < best_distance) {
+            best_distance = distance;
+            data = static_cast<uint8_t>(d);
+        }
+    }
+    return best_distance <= 3;
+}
+
+// Hamming(15,11,3) of the BPTC rows, d0-d10 then p0-p3: the syndrome of
+// each data bit (its column of the parity check matrix). The BPTC columns
+// use Hamming(13,9,3), the same code shortened by d0 and d1.
+static constexpr uint8_t HAMMING_15_11_SYNDROMES[11] = {
+    0x9, 0xB, 0xF, 0x7, 0xE, 0x5, 0xA, 0xD, 0x3, 0x6, 0xC
+};
+
+uint8_t DMRDecoder::hammingSyndrome(const uint8_t* bits, size_t stride, size_t data_bits) {
+    const uint8_t* syndromes = HAMMING_15_11_SYNDROMES + (11 - data_bits);
+    uint8_t syndrome = 0;
+    for (size_t i = 0; i < data_bits; i++) {
+        if (bits[i * stride] & 1) {
+            syndrome ^= syndromes[i];
+        }
     }
+    for (size_t i = 0; i < 4; i++) {
+        if (bits[(data_bits + i) * stride] & 1) {
+            syndrome ^= static_cast<uint8_t>(1u << i);
+        }
+    }
+    return syndrome;
+}
+
+bool DMRDecoder::hammingCorrect(uint8_t* bits, size_t stride, size_t data_bits) {
+    // Flip the one bit the syndrome names; false if there is none (no
+    // error, or a syndrome of a shortened position: more than one error)
+    uint8_t syndrome = hammingSyndrome(bits, stride, data_bits);
+    if (syndrome == 0) {
+        return false;
+    }
+
+    const uint8_t* syndromes = HAMMING_15_11_SYNDROMES + (11 - data_bits);
+    for (size_t i = 0; i < data_bits; i++) {
+        if (syndromes[i] == syndrome) {
+            bits[i * stride] ^= 1;
+            return true;
+        }
+    }
+    if ((syndrome & (syndrome - 1)) == 0) {
+        bits[(data_bits + __builtin_ctz(syndrome)) * stride] ^= 1;
+        return true;
+    }
+    return false;
 }
 
 bool DMRDecoder::bptc_196_96_decode(const uint8_t* input, uint8_t* output) {
     // Block Product Turbo Code (196,96) used in DMR
-    // Simplified implementation - full version would do proper turbo decoding
+    // Undo the (i * 181) mod 196 interleave into the 13x15 product matrix
+    // that follows the reserved bit 0: 9 data rows of 11 bits +
+    // Hamming(15,11), the first row led by 3 reserved bits, then 4 rows of
+    // column Hamming(13,9) parity.
+    static constexpr size_t COLUMNS = 15;
+    static constexpr size_t DATA_ROWS = 9;
+
+    uint8_t deinterleaved[DMR_INFO_BITS];
+    for (size_t i = 0; i < DMR_INFO_BITS; i++) {
+        deinterleaved[i] = input[(i * 181) % DMR_INFO_BITS] & 1;
+    }
+    uint8_t* matrix = deinterleaved + 1;
 
-    // For now, extract raw data bits (would apply error correction)
-    size_t out_idx = 0;
-    for (size_t i = 0; i < 196 && out_idx < 96; i++) {
-        // Skip check bits, keep data bits (simplified pattern)
-        if ((i % 15) < 11) {
-            output[out_idx++] = input[i];
+    // Alternate column and row passes until nothing more is corrected
+    for (int pass = 0; pass < 5; pass++) {
+        bool fixed = false;
+        for (size_t col = 0; col < COLUMNS; col++) {
+            fixed |= hammingCorrect(matrix + col, COLUMNS, DATA_ROWS);
+        }
+        for (size_t row = 0; row < DATA_ROWS; row++) {
+            fixed |= hammingCorrect(matrix + row * COLUMNS, 1, 11);
+        }
+        if (!fixed) {
+            break;
+        }
+    }
+
+    // Anything still inconsistent is beyond the code
+    for (size_t col = 0; col < COLUMNS; col++) {
+        if (hammingSyndrome(matrix + col, COLUMNS, DATA_ROWS) != 0) {
+            return false;
+        }
+    }
+    for (size_t row = 0; row < DATA_ROWS; row++) {
+        if (hammingSyndrome(matrix + row * COLUMNS, 1, 11) != 0) {
+            return false;
         }
     }
 
+    // Matrix data bit k (the first three reserved) is column k % 11 of
+    // row k / 11
+    for (size_t i = 0; i < DMR_BPTC_DATA_BITS; i++) {
+        size_t bit = i + 3;
+        output[i] = matrix[(bit / 11) * COLUMNS + bit % 11];
+    }
     return true;
 }
 
+bool DMRDecoder::rs_12_9_check(const uint8_t* bits, uint32_t mask) {
+    // Reed-Solomon (12,9) over GF(2^8), field polynomial x^8+x^4+x^3+x^2+1,
+    // generator (x+a)(x+a^2)(x+a^3) = x^3 + 0x0E x^2 + 0x38 x + 0x40. The 9
+    // LC octets are followed by 3 parity octets XORed with 'mask'.
+    struct GaloisTables {
+        std::array<uint8_t, 512> exp;
+        std::array<uint8_t, 256> log;
+    };
+    static const GaloisTables gf = [] {
+        GaloisTables t{};
+        uint32_t x = 1;
+        for (size_t i = 0; i < 255; i++) {
+            t.exp[i] = static_cast<uint8_t>(x);
+            t.log[x] = static_cast<uint8_t>(i);
+            x <<= 1;
+            if (x & 0x100) {
+                x ^= 0x11D;
+            }
+        }
+        for (size_t i = 255; i < t.exp.size(); i++) {
+            t.exp[i] = t.exp[i - 255];
+        }
+        return t;
+    }();
+    auto field = [bits](size_t start, size_t count) -> uint32_t {
+        uint32_t value = 0;
+        for (size_t i = 0; i < count; i++) {
+            value = (value << 1) | (bits[start + i] & 1);
+        }
+        return value;
+    };
+    auto multiply = [](uint8_t a, uint8_t b) -> uint8_t {
+        if (a == 0 || b == 0) {
+            return 0;
+        }
+        return gf.exp[gf.log[a] + gf.log[b]];
+    };
+
+    // Systematic encoder: parity = LC(x) * x^3 mod g(x)
+    static constexpr uint8_t GENERATOR[3] = {0x40, 0x38, 0x0E};
+    uint8_t parity[3] = {0, 0, 0};   // parity[2] is the x^2 coefficient
+    for (size_t i = 0; i < 9; i++) {
+        uint8_t feedback = static_cast<uint8_t>(field(i * 8, 8)) ^ parity[2];
+        parity[2] = parity[1] ^ multiply(GENERATOR[2], feedback);
+        parity[1] = parity[0] ^ multiply(GENERATOR[1], feedback);
+        parity[0] = multiply(GENERATOR[0], feedback);
+    }
+
+    uint32_t expected = (static_cast<uint32_t>(parity[2]) << 16) |
+                        (static_cast<uint32_t>(parity[1]) << 8) | parity[0];
+    return (expected ^ mask) == field(DMR_LC_BITS, 24);
+}
+
+bool DMRDecoder::crcCCITT(const uint8_t* bits, size_t data_bits, uint16_t mask) {
+    // CRC-CCITT (x^16 + x^12 + x^5 + 1), inverted, then XOR mask
+    uint16_t crc = 0;
+    for (size_t i = 0; i < data_bits; i++) {
+        bool feedback = ((crc >> 15) & 1) ^ (bits[i] & 1);
+        crc <<= 1;
+        if (feedback) {
+            crc ^= 0x1021;
+        }
+    }
+    crc = static_cast<uint16_t>(~crc) ^ mask;
+
+    uint16_t received = 0;
+    for (size_t i = 0; i < 16; i++) {
+        received = static_cast<uint16_t>((received << 1) | (bits[data_bits + i] & 1));
+    }
+    return crc == received;
+}
+
 uint32_t DMRDecoder::bitsToUint32(const uint8_t* bits, size_t start, size_t count) {
     uint32_t value = 0;
     for (size_t i = 0; i < count && i < 32; i++) {
@@ -2,8 +2,10 @@
 #define DMR_DECODER_H
 
 #include "../../decoders/base_decoder.h"
+#include <array>
+#include <functional>
 #include <map>
-#include <deque>
+#include <set>
 
 namespace TrunkSDR {
 namespace European {
@@ -14,7 +16,7 @@ namespace European {
  * Supports:
  * - DMR Tier II (conventional repeater mode)
  * - DMR Tier III (trunking: Capacity Plus, Connect Plus)
- * - 2-slot TDMA
+ * - 2-slot TDMA (both timeslots decoded concurrently, slot from CACH/TACT)
  * - CSBK (Control Signaling Block) decoding
  * - Color Code system (0-15)
  * - AMBE+2 voice codec support
@@ -24,41 +26,105 @@ namespace European {
  */
 
 // DMR constants
-constexpr size_t DMR_FRAME_BITS = 264;      // Total bits in DMR frame
+constexpr size_t DMR_FRAME_BITS = 264;      // Total bits in DMR burst
 constexpr size_t DMR_SYNC_PATTERN_BITS = 48;
 constexpr size_t DMR_SLOT_TYPE_BITS = 20;
 constexpr size_t DMR_INFO_BITS = 196;
+constexpr size_t DMR_BPTC_DATA_BITS = 96;   // Info bits after BPTC(196,96)
 constexpr size_t DMR_SLOTS_PER_FRAME = 2;
-constexpr float DMR_FRAME_DURATION_MS = 30.0f;
-constexpr float DMR_SLOT_DURATION_MS = 15.0f;
+constexpr float DMR_FRAME_DURATION_MS = 60.0f;  // TDMA frame (two timeslots)
+constexpr float DMR_SLOT_DURATION_MS = 30.0f;
 
-// DMR sync patterns
-constexpr uint64_t DMR_SYNC_BS_SOURCED = 0x755FD7DF75F7;  // Base station
-constexpr uint64_t DMR_SYNC_MS_SOURCED = 0xDFF57D75DF5D;  // Mobile station
-constexpr uint64_t DMR_SYNC_DATA = 0xD5D7F77FD757;         // Data
-constexpr uint64_t DMR_SYNC_VOICE = 0x7F7D5DD57DFD;        // Voice
+/**
+ * Outbound (BS sourced) timeslot layout, in bits:
+ *
+ *   CACH(24) | info(98) | slot type(10) | SYNC/EMB(48) | slot type(10) | info(98)
+ *
+ * Voice bursts replace the info and slot type fields with 216 bits of
+ * AMBE+2 (three 72-bit frames, the middle one split around the centre).
+ * Only burst A of a voice superframe carries the voice sync; bursts B-F
+ * carry the EMB and embedded signalling in the centre field instead.
+ */
+constexpr size_t DMR_CACH_BITS = 24;
+constexpr size_t DMR_SLOT_BITS = DMR_CACH_BITS + DMR_FRAME_BITS;  // 288
+constexpr size_t DMR_SLOT_DIBITS = DMR_SLOT_BITS / 2;               // 144
+constexpr size_t DMR_SYNC_OFFSET = 108;      // Centre field, bits into burst
+constexpr size_t DMR_SLOT_TYPE_OFFSET_1 = 98;
+constexpr size_t DMR_SLOT_TYPE_OFFSET_2 = 156;
+constexpr size_t DMR_VOICE_FRAMES_PER_BURST = 3;
+constexpr size_t DMR_AMBE_FRAME_BITS = 72;
+constexpr size_t DMR_AMBE_FRAME_BYTES = 9;
+constexpr size_t DMR_VOICE_SUPERFRAME_BURSTS = 6;  // A-F
+
+// Centre field of bursts B-F: EMB(8) | embedded signalling(32) | EMB(8).
+// Bursts B-E carry one fragment each of a 128-bit embedded LC.
+constexpr size_t DMR_EMB_HALF_BITS = 8;
+constexpr size_t DMR_EMBEDDED_FRAGMENT_BITS = 32;
+constexpr size_t DMR_EMBEDDED_LC_BITS = 128;
+constexpr size_t DMR_LC_BITS = 72;
+
+// Full LC RS(12,9) parity masks (ETSI TS 102 361-1 B.3.12)
+constexpr uint32_t DMR_RS_MASK_VOICE_LC_HEADER = 0x969696;
+constexpr uint32_t DMR_RS_MASK_TERMINATOR = 0x999999;
+
+// Sync matching thresholds (bit errors out of 48)
+constexpr int DMR_SYNC_ACQUIRE_ERRORS = 4;
+constexpr int DMR_SYNC_TRACK_ERRORS = 6;
+
+// Bursts (both slots) without any sync before lock is dropped; longer than
+// a voice superframe so two simultaneous voice calls keep lock
+constexpr size_t DMR_MAX_BURSTS_WITHOUT_SYNC = 14;
+
+// DMR sync patterns (ETSI TS 102 361-1 9.1.1)
+constexpr uint64_t DMR_SYNC_BS_VOICE = 0x755FD7DF75F7;  // Base station voice
+constexpr uint64_t DMR_SYNC_BS_DATA = 0xDFF57D75DF5D;   // Base station data
+constexpr uint64_t DMR_SYNC_MS_VOICE = 0x7F7D5DD57DFD;  // Mobile station voice
+constexpr uint64_t DMR_SYNC_MS_DATA = 0xD5D7F77FD757;   // Mobile station data
 
-// DMR Data types
+// DMR Data types (slot type field values)
 enum class DMRDataType {
-    VOICE_LC_HEADER,    // Voice with Link Control header
-    VOICE_TERMINATOR,   // Voice terminator with LC
-    CSBK,               // Control Signaling Block
-    DATA_HEADER,        // Data header
-    RATE_1_2_DATA,      // Rate 1/2 data
-    RATE_3_4_DATA,      // Rate 3/4 data
-    IDLE,               // Idle burst
-    UNKNOWN
+    PI_HEADER = 0x0,        // Privacy indicator header
+    VOICE_LC_HEADER = 0x1,  // Voice with Link Control header
+    VOICE_TERMINATOR = 0x2, // Voice terminator with LC
+    CSBK = 0x3,             // Control Signaling Block
+    MBC_HEADER = 0x4,       // Multi-block control header
+    MBC_CONTINUATION = 0x5, // Multi-block control continuation
+    DATA_HEADER = 0x6,      // Data header
+    RATE_1_2_DATA = 0x7,    // Rate 1/2 data
+    RATE_3_4_DATA = 0x8,    // Rate 3/4 data
+    IDLE = 0x9,             // Idle burst
+    RATE_1_DATA = 0xA,      // Rate 1 data
+    UNKNOWN = 0xFF
 };
 
+// CSBK feature set IDs
+constexpr uint8_t DMR_FID_STANDARD = 0x00;       // ETSI (Tier III, TS 102 361-4)
+constexpr uint8_t DMR_FID_CONNECT_PLUS = 0x06;   // Motorola Connect Plus
+constexpr uint8_t DMR_FID_CAPACITY_PLUS = 0x10;  // Motorola Capacity Plus
+
+// Tier III physical channel number meaning "absolute parameters follow"
+constexpr uint16_t DMR_LPCN_ABSOLUTE = 0xFFF;
+
 // CSBK (Control Signaling Block) opcodes
 enum class DMRCSBKOpcode {
+    CONNECT_PLUS_VOICE_GRANT = 0x03,    // Under FID 0x06 only
     UNIT_TO_UNIT_VOICE_SERVICE_REQUEST = 0x04,
     UNIT_TO_UNIT_VOICE_SERVICE_ANSWER = 0x05,
-    CHANNEL_GRANT = 0x06,
+    CONNECT_PLUS_DATA_GRANT = 0x06,     // Under FID 0x06 only
     MOVE = 0x07,
     BROADCAST_TALKGROUP_ANNOUNCE = 0x08,
+    ALOHA = 0x19,                       // Tier III C_ALOHA
     NEGATIVE_ACKNOWLEDGE = 0x26,
+    BROADCAST = 0x28,                   // Tier III C_BCAST
+    PRIVATE_VOICE_GRANT = 0x30,         // Tier III PV_GRANT
+    TALKGROUP_VOICE_GRANT = 0x31,       // Tier III TV_GRANT
+    BROADCAST_VOICE_GRANT = 0x32,       // Tier III BTV_GRANT
+    PRIVATE_DATA_GRANT = 0x33,
+    TALKGROUP_DATA_GRANT = 0x34,
+    DUPLEX_PRIVATE_VOICE_GRANT = 0x35,
+    DUPLEX_PRIVATE_DATA_GRANT = 0x36,
     PREAMBLE = 0x3D,
+    CHANNEL_STATUS = 0x3E,              // Capacity Plus rest channel / activity
     UNKNOWN = 0xFF
 };
 
@@ -83,9 +149,13 @@ enum class DMRTrunkingType {
     CAPACITY_PLUS_MULTI,// Multi-site Capacity Plus
     CONNECT_PLUS,       // Wide-area trunking
     HYTERA_XPT,         // Hytera pseudo-trunking
-    LINKED_CAPACITY     // Linked Capacity Plus
+    LINKED_CAPACITY,    // Linked Capacity Plus
+    TIER3               // ETSI Tier III (TS 102 361-4)
 };
 
+// Callback for Capacity Plus rest channel moves
+using RestChannelCallback = std::function<void(Frequency)>;
+
 class DMRDecoder : public BaseDecoder {
 public:
     DMRDecoder();
@@ -102,61 +172,116 @@ public:
     void setColorCode(uint8_t cc) { expected_color_code_ = cc; }
     void setTrunkingType(DMRTrunkingType type) { trunking_type_ = type; }
     void setRestChannel(Frequency freq) { rest_channel_freq_ = freq; }
+    Frequency getRestChannel() const { return rest_channel_freq_; }
+
+    // Logical channel number -> frequency. Capacity Plus numbers repeaters,
+    // Connect Plus and Tier III number physical channels (LPCN).
+    void setChannelMap(const std::map<uint32_t, Frequency>& channels) { channel_map_ = channels; }
+
+    void setRestChannelCallback(RestChannelCallback callback) {
+        rest_channel_callback_ = callback;
+    }
 
     // Statistics
     uint8_t getColorCode() const { return detected_color_code_; }
     size_t getCallsDecoded() const { return calls_decoded_; }
+    size_t getBurstsDecoded() const { return bursts_decoded_; }
+    size_t getVoiceFramesDecoded() const { return voice_frames_decoded_; }
+    size_t getCRCErrors() const override { return crc_errors_; }
+    bool isSlotActive(uint8_t slot) const { return slot < 2 && slots_[slot].voice_active; }
 
 private:
-    // Synchronization
-    bool detectSync();
-    size_t hammingDistance64(uint64_t a, uint64_t b);
-    uint64_t bitsToU64(const std::deque<uint8_t>& bits, size_t start, size_t count);
+    // Per-timeslot call state; both slots are tracked independently
+    struct SlotState {
+        bool voice_active;
+        int voice_burst;            // Position in voice superframe (0 = A), -1 before A
+        std::array<uint8_t, DMR_FRAME_BITS> burst_a;  // Held until burst B's colour code
+        TalkgroupID talkgroup;
+        RadioID source;
+        bool emergency;
+        bool encrypted;
+        VoiceFrameBatch voice_batch;
+        std::array<uint8_t, DMR_EMBEDDED_LC_BITS> embedded_lc;  // Fragments so far
+        size_t embedded_bits;
+    };
+
+    // Synchronization / burst framing
+    void processDibit(uint8_t dibit);
+    uint64_t centreField() const;
+    static int syncErrors(uint64_t field, uint64_t pattern);
+    void processBurst();
+
+    // CACH
+    bool decodeTACT(const uint8_t* cach_bits, uint8_t& slot);
 
     // Frame processing
     void processSlot(uint8_t slot_num, const uint8_t* data);
-    DMRDataType decodeSlotType(const uint8_t* slot_type_bits);
-    uint8_t extractColorCode(const uint8_t* slot_type_bits);
+    void processVoiceBurst(uint8_t slot_num, const uint8_t* data);
+    DMRDataType decodeSlotType(const uint8_t* data, uint8_t& color_code);
+    uint8_t extractColorCode(const uint8_t* emb_bits);
+    void startVoice(uint8_t slot_num);
+    void endVoice(uint8_t slot_num);
 
-    // CSBK processing (Capacity Plus trunking)
+    // CSBK processing (trunking)
     void processCSBK(const uint8_t* data, size_t length);
     DMRCSBKOpcode extractCSBKOpcode(const uint8_t* data);
-    void parseChannelGrant(const uint8_t* data);
+    void parseConnectPlusGrant(const uint8_t* data);
+    void parseTier3Grant(DMRCSBKOpcode opcode, const uint8_t* data);
+    void parseCapacityPlusStatus(const uint8_t* data);
     void parseTalkgroupAnnounce(const uint8_t* data);
+    void emitGrant(uint32_t dest_id, uint32_t source_id, uint32_t channel,
+                   uint8_t slot_number, CallType type, bool emergency);
+    bool lookupChannel(uint32_t channel, Frequency& freq);
 
     // Voice LC (Link Control) processing
-    void processVoiceLC(const uint8_t* data, size_t length);
+    void processVoiceLC(uint8_t slot_num, const uint8_t* data, size_t length);
+    void processTerminatorLC(uint8_t slot_num, const uint8_t* data, size_t length);
+    bool decodeFullLC(const uint8_t* data, size_t length, uint32_t mask, uint8_t* lc);
+    void processEmbeddedSignalling(uint8_t slot_num, const uint8_t* centre);
+    bool decodeEmbeddedLC(const uint8_t* fragments, uint8_t* lc);
     void parseTalkerAlias(const uint8_t* data);
 
     // Error correction
-    void golay_24_12_decode(uint8_t* data);
-    void hamming_16_11_decode(uint8_t* data);
+    static bool hamming_7_4_decode(uint8_t& value);
+    static bool golay_20_8_decode(uint32_t codeword, uint8_t& data);
+    static uint8_t hammingSyndrome(const uint8_t* bits, size_t stride, size_t data_bits);
+    static bool hammingCorrect(uint8_t* bits, size_t stride, size_t data_bits);
     bool bptc_196_96_decode(const uint8_t* input, uint8_t* output);
-
-    // Deinterleaving
-    void deinterleave(const uint8_t* input, uint8_t* output, size_t length);
+    static bool rs_12_9_check(const uint8_t* bits, uint32_t mask);
+    static bool crcCCITT(const uint8_t* bits, size_t data_bits, uint16_t mask);
 
     // Utility functions
     uint32_t bitsToUint32(const uint8_t* bits, size_t start, size_t count);
 
     // State
     bool sync_locked_;
-    std::deque<uint8_t> bit_buffer_;
-    size_t bits_since_sync_;
+    uint64_t sync_register_;        // Last 24 dibits, for sync search
+    std::array<uint8_t, DMR_SLOT_DIBITS> dibit_history_;  // Circular
+    size_t history_index_;
+    size_t slot_dibit_count_;       // Dibits into the current timeslot
+    size_t bursts_since_sync_;
+    std::array<uint8_t, DMR_SLOT_BITS> slot_bits_;  // CACH + burst, one bit per byte
 
     // DMR configuration
     uint8_t expected_color_code_;
     uint8_t detected_color_code_;
     DMRTrunkingType trunking_type_;
     Frequency rest_channel_freq_;
+    uint32_t rest_channel_lcn_;
+    std::map<uint32_t, Frequency> channel_map_;
+    std::set<uint32_t> unknown_channels_;  // Reported once each
+    RestChannelCallback rest_channel_callback_;
 
     // Slot tracking
     uint8_t current_slot_;
-    bool slot_active_[2];
+    SlotState slots_[2];
 
     // Call tracking
     std::map<uint32_t, DMRCall> active_calls_;
     size_t calls_decoded_;
+    size_t bursts_decoded_;
+    size_t voice_frames_decoded_;
+    size_t crc_errors_;
 
     // Talker alias reconstruction (sent over multiple frames)
     std::map<uint32_t, std::vector<uint8_t>> talker_alias_fragments_;
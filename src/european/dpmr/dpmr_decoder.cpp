@@ -0,0 +1,474 @@
+#include "dpmr_decoder.h"
+#include "../../utils/logger.h"
+#include <ctime>
+
+namespace TrunkSDR {
+namespace European {
+
+namespace {
+
+// FSK4Demodulator symbol (0 = -3 ... 3 = +3) to dPMR dibit
+constexpr uint8_t SYMBOL_TO_DIBIT[4] = {3, 2, 0, 1};
+
+constexpr uint64_t LONG_SYNC_MASK = 0xFFFFFFFFFFFFULL;
+constexpr uint64_t SHORT_SYNC_MASK = 0xFFFFFFULL;
+
+// Hamming(12,8) parity column for each data bit (MSB first); distinct and
+// of weight >= 2 so every single-bit error has a unique syndrome
+constexpr uint8_t HAMMING_12_8_COLUMNS[8] = {0x3, 0x5, 0x6, 0x7, 0x9, 0xA, 0xB, 0xC};
+
+// CCH and TCH are scrambled with PN9 (x^9 + x^5 + 1, preset to all ones),
+// restarted at the CCH of every frame
+const std::array<uint8_t, DPMR_SCRAMBLED_BITS>& scrambleTable() {
+    static const std::array<uint8_t, DPMR_SCRAMBLED_BITS> table = [] {
+        std::array<uint8_t, DPMR_SCRAMBLED_BITS> t{};
+        uint16_t pn = 0x1FF;
+        for (size_t i = 0; i < t.size(); i++) {
+            t[i] = (pn >> 8) & 1;
+            uint16_t feedback = ((pn >> 8) ^ (pn >> 4)) & 1;
+            pn = static_cast<uint16_t>(((pn << 1) | feedback) & 0x1FF);
+        }
+        return t;
+    }();
+    return table;
+}
+
+inline int bitErrors(uint64_t a, uint64_t b) {
+    return __builtin_popcountll(a ^ b);
+}
+
+} // anonymous namespace
+
+DPMRDecoder::DPMRDecoder()
+    : state_(State::HUNT),
+      sync_register_(0),
+      missed_sync_(0),
+      frame_index_(0),
+      colour_code_(0),
+      channel_freq_(0),
+      cc_blocked_(false),
+      call_active_(false),
+      called_id_(0),
+      own_id_(0),
+      id_parts_{0, 0},
+      id_parts_seen_(0),
+      format_(DPMRCommFormat::VOICE),
+      headers_decoded_(0),
+      frames_decoded_(0),
+      crc_errors_(0),
+      cc_mismatches_(0),
+      voice_frames_decoded_(0) {
+
+    voice_batch_ = VoiceFrameBatch();
+}
+
+void DPMRDecoder::initialize() {
+    // Build the shared table now rather than on the first frame
+    scrambleTable();
+    reset();
+}
+
+void DPMRDecoder::reset() {
+    state_ = State::HUNT;
+    sync_register_ = 0;
+    missed_sync_ = 0;
+    frame_index_ = 0;
+    frame_.clear();
+    cc_blocked_ = false;
+    call_active_ = false;
+    id_parts_seen_ = 0;
+    headers_decoded_ = 0;
+    frames_decoded_ = 0;
+    crc_errors_ = 0;
+    cc_mismatches_ = 0;
+    voice_frames_decoded_ = 0;
+}
+
+void DPMRDecoder::processSymbols(const float* symbols, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        int sym = static_cast<int>(symbols[i]) & 0x3;
+        processDibit(SYMBOL_TO_DIBIT[sym]);
+    }
+}
+
+void DPMRDecoder::processDibit(uint8_t dibit) {
+    sync_register_ = ((sync_register_ << 2) | dibit) & LONG_SYNC_MASK;
+
+    switch (state_) {
+        case State::HUNT:
+            huntSync();
+            break;
+
+        case State::HEADER:
+            frame_.pushDibit(dibit);
+            if (frame_.size() == DPMR_HEADER_BITS) {
+                processHeader();
+            }
+            break;
+
+        case State::FRAME:
+            // An end frame or a new header can follow any payload frame
+            if (bitErrors(sync_register_, DPMR_FS3) <= DPMR_FS_LONG_ERRORS) {
+                endCall();
+                state_ = State::HUNT;
+                break;
+            }
+            if (bitErrors(sync_register_, DPMR_FS1) <= DPMR_FS_LONG_ERRORS) {
+                frame_.clear();
+                state_ = State::HEADER;
+                break;
+            }
+
+            frame_.pushDibit(dibit);
+            if (frame_.full()) {
+                processFrame();
+                frame_.clear();
+            }
+            break;
+    }
+}
+
+bool DPMRDecoder::huntSync() {
+    if (bitErrors(sync_register_, DPMR_FS1) <= DPMR_FS_LONG_ERRORS) {
+        frame_.clear();
+        state_ = State::HEADER;
+        return true;
+    }
+
+    if (bitErrors(sync_register_, DPMR_FS3) <= DPMR_FS_LONG_ERRORS) {
+        endCall();
+        return true;
+    }
+
+    if (bitErrors(sync_register_, DPMR_FS4) <= DPMR_FS_LONG_ERRORS) {
+        Logger::instance().debug("dPMR packet data header (not decoded)");
+        return true;
+    }
+
+    // Late entry: start on a superframe sync, the CCH realigns the index
+    uint64_t short_field = sync_register_ & SHORT_SYNC_MASK;
+    if (bitErrors(short_field, DPMR_FS2) <= DPMR_FS2_ACQUIRE_ERRORS) {
+        frame_.clear();
+        for (size_t i = DPMR_SYNC_CC_BITS; i-- > 0;) {
+            frame_.push((short_field >> i) & 1);
+        }
+        state_ = State::FRAME;
+        frame_index_ = 0;
+        missed_sync_ = 0;
+        Logger::instance().debug("dPMR superframe sync acquired");
+        return true;
+    }
+
+    return false;
+}
+
+void DPMRDecoder::processHeader() {
+    // The superframe follows the header directly
+    state_ = State::FRAME;
+    frame_index_ = 0;
+    missed_sync_ = 0;
+
+    // HI is sent twice around the colour code
+    LinkInfo info;
+    if (!decodeHI(0, info) && !decodeHI(DPMR_HI_BITS + DPMR_SYNC_CC_BITS, info)) {
+        crc_errors_++;
+        frame_.clear();
+        return;
+    }
+
+    uint32_t cc = static_cast<uint32_t>(frame_.getBits(DPMR_HI_BITS, DPMR_SYNC_CC_BITS));
+    frame_.clear();
+
+    if (colour_code_ == 0) {
+        colour_code_ = cc;
+        Logger::instance().info("dPMR colour code learned:", colour_code_);
+    } else if (bitErrors(cc, colour_code_) > DPMR_CC_ERRORS) {
+        cc_mismatches_++;
+        cc_blocked_ = true;
+        return;
+    }
+    cc_blocked_ = false;
+    headers_decoded_++;
+
+    format_ = info.format;
+    startCall(info.called_id, info.own_id, info.mode, info.emergency);
+}
+
+void DPMRDecoder::processFrame() {
+    frames_decoded_++;
+
+    uint64_t field = frame_.getBits(0, DPMR_SYNC_CC_BITS);
+    if (frame_index_ % 2 == 0) {
+        // Frames 1 and 3 carry FS2
+        if (bitErrors(field, DPMR_FS2) > DPMR_FS2_TRACK_ERRORS) {
+            if (++missed_sync_ > DPMR_MAX_MISSED_SYNC) {
+                lostSync();
+                return;
+            }
+        } else {
+            missed_sync_ = 0;
+        }
+    } else if (colour_code_ != 0) {
+        // Frames 2 and 4 carry the colour code; a mismatch is a co-channel
+        // transmission and blocks voice until the next matching code
+        cc_blocked_ = bitErrors(field, colour_code_) > DPMR_CC_ERRORS;
+        if (cc_blocked_) {
+            cc_mismatches_++;
+        }
+    }
+
+    const auto& scramble = scrambleTable();
+    for (size_t i = 0; i < DPMR_SCRAMBLED_BITS; i++) {
+        size_t index = DPMR_SYNC_CC_BITS + i;
+        frame_.set(index, frame_.get(index) ^ scramble[i]);
+    }
+
+    LinkInfo cch;
+    if (decodeCCH(cch)) {
+        frame_index_ = cch.frame_number;
+        format_ = cch.format;
+
+        // Even frames carry the upper half of the called ID, odd the lower
+        uint8_t part = cch.frame_number & 1;
+        id_parts_[part] = static_cast<uint16_t>(cch.called_id);
+        id_parts_seen_ |= static_cast<uint8_t>(1 << part);
+
+        if (!call_active_ && id_parts_seen_ == 0x3 && !cc_blocked_) {
+            uint32_t called = (static_cast<uint32_t>(id_parts_[0]) << 12) | id_parts_[1];
+            startCall(called, 0, cch.mode, cch.emergency);
+        }
+    } else {
+        crc_errors_++;
+    }
+
+    if (call_active_ && !cc_blocked_) {
+        processVoice();
+    }
+
+    frame_index_ = (frame_index_ + 1) % 4;
+}
+
+void DPMRDecoder::lostSync() {
+    state_ = State::HUNT;
+    frame_.clear();
+    endCall();
+    Logger::instance().debug("dPMR sync lost");
+}
+
+bool DPMRDecoder::decodeHI(size_t start, LinkInfo& info) {
+    // 10 x 12 block interleave over ten Hamming(12,8) codewords
+    constexpr size_t ROWS = DPMR_HI_BITS / 12;
+    uint8_t coded[DPMR_HI_BITS];
+    for (size_t i = 0; i < DPMR_HI_BITS; i++) {
+        coded[i] = frame_.get(start + (i % ROWS) * 12 + i / ROWS);
+    }
+
+    uint8_t data[DPMR_HI_DATA_BITS];
+    for (size_t cw = 0; cw < ROWS; cw++) {
+        if (!decodeHamming12_8(coded + cw * 12, data + cw * 8)) {
+            return false;
+        }
+    }
+
+    // Header type(2) called ID(24) own ID(24) mode(3) format(4)
+    // emergency(1) reserved(14) CRC-8
+    uint8_t received_crc = 0;
+    for (size_t i = 72; i < 80; i++) {
+        received_crc = static_cast<uint8_t>((received_crc << 1) | data[i]);
+    }
+    if (crc8(data, 72) != received_crc) {
+        return false;
+    }
+
+    auto field = [&](size_t pos, size_t len) {
+        uint32_t value = 0;
+        for (size_t i = 0; i < len; i++) {
+            value = (value << 1) | data[pos + i];
+        }
+        return value;
+    };
+
+    info.frame_number = 0;
+    info.called_id = field(2, 24);
+    info.own_id = field(26, 24);
+    info.mode = static_cast<DPMRCommMode>(field(50, 3));
+    info.format = static_cast<DPMRCommFormat>(field(53, 4));
+    info.emergency = field(57, 1) != 0;
+    return true;
+}
+
+bool DPMRDecoder::decodeCCH(LinkInfo& info) {
+    // 6 x 12 block interleave over six Hamming(12,8) codewords
+    constexpr size_t ROWS = DPMR_CCH_BITS / 12;
+    uint8_t coded[DPMR_CCH_BITS];
+    for (size_t i = 0; i < DPMR_CCH_BITS; i++) {
+        coded[i] = frame_.get(DPMR_SYNC_CC_BITS + (i % ROWS) * 12 + i / ROWS);
+    }
+
+    uint8_t data[DPMR_CCH_DATA_BITS];
+    for (size_t cw = 0; cw < ROWS; cw++) {
+        if (!decodeHamming12_8(coded + cw * 12, data + cw * 8)) {
+            return false;
+        }
+    }
+
+    // Frame number(2) called ID part(12) mode(3) format(4) emergency(1)
+    // slow data(19) CRC-7
+    uint8_t received_crc = 0;
+    for (size_t i = 41; i < 48; i++) {
+        received_crc = static_cast<uint8_t>((received_crc << 1) | data[i]);
+    }
+    if (crc7(data, 41) != received_crc) {
+        return false;
+    }
+
+    auto field = [&](size_t pos, size_t len) {
+        uint32_t value = 0;
+        for (size_t i = 0; i < len; i++) {
+            value = (value << 1) | data[pos + i];
+        }
+        return value;
+    };
+
+    info.frame_number = static_cast<uint8_t>(field(0, 2));
+    info.called_id = field(2, 12);
+    info.own_id = 0;
+    info.mode = static_cast<DPMRCommMode>(field(14, 3));
+    info.format = static_cast<DPMRCommFormat>(field(17, 4));
+    info.emergency = field(21, 1) != 0;
+    return true;
+}
+
+void DPMRDecoder::processVoice() {
+    if (format_ != DPMRCommFormat::VOICE &&
+        format_ != DPMRCommFormat::VOICE_SLOW_DATA &&
+        format_ != DPMRCommFormat::VOICE_APPENDED_DATA) {
+        return;
+    }
+
+    voice_batch_.frame_count = 0;
+    voice_batch_.bit_errors = 0;
+    voice_batch_.data.fill(0);
+
+    size_t tch = DPMR_SYNC_CC_BITS + DPMR_CCH_BITS;
+    for (size_t f = 0; f < DPMR_VOICE_FRAMES; f++) {
+        uint8_t* out = voice_batch_.frame(voice_batch_.frame_count++);
+        size_t start = tch + f * DPMR_AMBE_FRAME_BITS;
+        for (size_t i = 0; i < DPMR_AMBE_FRAME_BITS; i++) {
+            out[i / 8] |= static_cast<uint8_t>(frame_.get(start + i) << (7 - (i % 8)));
+        }
+    }
+
+    voice_frames_decoded_ += voice_batch_.frame_count;
+    if (voice_frame_callback_) {
+        voice_frame_callback_(voice_batch_);
+    }
+}
+
+void DPMRDecoder::startCall(uint32_t called_id, uint32_t own_id, DPMRCommMode mode, bool emergency) {
+    if (call_active_ && called_id == called_id_) {
+        // Header repeated within the call (e.g. after late entry)
+        if (own_id != 0) {
+            own_id_ = own_id;
+            voice_batch_.radio_id = own_id;
+        }
+        return;
+    }
+    endCall();
+
+    call_active_ = true;
+    called_id_ = called_id;
+    own_id_ = own_id;
+
+    voice_batch_.codec = CodecType::AMBE_PLUS2;
+    voice_batch_.talkgroup = called_id_;
+    voice_batch_.radio_id = own_id_;
+    voice_batch_.slot = 0;
+    voice_batch_.frame_bytes = DPMR_AMBE_FRAME_BYTES;
+
+    Logger::instance().debug("dPMR call: called =", called_id_, "own =", own_id_);
+
+    // Conventional: the call is on the channel this instance watches
+    if (grant_callback_) {
+        CallGrant grant;
+        grant.talkgroup = called_id_;
+        grant.radio_id = own_id_;
+        grant.frequency = channel_freq_;
+        grant.slot = 0;
+        grant.type = emergency ? CallType::EMERGENCY
+                   : (mode == DPMRCommMode::INDIVIDUAL ? CallType::PRIVATE : CallType::GROUP);
+        grant.priority = emergency ? 10 : 5;
+        grant.timestamp = std::time(nullptr);
+        grant.encrypted = false;
+        grant_callback_(grant);
+    }
+}
+
+void DPMRDecoder::endCall() {
+    id_parts_seen_ = 0;
+    if (!call_active_) {
+        return;
+    }
+    call_active_ = false;
+
+    Logger::instance().debug("dPMR call ended: called =", called_id_);
+    if (call_end_callback_) {
+        call_end_callback_(called_id_);
+    }
+}
+
+bool DPMRDecoder::decodeHamming12_8(const uint8_t* bits, uint8_t* data) {
+    uint8_t parity = 0;
+    for (size_t i = 0; i < 8; i++) {
+        data[i] = bits[i] & 1;
+        if (data[i]) {
+            parity ^= HAMMING_12_8_COLUMNS[i];
+        }
+    }
+
+    uint8_t received = 0;
+    for (size_t i = 8; i < 12; i++) {
+        received = static_cast<uint8_t>((received << 1) | (bits[i] & 1));
+    }
+
+    uint8_t syndrome = parity ^ received;
+    if (syndrome == 0 || __builtin_popcount(syndrome) == 1) {
+        return true;  // Clean, or the error is in a parity bit
+    }
+    for (size_t i = 0; i < 8; i++) {
+        if (HAMMING_12_8_COLUMNS[i] == syndrome) {
+            data[i] ^= 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+uint8_t DPMRDecoder::crc7(const uint8_t* bits, size_t count) {
+    // x^7 + x^3 + 1
+    uint8_t crc = 0;
+    for (size_t i = 0; i < count; i++) {
+        bool feedback = ((crc >> 6) & 1) ^ (bits[i] & 1);
+        crc = static_cast<uint8_t>((crc << 1) & 0x7F);
+        if (feedback) {
+            crc ^= 0x09;
+        }
+    }
+    return crc;
+}
+
+uint8_t DPMRDecoder::crc8(const uint8_t* bits, size_t count) {
+    // x^8 + x^2 + x + 1
+    uint8_t crc = 0;
+    for (size_t i = 0; i < count; i++) {
+        bool feedback = ((crc >> 7) & 1) ^ (bits[i] & 1);
+        crc = static_cast<uint8_t>(crc << 1);
+        if (feedback) {
+            crc ^= 0x07;
+        }
+    }
+    return crc;
+}
+
+} // namespace European
+} // namespace TrunkSDR
@@ -0,0 +1,179 @@
+#ifndef DPMR_DECODER_H
+#define DPMR_DECODER_H
+
+#include "../../decoders/base_decoder.h"
+#include "../../utils/bit_buffer.h"
+#include <array>
+
+namespace TrunkSDR {
+namespace European {
+
+/**
+ * dPMR (digital Private Mobile Radio, ETSI TS 102 490 / TS 102 658) Decoder
+ *
+ * Supports:
+ * - dPMR446 and Mode 1/2 conventional, 4FSK at 2400 sym/s (6.25 kHz)
+ * - Correlation against all four frame sync patterns (FS1-FS4)
+ * - Header (HI) and superframe CCH decoding with CRC checking
+ * - Late entry: called ID reassembled from the CCH of two frames
+ * - Colour code filtering of co-channel traffic
+ * - AMBE+2 voice (four 72-bit frames per 80 ms frame)
+ *
+ * One instance per 6.25 kHz channel. State is a few hundred bytes of
+ * fixed arrays with no heap use after construction, and the code tables
+ * are shared, so a channelized wideband host can run one per channel.
+ *
+ * Header frame:
+ *   FS1 (24 sym) | HI0 (60 sym) | CC (12 sym) | HI1 (60 sym)
+ * Payload frame (80 ms, four per 320 ms superframe):
+ *   FS2 or CC (12 sym) | CCH (36 sym) | TCH (144 sym)
+ * Frames 1 and 3 of a superframe start with FS2, frames 2 and 4 with the
+ * colour code. An end frame starts with FS3; FS4 starts packet data.
+ */
+
+// Frame sync patterns (dibits, MSB first)
+constexpr uint64_t DPMR_FS1 = 0x57FF5F75D577ULL;  // Header, 48 bits
+constexpr uint64_t DPMR_FS2 = 0x5FF77DULL;        // Superframe, 24 bits
+constexpr uint64_t DPMR_FS3 = 0x7DFFD5F55D5FULL;  // End, 48 bits
+constexpr uint64_t DPMR_FS4 = 0xFD55F5DF7FDDULL;  // Packet data header, 48 bits
+
+constexpr int DPMR_FS_LONG_ERRORS = 4;     // Out of 48
+constexpr int DPMR_FS2_ACQUIRE_ERRORS = 2; // Out of 24
+constexpr int DPMR_FS2_TRACK_ERRORS = 4;
+constexpr int DPMR_CC_ERRORS = 3;          // Colour code match, out of 24
+constexpr size_t DPMR_MAX_MISSED_SYNC = 2;
+
+// Field sizes in bits
+constexpr size_t DPMR_FS_LONG_BITS = 48;
+constexpr size_t DPMR_SYNC_CC_BITS = 24;
+constexpr size_t DPMR_HI_BITS = 120;       // 10 x Hamming(12,8)
+constexpr size_t DPMR_HI_DATA_BITS = 80;
+constexpr size_t DPMR_CCH_BITS = 72;       // 6 x Hamming(12,8)
+constexpr size_t DPMR_CCH_DATA_BITS = 48;
+constexpr size_t DPMR_TCH_BITS = 288;
+constexpr size_t DPMR_VOICE_FRAMES = 4;
+constexpr size_t DPMR_AMBE_FRAME_BITS = 72;
+constexpr size_t DPMR_AMBE_FRAME_BYTES = 9;
+
+constexpr size_t DPMR_HEADER_BITS = 2 * DPMR_HI_BITS + DPMR_SYNC_CC_BITS;            // 264 after FS1
+constexpr size_t DPMR_FRAME_BITS = DPMR_SYNC_CC_BITS + DPMR_CCH_BITS + DPMR_TCH_BITS;  // 384
+constexpr size_t DPMR_SCRAMBLED_BITS = DPMR_CCH_BITS + DPMR_TCH_BITS;                 // 360
+
+// Communications format (HI and CCH)
+enum class DPMRCommFormat : uint8_t {
+    VOICE = 0,
+    VOICE_SLOW_DATA = 1,
+    DATA_TYPE1 = 2,
+    DATA_TYPE2 = 3,
+    DATA_TYPE3 = 4,
+    VOICE_APPENDED_DATA = 5
+};
+
+// Communications mode (HI and CCH)
+enum class DPMRCommMode : uint8_t {
+    GROUP = 0,
+    INDIVIDUAL = 1,
+    ALL_CALL = 2,
+    STATUS = 3
+};
+
+class DPMRDecoder : public BaseDecoder {
+public:
+    DPMRDecoder();
+    ~DPMRDecoder() override = default;
+
+    void initialize() override;
+    void processSymbols(const float* symbols, size_t count) override;
+    void reset() override;
+
+    SystemType getSystemType() const override { return SystemType::DPMR; }
+    bool isLocked() const override { return state_ != State::HUNT; }
+
+    // Configuration
+    // 24-bit colour code word; 0 learns it from the first valid header
+    void setColourCode(uint32_t colour_code) { colour_code_ = colour_code & 0xFFFFFF; }
+    // Channel this instance watches; reported in call grants
+    void setChannelFrequency(Frequency freq) { channel_freq_ = freq; }
+
+    // Statistics
+    uint32_t getColourCode() const { return colour_code_; }
+    bool isCallActive() const { return call_active_; }
+    size_t getHeadersDecoded() const { return headers_decoded_; }
+    size_t getFramesDecoded() const { return frames_decoded_; }
+    size_t getCRCErrors() const override { return crc_errors_; }
+    size_t getColourCodeMismatches() const { return cc_mismatches_; }
+    size_t getVoiceFramesDecoded() const { return voice_frames_decoded_; }
+
+private:
+    enum class State : uint8_t {
+        HUNT,       // Searching for any frame sync
+        HEADER,     // Collecting HI0/CC/HI1 after FS1
+        FRAME       // Collecting superframe payload frames
+    };
+
+    // Decoded HI or CCH fields
+    struct LinkInfo {
+        uint8_t frame_number;      // CCH only
+        uint32_t called_id;        // HI: full ID, CCH: 12-bit part
+        uint32_t own_id;           // HI only
+        DPMRCommMode mode;
+        DPMRCommFormat format;
+        bool emergency;
+    };
+
+    // Framing
+    void processDibit(uint8_t dibit);
+    bool huntSync();
+    void processHeader();
+    void processFrame();
+    void lostSync();
+
+    // Field decoding
+    bool decodeHI(size_t start, LinkInfo& info);
+    bool decodeCCH(LinkInfo& info);
+    void processVoice();
+
+    // Call tracking
+    void startCall(uint32_t called_id, uint32_t own_id, DPMRCommMode mode, bool emergency);
+    void endCall();
+
+    // Error correction
+    static bool decodeHamming12_8(const uint8_t* bits, uint8_t* data);
+    static uint8_t crc7(const uint8_t* bits, size_t count);
+    static uint8_t crc8(const uint8_t* bits, size_t count);
+
+    // Sync
+    State state_;
+    uint64_t sync_register_;   // Last 24 dibits
+    size_t missed_sync_;
+    size_t frame_index_;       // Position in superframe, 0-3
+
+    // Bits after FS1 (header) or the whole payload frame
+    PackedBitBuffer<DPMR_FRAME_BITS> frame_;
+
+    // Configuration
+    uint32_t colour_code_;
+    Frequency channel_freq_;
+    bool cc_blocked_;          // Last colour code belonged to another site
+
+    // Call state
+    bool call_active_;
+    uint32_t called_id_;
+    uint32_t own_id_;
+    uint16_t id_parts_[2];     // Late entry: called ID halves from CCH
+    uint8_t id_parts_seen_;    // Bit mask of id_parts_ received
+    DPMRCommFormat format_;
+    VoiceFrameBatch voice_batch_;
+
+    // Statistics
+    size_t headers_decoded_;
+    size_t frames_decoded_;
+    size_t crc_errors_;
+    size_t cc_mismatches_;
+    size_t voice_frames_decoded_;
+};
+
+} // namespace European
+} // namespace TrunkSDR
+
+#endif // DPMR_DECODER_H
@@ -0,0 +1,548 @@
+#include "nxdn_decoder.h"
+#include "../../utils/logger.h"
+#include <algorithm>
+#include <ctime>
+
+namespace TrunkSDR {
+namespace European {
+
+namespace {
+
+// FSK4Demodulator symbol (0 = -3 ... 3 = +3) to NXDN dibit
+constexpr uint8_t SYMBOL_TO_DIBIT[4] = {3, 2, 0, 1};
+
+// Two of every fourteen CAC code bits are punctured
+constexpr size_t CAC_PUNCTURE_PERIOD = 14;
+constexpr size_t CAC_PUNCTURE_POSITIONS[2] = {3, 11};
+
+// One of every four FACCH1 code bits is punctured
+constexpr size_t FACCH1_PUNCTURE_PERIOD = 4;
+constexpr size_t FACCH1_PUNCTURE_POSITION = 1;
+
+// A stolen half of a traffic frame carries FACCH1 instead of voice
+bool facchInHalf(uint8_t option, bool first_half) {
+    return option == NXDN_STEAL_FACCH_BOTH ||
+           option == (first_half ? NXDN_STEAL_FACCH_FIRST : NXDN_STEAL_FACCH_SECOND);
+}
+
+// PN9 (x^9 + x^4 + 1, seed 0x0E4) over the frame body: a 1 inverts the
+// polarity of the symbol, i.e. flips the dibit sign bit
+const std::array<uint8_t, NXDN_BODY_SYMBOLS>& scrambleTable() {
+    static const std::array<uint8_t, NXDN_BODY_SYMBOLS> table = [] {
+        std::array<uint8_t, NXDN_BODY_SYMBOLS> t{};
+        uint16_t pn = 0x0E4;
+        for (size_t i = 0; i < t.size(); i++) {
+            t[i] = pn & 1;
+            pn = static_cast<uint16_t>(((((pn >> 4) ^ pn) & 1) << 8) | (pn >> 1));
+        }
+        return t;
+    }();
+    return table;
+}
+
+} // anonymous namespace
+
+NXDNDecoder::NXDNDecoder(uint32_t symbol_rate)
+    : symbol_rate_(symbol_rate),
+      sync_locked_(false),
+      sync_register_(0),
+      frame_position_(0),
+      missed_fsw_(0),
+      expected_ran_(0),
+      detected_ran_(0),
+      location_id_(0),
+      voice_active_(false),
+      voice_talkgroup_(0),
+      voice_source_(0),
+      frames_decoded_(0),
+      cac_decoded_(0),
+      crc_errors_(0),
+      voice_frames_decoded_(0) {
+
+    body_dibits_.fill(0);
+    voice_batch_ = VoiceFrameBatch();
+}
+
+void NXDNDecoder::initialize() {
+    Logger::instance().info(isNXDN96() ? "NXDN96" : "NXDN48", "decoder initialized");
+    reset();
+}
+
+void NXDNDecoder::reset() {
+    sync_locked_ = false;
+    sync_register_ = 0;
+    frame_position_ = 0;
+    missed_fsw_ = 0;
+    payload_.clear();
+    detected_ran_ = 0;
+    unknown_channels_.clear();
+    voice_active_ = false;
+    frames_decoded_ = 0;
+    cac_decoded_ = 0;
+    crc_errors_ = 0;
+    voice_frames_decoded_ = 0;
+}
+
+void NXDNDecoder::setVoiceTalkgroup(TalkgroupID talkgroup, RadioID source) {
+    voice_talkgroup_ = talkgroup;
+    voice_source_ = source;
+    voice_active_ = false;
+}
+
+void NXDNDecoder::processSymbols(const float* symbols, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        int sym = static_cast<int>(symbols[i]) & 0x3;
+        processDibit(SYMBOL_TO_DIBIT[sym]);
+    }
+}
+
+void NXDNDecoder::processDibit(uint8_t dibit) {
+    sync_register_ = ((sync_register_ << 2) | dibit) & NXDN_FSW_MASK;
+
+    if (!sync_locked_) {
+        if (__builtin_popcount(sync_register_ ^ NXDN_FSW) <= NXDN_FSW_ACQUIRE_ERRORS) {
+            sync_locked_ = true;
+            missed_fsw_ = 0;
+            frame_position_ = NXDN_FSW_SYMBOLS;
+            Logger::instance().info("NXDN sync acquired");
+        }
+        return;
+    }
+
+    if (frame_position_ < NXDN_FSW_SYMBOLS) {
+        // Every frame starts with an FSW; check it once it is complete
+        if (++frame_position_ == NXDN_FSW_SYMBOLS) {
+            if (__builtin_popcount(sync_register_ ^ NXDN_FSW) <= NXDN_FSW_TRACK_ERRORS) {
+                missed_fsw_ = 0;
+            } else if (++missed_fsw_ > NXDN_MAX_MISSED_FSW) {
+                sync_locked_ = false;
+                endVoice();
+                Logger::instance().warning("NXDN sync lost");
+            }
+        }
+        return;
+    }
+
+    size_t index = frame_position_ - NXDN_FSW_SYMBOLS;
+    body_dibits_[index] = dibit ^ (scrambleTable()[index] << 1);
+
+    if (++frame_position_ == NXDN_FRAME_SYMBOLS) {
+        frame_position_ = 0;
+        processFrame();
+    }
+}
+
+void NXDNDecoder::processFrame() {
+    frames_decoded_++;
+
+    NXDNLICH lich;
+    if (!decodeLICH(lich)) {
+        return;
+    }
+
+    // Pack the payload after the LICH
+    payload_.clear();
+    for (size_t i = NXDN_LICH_SYMBOLS; i < NXDN_BODY_SYMBOLS; i++) {
+        payload_.pushDibit(body_dibits_[i]);
+    }
+
+    switch (lich.channel_type) {
+        case NXDNChannelType::RCCH:
+            // Outbound CAC only; inbound CACs are mobile requests
+            if (lich.outbound && lich.function == 0) {
+                processCAC();
+            }
+            break;
+
+        case NXDNChannelType::RTCH:
+            processTraffic(lich);
+            break;
+
+        default:
+            Logger::instance().debug("NXDN channel type", static_cast<int>(lich.channel_type));
+            break;
+    }
+}
+
+bool NXDNDecoder::decodeLICH(NXDNLICH& lich) const {
+    // One LICH bit per symbol, carried in the sign (MSB of the dibit):
+    // RF channel type(2) functional type(2) option(2) direction(1) parity(1)
+    uint8_t bits = 0;
+    for (size_t i = 0; i < NXDN_LICH_SYMBOLS; i++) {
+        bits = static_cast<uint8_t>((bits << 1) | ((body_dibits_[i] >> 1) & 1));
+    }
+
+    // Even parity over the channel and functional types
+    if ((__builtin_popcount(bits >> 4) & 1) != (bits & 1)) {
+        return false;
+    }
+
+    lich.channel_type = static_cast<NXDNChannelType>((bits >> 6) & 0x3);
+    lich.function = (bits >> 4) & 0x3;
+    lich.option = (bits >> 2) & 0x3;
+    lich.outbound = ((bits >> 1) & 1) != 0;
+
+    // Traffic channel function types other than SACCH/UDCH are not defined
+    return lich.channel_type != NXDNChannelType::RDCH;
+}
+
+void NXDNDecoder::processCAC() {
+    uint8_t message[NXDN_CAC_MESSAGE_BYTES];
+    uint8_t sr;
+
+    if (!decodeCAC(message, sr)) {
+        crc_errors_++;
+        Logger::instance().debug("NXDN CAC CRC error");
+        return;
+    }
+    cac_decoded_++;
+
+    // SR: structure(2) RAN(6)
+    detected_ran_ = sr & 0x3F;
+    if (expected_ran_ != 0 && detected_ran_ != expected_ran_) {
+        Logger::instance().debug("NXDN RAN mismatch: expected =", static_cast<int>(expected_ran_),
+                                 "got =", static_cast<int>(detected_ran_));
+        return;
+    }
+
+    processMessage(message);
+}
+
+bool NXDNDecoder::decodeCAC(uint8_t* message, uint8_t& sr) {
+    // Undo the 12 x 25 block interleave
+    int8_t coded[NXDN_CAC_CODED_BITS];
+    for (size_t i = 0; i < NXDN_CAC_CODED_BITS; i++) {
+        coded[i] = static_cast<int8_t>(payload_.get((i % 25) * 12 + i / 25));
+    }
+
+    // Re-insert punctured positions as erasures (-1)
+    int8_t depunctured[NXDN_CAC_DEPUNCTURED_BITS];
+    size_t in = 0;
+    for (size_t i = 0; i < NXDN_CAC_DEPUNCTURED_BITS; i++) {
+        size_t phase = i % CAC_PUNCTURE_PERIOD;
+        if (phase == CAC_PUNCTURE_POSITIONS[0] || phase == CAC_PUNCTURE_POSITIONS[1]) {
+            depunctured[i] = -1;
+        } else {
+            depunctured[i] = coded[in++];
+        }
+    }
+
+    uint8_t decoded[NXDN_CAC_DECODED_BITS];
+    viterbiDecode(depunctured, NXDN_CAC_DECODED_BITS, decoded);
+
+    if (!checkCRC16(decoded, NXDN_CAC_DATA_BITS)) {
+        return false;
+    }
+
+    sr = 0;
+    for (size_t i = 0; i < 8; i++) {
+        sr = static_cast<uint8_t>((sr << 1) | decoded[i]);
+    }
+    for (size_t byte = 0; byte < NXDN_CAC_MESSAGE_BYTES; byte++) {
+        uint8_t value = 0;
+        for (size_t i = 0; i < 8; i++) {
+            value = static_cast<uint8_t>((value << 1) | decoded[8 + byte * 8 + i]);
+        }
+        message[byte] = value;
+    }
+    return true;
+}
+
+void NXDNDecoder::processMessage(const uint8_t* message) {
+    // F1 F2 message type(6)
+    NXDNMessageType type = static_cast<NXDNMessageType>(message[0] & 0x3F);
+
+    switch (type) {
+        case NXDNMessageType::VCALL_ASSGN:
+        case NXDNMessageType::VCALL_ASSGN_DUP:
+            parseVoiceAssignment(message);
+            break;
+
+        case NXDNMessageType::SITE_INFO:
+            parseSiteInfo(message);
+            break;
+
+        case NXDNMessageType::IDLE:
+            break;
+
+        default:
+            Logger::instance().debug("NXDN message type", static_cast<int>(message[0] & 0x3F));
+            break;
+    }
+}
+
+void NXDNDecoder::parseVoiceAssignment(const uint8_t* message) {
+    // CC option(8) call type(3) voice option(5) source(16) destination(16)
+    // call timer(6) channel(10)
+    bool emergency = (message[1] & 0x80) != 0;
+    uint8_t call_type = (message[2] >> 5) & 0x07;
+    RadioID source = (static_cast<RadioID>(message[3]) << 8) | message[4];
+    TalkgroupID destination = (static_cast<TalkgroupID>(message[5]) << 8) | message[6];
+    uint32_t channel = (static_cast<uint32_t>(message[7] & 0x03) << 8) | message[8];
+
+    Frequency freq;
+    if (!lookupChannel(channel, freq)) {
+        return;
+    }
+
+    Logger::instance().debug("NXDN VCALL_ASSGN: TG =", destination, "source =", source,
+                             "channel =", channel, "freq =", freq);
+
+    if (grant_callback_) {
+        CallGrant grant;
+        grant.talkgroup = destination;
+        grant.radio_id = source;
+        grant.frequency = freq;
+        grant.slot = 0;
+        grant.type = emergency ? CallType::EMERGENCY
+                   : (call_type == 4 ? CallType::PRIVATE : CallType::GROUP);
+        grant.priority = emergency ? 10 : 5;
+        grant.timestamp = std::time(nullptr);
+        grant.encrypted = false;  // Cipher type is only in the traffic channel VCALL
+        grant_callback_(grant);
+    }
+}
+
+void NXDNDecoder::parseSiteInfo(const uint8_t* message) {
+    uint32_t location_id = (static_cast<uint32_t>(message[1]) << 16) |
+                           (static_cast<uint32_t>(message[2]) << 8) | message[3];
+    if (location_id == location_id_) {
+        return;
+    }
+    location_id_ = location_id;
+
+    Logger::instance().info("NXDN site: location ID =", location_id_,
+                            "RAN =", static_cast<int>(detected_ran_));
+
+    if (system_info_callback_) {
+        SystemInfo info;
+        info.type = SystemType::NXDN;
+        info.system_id = location_id_;
+        info.nac = 0;
+        info.wacn = 0;
+        info.color_code = detected_ran_;
+        info.symbol_rate = symbol_rate_;
+        system_info_callback_(info);
+    }
+}
+
+bool NXDNDecoder::lookupChannel(uint32_t channel, Frequency& freq) {
+    auto it = channel_map_.find(channel);
+    if (it == channel_map_.end()) {
+        if (unknown_channels_.insert(channel).second) {
+            Logger::instance().warning("NXDN channel", channel,
+                                       "not in channel map, grants on it are ignored");
+        }
+        return false;
+    }
+    freq = it->second;
+    return true;
+}
+
+void NXDNDecoder::processTraffic(const NXDNLICH& lich) {
+    if (!lich.outbound) {
+        return;
+    }
+
+    // Stolen halves carry FACCH1; the call ends on a transmission release
+    // or disconnect, not on signalling in general
+    bool released = false;
+    for (int half = 0; half < 2; half++) {
+        if (!facchInHalf(lich.option, half == 0)) {
+            continue;
+        }
+        uint8_t message[NXDN_FACCH1_MESSAGE_BYTES];
+        if (!decodeFACCH1(NXDN_SACCH_BITS + half * NXDN_FACCH1_CODED_BITS, message)) {
+            crc_errors_++;
+            continue;
+        }
+        NXDNMessageType type = static_cast<NXDNMessageType>(message[0] & 0x3F);
+        released = released || type == NXDNMessageType::TX_REL ||
+                   type == NXDNMessageType::DISC;
+    }
+
+    // NXDN96 traffic uses full-rate (EFR) voice, which has no codec here
+    if (isNXDN96() || voice_talkgroup_ == 0) {
+        if (released) {
+            endVoice();
+        }
+        return;
+    }
+
+    if (!voice_active_) {
+        voice_active_ = true;
+        voice_batch_.codec = CodecType::AMBE_PLUS2;
+        voice_batch_.slot = 0;
+        voice_batch_.frame_bytes = (NXDN_VCH_BITS + 7) / 8;
+        Logger::instance().debug("NXDN voice started: TG =", voice_talkgroup_);
+    }
+
+    voice_batch_.talkgroup = voice_talkgroup_;
+    voice_batch_.radio_id = voice_source_;
+    voice_batch_.frame_count = 0;
+    voice_batch_.bit_errors = 0;
+    voice_batch_.data.fill(0);
+
+    for (size_t vch = 0; vch < NXDN_VCH_PER_FRAME; vch++) {
+        if (facchInHalf(lich.option, vch < NXDN_VCH_PER_FRAME / 2)) {
+            continue;
+        }
+
+        uint8_t* out = voice_batch_.frame(voice_batch_.frame_count++);
+        size_t start = NXDN_SACCH_BITS + vch * NXDN_VCH_BITS;
+        for (size_t i = 0; i < NXDN_VCH_BITS; i++) {
+            out[i / 8] |= static_cast<uint8_t>(payload_.get(start + i) << (7 - (i % 8)));
+        }
+    }
+
+    voice_frames_decoded_ += voice_batch_.frame_count;
+    if (voice_batch_.frame_count > 0 && voice_frame_callback_) {
+        voice_frame_callback_(voice_batch_);
+    }
+
+    if (released) {
+        endVoice();
+    }
+}
+
+bool NXDNDecoder::decodeFACCH1(size_t offset, uint8_t* message) {
+    // Undo the 16 x 9 block interleave
+    int8_t coded[NXDN_FACCH1_CODED_BITS];
+    for (size_t i = 0; i < NXDN_FACCH1_CODED_BITS; i++) {
+        coded[i] = static_cast<int8_t>(payload_.get(offset + (i % 9) * 16 + i / 9));
+    }
+
+    // Re-insert punctured positions as erasures (-1)
+    int8_t depunctured[NXDN_FACCH1_DEPUNCTURED_BITS];
+    size_t in = 0;
+    for (size_t i = 0; i < NXDN_FACCH1_DEPUNCTURED_BITS; i++) {
+        if (i % FACCH1_PUNCTURE_PERIOD == FACCH1_PUNCTURE_POSITION) {
+            depunctured[i] = -1;
+        } else {
+            depunctured[i] = coded[in++];
+        }
+    }
+
+    uint8_t decoded[NXDN_FACCH1_DECODED_BITS];
+    viterbiDecode(depunctured, NXDN_FACCH1_DECODED_BITS, decoded);
+
+    if (!checkCRC12(decoded, NXDN_FACCH1_DATA_BITS)) {
+        return false;
+    }
+
+    for (size_t byte = 0; byte < NXDN_FACCH1_MESSAGE_BYTES; byte++) {
+        uint8_t value = 0;
+        for (size_t i = 0; i < 8; i++) {
+            value = static_cast<uint8_t>((value << 1) | decoded[byte * 8 + i]);
+        }
+        message[byte] = value;
+    }
+    return true;
+}
+
+void NXDNDecoder::endVoice() {
+    if (!voice_active_) {
+        return;
+    }
+    voice_active_ = false;
+
+    Logger::instance().debug("NXDN voice ended: TG =", voice_talkgroup_);
+    if (call_end_callback_ && voice_talkgroup_ != 0) {
+        call_end_callback_(voice_talkgroup_);
+    }
+}
+
+size_t NXDNDecoder::viterbiDecode(const int8_t* symbols, size_t pairs, uint8_t* output) {
+    // K=5, rate 1/2: G1 = 1 + D^3 + D^4, G2 = 1 + D + D^2 + D^4.
+    // State holds the last four inputs, most recent in bit 3. Erased
+    // symbols (-1) add nothing to the branch metric.
+    constexpr size_t STATES = 16;
+    constexpr uint16_t UNREACHABLE = 0x7FFF;
+
+    std::array<uint16_t, STATES> metric;
+    metric.fill(UNREACHABLE);
+    metric[0] = 0;
+
+    // Survivor bit per state per step: the bit shifted out of the state
+    std::array<std::array<uint8_t, STATES>, NXDN_CAC_DECODED_BITS> survivors;
+    pairs = std::min(pairs, survivors.size());
+
+    for (size_t t = 0; t < pairs; t++) {
+        int8_t r1 = symbols[2 * t];
+        int8_t r2 = symbols[2 * t + 1];
+
+        std::array<uint16_t, STATES> next;
+        next.fill(UNREACHABLE);
+
+        for (uint8_t state = 0; state < STATES; state++) {
+            if (metric[state] == UNREACHABLE) {
+                continue;
+            }
+            uint8_t d1 = (state >> 3) & 1, d2 = (state >> 2) & 1;
+            uint8_t d3 = (state >> 1) & 1, d4 = state & 1;
+
+            for (uint8_t d = 0; d < 2; d++) {
+                uint8_t g1 = d ^ d3 ^ d4;
+                uint8_t g2 = d ^ d1 ^ d2 ^ d4;
+                uint16_t cost = metric[state] +
+                                ((r1 >= 0 && r1 != g1) ? 1 : 0) +
+                                ((r2 >= 0 && r2 != g2) ? 1 : 0);
+
+                uint8_t to = static_cast<uint8_t>((d << 3) | (state >> 1));
+                if (cost < next[to]) {
+                    next[to] = cost;
+                    survivors[t][to] = d4;
+                }
+            }
+        }
+        metric = next;
+    }
+
+    // Tail bits flush the encoder to state 0
+    uint8_t state = 0;
+    for (size_t t = pairs; t-- > 0;) {
+        output[t] = (state >> 3) & 1;
+        state = static_cast<uint8_t>(((state << 1) & 0xF) | survivors[t][state]);
+    }
+
+    return metric[0];
+}
+
+bool NXDNDecoder::checkCRC16(const uint8_t* bits, size_t data_bits) {
+    // CRC-16 (x^16 + x^12 + x^5 + 1), preset to all ones
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < data_bits; i++) {
+        bool feedback = ((crc >> 15) & 1) ^ (bits[i] & 1);
+        crc = static_cast<uint16_t>(crc << 1);
+        if (feedback) {
+            crc ^= 0x1021;
+        }
+    }
+
+    uint16_t received = 0;
+    for (size_t i = 0; i < 16; i++) {
+        received = static_cast<uint16_t>((received << 1) | (bits[data_bits + i] & 1));
+    }
+    return crc == received;
+}
+
+bool NXDNDecoder::checkCRC12(const uint8_t* bits, size_t data_bits) {
+    // CRC-12 (x^12 + x^11 + x^3 + x^2 + x + 1), preset to all ones
+    uint16_t crc = 0x0FFF;
+    for (size_t i = 0; i < data_bits; i++) {
+        bool feedback = ((crc >> 11) & 1) ^ (bits[i] & 1);
+        crc = static_cast<uint16_t>((crc << 1) & 0x0FFF);
+        if (feedback) {
+            crc ^= 0x080F;
+        }
+    }
+
+    uint16_t received = 0;
+    for (size_t i = 0; i < 12; i++) {
+        received = static_cast<uint16_t>((received << 1) | (bits[data_bits + i] & 1));
+    }
+    return crc == received;
+}
+
+} // namespace European
+} // namespace TrunkSDR
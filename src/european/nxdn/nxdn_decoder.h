@@ -0,0 +1,186 @@
+#ifndef NXDN_DECODER_H
+#define NXDN_DECODER_H
+
+#include "../../decoders/base_decoder.h"
+#include "../../utils/bit_buffer.h"
+#include <array>
+#include <map>
+#include <set>
+
+namespace TrunkSDR {
+namespace European {
+
+/**
+ * NXDN (Kenwood NEXEDGE / Icom IDAS) Decoder
+ *
+ * Supports:
+ * - NXDN48 (2400 sym/s, 6.25 kHz) and NXDN96 (4800 sym/s, 12.5 kHz)
+ * - Frame Sync Word (FSW) acquisition and per-frame tracking
+ * - LICH (Link Information Channel) decoding and parity check
+ * - CAC (Common Access Channel) on the outbound control channel:
+ *   deinterleave, depuncture, Viterbi (K=5) and CRC-16
+ * - Trunked VCALL_ASSGN grants and SITE_INFO
+ * - NXDN48 EHR (AMBE+2) voice frames on traffic channels
+ * - FACCH1 on traffic channels; TX_REL and DISC end the call
+ *
+ * Frame (192 symbols, 80 ms NXDN48 / 40 ms NXDN96):
+ *   FSW (10 sym) | LICH (8 sym) | payload (174 sym)
+ * Everything after the FSW is scrambled with a PN9 sequence.
+ */
+
+// NXDN frame constants
+constexpr size_t NXDN_FRAME_SYMBOLS = 192;
+constexpr size_t NXDN_FSW_SYMBOLS = 10;
+constexpr size_t NXDN_LICH_SYMBOLS = 8;
+constexpr size_t NXDN_BODY_SYMBOLS = NXDN_FRAME_SYMBOLS - NXDN_FSW_SYMBOLS;       // 182
+constexpr size_t NXDN_PAYLOAD_BITS = (NXDN_BODY_SYMBOLS - NXDN_LICH_SYMBOLS) * 2;  // 348
+
+constexpr uint32_t NXDN_FSW = 0xCDF59;  // -3 +1 -3 +3 -3 -3 +3 +3 -1 +3
+constexpr uint32_t NXDN_FSW_MASK = 0xFFFFF;
+constexpr int NXDN_FSW_ACQUIRE_ERRORS = 2;
+constexpr int NXDN_FSW_TRACK_ERRORS = 4;
+constexpr size_t NXDN_MAX_MISSED_FSW = 3;
+
+// CAC (outbound): 300 coded bits -> 350 depunctured -> 175 decoded
+constexpr size_t NXDN_CAC_CODED_BITS = 300;
+constexpr size_t NXDN_CAC_DEPUNCTURED_BITS = 350;
+constexpr size_t NXDN_CAC_DECODED_BITS = 175;  // 155 data + CRC-16 + 4 tail
+constexpr size_t NXDN_CAC_DATA_BITS = 155;     // SR(8) + message(144) + spare(3)
+constexpr size_t NXDN_CAC_MESSAGE_BYTES = 18;
+
+// Traffic channel: SACCH(60) then four 72-bit EHR voice frames
+constexpr size_t NXDN_SACCH_BITS = 60;
+constexpr size_t NXDN_VCH_BITS = 72;
+constexpr size_t NXDN_VCH_PER_FRAME = 4;
+
+// FACCH1 (in place of two voice frames): 144 coded bits -> 192
+// depunctured -> 96 decoded
+constexpr size_t NXDN_FACCH1_CODED_BITS = 144;
+constexpr size_t NXDN_FACCH1_DEPUNCTURED_BITS = 192;
+constexpr size_t NXDN_FACCH1_DECODED_BITS = 96;  // 80 data + CRC-12 + 4 tail
+constexpr size_t NXDN_FACCH1_DATA_BITS = 80;
+constexpr size_t NXDN_FACCH1_MESSAGE_BYTES = 10;
+
+// LICH RF channel types
+enum class NXDNChannelType {
+    RCCH = 0,    // Control channel
+    RTCH = 1,    // Traffic channel
+    RDCH = 2,    // Data channel
+    RTCH_C = 3   // Composite control/traffic
+};
+
+// LICH steal options on traffic channels
+constexpr uint8_t NXDN_STEAL_FACCH_BOTH = 0;
+constexpr uint8_t NXDN_STEAL_FACCH_FIRST = 1;
+constexpr uint8_t NXDN_STEAL_FACCH_SECOND = 2;
+constexpr uint8_t NXDN_STEAL_NONE = 3;
+
+// Layer 3 message types (RCCH, and FACCH1 on traffic channels)
+enum class NXDNMessageType {
+    VCALL = 0x01,
+    VCALL_ASSGN = 0x04,
+    VCALL_ASSGN_DUP = 0x05,
+    TX_REL = 0x08,
+    IDLE = 0x10,
+    DISC = 0x11,
+    SITE_INFO = 0x18,
+    SRV_INFO = 0x19,
+    CCH_INFO = 0x1A,
+    ADJ_SITE_INFO = 0x1B,
+    UNKNOWN = 0xFF
+};
+
+struct NXDNLICH {
+    NXDNChannelType channel_type;
+    uint8_t function;   // Functional channel type (USC)
+    uint8_t option;     // Steal flags on traffic channels
+    bool outbound;
+};
+
+class NXDNDecoder : public BaseDecoder {
+public:
+    explicit NXDNDecoder(uint32_t symbol_rate = NXDN_SYMBOL_RATE);
+    ~NXDNDecoder() override = default;
+
+    void initialize() override;
+    void processSymbols(const float* symbols, size_t count) override;
+    void reset() override;
+
+    SystemType getSystemType() const override { return SystemType::NXDN; }
+    bool isLocked() const override { return sync_locked_; }
+
+    void setVoiceTalkgroup(TalkgroupID talkgroup, RadioID source) override;
+
+    // Configuration
+    void setRAN(uint8_t ran) { expected_ran_ = ran & 0x3F; }
+    void setChannelMap(const std::map<uint32_t, Frequency>& channels) { channel_map_ = channels; }
+    bool isNXDN96() const { return symbol_rate_ == 2 * NXDN_SYMBOL_RATE; }
+
+    // Statistics
+    uint8_t getRAN() const { return detected_ran_; }
+    uint32_t getLocationID() const { return location_id_; }
+    size_t getFramesDecoded() const { return frames_decoded_; }
+    size_t getCACDecoded() const { return cac_decoded_; }
+    size_t getCRCErrors() const override { return crc_errors_; }
+    size_t getVoiceFramesDecoded() const { return voice_frames_decoded_; }
+
+private:
+    // Framing
+    void processDibit(uint8_t dibit);
+    void processFrame();
+    bool decodeLICH(NXDNLICH& lich) const;
+
+    // Control channel
+    void processCAC();
+    bool decodeCAC(uint8_t* message, uint8_t& sr);
+    void processMessage(const uint8_t* message);
+    void parseVoiceAssignment(const uint8_t* message);
+    void parseSiteInfo(const uint8_t* message);
+    bool lookupChannel(uint32_t channel, Frequency& freq);
+
+    // Traffic channel
+    void processTraffic(const NXDNLICH& lich);
+    bool decodeFACCH1(size_t offset, uint8_t* message);
+    void endVoice();
+
+    // Error correction
+    static size_t viterbiDecode(const int8_t* symbols, size_t pairs, uint8_t* output);
+    static bool checkCRC16(const uint8_t* bits, size_t data_bits);
+    static bool checkCRC12(const uint8_t* bits, size_t data_bits);
+
+    uint32_t symbol_rate_;
+
+    // Sync
+    bool sync_locked_;
+    uint32_t sync_register_;
+    size_t frame_position_;   // Symbol index within the 192-symbol frame
+    size_t missed_fsw_;
+
+    // Current frame body (after FSW), descrambled
+    std::array<uint8_t, NXDN_BODY_SYMBOLS> body_dibits_;
+    PackedBitBuffer<NXDN_PAYLOAD_BITS> payload_;
+
+    // Configuration
+    uint8_t expected_ran_;
+    uint8_t detected_ran_;
+    uint32_t location_id_;
+    std::map<uint32_t, Frequency> channel_map_;
+    std::set<uint32_t> unknown_channels_;  // Reported once each
+
+    // Voice
+    bool voice_active_;
+    TalkgroupID voice_talkgroup_;
+    RadioID voice_source_;
+    VoiceFrameBatch voice_batch_;
+
+    // Statistics
+    size_t frames_decoded_;
+    size_t cac_decoded_;
+    size_t crc_errors_;
+    size_t voice_frames_decoded_;
+};
+
+} // namespace European
+} // namespace TrunkSDR
+
+#endif // NXDN_DECODER_H
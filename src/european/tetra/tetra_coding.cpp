@@ -0,0 +1,139 @@
+#include "tetra_coding.h"
+#include <algorithm>
+
+namespace TrunkSDR {
+namespace European {
+
+namespace {
+
+// Mother code generators; register bit 0 is the newest input bit
+constexpr uint8_t TETRA_GENERATORS[4] = { 0x13, 0x1D, 0x17, 0x1B };
+
+// Rate 2/3 puncturing pattern (1-based positions within 8 mother bits)
+constexpr uint8_t TETRA_PUNCTURE_23[3] = { 1, 2, 5 };
+
+// Encoder output (4 bits, G1 first) for each 5-bit register value
+const std::array<uint8_t, 32>& motherCodeOutputs() {
+    static const std::array<uint8_t, 32> table = [] {
+        std::array<uint8_t, 32> t{};
+        for (uint8_t reg = 0; reg < 32; reg++) {
+            uint8_t out = 0;
+            for (int g = 0; g < 4; g++) {
+                out = static_cast<uint8_t>((out << 1) | (__builtin_popcount(reg & TETRA_GENERATORS[g]) & 1));
+            }
+            t[reg] = out;
+        }
+        return t;
+    }();
+    return table;
+}
+
+} // namespace
+
+uint32_t tetraScramblingInit(uint16_t mcc, uint16_t mnc, uint8_t colour_code) {
+    uint32_t init = (colour_code & 0x3Fu) | ((mnc & 0x3FFFu) << 6) | ((mcc & 0x3FFu) << 20);
+    return (init << 2) | TETRA_SCRAMBLE_INIT_BSCH;
+}
+
+void tetraScramblingSequence(uint32_t init, uint8_t* sequence, size_t count) {
+    // c(x) = 1 + x + x^2 + x^4 + x^5 + x^7 + x^8 + x^10 + x^11 + x^12
+    //          + x^16 + x^22 + x^23 + x^26 + x^32
+    uint32_t lfsr = init;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t bit = (lfsr ^ (lfsr >> 6) ^ (lfsr >> 9) ^ (lfsr >> 10) ^ (lfsr >> 16) ^
+                        (lfsr >> 20) ^ (lfsr >> 21) ^ (lfsr >> 22) ^ (lfsr >> 24) ^
+                        (lfsr >> 25) ^ (lfsr >> 27) ^ (lfsr >> 28) ^ (lfsr >> 30) ^
+                        (lfsr >> 31)) & 1;
+        lfsr = (lfsr >> 1) | (bit << 31);
+        sequence[i] = static_cast<uint8_t>(bit);
+    }
+}
+
+void tetraBlockDeinterleave(const uint8_t* input, uint8_t* output, size_t K, size_t a) {
+    for (size_t i = 1; i <= K; i++) {
+        size_t k = 1 + (a * i) % K;
+        output[i - 1] = input[k - 1];
+    }
+}
+
+void tetraDepuncture23(const uint8_t* input, uint8_t* mother, size_t coded_bits) {
+    size_t mother_bits = coded_bits * 8 / 3;
+    std::fill(mother, mother + mother_bits, TETRA_ERASURE);
+
+    for (size_t j = 0; j < coded_bits; j++) {
+        size_t k = 8 * (j / 3) + TETRA_PUNCTURE_23[j % 3];
+        mother[k - 1] = input[j];
+    }
+}
+
+uint32_t TETRAViterbi::decode(const uint8_t* mother, uint8_t* output, size_t bits) {
+    const std::array<uint8_t, 32>& outputs = motherCodeOutputs();
+    bits = std::min(bits, TETRA_VITERBI_MAX_BITS);
+
+    // The encoder starts in state 0
+    constexpr uint32_t UNREACHABLE = 0x3FFFFFFF;
+    std::array<uint32_t, 16> metrics;
+    std::array<uint32_t, 16> next;
+    metrics.fill(UNREACHABLE);
+    metrics[0] = 0;
+
+    for (size_t t = 0; t < bits; t++) {
+        const uint8_t* received = mother + t * 4;
+        uint16_t decisions = 0;
+
+        for (uint8_t state = 0; state < 16; state++) {
+            // Predecessors differ in the oldest bit; register = x | state
+            uint32_t best = UNREACHABLE;
+            for (uint8_t x = 0; x < 2; x++) {
+                uint8_t previous = static_cast<uint8_t>((state >> 1) | (x << 3));
+                uint8_t expected = outputs[(x << 4) | state];
+
+                uint32_t branch = 0;
+                for (int g = 0; g < 4; g++) {
+                    uint8_t bit = received[g];
+                    if (bit != TETRA_ERASURE && bit != ((expected >> (3 - g)) & 1)) {
+                        branch++;
+                    }
+                }
+
+                uint32_t metric = metrics[previous] + branch;
+                if (metric < best) {
+                    best = metric;
+                    if (x) {
+                        decisions |= static_cast<uint16_t>(1u << state);
+                    } else {
+                        decisions &= static_cast<uint16_t>(~(1u << state));
+                    }
+                }
+            }
+            next[state] = best;
+        }
+
+        decisions_[t] = decisions;
+        metrics = next;
+    }
+
+    // Tail bits return the encoder to state 0
+    uint8_t state = 0;
+    for (size_t t = bits; t-- > 0;) {
+        output[t] = state & 1;
+        uint8_t x = (decisions_[t] >> state) & 1;
+        state = static_cast<uint8_t>((state >> 1) | (x << 3));
+    }
+    return metrics[0];
+}
+
+bool tetraCheckCRC16(const uint8_t* bits, size_t length_with_crc) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < length_with_crc; i++) {
+        uint16_t feedback = static_cast<uint16_t>(((crc >> 15) ^ bits[i]) & 1);
+        crc = static_cast<uint16_t>(crc << 1);
+        if (feedback) {
+            crc ^= 0x1021;
+        }
+    }
+    return crc == 0x1D0F;
+}
+
+} // namespace European
+} // namespace TrunkSDR
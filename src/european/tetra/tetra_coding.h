@@ -0,0 +1,63 @@
+#ifndef TETRA_CODING_H
+#define TETRA_CODING_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace TrunkSDR {
+namespace European {
+
+/**
+ * TETRA lower MAC channel coding (EN 300 392-2 clause 8)
+ *
+ * Downlink blocks go type-1 (information) -> type-2 (+CRC, +tail) ->
+ * type-3 (RCPC coded) -> type-4 (block interleaved) -> type-5 (scrambled).
+ * These helpers undo each step on one-bit-per-byte arrays, using only
+ * caller or member storage so a burst decodes without touching the heap.
+ */
+
+// Scrambling: 32-bit LFSR seeded from the extended colour code. The BSCH
+// is always scrambled with the all-zero colour code.
+constexpr uint32_t TETRA_SCRAMBLE_INIT_BSCH = 0x00000003;
+
+uint32_t tetraScramblingInit(uint16_t mcc, uint16_t mnc, uint8_t colour_code);
+
+// Scrambling sequence for one block; each block restarts the LFSR
+void tetraScramblingSequence(uint32_t init, uint8_t* sequence, size_t count);
+
+// (K, a) block deinterleaver: type-4 bit k = 1 + (a * i) mod K holds
+// type-3 bit i
+void tetraBlockDeinterleave(const uint8_t* input, uint8_t* output, size_t K, size_t a);
+
+// Depunctured positions of the rate 1/4 mother code that carry no bit
+constexpr uint8_t TETRA_ERASURE = 0xFF;
+
+// Rate 2/3 puncturing: keeps mother code bits 1, 2, 5 of every 8.
+// 'coded_bits' type-3 bits expand to coded_bits * 8 / 3 mother code bits.
+void tetraDepuncture23(const uint8_t* input, uint8_t* mother, size_t coded_bits);
+
+// Viterbi decoder for the 16-state rate 1/4 mother code
+// G1 = 1 + D + D^4, G2 = 1 + D^2 + D^3 + D^4, G3 = 1 + D + D^2 + D^4,
+// G4 = 1 + D + D^3 + D^4. Erased positions do not count in the metric.
+constexpr size_t TETRA_VITERBI_MAX_BITS = 292;
+
+class TETRAViterbi {
+public:
+    // Decodes 'bits' type-2 bits (tail included) from bits * 4 mother code
+    // bits. Returns the path metric: the number of coded bits that
+    // disagreed with the decoded sequence.
+    uint32_t decode(const uint8_t* mother, uint8_t* output, size_t bits);
+
+private:
+    std::array<uint16_t, TETRA_VITERBI_MAX_BITS> decisions_;
+};
+
+// CRC-16-CCITT over type-1 bits followed by their 16 CRC bits (sent
+// inverted); a good block leaves the 0x1D0F residue
+bool tetraCheckCRC16(const uint8_t* bits, size_t length_with_crc);
+
+} // namespace European
+} // namespace TrunkSDR
+
+#endif // TETRA_CODING_H
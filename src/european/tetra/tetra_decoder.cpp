@@ -2,24 +2,50 @@
 #include "../../utils/logger.h"
 #include <algorithm>
 #include <cstring>
-#include <sstream>
+#include <ctime>
 
 namespace TrunkSDR {
 namespace European {
 
-// TETRA MAC PDU identifiers
-constexpr uint8_t TETRA_MAC_RESOURCE = 0x00;
-constexpr uint8_t TETRA_MAC_BROADCAST = 0x01;
-constexpr uint8_t TETRA_MAC_D_SETUP = 0x02;
-constexpr uint8_t TETRA_MAC_D_CONNECT = 0x03;
-constexpr uint8_t TETRA_MAC_D_RELEASE = 0x04;
-constexpr uint8_t TETRA_MAC_D_SDS = 0x05;
+namespace {
+
+// LLC PDU types carrying an MLE PDU (the FCS variants end in a 32-bit FCS)
+constexpr uint8_t LLC_BL_ADATA = 0x0;
+constexpr uint8_t LLC_BL_DATA = 0x1;
+constexpr uint8_t LLC_BL_UDATA = 0x2;
+constexpr uint8_t LLC_BL_ACK = 0x3;
+constexpr uint8_t LLC_FCS_FLAG = 0x4;
+constexpr size_t LLC_FCS_BITS = 32;
+
+// MLE protocol discriminators
+constexpr uint8_t MLE_PD_CMCE = 2;
+constexpr uint8_t MLE_PD_MLE = 5;
+
+// CMCE downlink PDU types
+constexpr uint8_t CMCE_D_CONNECT = 2;
+constexpr uint8_t CMCE_D_RELEASE = 6;
+constexpr uint8_t CMCE_D_SETUP = 7;
+constexpr uint8_t CMCE_D_TX_GRANTED = 11;
+constexpr uint8_t CMCE_D_SDS_DATA = 15;
+
+// Call priority 15 is the emergency (pre-emptive) level
+constexpr uint8_t CALL_PRIORITY_EMERGENCY = 15;
+
+// SDS protocol identifiers with 8-bit text
+constexpr uint8_t SDS_PID_SIMPLE_TEXT = 0x02;
+constexpr uint8_t SDS_PID_TEXT = 0x82;
+
+// Carrier offsets from the SYSINFO / channel allocation offset field
+constexpr Frequency CARRIER_OFFSETS[4] = { 0.0, 6250.0, -6250.0, 12500.0 };
+
+} // namespace
 
 TETRADecoder::TETRADecoder()
     : expected_mcc_(0),
       expected_mnc_(0),
       expected_color_code_(0),
       has_system_info_(false),
+      has_sysinfo_(false),
       calls_decoded_(0),
       encrypted_calls_(0),
       clear_calls_(0)
@@ -31,6 +57,11 @@ TETRADecoder::TETRADecoder()
 #ifdef ENABLE_TETRA_DECRYPTION
     decryption_stats_ = {0, 0, 0, 0};
 #endif
+    sysinfo_ = TETRASysInfo{};
+
+    mac_layer_.setSyncCallback([this](const TETRASyncInfo& sync) { processBSCH(sync); });
+    mac_layer_.setSysInfoCallback([this](const TETRASysInfo& info) { processBNCH(info); });
+    mac_layer_.setSDUCallback([this](const TETRATMSDU& sdu) { processMCCH(sdu); });
 }
 
 void TETRADecoder::initialize() {
@@ -45,8 +76,10 @@ void TETRADecoder::initialize() {
 
 void TETRADecoder::reset() {
     phy_layer_.reset();
+    mac_layer_.reset();
     active_calls_.clear();
     has_system_info_ = false;
+    has_sysinfo_ = false;
     calls_decoded_ = 0;
     encrypted_calls_ = 0;
     clear_calls_ = 0;
@@ -56,209 +89,237 @@ void TETRADecoder::processSymbols(const float* symbols, size_t count) {
     // Feed symbols to physical layer
     phy_layer_.processSymbols(symbols, count);
 
-    // Process any decoded bursts
+    // Bursts are read in place from the PHY ring
     while (phy_layer_.hasBurst()) {
-        TETRABurst burst = phy_layer_.getBurst();
-        if (burst.crc_valid) {
-            processBurst(burst);
-        }
+        processBurst(phy_layer_.frontBurst());
+        phy_layer_.popBurst();
     }
 }
 
 void TETRADecoder::processBurst(const TETRABurst& burst) {
-    // Route burst to appropriate handler based on logical channel
-    switch (burst.channel) {
-        case TETRALogicalChannel::BSCH:
-            processBSCH(burst.bits.data(), burst.bits.size());
-            break;
-
-        case TETRALogicalChannel::BNCH:
-            processBNCH(burst.bits.data(), burst.bits.size());
-            break;
-
-        case TETRALogicalChannel::MCCH:
-        case TETRALogicalChannel::AACH:
-        case TETRALogicalChannel::SCH_F:
-        case TETRALogicalChannel::SCH_HD:
-            processMCCH(burst.bits.data(), burst.bits.size());
-            break;
+    for (size_t i = 0; i < burst.block_count; i++) {
+        const TETRABlock& block = burst.blocks[i];
 
-        case TETRALogicalChannel::TCH:
-        case TETRALogicalChannel::STCH:
-            processTCH(burst.bits.data(), burst.bits.size());
-            break;
-
-        default:
-            Logger::instance().debug("Unknown TETRA logical channel");
-            break;
+        if (block.channel == TETRALogicalChannel::TCH) {
+            processTCH(block.bits.data(), block.length);
+        } else if (block.crc_valid) {
+            mac_layer_.processBlock(burst, block);
+        }
     }
 }
 
-void TETRADecoder::processBSCH(const uint8_t* data, size_t length) {
-    // Broadcast Synchronization Channel - contains basic system info
-    if (length < 60) {
+void TETRADecoder::processBSCH(const TETRASyncInfo& sync) {
+    // Broadcast Synchronization Channel - cell identity. The PHY has
+    // already taken the TDMA time and scrambling code from this block.
+    if ((expected_mcc_ != 0 && sync.mcc != expected_mcc_) ||
+        (expected_mnc_ != 0 && sync.mnc != expected_mnc_) ||
+        (expected_color_code_ != 0 && sync.colour_code != expected_color_code_)) {
         return;
     }
 
-    // Extract MCC (10 bits, starting at bit 0)
-    uint16_t mcc = static_cast<uint16_t>(extractBits(data, 0, 10));
-
-    // Extract MNC (14 bits, starting at bit 10)
-    uint16_t mnc = static_cast<uint16_t>(extractBits(data, 10, 14));
-
-    // Extract color code (6 bits, starting at bit 24)
-    uint8_t cc = static_cast<uint8_t>(extractBits(data, 24, 6));
-
-    system_info_.mcc = mcc;
-    system_info_.mnc = mnc;
-    system_info_.color_code = cc & 0x03;  // Usually only 2 bits used
+    bool changed = !has_system_info_ || sync.mcc != system_info_.mcc ||
+                   sync.mnc != system_info_.mnc || sync.colour_code != system_info_.color_code;
+    if (!changed) {
+        return;
+    }
 
-    // Determine if emergency services based on MCC/MNC
-    // This is a simplified check - full implementation would use lookup table
-    system_info_.emergency_services = (mcc >= 200 && mcc <= 799);
+    mac_layer_.reset();
 
+    system_info_.mcc = sync.mcc;
+    system_info_.mnc = sync.mnc;
+    system_info_.color_code = sync.colour_code;
     has_system_info_ = true;
 
-    Logger::instance().info("TETRA System: MCC=%u, MNC=%u, CC=%u, Emergency=%s",
-                 mcc, mnc, system_info_.color_code,
-                 system_info_.emergency_services ? "YES" : "NO");
+    Logger::instance().info("TETRA System: MCC =", sync.mcc, "MNC =", sync.mnc,
+                            "CC =", static_cast<int>(sync.colour_code));
 
     // Notify via callback
     if (system_info_callback_) {
         SystemInfo info;
         info.type = SystemType::TETRA;
-        info.system_id = (mcc << 16) | mnc;
+        info.system_id = (sync.mcc << 16) | sync.mnc;
+        info.nac = 0;
+        info.wacn = 0;
+        info.color_code = sync.colour_code;
+        info.symbol_rate = TETRA_SYMBOL_RATE;
         info.name = "TETRA System";
         system_info_callback_(info);
     }
 }
 
-void TETRADecoder::processBNCH(const uint8_t* data, size_t length) {
-    // Broadcast Network Channel - contains network parameters
-    if (length < 80) {
+void TETRADecoder::processBNCH(const TETRASysInfo& sysinfo) {
+    // Broadcast Network Channel - carrier numbering and location area
+    bool changed = !has_sysinfo_ || sysinfo.main_carrier != sysinfo_.main_carrier ||
+                   sysinfo.band != sysinfo_.band || sysinfo.offset != sysinfo_.offset ||
+                   sysinfo.location_area != sysinfo_.location_area;
+    sysinfo_ = sysinfo;
+    has_sysinfo_ = true;
+    if (!changed) {
         return;
     }
 
-    // Extract location area (16 bits)
-    uint16_t location_area = static_cast<uint16_t>(extractBits(data, 0, 16));
-    system_info_.location_area = location_area;
+    TETRAChannelAllocation main_carrier{};
+    main_carrier.carrier = sysinfo.main_carrier;
+    Frequency freq = 0;
+    carrierToFrequency(main_carrier, freq);
+
+    system_info_.location_area = sysinfo.location_area;
+    system_info_.control_channels.assign(1, freq);
+    system_info_.emergency_services = freq >= 380e6 && freq <= 400e6;
+
+    Logger::instance().info("TETRA SYSINFO: main carrier", sysinfo.main_carrier,
+                            "(", freq / 1e6, "MHz ) LA =", sysinfo.location_area,
+                            "secondary CCs =", static_cast<int>(sysinfo.secondary_control_channels));
+}
+
+void TETRADecoder::followCell(const TETRADecoder& main_carrier) {
+    system_info_ = main_carrier.system_info_;
+    has_system_info_ = main_carrier.has_system_info_;
+    sysinfo_ = main_carrier.sysinfo_;
+    has_sysinfo_ = main_carrier.has_sysinfo_;
 
-    // Extract network name if present (simplified)
-    // Full implementation would decode text according to TETRA character set
-    std::string network_name = bitsToString(data, 32, std::min(size_t(64), length - 32));
-    if (!network_name.empty()) {
-        system_info_.network_name = network_name;
-        Logger::instance().info("TETRA Network: %s (LA=%u)", network_name.c_str(), location_area);
+    if (has_system_info_) {
+        phy_layer_.setScramblingCode(system_info_.mcc, system_info_.mnc, system_info_.color_code);
     }
 }
 
-void TETRADecoder::processMCCH(const uint8_t* data, size_t length) {
-    // Main Control Channel - contains call grants and control messages
-    if (length < 16) {
+bool TETRADecoder::carrierToFrequency(const TETRAChannelAllocation& allocation,
+                                      Frequency& freq) const {
+    uint8_t band;
+    uint8_t offset;
+    if (allocation.extended) {
+        band = allocation.band;
+        offset = allocation.offset;
+    } else if (has_sysinfo_) {
+        band = sysinfo_.band;
+        offset = sysinfo_.offset;
+    } else {
+        return false;
+    }
+
+    // Downlink = band * 100 MHz + carrier * 25 kHz + offset
+    freq = band * 100e6 + allocation.carrier * static_cast<Frequency>(TETRA_CHANNEL_SPACING) +
+           CARRIER_OFFSETS[offset & 0x3];
+    return true;
+}
+
+void TETRADecoder::processMCCH(const TETRATMSDU& sdu) {
+    // TM-SDU: LLC header, then the MLE protocol discriminator
+    const uint8_t* data = sdu.bits;
+    size_t length = sdu.length;
+    if (length < 4) {
         return;
     }
 
-    TETRAPDUType pdu_type = identifyPDU(data, length);
+    uint8_t llc_type = static_cast<uint8_t>(extractBits(data, 0, 4));
+    size_t pos;
+    switch (llc_type & ~LLC_FCS_FLAG) {
+        case LLC_BL_ADATA: pos = 6; break;   // N(R), N(S)
+        case LLC_BL_DATA:  pos = 5; break;   // N(S)
+        case LLC_BL_UDATA: pos = 4; break;
+        case LLC_BL_ACK:   pos = 5; break;   // N(R)
+        default:
+            return;   // Advanced link
+    }
+    if (llc_type & LLC_FCS_FLAG) {
+        if (length < pos + LLC_FCS_BITS) {
+            return;
+        }
+        length -= LLC_FCS_BITS;
+    }
+    if (length < pos + 8) {
+        return;   // BL-ACK without MLE payload
+    }
 
-    switch (pdu_type) {
-        case TETRAPDUType::SYSTEM_INFO:
-            parseSystemInfo(data, length);
-            break;
+    uint8_t discriminator = static_cast<uint8_t>(extractBits(data, pos, 3));
+    pos += 3;
 
+    if (discriminator == MLE_PD_MLE) {
+        parseSystemInfo(data + pos, length - pos);
+        return;
+    }
+    if (discriminator != MLE_PD_CMCE) {
+        return;
+    }
+
+    uint8_t cmce_type = static_cast<uint8_t>(extractBits(data, pos, 5));
+    pos += 5;
+
+    switch (identifyPDU(cmce_type)) {
         case TETRAPDUType::CALL_GRANT:
-            parseCallGrant(data, length);
+            parseCallGrant(sdu, cmce_type, data + pos, length - pos);
             break;
 
         case TETRAPDUType::CALL_RELEASE:
-            parseCallRelease(data, length);
+            parseCallRelease(data + pos, length - pos);
             break;
 
         case TETRAPDUType::SHORT_DATA:
-            parseShortData(data, length);
+            parseShortData(data + pos, length - pos);
             break;
 
         default:
-            Logger::instance().debug("Unknown TETRA PDU type");
+            Logger::instance().debug("TETRA CMCE PDU", static_cast<int>(cmce_type));
             break;
     }
 }
 
 void TETRADecoder::processTCH(const uint8_t* data, size_t length) {
-    // Traffic Channel - voice or data
-    // Check for stealing channel (STCH) which carries short data in voice bursts
+    // Traffic Channel - voice or data. Speech is classified as clear or
+    // encrypted but not channel decoded: there is no TCH/S decoder or
+    // ACELP codec in the tree.
 
     if (length < 10) {
         return;
     }
 
-    // Check stealing bits (bit 0 and bit 114 typically)
-    bool stealing_flag = (data[0] == 1);
-
-    if (stealing_flag) {
-        // STCH - parse short data
-        parseShortData(data, length);
-    } else {
-        // Regular voice frame
-        // Check if this voice frame is encrypted
-        EncryptionType encryption = detectEncryption(data);
+    // Check if this voice frame is encrypted
+    EncryptionType encryption = detectEncryption(data);
 
 #ifdef ENABLE_TETRA_DECRYPTION
-        if (encryption == EncryptionType::TEA1 && decryption_enabled_ && decryption_authorized_) {
-            // Attempt real-time decryption
-            // Create mutable copy for decryption
-            std::vector<uint8_t> mutable_data(data, data + length);
-
-            // Find the call ID for this traffic channel (simplified - would track from grants)
-            uint32_t call_id = 0; // Would be determined from channel/slot tracking
-
-            if (decryptVoiceFrame(mutable_data.data(), mutable_data.size(), call_id)) {
-                Logger::instance().info("✓ TETRA voice frame decrypted in real-time");
-                // Pass decrypted data to codec decoder
-                // In full implementation: invoke ACELP decoder with mutable_data
-                decryption_stats_.tea1_calls_decrypted++;
-            } else {
-                Logger::instance().warning("✗ TETRA voice frame decryption failed");
-                decryption_stats_.decryption_failures++;
-            }
-        } else if (encryption != EncryptionType::NONE) {
-            if (encryption == EncryptionType::TEA1) {
-                Logger::instance().debug("TETRA voice frame: TEA1 encrypted (decryption not enabled)");
-            } else {
-                Logger::instance().debug("TETRA voice frame: Encrypted with secure algorithm (TEA2/3/4)");
-            }
+    if (encryption == EncryptionType::TEA1 && decryption_enabled_ && decryption_authorized_) {
+        // Attempt real-time decryption on a copy of the block
+        std::array<uint8_t, TETRA_FULL_BLOCK_BITS> mutable_data;
+        std::copy(data, data + length, mutable_data.begin());
+
+        // Find the call ID for this traffic channel (simplified - would track from grants)
+        uint32_t call_id = 0; // Would be determined from channel/slot tracking
+
+        if (decryptVoiceFrame(mutable_data.data(), length, call_id)) {
+            Logger::instance().info("✓ TETRA voice frame decrypted in real-time");
+            decryption_stats_.tea1_calls_decrypted++;
         } else {
-            Logger::instance().debug("TETRA voice frame: Clear (not encrypted)");
-            // Pass clear voice to codec decoder
-            // In full implementation: invoke ACELP decoder
+            Logger::instance().warning("✗ TETRA voice frame decryption failed");
+            decryption_stats_.decryption_failures++;
         }
-#else
-        // Decryption not compiled in
-        if (encryption != EncryptionType::NONE) {
-            Logger::instance().debug("TETRA voice frame: Encrypted (decryption not available)");
+    } else if (encryption != EncryptionType::NONE) {
+        if (encryption == EncryptionType::TEA1) {
+            Logger::instance().debug("TETRA voice frame: TEA1 encrypted (decryption not enabled)");
         } else {
-            Logger::instance().debug("TETRA voice frame: Clear");
-            // Pass to codec decoder
+            Logger::instance().debug("TETRA voice frame: Encrypted with secure algorithm (TEA2/3/4)");
         }
-#endif
+    } else {
+        Logger::instance().debug("TETRA voice frame: Clear (not encrypted)");
     }
-}
-
-TETRAPDUType TETRADecoder::identifyPDU(const uint8_t* data, size_t length) {
-    if (length < 8) {
-        return TETRAPDUType::UNKNOWN;
+#else
+    // Decryption not compiled in
+    if (encryption != EncryptionType::NONE) {
+        Logger::instance().debug("TETRA voice frame: Encrypted (decryption not available)");
+    } else {
+        Logger::instance().debug("TETRA voice frame: Clear");
     }
+#endif
+}
 
-    // PDU type is in first 8 bits (MAC PDU type)
-    uint8_t pdu_id = static_cast<uint8_t>(extractBits(data, 0, 8));
-
-    switch (pdu_id) {
-        case TETRA_MAC_BROADCAST:
-            return TETRAPDUType::SYSTEM_INFO;
-        case TETRA_MAC_D_SETUP:
+TETRAPDUType TETRADecoder::identifyPDU(uint8_t cmce_type) {
+    switch (cmce_type) {
+        case CMCE_D_SETUP:
+        case CMCE_D_CONNECT:
+        case CMCE_D_TX_GRANTED:
             return TETRAPDUType::CALL_GRANT;
-        case TETRA_MAC_D_RELEASE:
+        case CMCE_D_RELEASE:
             return TETRAPDUType::CALL_RELEASE;
-        case TETRA_MAC_D_SDS:
+        case CMCE_D_SDS_DATA:
             return TETRAPDUType::SHORT_DATA;
         default:
             return TETRAPDUType::UNKNOWN;
@@ -266,94 +327,114 @@ TETRAPDUType TETRADecoder::identifyPDU(const uint8_t* data, size_t length) {
 }
 
 void TETRADecoder::parseSystemInfo(const uint8_t* data, size_t length) {
-    // Additional system information from MAC layer
-    // This supplements what's in BSCH/BNCH
-    Logger::instance().debug("TETRA system info PDU");
+    // MLE broadcasts (D-NWRK-BROADCAST and friends) supplement SYSINFO
+    if (length >= 3) {
+        Logger::instance().debug("TETRA MLE PDU", extractBits(data, 0, 3));
+    }
 }
 
-void TETRADecoder::parseCallGrant(const uint8_t* data, size_t length) {
-    if (length < 80) {
+void TETRADecoder::parseCallGrant(const TETRATMSDU& sdu, uint8_t cmce_type,
+                                  const uint8_t* data, size_t length) {
+    // D-SETUP:      Call ID(14) | Timeout(4) | Hook(1) | Duplex(1) | Basic service(8) |
+    //               Tx grant(2) | Tx request permission(1) | Priority(4) | O-bit(1) ...
+    // D-CONNECT:    Call ID(14) | Timeout(4) | Hook(1) | Duplex(1) | Tx grant(2) | ...
+    // D-TX-GRANTED: Call ID(14) | Tx grant(2) | ...
+    if (length < 35) {
         return;
     }
 
-    TETRACall call;
-
-    // Extract call type (4 bits at offset 8)
-    uint8_t call_type_bits = static_cast<uint8_t>(extractBits(data, 8, 4));
+    uint32_t call_id = extractBits(data, 0, 14);
+    bool group = sdu.address_type != TETRAAddressType::SMI &&
+                 sdu.address_type != TETRAAddressType::SMI_EVENT_LABEL;
+    bool end_to_end = false;
+    uint8_t priority = 0;
+    RadioID source = 0;
+
+    if (cmce_type == CMCE_D_SETUP) {
+        // Basic service: Circuit mode(3) | Encryption flag(1) | Communication type(2) | Slots(2)
+        end_to_end = extractBits(data, 23, 1) != 0;
+        group = extractBits(data, 24, 2) != 0;
+        priority = static_cast<uint8_t>(extractBits(data, 31, 4));
+
+        // Optional: notification indicator, temporary address, calling party
+        size_t pos = 35;
+        if (pos < length && extractBits(data, pos++, 1)) {
+            if (pos < length && extractBits(data, pos++, 1)) {
+                pos += 6;
+            }
+            if (pos < length && extractBits(data, pos++, 1)) {
+                pos += 24;
+            }
+            if (pos + 27 <= length && extractBits(data, pos++, 1)) {
+                uint8_t party_type = static_cast<uint8_t>(extractBits(data, pos, 2));
+                if (party_type == 1 || party_type == 2) {
+                    source = extractBits(data, pos + 2, 24);
+                }
+            }
+        }
+    }
 
-    if (call_type_bits == 0) {
-        call.type = CallType::GROUP;
-    } else if (call_type_bits == 1) {
-        call.type = CallType::PRIVATE;
-    } else if (call_type_bits == 4) {
+    auto existing = active_calls_.find(call_id);
+    bool new_call = existing == active_calls_.end();
+    TETRACall& call = active_calls_[call_id];
+    if (new_call) {
+        call = TETRACall{};
+        call.call_id = call_id;
+        call.talkgroup = sdu.address;
+        call.type = group ? CallType::GROUP : CallType::PRIVATE;
+        call.encryption = EncryptionType::NONE;
+        calls_decoded_++;
+    }
+    if (source != 0) {
+        call.radio_id = source;
+    }
+    if (priority == CALL_PRIORITY_EMERGENCY) {
         call.type = CallType::EMERGENCY;
         call.is_emergency = true;
-    } else {
-        call.type = CallType::UNKNOWN;
+    }
+    if (sdu.encryption_mode != 0 || end_to_end) {
+        call.encryption = EncryptionType::UNKNOWN_ENCRYPTED;
+    }
+    call.timestamp = static_cast<uint64_t>(std::time(nullptr));
+
+    // Traffic channel: carrier and timeslot from the MAC channel allocation
+    uint8_t slot = 0;
+    if (sdu.allocation.valid) {
+        Frequency freq;
+        if (carrierToFrequency(sdu.allocation, freq)) {
+            call.frequency = freq;
+        }
+        for (uint8_t tn = 0; tn < TETRA_SLOTS_PER_FRAME; tn++) {
+            if (sdu.allocation.timeslots & (0x8 >> tn)) {
+                slot = tn + 1;
+                break;
+            }
+        }
     }
 
-    // Extract talkgroup/destination (24 bits at offset 12)
-    call.talkgroup = extractBits(data, 12, 24);
-
-    // Extract source radio ID (24 bits at offset 36)
-    call.radio_id = extractBits(data, 36, 24);
-
-    // Extract frequency information (12 bits at offset 60)
-    uint32_t freq_index = extractBits(data, 60, 12);
-
-    // Calculate actual frequency (simplified - depends on band and base freq)
-    // For 380-400 MHz emergency band:
-    double base_freq = 380000000.0;  // 380 MHz
-    call.frequency = base_freq + (freq_index * TETRA_CHANNEL_SPACING);
-
-    // Detect encryption (2 bits at offset 72)
-    call.encryption = detectEncryption(data + 9);
-
-    call.timestamp = 0;  // Would use actual timestamp
-    call.call_id = calls_decoded_;
-
-    // Store active call
-    active_calls_[call.call_id] = call;
-    calls_decoded_++;
-
-    if (call.encryption != EncryptionType::NONE) {
-        encrypted_calls_++;
-
+    if (new_call) {
+        if (call.encryption != EncryptionType::NONE) {
+            encrypted_calls_++;
+        } else {
+            clear_calls_++;
+        }
+        Logger::instance().info("TETRA Call Grant: TG =", call.talkgroup, "Source =", call.radio_id,
+                                "Freq =", call.frequency / 1e6, "MHz TS =", static_cast<int>(slot),
+                                call.encryption != EncryptionType::NONE ? "[ENCRYPTED]" : "[CLEAR]");
 #ifdef ENABLE_TETRA_DECRYPTION
-        if (call.encryption == EncryptionType::TEA1) {
+        if (call.encryption != EncryptionType::NONE) {
             decryption_stats_.tea1_calls_encountered++;
-            Logger::instance().warning("TETRA Call Grant: TG=%u, Source=%u, Freq=%.4f MHz [TEA1 ENCRYPTED - VULNERABLE]",
-                           call.talkgroup, call.radio_id, call.frequency / 1e6);
-
-            // If decryption is enabled and authorized, prepare for key recovery
-            if (decryption_enabled_ && decryption_authorized_) {
-                Logger::instance().info("  → Will attempt key recovery when traffic begins");
-            } else {
-                Logger::instance().info("  → Decryption not enabled (use --enable-decryption)");
-            }
-        } else {
-            Logger::instance().warning("TETRA Call Grant: TG=%u, Source=%u, Freq=%.4f MHz [%s ENCRYPTED - SECURE]",
-                           call.talkgroup, call.radio_id, call.frequency / 1e6,
-                           (call.encryption == EncryptionType::TEA2 ? "TEA2" :
-                            call.encryption == EncryptionType::TEA3 ? "TEA3" : "TEA4"));
         }
-#else
-        Logger::instance().warning("TETRA Call Grant: TG=%u, Source=%u, Freq=%.4f MHz [ENCRYPTED %d]",
-                       call.talkgroup, call.radio_id, call.frequency / 1e6,
-                       static_cast<int>(call.encryption));
 #endif
-    } else {
-        clear_calls_++;
-        Logger::instance().info("TETRA Call Grant: TG=%u, Source=%u, Freq=%.4f MHz [CLEAR]",
-                    call.talkgroup, call.radio_id, call.frequency / 1e6);
     }
 
-    // Notify via callback
-    if (grant_callback_) {
+    // Notify via callback once the traffic channel is known
+    if (grant_callback_ && call.frequency > 0 && slot != 0) {
         CallGrant grant;
         grant.talkgroup = call.talkgroup;
         grant.radio_id = call.radio_id;
         grant.frequency = call.frequency;
+        grant.slot = slot;
         grant.type = call.type;
         grant.encrypted = (call.encryption != EncryptionType::NONE);
         grant.priority = call.is_emergency ? 10 : 5;
@@ -363,35 +444,63 @@ void TETRADecoder::parseCallGrant(const uint8_t* data, size_t length) {
 }
 
 void TETRADecoder::parseCallRelease(const uint8_t* data, size_t length) {
-    if (length < 32) {
+    // D-RELEASE: Call ID(14) | Disconnect cause(5)
+    if (length < 19) {
         return;
     }
 
-    // Extract call ID (24 bits)
-    uint32_t call_id = extractBits(data, 8, 24);
+    uint32_t call_id = extractBits(data, 0, 14);
 
     // Remove from active calls
     auto it = active_calls_.find(call_id);
     if (it != active_calls_.end()) {
-        Logger::instance().info("TETRA Call Release: TG=%u", it->second.talkgroup);
+        Logger::instance().info("TETRA Call Release: TG =", it->second.talkgroup,
+                                "cause =", extractBits(data, 14, 5));
+        if (call_end_callback_) {
+            call_end_callback_(it->second.talkgroup);
+        }
         active_calls_.erase(it);
     }
 }
 
 void TETRADecoder::parseShortData(const uint8_t* data, size_t length) {
-    // Short Data Service (SDS) - text messages, status, GPS, etc.
-    if (length < 32) {
+    // D-SDS-DATA: Calling party type(2) | Address(24/48) | SDS type(2) | Data
+    if (length < 28) {
         return;
     }
 
-    // SDS type (4 bits)
-    uint8_t sds_type = static_cast<uint8_t>(extractBits(data, 8, 4));
+    uint8_t party_type = static_cast<uint8_t>(extractBits(data, 0, 2));
+    uint32_t source = extractBits(data, 2, 24);
+    size_t pos = party_type == 2 ? 50 : 26;
+    if (pos + 2 > length) {
+        return;
+    }
+    uint8_t sds_type = static_cast<uint8_t>(extractBits(data, pos, 2));
+    pos += 2;
 
-    // Extract text data (simplified - would decode properly)
-    std::string sds_text = bitsToString(data, 32, std::min(size_t(128), length - 32));
+    // Types 0-2 are 16/32/64-bit status values; type 3 is user data
+    if (sds_type != 3) {
+        Logger::instance().info("TETRA SDS status from", source, "type", static_cast<int>(sds_type));
+        return;
+    }
+    if (pos + 19 > length) {
+        return;
+    }
+    size_t data_bits = std::min(static_cast<size_t>(extractBits(data, pos, 11)), length - pos - 11);
+    pos += 11;
+    uint8_t protocol = static_cast<uint8_t>(extractBits(data, pos, 8));
+
+    // Text messages: skip the SDS-TL / text coding headers
+    size_t text_offset = protocol == SDS_PID_SIMPLE_TEXT ? 16 : protocol == SDS_PID_TEXT ? 32 : 0;
+    if (text_offset == 0 || data_bits <= text_offset) {
+        Logger::instance().info("TETRA SDS from", source, "protocol", static_cast<int>(protocol),
+                                "(", data_bits, "bits )");
+        return;
+    }
 
+    std::string sds_text = bitsToString(data, pos + text_offset, data_bits - text_offset);
     if (!sds_text.empty()) {
-        Logger::instance().info("TETRA SDS: %s", sds_text.c_str());
+        Logger::instance().info("TETRA SDS from", source, ":", sds_text);
     }
 }
 
@@ -423,28 +532,24 @@ EncryptionType TETRADecoder::detectEncryption(const uint8_t* data) {
 uint32_t TETRADecoder::extractBits(const uint8_t* data, size_t start, size_t count) {
     uint32_t value = 0;
     for (size_t i = 0; i < count && i < 32; i++) {
-        size_t bit_idx = start + i;
-        size_t byte_idx = bit_idx / 8;
-        size_t bit_in_byte = 7 - (bit_idx % 8);
-
-        uint8_t bit = (data[byte_idx] >> bit_in_byte) & 1;
-        value = (value << 1) | bit;
+        value = (value << 1) | (data[start + i] & 1);
     }
     return value;
 }
 
 std::string TETRADecoder::bitsToString(const uint8_t* data, size_t start, size_t length) {
-    // Simplified text extraction - TETRA uses specific character encoding
-    std::ostringstream oss;
+    // 8-bit text (ISO 8859-1); non-printable characters are dropped
+    std::string text;
+    text.reserve(length / 8);
 
     for (size_t i = 0; i < length / 8; i++) {
         uint8_t ch = static_cast<uint8_t>(extractBits(data, start + i * 8, 8));
         if (ch >= 32 && ch < 127) {  // Printable ASCII
-            oss << static_cast<char>(ch);
+            text.push_back(static_cast<char>(ch));
         }
     }
 
-    return oss.str();
+    return text;
 }
 
 std::vector<TETRACall> TETRADecoder::getActiveCalls() const {
@@ -487,7 +592,7 @@ bool TETRADecoder::decryptVoiceFrame(uint8_t* data, size_t length, uint32_t call
         // Get call information
         auto call_it = active_calls_.find(call_id);
         if (call_it == active_calls_.end()) {
-            Logger::instance().error("Cannot decrypt: Unknown call ID %u", call_id);
+            Logger::instance().error("Cannot decrypt: Unknown call ID", call_id);
             return false;
         }
 
@@ -523,14 +628,14 @@ bool TETRADecoder::decryptVoiceFrame(uint8_t* data, size_t length, uint32_t call
 
 bool TETRADecoder::attemptKeyRecovery(const uint8_t* ciphertext, size_t length,
                                       uint32_t network_id, uint32_t talkgroup) {
-    Logger::instance().info("Attempting TEA1 key recovery (network=0x%08X, TG=%u)...",
-                           network_id, talkgroup);
+    Logger::instance().info("Attempting TEA1 key recovery: TG =", talkgroup,
+                            "network =", std::hex, network_id);
     Logger::instance().warning("This may take up to 90 seconds on Raspberry Pi");
 
     // Check if key is already known in crypto module's cache
     uint32_t cached_key;
     if (crypto_.hasKnownKey(network_id, talkgroup, &cached_key)) {
-        Logger::instance().info("✓ Using cached key from previous recovery: 0x%08X", cached_key);
+        Logger::instance().info("✓ Using cached key from previous recovery:", std::hex, cached_key);
 
         // Find the active call for this talkgroup
         for (auto& call_pair : active_calls_) {
@@ -548,9 +653,9 @@ bool TETRADecoder::attemptKeyRecovery(const uint8_t* ciphertext, size_t length,
 
     if (key_result.success) {
         Logger::instance().info("✓ Key recovered successfully!");
-        Logger::instance().info("  Key: 0x%08X", key_result.recovered_key);
-        Logger::instance().info("  Time: %.2f seconds", key_result.time_seconds);
-        Logger::instance().info("  Attempts: %llu", (unsigned long long)key_result.attempts);
+        Logger::instance().info("  Key:", std::hex, key_result.recovered_key);
+        Logger::instance().info("  Time:", key_result.time_seconds, "seconds");
+        Logger::instance().info("  Attempts:", key_result.attempts);
 
         // Cache the key for this network/talkgroup
         crypto_.addKnownKey(network_id, talkgroup, key_result.recovered_key);
@@ -565,7 +670,7 @@ bool TETRADecoder::attemptKeyRecovery(const uint8_t* ciphertext, size_t length,
         decryption_stats_.keys_recovered++;
         return true;
     } else {
-        Logger::instance().error("✗ Key recovery failed: %s", key_result.error_message.c_str());
+        Logger::instance().error("✗ Key recovery failed:", key_result.error_message);
         return false;
     }
 }
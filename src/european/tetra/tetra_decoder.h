@@ -3,6 +3,7 @@
 
 #include "../../decoders/base_decoder.h"
 #include "tetra_phy.h"
+#include "tetra_mac.h"
 #ifdef ENABLE_TETRA_DECRYPTION
 #include "tetra_crypto.h"
 #endif
@@ -17,11 +18,13 @@ namespace European {
  *
  * Main decoder class that:
  * - Coordinates physical and MAC layers
- * - Decodes control channels (MCCH, BSCH, BNCH)
+ * - Decodes control channels (MCCH, BSCH, BNCH) and the CMCE call
+ *   control PDUs in reassembled TM-SDUs
  * - Extracts system information (MCC, MNC, color code)
  * - Detects call grants
- * - Identifies encryption
+ * - Identifies encryption, including on traffic (TCH) blocks
  * - Handles talkgroup management
+ * - Traffic (TCH/S speech) is not channel decoded
  *
  * Supports both emergency services (380-400 MHz) and commercial TETRA
  */
@@ -81,6 +84,10 @@ public:
     void setExpectedMNC(uint16_t mnc) { expected_mnc_ = mnc; }
     void setColorCode(uint8_t cc) { expected_color_code_ = cc; }
 
+    // Traffic carriers carry no BSCH or BNCH: take the cell identity,
+    // scrambling code and carrier numbering from the main carrier's decoder
+    void followCell(const TETRADecoder& main_carrier);
+
     // System information
     TETRASystem getSystemInfo() const { return system_info_; }
     bool hasSystemInfo() const { return has_system_info_; }
@@ -88,9 +95,14 @@ public:
     // Active calls
     std::vector<TETRACall> getActiveCalls() const;
 
+    // Carrier number -> downlink frequency, using the band and offset from
+    // SYSINFO unless the channel allocation carries its own
+    bool carrierToFrequency(const TETRAChannelAllocation& allocation, Frequency& freq) const;
+
     // Statistics
     float getSignalQuality() const { return phy_layer_.getSignalQuality(); }
     size_t getCallsDecoded() const { return calls_decoded_; }
+    size_t getFragmentsReassembled() const { return mac_layer_.getFragmentsReassembled(); }
 
 #ifdef ENABLE_TETRA_DECRYPTION
     // Decryption control (requires legal authorization)
@@ -110,15 +122,16 @@ public:
 private:
     // MAC layer processing
     void processBurst(const TETRABurst& burst);
-    void processBSCH(const uint8_t* data, size_t length);
-    void processBNCH(const uint8_t* data, size_t length);
-    void processMCCH(const uint8_t* data, size_t length);
+    void processBSCH(const TETRASyncInfo& sync);
+    void processBNCH(const TETRASysInfo& sysinfo);
+    void processMCCH(const TETRATMSDU& sdu);
     void processTCH(const uint8_t* data, size_t length);
 
-    // PDU parsing
-    TETRAPDUType identifyPDU(const uint8_t* data, size_t length);
+    // PDU parsing (CMCE, after the LLC and MLE headers)
+    TETRAPDUType identifyPDU(uint8_t cmce_type);
     void parseSystemInfo(const uint8_t* data, size_t length);
-    void parseCallGrant(const uint8_t* data, size_t length);
+    void parseCallGrant(const TETRATMSDU& sdu, uint8_t cmce_type,
+                        const uint8_t* data, size_t length);
     void parseCallRelease(const uint8_t* data, size_t length);
     void parseShortData(const uint8_t* data, size_t length);
 
@@ -132,12 +145,13 @@ private:
                            uint32_t network_id, uint32_t talkgroup);
 #endif
 
-    // Utility functions
+    // Utility functions (one bit per byte)
     uint32_t extractBits(const uint8_t* data, size_t start, size_t count);
     std::string bitsToString(const uint8_t* data, size_t start, size_t length);
 
-    // Physical layer
+    // Physical and MAC layers
     TETRAPhysicalLayer phy_layer_;
+    TETRAUpperMAC mac_layer_;
 
     // System configuration
     uint16_t expected_mcc_;
@@ -147,6 +161,8 @@ private:
     // Decoded system information
     TETRASystem system_info_;
     bool has_system_info_;
+    bool has_sysinfo_;              // SYSINFO (band, offset) seen
+    TETRASysInfo sysinfo_;
 
     // Call tracking
     std::map<uint32_t, TETRACall> active_calls_;
@@ -0,0 +1,361 @@
+#include "tetra_mac.h"
+#include "../../utils/logger.h"
+#include <cstring>
+
+namespace TrunkSDR {
+namespace European {
+
+namespace {
+
+// MAC PDU types (first two bits of every downlink MAC PDU)
+constexpr uint8_t MAC_PDU_RESOURCE = 0;
+constexpr uint8_t MAC_PDU_FRAG_END = 1;
+constexpr uint8_t MAC_PDU_BROADCAST = 2;
+
+constexpr uint8_t BROADCAST_SYSINFO = 0;
+
+// Length indication values that are not octet counts
+constexpr uint8_t LENGTH_SECOND_HALF_STOLEN = 0x3E;
+constexpr uint8_t LENGTH_START_FRAGMENT = 0x3F;
+
+// Smallest MAC-RESOURCE header (up to and including the address type)
+constexpr size_t RESOURCE_MIN_BITS = 16;
+
+} // namespace
+
+TETRAUpperMAC::TETRAUpperMAC()
+    : fragments_reassembled_(0),
+      fragments_dropped_(0) {
+    reset();
+}
+
+void TETRAUpperMAC::reset() {
+    for (auto& slot : reassembly_) {
+        slot.active = false;
+        slot.length = 0;
+    }
+}
+
+void TETRAUpperMAC::processBlock(const TETRABurst& burst, const TETRABlock& block) {
+    if (!block.crc_valid || block.channel == TETRALogicalChannel::TCH) {
+        return;
+    }
+
+    if (block.channel == TETRALogicalChannel::BSCH) {
+        processSync(block);
+        return;
+    }
+
+    // PDU association: several MAC PDUs may share one block
+    const uint8_t* bits = block.bits.data();
+    size_t length = block.length;
+    size_t pos = 0;
+
+    while (length - pos >= RESOURCE_MIN_BITS) {
+        uint8_t type = static_cast<uint8_t>(readBits(bits, pos, 2));
+        size_t consumed = 0;
+
+        if (type == MAC_PDU_RESOURCE) {
+            consumed = processResource(burst, block, bits + pos, length - pos);
+        } else if (type == MAC_PDU_FRAG_END) {
+            // Subtype: 0 = MAC-FRAG, 1 = MAC-END
+            consumed = readBits(bits, pos + 2, 1)
+                     ? processEnd(burst, block, bits + pos, length - pos)
+                     : processFragment(burst, bits + pos, length - pos);
+        } else if (type == MAC_PDU_BROADCAST) {
+            if (readBits(bits, pos + 2, 2) == BROADCAST_SYSINFO) {
+                processSysInfo(bits + pos, length - pos);
+            }
+        }
+
+        if (consumed == 0) {
+            break;
+        }
+        pos += consumed;
+    }
+}
+
+void TETRAUpperMAC::processSync(const TETRABlock& block) {
+    // MAC-SYNC: System code(4) | Colour code(6) | TN(2) | FN(5) | MN(6) |
+    // Sharing mode(2) | Reserved frames(3) | DTX(1) | Frame 18 ext(1) | Reserved(1)
+    // MLE-SYNC: MCC(10) | MNC(14) | Neighbour broadcast(2) | Service level(2) | Late entry(1)
+    const uint8_t* bits = block.bits.data();
+
+    TETRASyncInfo info;
+    info.system_code = static_cast<uint8_t>(readBits(bits, 0, 4));
+    info.colour_code = static_cast<uint8_t>(readBits(bits, 4, 6));
+    info.slot = static_cast<uint8_t>(readBits(bits, 10, 2));
+    info.frame = static_cast<uint8_t>(readBits(bits, 12, 5));
+    info.multiframe = static_cast<uint8_t>(readBits(bits, 17, 6));
+    info.sharing_mode = static_cast<uint8_t>(readBits(bits, 23, 2));
+    info.mcc = static_cast<uint16_t>(readBits(bits, 31, 10));
+    info.mnc = static_cast<uint16_t>(readBits(bits, 41, 14));
+
+    if (sync_callback_) {
+        sync_callback_(info);
+    }
+}
+
+void TETRAUpperMAC::processSysInfo(const uint8_t* bits, size_t length) {
+    // Type(2) | Broadcast type(2) | Main carrier(12) | Band(4) | Offset(2) |
+    // Duplex spacing(3) | Reverse(1) | Secondary CCs(2) | Tx power(3) |
+    // RXLEV min(4) | Access parameter(4) | DL timeout(4) | HF/CCK flag(1) |
+    // HF or CCK(16) | Optional field flag(2) | Option(20) | MLE: LA(14) |
+    // Subscriber class(16) | BS service details(12)
+    if (length < TETRA_HALF_SLOT_BITS) {
+        return;
+    }
+
+    TETRASysInfo info;
+    info.main_carrier = static_cast<uint16_t>(readBits(bits, 4, 12));
+    info.band = static_cast<uint8_t>(readBits(bits, 16, 4));
+    info.offset = static_cast<uint8_t>(readBits(bits, 20, 2));
+    info.duplex_spacing = static_cast<uint8_t>(readBits(bits, 22, 3));
+    info.reverse_operation = readBits(bits, 25, 1) != 0;
+    info.secondary_control_channels = static_cast<uint8_t>(readBits(bits, 26, 2));
+    info.location_area = static_cast<uint16_t>(readBits(bits, 82, 14));
+    info.subscriber_class = static_cast<uint16_t>(readBits(bits, 96, 16));
+    info.bs_service_details = static_cast<uint16_t>(readBits(bits, 112, 12));
+
+    if (sysinfo_callback_) {
+        sysinfo_callback_(info);
+    }
+}
+
+size_t TETRAUpperMAC::processResource(const TETRABurst& burst, const TETRABlock& block,
+                                      const uint8_t* bits, size_t length) {
+    // Type(2) | Fill bit(1) | Position of grant(1) | Encryption mode(2) |
+    // Random access flag(1) | Length indication(6) | Address type(3) | Address
+    bool fill_bits = readBits(bits, 2, 1) != 0;
+    uint8_t encryption_mode = static_cast<uint8_t>(readBits(bits, 4, 2));
+    uint8_t length_indication = static_cast<uint8_t>(readBits(bits, 7, 6));
+    auto address_type = static_cast<TETRAAddressType>(readBits(bits, 13, 3));
+    size_t pos = RESOURCE_MIN_BITS;
+
+    // A null PDU ends the block
+    if (address_type == TETRAAddressType::NULL_PDU) {
+        return 0;
+    }
+
+    TETRATMSDU sdu;
+    sdu.channel = block.channel;
+    sdu.slot = burst.slot_number;
+    sdu.address_type = address_type;
+    sdu.address = 0;
+    sdu.encryption_mode = encryption_mode;
+    sdu.allocation.valid = false;
+
+    size_t address_bits;
+    switch (address_type) {
+        case TETRAAddressType::EVENT_LABEL:      address_bits = 10; break;
+        case TETRAAddressType::SSI_EVENT_LABEL:
+        case TETRAAddressType::SMI_EVENT_LABEL:  address_bits = 34; break;
+        case TETRAAddressType::SSI_USAGE_MARKER: address_bits = 30; break;
+        default:                                 address_bits = 24; break;
+    }
+    if (pos + address_bits + 3 > length) {
+        return 0;
+    }
+    sdu.address = address_type == TETRAAddressType::EVENT_LABEL ? 0 : readBits(bits, pos, 24);
+    pos += address_bits;
+
+    // Optional elements, each behind a flag
+    if (readBits(bits, pos++, 1)) {
+        pos += 4;   // Power control
+    }
+    if (pos < length && readBits(bits, pos++, 1)) {
+        pos += 8;   // Slot granting
+    }
+    if (pos < length && readBits(bits, pos++, 1)) {
+        if (!parseChannelAllocation(bits, length, pos, sdu.allocation)) {
+            return 0;
+        }
+    }
+    if (pos > length) {
+        return 0;
+    }
+
+    if (length_indication == LENGTH_START_FRAGMENT) {
+        // The rest of the block is the first fragment
+        size_t end = fill_bits ? stripFillBits(bits, length) : length;
+        Reassembly& slot = reassembly_[burst.slot_number];
+        if (slot.active) {
+            fragments_dropped_++;
+        }
+        slot.active = true;
+        slot.header = sdu;
+        slot.length = 0;
+        if (end > pos) {
+            slot.length = end - pos;
+            std::memcpy(slot.bits.data(), bits + pos, slot.length);
+        }
+        return length;
+    }
+
+    size_t pdu_bits;
+    if (length_indication == LENGTH_SECOND_HALF_STOLEN) {
+        pdu_bits = length;
+    } else {
+        pdu_bits = static_cast<size_t>(length_indication) * 8;
+        if (pdu_bits < pos || pdu_bits > length) {
+            return 0;
+        }
+    }
+
+    size_t end = fill_bits ? stripFillBits(bits, pdu_bits) : pdu_bits;
+    if (end > pos) {
+        sdu.bits = bits + pos;
+        sdu.length = end - pos;
+        deliver(sdu);
+    }
+    return pdu_bits;
+}
+
+size_t TETRAUpperMAC::processFragment(const TETRABurst& burst, const uint8_t* bits, size_t length) {
+    // Type(2) | Subtype(1) | Fill bit(1) | TM-SDU to the end of the block
+    Reassembly& slot = reassembly_[burst.slot_number];
+    if (!slot.active) {
+        return length;
+    }
+
+    bool fill_bits = readBits(bits, 3, 1) != 0;
+    size_t end = fill_bits ? stripFillBits(bits, length) : length;
+    size_t fragment = end > 4 ? end - 4 : 0;
+
+    if (slot.length + fragment > TETRA_MAX_SDU_BITS) {
+        slot.active = false;
+        fragments_dropped_++;
+        return length;
+    }
+    std::memcpy(slot.bits.data() + slot.length, bits + 4, fragment);
+    slot.length += fragment;
+    return length;
+}
+
+size_t TETRAUpperMAC::processEnd(const TETRABurst& burst, const TETRABlock& block,
+                                 const uint8_t* bits, size_t length) {
+    // Type(2) | Subtype(1) | Fill bit(1) | Position of grant(1) |
+    // Length indication(6) | Slot granting | Channel allocation | TM-SDU
+    bool fill_bits = readBits(bits, 3, 1) != 0;
+    uint8_t length_indication = static_cast<uint8_t>(readBits(bits, 5, 6));
+    size_t pos = 11;
+
+    TETRAChannelAllocation allocation;
+    allocation.valid = false;
+    if (readBits(bits, pos++, 1)) {
+        pos += 8;   // Slot granting
+    }
+    if (pos < length && readBits(bits, pos++, 1)) {
+        if (!parseChannelAllocation(bits, length, pos, allocation)) {
+            return 0;
+        }
+    }
+
+    size_t pdu_bits = static_cast<size_t>(length_indication) * 8;
+    if (length_indication >= LENGTH_SECOND_HALF_STOLEN || pdu_bits > length) {
+        pdu_bits = length;
+    }
+    if (pos > pdu_bits) {
+        return 0;
+    }
+
+    Reassembly& slot = reassembly_[burst.slot_number];
+    if (!slot.active) {
+        return pdu_bits;
+    }
+    slot.active = false;
+
+    size_t end = fill_bits ? stripFillBits(bits, pdu_bits) : pdu_bits;
+    size_t fragment = end > pos ? end - pos : 0;
+    if (slot.length + fragment > TETRA_MAX_SDU_BITS) {
+        fragments_dropped_++;
+        return pdu_bits;
+    }
+    std::memcpy(slot.bits.data() + slot.length, bits + pos, fragment);
+    slot.length += fragment;
+
+    // The allocation may come with the last fragment instead of the first
+    TETRATMSDU sdu = slot.header;
+    sdu.channel = block.channel;
+    if (allocation.valid) {
+        sdu.allocation = allocation;
+    }
+    sdu.bits = slot.bits.data();
+    sdu.length = slot.length;
+
+    fragments_reassembled_++;
+    deliver(sdu);
+    return pdu_bits;
+}
+
+bool TETRAUpperMAC::parseChannelAllocation(const uint8_t* bits, size_t length, size_t& pos,
+                                           TETRAChannelAllocation& allocation) {
+    // Allocation type(2) | Timeslots(4) | UL/DL(2) | CLCH(1) | Cell change(1) |
+    // Carrier(12) | Extended flag(1) [Band(4) Offset(2) Duplex(3) Reverse(1)] |
+    // Monitoring pattern(2) [Frame 18 pattern(2)]
+    if (pos + 25 > length) {
+        return false;
+    }
+    allocation.allocation_type = static_cast<uint8_t>(readBits(bits, pos, 2));
+    allocation.timeslots = static_cast<uint8_t>(readBits(bits, pos + 2, 4));
+    allocation.uplink_downlink = static_cast<uint8_t>(readBits(bits, pos + 6, 2));
+    allocation.carrier = static_cast<uint16_t>(readBits(bits, pos + 10, 12));
+    allocation.extended = readBits(bits, pos + 22, 1) != 0;
+    allocation.band = 0;
+    allocation.offset = 0;
+    allocation.duplex_spacing = 0;
+    allocation.reverse_operation = false;
+    pos += 23;
+
+    if (allocation.extended) {
+        if (pos + 12 > length) {
+            return false;
+        }
+        allocation.band = static_cast<uint8_t>(readBits(bits, pos, 4));
+        allocation.offset = static_cast<uint8_t>(readBits(bits, pos + 4, 2));
+        allocation.duplex_spacing = static_cast<uint8_t>(readBits(bits, pos + 6, 3));
+        allocation.reverse_operation = readBits(bits, pos + 9, 1) != 0;
+        pos += 10;
+    }
+
+    uint8_t monitoring_pattern = static_cast<uint8_t>(readBits(bits, pos, 2));
+    pos += 2;
+    if (monitoring_pattern == 0) {
+        pos += 2;
+    }
+
+    // The augmented allocation (UL/DL = 0) is not parsed, so the TM-SDU
+    // behind it cannot be located
+    if (allocation.uplink_downlink == 0 || pos > length) {
+        return false;
+    }
+    allocation.valid = true;
+    return true;
+}
+
+size_t TETRAUpperMAC::stripFillBits(const uint8_t* bits, size_t length) {
+    // Fill bits are a single 1 followed by zeros
+    while (length > 0) {
+        if (bits[--length]) {
+            break;
+        }
+    }
+    return length;
+}
+
+uint32_t TETRAUpperMAC::readBits(const uint8_t* bits, size_t start, size_t count) {
+    uint32_t value = 0;
+    for (size_t i = 0; i < count && i < 32; i++) {
+        value = (value << 1) | (bits[start + i] & 1);
+    }
+    return value;
+}
+
+void TETRAUpperMAC::deliver(const TETRATMSDU& sdu) {
+    if (sdu_callback_) {
+        sdu_callback_(sdu);
+    }
+}
+
+} // namespace European
+} // namespace TrunkSDR
@@ -0,0 +1,150 @@
+#ifndef TETRA_MAC_H
+#define TETRA_MAC_H
+
+#include "tetra_phy.h"
+#include <array>
+#include <functional>
+
+namespace TrunkSDR {
+namespace European {
+
+/**
+ * TETRA Upper MAC (EN 300 392-2 clause 21)
+ *
+ * Parses the MAC PDUs carried in decoded control blocks:
+ * - MAC-SYNC / MLE-SYNC on the BSCH
+ * - SYSINFO on the BNCH
+ * - MAC-RESOURCE, MAC-FRAG and MAC-END on SCH/F, SCH/HD and STCH,
+ *   reassembling fragmented TM-SDUs per timeslot
+ *
+ * Complete TM-SDUs (the LLC PDU and everything above it) are handed to a
+ * callback together with the addressing and channel allocation from the
+ * MAC header. Reassembly buffers are fixed size, one per timeslot.
+ */
+
+// Largest reassembled TM-SDU
+constexpr size_t TETRA_MAX_SDU_BITS = 2048;
+
+// MAC header address types
+enum class TETRAAddressType : uint8_t {
+    NULL_PDU = 0,
+    SSI = 1,
+    EVENT_LABEL = 2,
+    USSI = 3,
+    SMI = 4,
+    SSI_EVENT_LABEL = 5,
+    SSI_USAGE_MARKER = 6,
+    SMI_EVENT_LABEL = 7
+};
+
+// Channel allocation element (21.5.2), basic form
+struct TETRAChannelAllocation {
+    bool valid;
+    uint8_t allocation_type;    // 0 replace, 1 additional, 2 quit, 3 replace + CSS
+    uint8_t timeslots;          // Bitmap, MSB = TN 1
+    uint8_t uplink_downlink;    // 1 downlink, 2 uplink, 3 both
+    uint16_t carrier;
+    bool extended;              // Band/offset below override SYSINFO
+    uint8_t band;
+    uint8_t offset;
+    uint8_t duplex_spacing;
+    bool reverse_operation;
+};
+
+// MAC-SYNC + MLE-SYNC (BSCH)
+struct TETRASyncInfo {
+    uint8_t system_code;
+    uint8_t colour_code;
+    uint8_t slot;               // 0-3
+    uint8_t frame;              // 1-18
+    uint8_t multiframe;         // 1-60
+    uint8_t sharing_mode;
+    uint16_t mcc;
+    uint16_t mnc;
+};
+
+// SYSINFO (BNCH) with its MLE part
+struct TETRASysInfo {
+    uint16_t main_carrier;
+    uint8_t band;
+    uint8_t offset;
+    uint8_t duplex_spacing;
+    bool reverse_operation;
+    uint8_t secondary_control_channels;
+    uint16_t location_area;
+    uint16_t subscriber_class;
+    uint16_t bs_service_details;
+};
+
+// A complete TM-SDU and the MAC header fields that came with it. 'bits'
+// points into MAC storage and is valid during the callback only.
+struct TETRATMSDU {
+    TETRALogicalChannel channel;
+    uint8_t slot;               // 0-3
+    TETRAAddressType address_type;
+    uint32_t address;           // SSI / USSI / SMI (24 bits)
+    uint8_t encryption_mode;    // Air interface encryption, 0 = clear
+    TETRAChannelAllocation allocation;
+    const uint8_t* bits;
+    size_t length;
+};
+
+class TETRAUpperMAC {
+public:
+    using SyncCallback = std::function<void(const TETRASyncInfo&)>;
+    using SysInfoCallback = std::function<void(const TETRASysInfo&)>;
+    using SDUCallback = std::function<void(const TETRATMSDU&)>;
+
+    TETRAUpperMAC();
+
+    void reset();
+
+    // Decoded blocks with a valid CRC
+    void processBlock(const TETRABurst& burst, const TETRABlock& block);
+
+    void setSyncCallback(SyncCallback callback) { sync_callback_ = callback; }
+    void setSysInfoCallback(SysInfoCallback callback) { sysinfo_callback_ = callback; }
+    void setSDUCallback(SDUCallback callback) { sdu_callback_ = callback; }
+
+    size_t getFragmentsReassembled() const { return fragments_reassembled_; }
+    size_t getFragmentsDropped() const { return fragments_dropped_; }
+
+private:
+    void processSync(const TETRABlock& block);
+    void processSysInfo(const uint8_t* bits, size_t length);
+
+    // Each returns the bits consumed, or 0 when nothing more can be parsed
+    size_t processResource(const TETRABurst& burst, const TETRABlock& block,
+                           const uint8_t* bits, size_t length);
+    size_t processFragment(const TETRABurst& burst, const uint8_t* bits, size_t length);
+    size_t processEnd(const TETRABurst& burst, const TETRABlock& block,
+                      const uint8_t* bits, size_t length);
+
+    bool parseChannelAllocation(const uint8_t* bits, size_t length, size_t& pos,
+                                TETRAChannelAllocation& allocation);
+    static size_t stripFillBits(const uint8_t* bits, size_t length);
+    static uint32_t readBits(const uint8_t* bits, size_t start, size_t count);
+
+    void deliver(const TETRATMSDU& sdu);
+
+    // Fragmented TM-SDU being collected on one timeslot
+    struct Reassembly {
+        bool active;
+        TETRATMSDU header;
+        size_t length;
+        std::array<uint8_t, TETRA_MAX_SDU_BITS> bits;
+    };
+    std::array<Reassembly, TETRA_SLOTS_PER_FRAME> reassembly_;
+
+    SyncCallback sync_callback_;
+    SysInfoCallback sysinfo_callback_;
+    SDUCallback sdu_callback_;
+
+    size_t fragments_reassembled_;
+    size_t fragments_dropped_;
+};
+
+} // namespace European
+} // namespace TrunkSDR
+
+#endif // TETRA_MAC_H
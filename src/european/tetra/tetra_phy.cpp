@@ -7,39 +7,73 @@
 namespace TrunkSDR {
 namespace European {
 
-// Convolutional encoder polynomials for TETRA (rate 2/3, constraint length 5)
-constexpr uint8_t TETRA_CONV_POLY_1 = 0x1B;  // 11011
-constexpr uint8_t TETRA_CONV_POLY_2 = 0x1D;  // 11101
+namespace {
+
+// Downlink training sequences (EN 300 392-2 9.4.4.3)
+constexpr uint64_t TRAINING_N = 0x343A74;        // Normal 1: one full slot channel
+constexpr uint64_t TRAINING_P = 0x1E90DE;        // Normal 2: two half slot channels
+constexpr uint64_t TRAINING_Y = 0x30673A7067ULL; // Synchronization burst
+constexpr size_t TRAINING_NORMAL_BITS = 22;
+constexpr size_t TRAINING_SYNC_BITS = 38;
+constexpr uint64_t TRAINING_NORMAL_MASK = (1ULL << TRAINING_NORMAL_BITS) - 1;
+constexpr uint64_t TRAINING_SYNC_MASK = (1ULL << TRAINING_SYNC_BITS) - 1;
+constexpr size_t TRAINING_MAX_ERRORS = 4;
+
+// Slot bit count at which each training sequence has been received
+constexpr size_t SDB_TRAINING_END = TETRA_SDB_TRAINING_OFFSET + TRAINING_SYNC_BITS;
+constexpr size_t NDB_TRAINING_END = TETRA_NDB_TRAINING_OFFSET + TRAINING_NORMAL_BITS;
+
+// Slots without a recognisable training sequence before lock is dropped
+constexpr size_t MAX_SLOTS_WITHOUT_SYNC = 8;
+
+// Errors allowed when acquiring on a normal training sequence
+constexpr size_t NORMAL_ACQUIRE_MAX_ERRORS = 0;
+
+// (K, a) interleaving parameters per block size
+constexpr size_t INTERLEAVE_A_BSCH = 11;
+constexpr size_t INTERLEAVE_A_HALF = 101;
+constexpr size_t INTERLEAVE_A_FULL = 103;
+
+// CRC and tail bits added to the type-1 bits
+constexpr size_t CRC_BITS = 16;
+constexpr size_t TAIL_BITS = 4;
+
+uint64_t readBits(const uint8_t* bits, size_t start, size_t count) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < count; i++) {
+        value = (value << 1) | (bits[start + i] & 1);
+    }
+    return value;
+}
 
-// CRC polynomial for TETRA (CRC-16-CCITT)
-constexpr uint16_t TETRA_CRC_POLY = 0x1021;
+} // namespace
 
 TETRAPhysicalLayer::TETRAPhysicalLayer()
     : sync_locked_(false),
-      bits_since_sync_(0),
-      current_frame_(0),
-      current_multiframe_(0),
+      bit_count_(0),
+      sync_register_(0),
+      sync_training_(0),
+      normal_training_(0),
+      current_frame_(1),
+      current_multiframe_(1),
       current_slot_(0),
-      sync_threshold_(3),
       sync_errors_allowed_(3),
-      frames_without_sync_(0),
+      slots_without_sync_(0),
+      scrambling_init_(0),
+      cell_scrambling_known_(false),
+      burst_head_(0),
+      burst_count_(0),
       signal_quality_(0.0f),
       bursts_decoded_(0),
+      bursts_dropped_(0),
       crc_errors_(0),
       avg_ber_(0.0f) {
 }
 
 void TETRAPhysicalLayer::initialize() {
-    // Initialize Viterbi decoder with 2^(K-1) states for K=5
-    size_t num_states = 1 << 4;  // 16 states
-    viterbi_states_.resize(num_states);
-
-    for (auto& state : viterbi_states_) {
-        state.path_metric = 0;
-        state.path.clear();
-    }
-
-    deinterleave_buffer_.resize(TETRA_BITS_PER_SLOT);
+    tetraScramblingSequence(TETRA_SCRAMBLE_INIT_BSCH, bsch_scrambling_.data(),
+                            bsch_scrambling_.size());
+    cell_scrambling_known_ = false;
 
     Logger::instance().info("TETRA Physical Layer initialized");
     reset();
@@ -47,387 +81,331 @@ void TETRAPhysicalLayer::initialize() {
 
 void TETRAPhysicalLayer::reset() {
     sync_locked_ = false;
-    bit_buffer_.clear();
-    bits_since_sync_ = 0;
-    current_frame_ = 0;
-    current_multiframe_ = 0;
+    bit_count_ = 0;
+    sync_register_ = 0;
+    sync_training_ = 0;
+    normal_training_ = 0;
+    current_frame_ = 1;
+    current_multiframe_ = 1;
     current_slot_ = 0;
-    frames_without_sync_ = 0;
-    burst_queue_.clear();
+    slots_without_sync_ = 0;
+    burst_head_ = 0;
+    burst_count_ = 0;
+}
 
-    for (auto& state : viterbi_states_) {
-        state.path_metric = 0;
-        state.path.clear();
-    }
+void TETRAPhysicalLayer::setScramblingCode(uint16_t mcc, uint16_t mnc, uint8_t colour_code) {
+    scrambling_init_ = tetraScramblingInit(mcc, mnc, colour_code);
+    tetraScramblingSequence(scrambling_init_, cell_scrambling_.data(), cell_scrambling_.size());
+    cell_scrambling_known_ = true;
 }
 
 void TETRAPhysicalLayer::processSymbols(const float* symbols, size_t count) {
-    // Convert symbols to bits (hard decision)
+    // Each π/4-DQPSK symbol carries a dibit, MSB first
     for (size_t i = 0; i < count; i++) {
-        uint8_t bit = (symbols[i] >= 2.0f) ? 1 : 0;
-        bit_buffer_.push_back(bit);
-    }
-
-    // Maintain reasonable buffer size
-    while (bit_buffer_.size() > TETRA_FRAME_BITS * 2) {
-        bit_buffer_.pop_front();
-    }
-
-    // Try to find/maintain synchronization
-    if (!sync_locked_) {
-        if (bit_buffer_.size() >= 64) {  // Need enough bits for training sequence
-            if (detectTrainingSequence()) {
-                sync_locked_ = true;
-                frames_without_sync_ = 0;
-                Logger::instance().info("TETRA sync acquired");
-            }
-        }
-    } else {
-        bits_since_sync_++;
-
-        // Check for sync every slot
-        if (bits_since_sync_ >= TETRA_BITS_PER_SLOT) {
-            bits_since_sync_ = 0;
-
-            // Process the slot
-            processSlot(current_slot_);
-
-            current_slot_ = (current_slot_ + 1) % TETRA_SLOTS_PER_FRAME;
-            if (current_slot_ == 0) {
-                current_frame_++;
-                if (current_frame_ >= 18) {  // 18 frames per multiframe
-                    current_frame_ = 0;
-                    current_multiframe_++;
-                }
-            }
-
-            // Verify sync is still valid
-            if (!detectTrainingSequence()) {
-                frames_without_sync_++;
-                if (frames_without_sync_ > 10) {
-                    sync_locked_ = false;
-                    Logger::instance().warning("TETRA sync lost");
-                }
-            } else {
-                frames_without_sync_ = 0;
-            }
-        }
+        uint8_t dibit = static_cast<uint8_t>(symbols[i]) & 0x3;
+        pushBit(dibit >> 1);
+        pushBit(dibit & 1);
     }
 }
 
-bool TETRAPhysicalLayer::detectTrainingSequence() {
-    if (bit_buffer_.size() < 64) {
-        return false;
-    }
-
-    // Training sequence is typically at specific positions in the burst
-    // For TETRA, it's usually in the middle of the burst
-    // Try to detect it within a window
-
-    size_t best_pos = 0;
-    size_t best_distance = 100;
-    TETRABurstType detected_type = TETRABurstType::UNKNOWN;
-
-    for (size_t pos = 0; pos < std::min(bit_buffer_.size() - 11, size_t(64)); pos++) {
-        // Extract 11 bits for training sequence
-        uint16_t seq = 0;
-        for (size_t i = 0; i < 11; i++) {
-            seq = (seq << 1) | bit_buffer_[pos + i];
-        }
-
-        // Check against known training sequences
-        size_t dist_normal = hammingDistance(seq, TETRA_TRAINING_SEQ_NORMAL, 11);
-        size_t dist_ext = hammingDistance(seq, TETRA_TRAINING_SEQ_EXTENDED, 11);
-        size_t dist_sync = hammingDistance(seq, TETRA_TRAINING_SEQ_SYNC, 11);
+void TETRAPhysicalLayer::pushBit(uint8_t bit) {
+    sync_register_ = (sync_register_ << 1) | bit;
 
-        size_t min_dist = std::min({dist_normal, dist_ext, dist_sync});
-
-        if (min_dist < best_distance) {
-            best_distance = min_dist;
-            best_pos = pos;
-
-            if (min_dist == dist_normal) {
-                detected_type = TETRABurstType::NORMAL_UPLINK;
-            } else if (min_dist == dist_sync) {
-                detected_type = TETRABurstType::SYNCHRONIZATION;
-            } else {
-                detected_type = TETRABurstType::CONTROL_UPLINK;
-            }
-        }
+    // Only reached while hunting; trimming a slot at a time keeps the
+    // copy cost constant per bit
+    if (bit_count_ == bit_buffer_.size()) {
+        consumeBits(bit_buffer_.size() - TETRA_BITS_PER_SLOT);
     }
+    bit_buffer_[bit_count_++] = bit;
 
-    // Accept sync if within threshold
-    if (best_distance <= sync_errors_allowed_) {
-        // Remove bits before training sequence
-        for (size_t i = 0; i < best_pos; i++) {
-            bit_buffer_.pop_front();
+    if (!sync_locked_) {
+        size_t sync_errors = static_cast<size_t>(
+            __builtin_popcountll((sync_register_ & TRAINING_SYNC_MASK) ^ TRAINING_Y));
+        uint32_t normal = static_cast<uint32_t>(sync_register_ & TRAINING_NORMAL_MASK);
+        size_t normal_errors = static_cast<size_t>(
+            std::min(__builtin_popcount(normal ^ TRAINING_N), __builtin_popcount(normal ^ TRAINING_P)));
+
+        size_t training_end;
+        if (bit_count_ >= SDB_TRAINING_END && sync_errors <= sync_errors_allowed_) {
+            // The BSCH in a sync burst gives the TDMA time and scrambling code
+            training_end = SDB_TRAINING_END;
+            slots_without_sync_ = 0;
+        } else if (cell_scrambling_known_ && bit_count_ >= NDB_TRAINING_END &&
+                   normal_errors <= NORMAL_ACQUIRE_MAX_ERRORS) {
+            // Carriers without sync bursts. A 22-bit sequence is matched by
+            // noise now and then, so the next slot must confirm it.
+            training_end = NDB_TRAINING_END;
+            slots_without_sync_ = MAX_SLOTS_WITHOUT_SYNC;
+        } else {
+            return;
         }
 
-        signal_quality_ = 1.0f - (static_cast<float>(best_distance) / 11.0f);
-        return true;
+        // The slot started training_end bits ago
+        consumeBits(bit_count_ - training_end);
+        sync_training_ = 0;
+        normal_training_ = 0;
+        sync_locked_ = true;
+        Logger::instance().info("TETRA sync acquired");
     }
 
-    return false;
+    // Latch each training sequence position as the slot streams past
+    if (bit_count_ == SDB_TRAINING_END) {
+        sync_training_ = sync_register_ & TRAINING_SYNC_MASK;
+    } else if (bit_count_ == NDB_TRAINING_END) {
+        normal_training_ = static_cast<uint32_t>(sync_register_ & TRAINING_NORMAL_MASK);
+    } else if (bit_count_ == TETRA_BITS_PER_SLOT) {
+        processSlot(current_slot_);
+        advanceSlot();
+    }
 }
 
-size_t TETRAPhysicalLayer::hammingDistance(uint64_t a, uint64_t b, size_t bits) {
-    uint64_t xor_val = a ^ b;
-    size_t distance = 0;
-    for (size_t i = 0; i < bits; i++) {
-        if (xor_val & (1ULL << i)) {
-            distance++;
+void TETRAPhysicalLayer::advanceSlot() {
+    current_slot_ = (current_slot_ + 1) % TETRA_SLOTS_PER_FRAME;
+    if (current_slot_ == 0) {
+        if (++current_frame_ > TETRA_FRAMES_PER_MULTIFRAME) {
+            current_frame_ = 1;
+            if (++current_multiframe_ > TETRA_MULTIFRAMES_PER_HYPERFRAME) {
+                current_multiframe_ = 1;
+            }
         }
     }
-    return distance;
 }
 
-TETRABurstType TETRAPhysicalLayer::identifyBurstType(uint16_t training_seq) {
-    size_t dist_normal = hammingDistance(training_seq, TETRA_TRAINING_SEQ_NORMAL, 11);
-    size_t dist_ext = hammingDistance(training_seq, TETRA_TRAINING_SEQ_EXTENDED, 11);
-    size_t dist_sync = hammingDistance(training_seq, TETRA_TRAINING_SEQ_SYNC, 11);
-
-    size_t min_dist = std::min({dist_normal, dist_ext, dist_sync});
-
-    if (min_dist == dist_normal) {
-        return TETRABurstType::NORMAL_UPLINK;
-    } else if (min_dist == dist_sync) {
-        return TETRABurstType::SYNCHRONIZATION;
-    } else {
-        return TETRABurstType::CONTROL_UPLINK;
-    }
+void TETRAPhysicalLayer::consumeBits(size_t count) {
+    count = std::min(count, bit_count_);
+    std::memmove(bit_buffer_.data(), bit_buffer_.data() + count, bit_count_ - count);
+    bit_count_ -= count;
 }
 
 void TETRAPhysicalLayer::processSlot(uint8_t slot_num) {
-    if (bit_buffer_.size() < TETRA_BITS_PER_SLOT) {
-        return;
-    }
-
-    TETRABurst burst;
-    burst.slot_number = slot_num;
-    burst.frame_number = current_frame_;
-    burst.multiframe_number = current_multiframe_;
-    burst.crc_valid = false;
-    burst.ber = 0.0f;
-
-    // Extract slot bits
-    std::vector<uint8_t> slot_bits(TETRA_BITS_PER_SLOT);
-    extractBits(bit_buffer_, slot_bits.data(), 0, TETRA_BITS_PER_SLOT);
-
-    // Deinterleave
-    deinterleave(slot_bits.data(), deinterleave_buffer_.data(), TETRA_BITS_PER_SLOT);
-
-    // Descramble
-    descramble(deinterleave_buffer_.data(), TETRA_BITS_PER_SLOT, current_frame_);
+    const uint8_t* slot_bits = bit_buffer_.data();
 
-    // Viterbi decode (rate 2/3 convolutional code)
-    std::vector<uint8_t> decoded_bits(TETRA_BITS_PER_SLOT * 2 / 3);
-    if (viterbiDecode(deinterleave_buffer_.data(), decoded_bits.data(),
-                      decoded_bits.size())) {
+    bool half_slots = false;
+    TETRABurstType type = classifyBurst(half_slots);
 
-        // CRC check
-        burst.crc_valid = checkCRC16(decoded_bits.data(), decoded_bits.size());
+    sync_training_ = 0;
+    normal_training_ = 0;
 
-        if (!burst.crc_valid) {
-            crc_errors_++;
+    if (type == TETRABurstType::UNKNOWN) {
+        if (++slots_without_sync_ > MAX_SLOTS_WITHOUT_SYNC) {
+            sync_locked_ = false;
+            Logger::instance().warning("TETRA sync lost");
         }
+    } else {
+        slots_without_sync_ = 0;
+    }
 
-        // Reed-Muller decoding for certain fields (if applicable)
-        // This depends on the logical channel type
-
-        burst.bits = decoded_bits;
-        burst.type = TETRABurstType::NORMAL_DOWNLINK;
-        burst.channel = TETRALogicalChannel::MCCH;  // Will be refined by MAC layer
+    // Everything but the BSCH needs the cell scrambling code
+    if (type != TETRABurstType::UNKNOWN &&
+        (cell_scrambling_known_ || type == TETRABurstType::SYNCHRONIZATION)) {
+        // Oldest burst is overwritten if the MAC falls behind
+        if (burst_count_ == TETRA_BURST_RING_SIZE) {
+            popBurst();
+            bursts_dropped_++;
+        }
+        TETRABurst& burst = burst_ring_[(burst_head_ + burst_count_) % TETRA_BURST_RING_SIZE];
+        burst.type = type;
+        burst.slot_number = slot_num;
+        burst.frame_number = static_cast<uint8_t>(current_frame_);
+        burst.multiframe_number = static_cast<uint8_t>(current_multiframe_);
+        burst.aach = 0;
+        burst.block_count = 0;
+        burst.ber = 0.0f;
+
+        bool frame18 = current_frame_ == TETRA_FRAMES_PER_MULTIFRAME;
+
+        if (type == TETRABurstType::SYNCHRONIZATION) {
+            TETRABlock& bsch = burst.blocks[burst.block_count++];
+            decodeControlBlock(slot_bits + TETRA_SDB_BSCH_OFFSET, TETRALogicalChannel::BSCH, bsch);
+            if (bsch.crc_valid) {
+                applySync(bsch);
+                burst.slot_number = current_slot_;
+                burst.frame_number = static_cast<uint8_t>(current_frame_);
+                burst.multiframe_number = static_cast<uint8_t>(current_multiframe_);
+                frame18 = current_frame_ == TETRA_FRAMES_PER_MULTIFRAME;
+            }
+            if (cell_scrambling_known_) {
+                burst.aach = decodeAACH(slot_bits + TETRA_SDB_AACH_OFFSET);
+                decodeControlBlock(slot_bits + TETRA_BLOCK2_OFFSET,
+                                   frame18 ? TETRALogicalChannel::BNCH : TETRALogicalChannel::SCH_HD,
+                                   burst.blocks[burst.block_count++]);
+            }
+        } else {
+            // The AACH is split around the training sequence
+            uint8_t aach_bits[TETRA_AACH_CODED_BITS];
+            std::memcpy(aach_bits, slot_bits + TETRA_NDB_AACH1_OFFSET, TETRA_NDB_AACH1_BITS);
+            std::memcpy(aach_bits + TETRA_NDB_AACH1_BITS, slot_bits + TETRA_NDB_AACH2_OFFSET,
+                        TETRA_NDB_AACH2_BITS);
+            burst.aach = decodeAACH(aach_bits);
+            bool traffic = !frame18 && isTrafficSlot(burst.aach);
+
+            if (!half_slots) {
+                // Full slot: SCH/F on control slots, TCH on traffic slots
+                if (traffic) {
+                    copyTrafficBlock(slot_bits, burst.blocks[burst.block_count++]);
+                } else {
+                    uint8_t coded[TETRA_FULL_BLOCK_BITS];
+                    std::memcpy(coded, slot_bits + TETRA_NDB_BLOCK1_OFFSET, TETRA_HALF_BLOCK_BITS);
+                    std::memcpy(coded + TETRA_HALF_BLOCK_BITS, slot_bits + TETRA_BLOCK2_OFFSET,
+                                TETRA_HALF_BLOCK_BITS);
+                    decodeControlBlock(coded, TETRALogicalChannel::SCH_F,
+                                       burst.blocks[burst.block_count++]);
+                }
+            } else {
+                // Half slots: stolen traffic (STCH), or SCH/HD with the
+                // BNCH in the second half on frame 18
+                TETRALogicalChannel first = traffic ? TETRALogicalChannel::STCH
+                                                    : TETRALogicalChannel::SCH_HD;
+                TETRALogicalChannel second = traffic ? TETRALogicalChannel::STCH
+                                           : frame18 ? TETRALogicalChannel::BNCH
+                                                     : TETRALogicalChannel::SCH_HD;
+                decodeControlBlock(slot_bits + TETRA_NDB_BLOCK1_OFFSET, first,
+                                   burst.blocks[burst.block_count++]);
+                decodeControlBlock(slot_bits + TETRA_BLOCK2_OFFSET, second,
+                                   burst.blocks[burst.block_count++]);
+            }
+        }
 
-        burst_queue_.push_back(burst);
+        burst.ber = avg_ber_;
+        burst_count_++;
         bursts_decoded_++;
     }
 
     // Remove processed bits
-    for (size_t i = 0; i < TETRA_BITS_PER_SLOT; i++) {
-        if (!bit_buffer_.empty()) {
-            bit_buffer_.pop_front();
-        }
-    }
+    consumeBits(TETRA_BITS_PER_SLOT);
 }
 
-void TETRAPhysicalLayer::deinterleave(const uint8_t* input, uint8_t* output,
-                                       size_t length) {
-    // TETRA uses block interleaving
-    // Simplified rectangular interleaver (actual TETRA uses more complex scheme)
-    size_t rows = 30;
-    size_t cols = length / rows;
+TETRABurstType TETRAPhysicalLayer::classifyBurst(bool& half_slots) {
+    size_t sync_errors = static_cast<size_t>(__builtin_popcountll(sync_training_ ^ TRAINING_Y));
+    size_t n_errors = static_cast<size_t>(__builtin_popcount(normal_training_ ^ TRAINING_N));
+    size_t p_errors = static_cast<size_t>(__builtin_popcount(normal_training_ ^ TRAINING_P));
 
-    for (size_t i = 0; i < length; i++) {
-        size_t row = i / cols;
-        size_t col = i % cols;
-        size_t interleaved_pos = col * rows + row;
+    half_slots = p_errors < n_errors;
+    size_t normal_errors = std::min(n_errors, p_errors);
 
-        if (interleaved_pos < length) {
-            output[i] = input[interleaved_pos];
-        } else {
-            output[i] = 0;
-        }
+    if (sync_errors <= TRAINING_MAX_ERRORS && sync_errors <= normal_errors) {
+        signal_quality_ = 1.0f - static_cast<float>(sync_errors) / TRAINING_SYNC_BITS;
+        return TETRABurstType::SYNCHRONIZATION;
     }
-}
-
-bool TETRAPhysicalLayer::viterbiDecode(const uint8_t* input, uint8_t* output,
-                                        size_t output_length) {
-    // Simplified Viterbi decoder for TETRA convolutional code
-    // Rate 2/3, constraint length K=5
-
-    size_t num_states = viterbi_states_.size();
-    size_t input_length = output_length * 3 / 2;
-
-    // Initialize all path metrics to high value except state 0
-    for (size_t i = 0; i < num_states; i++) {
-        viterbi_states_[i].path_metric = (i == 0) ? 0 : 1000000;
-        viterbi_states_[i].path.clear();
+    if (normal_errors <= TRAINING_MAX_ERRORS) {
+        signal_quality_ = 1.0f - static_cast<float>(normal_errors) / TRAINING_NORMAL_BITS;
+        return TETRABurstType::NORMAL_DOWNLINK;
     }
+    return TETRABurstType::UNKNOWN;
+}
 
-    // Forward pass through trellis
-    for (size_t t = 0; t < output_length; t++) {
-        std::vector<ViterbiState> new_states(num_states);
-
-        for (size_t i = 0; i < num_states; i++) {
-            new_states[i].path_metric = 1000000;
-        }
-
-        for (size_t state = 0; state < num_states; state++) {
-            // For each possible input bit (0 or 1)
-            for (uint8_t bit = 0; bit <= 1; bit++) {
-                // Compute next state
-                uint8_t next_state = ((state << 1) | bit) & 0x0F;
-
-                // Compute expected output (simplified - would use generator polynomials)
-                // This is a placeholder - actual implementation would be more complex
-                uint8_t expected_0 = (state ^ bit) & 1;
-                uint8_t expected_1 = ((state >> 1) ^ bit) & 1;
-
-                // Hamming distance to received bits
-                size_t idx = t * 3 / 2;
-                if (idx + 1 < input_length) {
-                    size_t dist = (expected_0 != input[idx]) + (expected_1 != input[idx + 1]);
-
-                    uint64_t new_metric = viterbi_states_[state].path_metric + dist;
-
-                    if (new_metric < new_states[next_state].path_metric) {
-                        new_states[next_state].path_metric = new_metric;
-                        new_states[next_state].path = viterbi_states_[state].path;
-                        new_states[next_state].path.push_back(bit);
-                    }
-                }
-            }
-        }
-
-        viterbi_states_ = new_states;
+void TETRAPhysicalLayer::applySync(const TETRABlock& bsch) {
+    // MAC-SYNC: System code(4) | Colour code(6) | TN(2) | FN(5) | MN(6) | ...
+    // MLE-SYNC: MCC(10) | MNC(14) | ...
+    // Applied here rather than by the MAC so the bursts that follow in the
+    // same batch of symbols are stamped and descrambled correctly.
+    const uint8_t* bits = bsch.bits.data();
+    uint8_t slot = static_cast<uint8_t>(readBits(bits, 10, 2));
+    uint8_t frame = static_cast<uint8_t>(readBits(bits, 12, 5));
+    uint8_t multiframe = static_cast<uint8_t>(readBits(bits, 17, 6));
+    if (frame < 1 || frame > TETRA_FRAMES_PER_MULTIFRAME ||
+        multiframe < 1 || multiframe > TETRA_MULTIFRAMES_PER_HYPERFRAME) {
+        return;
     }
-
-    // Find best final state
-    size_t best_state = 0;
-    uint64_t best_metric = viterbi_states_[0].path_metric;
-    for (size_t i = 1; i < num_states; i++) {
-        if (viterbi_states_[i].path_metric < best_metric) {
-            best_metric = viterbi_states_[i].path_metric;
-            best_state = i;
-        }
+    current_slot_ = slot;
+    current_frame_ = frame;
+    current_multiframe_ = multiframe;
+
+    uint32_t init = tetraScramblingInit(static_cast<uint16_t>(readBits(bits, 31, 10)),
+                                        static_cast<uint16_t>(readBits(bits, 41, 14)),
+                                        static_cast<uint8_t>(readBits(bits, 4, 6)));
+    if (!cell_scrambling_known_ || init != scrambling_init_) {
+        scrambling_init_ = init;
+        tetraScramblingSequence(init, cell_scrambling_.data(), cell_scrambling_.size());
+        cell_scrambling_known_ = true;
     }
+}
 
-    // Output decoded bits
-    for (size_t i = 0; i < std::min(output_length, viterbi_states_[best_state].path.size()); i++) {
-        output[i] = viterbi_states_[best_state].path[i];
+uint16_t TETRAPhysicalLayer::decodeAACH(const uint8_t* coded) const {
+    // RM(30,14) is systematic: the first 14 descrambled bits are the
+    // ACCESS-ASSIGN PDU. Its 16 check bits are not used for correction.
+    uint16_t aach = 0;
+    for (size_t i = 0; i < TETRA_AACH_BITS; i++) {
+        aach = static_cast<uint16_t>((aach << 1) | ((coded[i] ^ cell_scrambling_[i]) & 1));
     }
-
-    // Calculate BER estimate
-    avg_ber_ = static_cast<float>(best_metric) / static_cast<float>(output_length * 2);
-
-    return true;
+    return aach;
 }
 
-bool TETRAPhysicalLayer::reedMullerDecode(uint8_t* data, size_t length) {
-    // Simplified Reed-Muller decoder
-    // TETRA uses RM(16,7) for some control information
-    // This is a placeholder - full implementation would be more complex
-    return true;
+bool TETRAPhysicalLayer::isTrafficSlot(uint16_t aach) const {
+    // ACCESS-ASSIGN outside frame 18: Header(2) | Field 1(6) | Field 2(6).
+    // With a non-zero header field 1 is the downlink usage marker, and
+    // markers 4-63 mean the slot carries traffic.
+    uint8_t header = (aach >> 12) & 0x3;
+    uint8_t usage_marker = (aach >> 6) & 0x3F;
+    return header != 0 && usage_marker >= 4;
 }
 
-bool TETRAPhysicalLayer::checkCRC16(const uint8_t* data, size_t length) {
-    if (length < 16) {
-        return false;
+void TETRAPhysicalLayer::decodeControlBlock(const uint8_t* coded, TETRALogicalChannel channel,
+                                            TETRABlock& block) {
+    size_t coded_bits;
+    size_t info_bits;
+    size_t interleave_a;
+    const uint8_t* scrambling;
+
+    switch (channel) {
+        case TETRALogicalChannel::BSCH:
+            coded_bits = TETRA_BSCH_CODED_BITS;
+            info_bits = TETRA_BSCH_BITS;
+            interleave_a = INTERLEAVE_A_BSCH;
+            scrambling = bsch_scrambling_.data();
+            break;
+        case TETRALogicalChannel::SCH_F:
+            coded_bits = TETRA_FULL_BLOCK_BITS;
+            info_bits = TETRA_FULL_SLOT_BITS;
+            interleave_a = INTERLEAVE_A_FULL;
+            scrambling = cell_scrambling_.data();
+            break;
+        default:
+            coded_bits = TETRA_HALF_BLOCK_BITS;
+            info_bits = TETRA_HALF_SLOT_BITS;
+            interleave_a = INTERLEAVE_A_HALF;
+            scrambling = cell_scrambling_.data();
+            break;
     }
 
-    // Extract CRC from last 16 bits
-    uint16_t received_crc = bitsToUint32(data, length - 16, 16);
-
-    // Calculate CRC on data (excluding CRC field)
-    uint16_t calculated_crc = calculateCRC16(data, length - 16);
-
-    return (received_crc == calculated_crc);
-}
-
-uint16_t TETRAPhysicalLayer::calculateCRC16(const uint8_t* data, size_t length) {
-    uint16_t crc = 0xFFFF;  // Initial value
-
-    for (size_t i = 0; i < length; i++) {
-        if (data[i]) {
-            crc ^= (1 << 15);
-        }
-
-        for (int j = 0; j < 1; j++) {
-            if (crc & 0x8000) {
-                crc = (crc << 1) ^ TETRA_CRC_POLY;
-            } else {
-                crc = crc << 1;
-            }
-        }
+    // Type-5 -> type-4 -> type-3 -> mother code -> type-2
+    for (size_t i = 0; i < coded_bits; i++) {
+        type4_[i] = (coded[i] ^ scrambling[i]) & 1;
     }
+    tetraBlockDeinterleave(type4_.data(), type3_.data(), coded_bits, interleave_a);
+    tetraDepuncture23(type3_.data(), mother_.data(), coded_bits);
 
-    return crc;
-}
+    size_t type2_bits = info_bits + CRC_BITS + TAIL_BITS;
+    uint32_t errors = viterbi_.decode(mother_.data(), type2_.data(), type2_bits);
+    avg_ber_ = 0.9f * avg_ber_ + 0.1f * (static_cast<float>(errors) / coded_bits);
 
-void TETRAPhysicalLayer::descramble(uint8_t* data, size_t length, uint32_t frame_num) {
-    // TETRA scrambling sequence based on frame number
-    // Simplified implementation - actual TETRA uses a specific LFSR
-    uint32_t lfsr = 0x1FF ^ frame_num;
+    block.channel = channel;
+    block.length = static_cast<uint16_t>(info_bits);
+    block.crc_valid = tetraCheckCRC16(type2_.data(), info_bits + CRC_BITS);
+    std::memcpy(block.bits.data(), type2_.data(), info_bits);
 
-    for (size_t i = 0; i < length; i++) {
-        // Generate scrambling bit
-        uint8_t scram_bit = (lfsr ^ (lfsr >> 5)) & 1;
-
-        // XOR with data
-        data[i] ^= scram_bit;
-
-        // Update LFSR
-        lfsr = ((lfsr << 1) | scram_bit) & 0x1FF;
+    if (!block.crc_valid) {
+        crc_errors_++;
     }
 }
 
-void TETRAPhysicalLayer::extractBits(const std::deque<uint8_t>& source,
-                                      uint8_t* dest, size_t start, size_t count) {
-    for (size_t i = 0; i < count && (start + i) < source.size(); i++) {
-        dest[i] = source[start + i];
+void TETRAPhysicalLayer::copyTrafficBlock(const uint8_t* slot_bits, TETRABlock& block) const {
+    // Speech is not decoded; only the scrambling is removed here
+    for (size_t i = 0; i < TETRA_HALF_BLOCK_BITS; i++) {
+        block.bits[i] = (slot_bits[TETRA_NDB_BLOCK1_OFFSET + i] ^ cell_scrambling_[i]) & 1;
+        block.bits[TETRA_HALF_BLOCK_BITS + i] =
+            (slot_bits[TETRA_BLOCK2_OFFSET + i] ^ cell_scrambling_[TETRA_HALF_BLOCK_BITS + i]) & 1;
     }
+    block.channel = TETRALogicalChannel::TCH;
+    block.length = static_cast<uint16_t>(TETRA_FULL_BLOCK_BITS);
+    block.crc_valid = true;
 }
 
-uint32_t TETRAPhysicalLayer::bitsToUint32(const uint8_t* bits, size_t start,
-                                           size_t count) {
-    uint32_t value = 0;
-    for (size_t i = 0; i < count && i < 32; i++) {
-        value = (value << 1) | (bits[start + i] & 1);
-    }
-    return value;
-}
-
-bool TETRAPhysicalLayer::hasBurst() const {
-    return !burst_queue_.empty();
-}
-
-TETRABurst TETRAPhysicalLayer::getBurst() {
-    TETRABurst burst;
-    if (!burst_queue_.empty()) {
-        burst = burst_queue_.front();
-        burst_queue_.pop_front();
+void TETRAPhysicalLayer::popBurst() {
+    if (burst_count_ > 0) {
+        burst_head_ = (burst_head_ + 1) % TETRA_BURST_RING_SIZE;
+        burst_count_--;
     }
-    return burst;
 }
 
 } // namespace European
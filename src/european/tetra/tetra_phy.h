@@ -2,8 +2,8 @@
 #define TETRA_PHY_H
 
 #include "../../utils/types.h"
-#include <vector>
-#include <deque>
+#include "tetra_coding.h"
+#include <array>
 #include <cstdint>
 
 namespace TrunkSDR {
@@ -13,26 +13,55 @@ namespace European {
  * TETRA Physical Layer Decoder
  *
  * Handles:
- * - Synchronization pattern detection (training sequences)
- * - Frame synchronization
+ * - Burst synchronization: the training sequences are correlated in a
+ *   shift register as bits arrive, at every bit position while hunting
+ *   and only at their offsets in the slot once locked
+ * - TDMA time and the cell scrambling code from the BSCH
  * - Slot detection (4-slot TDMA)
- * - Deinterleaving
- * - Convolutional decoding (rate 2/3, K=5)
- * - Reed-Muller error correction
+ * - Logical channel identification from burst type, AACH and frame number
+ * - Descrambling and deinterleaving
+ * - Convolutional decoding (RCPC rate 2/3 from the K=5 mother code)
  * - CRC checking
  */
 
 // TETRA frame structure constants
 constexpr size_t TETRA_SLOTS_PER_FRAME = 4;
+constexpr size_t TETRA_FRAMES_PER_MULTIFRAME = 18;
+constexpr size_t TETRA_MULTIFRAMES_PER_HYPERFRAME = 60;
 constexpr size_t TETRA_BITS_PER_SLOT = 510;
 constexpr size_t TETRA_FRAME_BITS = 2040;  // 4 slots * 510 bits
 constexpr float TETRA_FRAME_DURATION_MS = 14.167f;  // milliseconds
 constexpr float TETRA_SLOT_DURATION_MS = 3.542f;    // milliseconds
 
-// Training sequence (synchronization pattern) - 11 bits
-constexpr uint16_t TETRA_TRAINING_SEQ_NORMAL = 0x0FD;      // Normal uplink
-constexpr uint16_t TETRA_TRAINING_SEQ_EXTENDED = 0x6E4;    // Extended uplink
-constexpr uint16_t TETRA_TRAINING_SEQ_SYNC = 0x3AA;        // Synchronization burst
+// Continuous downlink burst layout (bit offsets within the 510-bit slot)
+//
+//   Normal (NDB):  Block 1 (216) @14 | AACH part 1 (14) @230 | Training n/p (22) @244
+//                  | AACH part 2 (16) @266 | Block 2 (216) @282
+//   Sync (SDB):    Frequency correction (80) @14 | BSCH (120) @94
+//                  | Training y (38) @214 | AACH (30) @252 | Block 2 (216) @282
+constexpr size_t TETRA_NDB_BLOCK1_OFFSET = 14;
+constexpr size_t TETRA_NDB_AACH1_OFFSET = 230;
+constexpr size_t TETRA_NDB_AACH1_BITS = 14;
+constexpr size_t TETRA_NDB_TRAINING_OFFSET = 244;
+constexpr size_t TETRA_NDB_AACH2_OFFSET = 266;
+constexpr size_t TETRA_NDB_AACH2_BITS = 16;
+constexpr size_t TETRA_SDB_BSCH_OFFSET = 94;
+constexpr size_t TETRA_SDB_TRAINING_OFFSET = 214;
+constexpr size_t TETRA_SDB_AACH_OFFSET = 252;
+constexpr size_t TETRA_BLOCK2_OFFSET = 282;
+constexpr size_t TETRA_HALF_BLOCK_BITS = 216;
+constexpr size_t TETRA_FULL_BLOCK_BITS = 432;
+constexpr size_t TETRA_BSCH_CODED_BITS = 120;
+constexpr size_t TETRA_AACH_CODED_BITS = 30;
+
+// Type-1 (information) bits per logical channel
+constexpr size_t TETRA_BSCH_BITS = 60;
+constexpr size_t TETRA_HALF_SLOT_BITS = 124;   // SCH/HD, BNCH, STCH
+constexpr size_t TETRA_FULL_SLOT_BITS = 268;   // SCH/F
+constexpr size_t TETRA_AACH_BITS = 14;
+
+// Bursts buffered between the PHY and the MAC
+constexpr size_t TETRA_BURST_RING_SIZE = 8;
 
 // Burst types
 enum class TETRABurstType {
@@ -59,15 +88,30 @@ enum class TETRALogicalChannel {
     UNKNOWN
 };
 
-// Decoded burst structure
-struct TETRABurst {
-    TETRABurstType type;
+/**
+ * One logical channel block of a burst. Control channels hold their
+ * decoded type-1 bits; TCH holds the 432 descrambled type-5 bits, which
+ * are not decoded further.
+ */
+struct TETRABlock {
     TETRALogicalChannel channel;
-    uint8_t slot_number;      // 0-3
-    uint32_t frame_number;
-    uint32_t multiframe_number;
-    std::vector<uint8_t> bits;  // Decoded and error-corrected bits
     bool crc_valid;
+    uint16_t length;                                   // Valid bits
+    std::array<uint8_t, TETRA_FULL_BLOCK_BITS> bits;   // One bit per byte
+};
+
+/**
+ * Decoded burst. Fixed size: bursts live in a preallocated ring in the
+ * physical layer and are read in place by the MAC.
+ */
+struct TETRABurst {
+    TETRABurstType type;
+    uint8_t slot_number;        // 0-3 (TN 1-4)
+    uint8_t frame_number;       // 1-18
+    uint8_t multiframe_number;  // 1-60
+    uint16_t aach;              // ACCESS-ASSIGN (14 bits)
+    size_t block_count;         // 1 for full slot channels, 2 for half slots
+    std::array<TETRABlock, 2> blocks;
     float ber;                  // Bit Error Rate estimate
 };
 
@@ -79,48 +123,59 @@ public:
     void initialize();
     void reset();
 
-    // Process symbols from demodulator
+    // Process symbols from demodulator (dibit values 0-3)
     void processSymbols(const float* symbols, size_t count);
 
     // Check if synchronized to TETRA signal
     bool isSynchronized() const { return sync_locked_; }
 
-    // Get decoded bursts
-    bool hasBurst() const;
-    TETRABurst getBurst();
+    // Cell scrambling code. Taken from the BSCH on carriers with sync
+    // bursts; must be set for carriers without them, which can then be
+    // acquired on their normal training sequences.
+    void setScramblingCode(uint16_t mcc, uint16_t mnc, uint8_t colour_code);
+
+    // Decoded bursts, read in place: frontBurst() stays valid until
+    // popBurst()
+    bool hasBurst() const { return burst_count_ > 0; }
+    const TETRABurst& frontBurst() const { return burst_ring_[burst_head_]; }
+    void popBurst();
 
     // Statistics
     float getSignalQuality() const { return signal_quality_; }
     size_t getBurstsDecoded() const { return bursts_decoded_; }
+    size_t getBurstsDropped() const { return bursts_dropped_; }
+    size_t getCRCErrors() const { return crc_errors_; }
 
 private:
     // Synchronization
-    bool detectTrainingSequence();
-    size_t hammingDistance(uint64_t a, uint64_t b, size_t bits);
-    TETRABurstType identifyBurstType(uint16_t training_seq);
+    void pushBit(uint8_t bit);
+    void applySync(const TETRABlock& bsch);
 
     // Frame processing
     void processSlot(uint8_t slot_num);
-    void deinterleave(const uint8_t* input, uint8_t* output, size_t length);
-
-    // Error correction
-    bool viterbiDecode(const uint8_t* input, uint8_t* output, size_t length);
-    bool reedMullerDecode(uint8_t* data, size_t length);
-    bool checkCRC16(const uint8_t* data, size_t length);
-    uint16_t calculateCRC16(const uint8_t* data, size_t length);
+    void advanceSlot();
+    TETRABurstType classifyBurst(bool& half_slots);
+    uint16_t decodeAACH(const uint8_t* coded) const;
+    bool isTrafficSlot(uint16_t aach) const;
 
-    // Scrambling/descrambling
-    void descramble(uint8_t* data, size_t length, uint32_t frame_num);
+    // Control channel blocks: descramble, deinterleave, depuncture,
+    // Viterbi decode and check the CRC
+    void decodeControlBlock(const uint8_t* coded, TETRALogicalChannel channel, TETRABlock& block);
+    void copyTrafficBlock(const uint8_t* slot_bits, TETRABlock& block) const;
 
-    // Utility functions
-    void extractBits(const std::deque<uint8_t>& source, uint8_t* dest,
-                     size_t start, size_t count);
-    uint32_t bitsToUint32(const uint8_t* bits, size_t start, size_t count);
+    void consumeBits(size_t count);
 
-    // State
+    // State: while locked bit_buffer_ holds the current slot from bit 0;
+    // while hunting it keeps at least the last slot of history
     bool sync_locked_;
-    std::deque<uint8_t> bit_buffer_;
-    size_t bits_since_sync_;
+    std::array<uint8_t, TETRA_BITS_PER_SLOT * 2> bit_buffer_;
+    size_t bit_count_;
+
+    // Training sequence correlator: the last 64 bits received, and the
+    // words at the sync and normal training positions of this slot
+    uint64_t sync_register_;
+    uint64_t sync_training_;
+    uint32_t normal_training_;
 
     // Frame tracking
     uint32_t current_frame_;
@@ -128,26 +183,32 @@ private:
     uint8_t current_slot_;
 
     // Synchronization thresholds
-    size_t sync_threshold_;
     size_t sync_errors_allowed_;
-    size_t frames_without_sync_;
-
-    // Viterbi decoder state
-    struct ViterbiState {
-        uint64_t path_metric;
-        std::vector<uint8_t> path;
-    };
-    std::vector<ViterbiState> viterbi_states_;
-
-    // Deinterleaving matrix
-    std::vector<uint8_t> deinterleave_buffer_;
-
-    // Output queue
-    std::deque<TETRABurst> burst_queue_;
+    size_t slots_without_sync_;
+
+    // Scrambling sequences: the BSCH uses a fixed code, everything else
+    // the cell's extended colour code
+    std::array<uint8_t, TETRA_BSCH_CODED_BITS> bsch_scrambling_;
+    std::array<uint8_t, TETRA_FULL_BLOCK_BITS> cell_scrambling_;
+    uint32_t scrambling_init_;
+    bool cell_scrambling_known_;
+
+    // Block decoding scratch
+    std::array<uint8_t, TETRA_FULL_BLOCK_BITS> type4_;
+    std::array<uint8_t, TETRA_FULL_BLOCK_BITS> type3_;
+    std::array<uint8_t, TETRA_FULL_BLOCK_BITS * 8 / 3> mother_;
+    std::array<uint8_t, TETRA_FULL_SLOT_BITS + 20> type2_;
+    TETRAViterbi viterbi_;
+
+    // Output ring
+    std::array<TETRABurst, TETRA_BURST_RING_SIZE> burst_ring_;
+    size_t burst_head_;
+    size_t burst_count_;
 
     // Statistics
     float signal_quality_;
     size_t bursts_decoded_;
+    size_t bursts_dropped_;
     size_t crc_errors_;
     float avg_ber_;
 };
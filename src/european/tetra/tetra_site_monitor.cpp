@@ -0,0 +1,300 @@
+#include "tetra_site_monitor.h"
+#include "../../utils/logger.h"
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+
+namespace TrunkSDR {
+namespace European {
+
+namespace {
+
+// Traffic carriers must fall inside this fraction of the capture
+constexpr double USABLE_BANDWIDTH_FRACTION = 0.4;
+
+// Grants are matched to carriers within this tolerance
+constexpr Frequency CARRIER_MATCH_TOLERANCE = 100.0;
+
+uint64_t threadCpuNanoseconds() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+} // namespace
+
+TETRASiteMonitor::TETRASiteMonitor()
+    : sample_rate_(0),
+      center_freq_(0),
+      grants_dropped_(0) {
+}
+
+bool TETRASiteMonitor::initialize(uint32_t sample_rate, Frequency center_freq,
+                                  Frequency main_carrier, size_t traffic_carriers) {
+    sample_rate_ = sample_rate;
+    center_freq_ = center_freq;
+
+    if (sample_rate_ < CARRIER_RATE) {
+        Logger::instance().error("TETRA site monitor needs at least", CARRIER_RATE,
+                                 "samples/s, got", sample_rate_);
+        return false;
+    }
+    if (std::abs(main_carrier - center_freq_) > sample_rate_ * USABLE_BANDWIDTH_FRACTION) {
+        Logger::instance().error("TETRA main carrier", main_carrier, "Hz outside capture bandwidth");
+        return false;
+    }
+
+    // All carrier instances are built up front; following a grant only
+    // retunes one
+    carriers_.clear();
+    for (size_t i = 0; i < traffic_carriers + 1; i++) {
+        carriers_.push_back(std::make_unique<Carrier>());
+        setupCarrier(*carriers_.back(), i == 0);
+    }
+    baseband_.resize(4096 / (sample_rate_ / CARRIER_RATE) + 1);
+
+    Carrier& main = *carriers_[0];
+    main.active = true;
+    main.frequency = main_carrier;
+    main.ddc.setOffset(main_carrier - center_freq_);
+
+    Logger::instance().info("TETRA site monitor: main carrier", main_carrier / 1e6, "MHz,",
+                            traffic_carriers, "traffic carriers available");
+    return true;
+}
+
+void TETRASiteMonitor::setupCarrier(Carrier& carrier, bool main_carrier) {
+    carrier.active = false;
+    carrier.frequency = 0;
+    carrier.timeslots.fill(0);
+    carrier.samples = 0;
+    carrier.idle_samples = 0;
+    carrier.cpu_ns = 0;
+
+    carrier.ddc.initialize(sample_rate_, sample_rate_ / CARRIER_RATE, TETRA_CHANNEL_SPACING);
+    carrier.demod.initialize(carrier.ddc.getOutputRate());
+    carrier.decoder.initialize();
+
+    TETRADecoder* decoder = &carrier.decoder;
+    carrier.demod.setSymbolCallback(
+        [decoder](const float* symbols, size_t count) {
+            decoder->processSymbols(symbols, count);
+        }
+    );
+
+    // Grants and releases can also arrive on a traffic carrier's STCH
+    carrier.decoder.setGrantCallback(
+        [this](const CallGrant& grant) {
+            handleGrant(grant);
+        }
+    );
+    carrier.decoder.setCallEndCallback(
+        [this](TalkgroupID talkgroup) {
+            handleCallEnd(talkgroup);
+        }
+    );
+
+    if (main_carrier) {
+        carrier.decoder.setSystemInfoCallback(
+            [this](const SystemInfo& info) {
+                if (system_info_callback_) {
+                    system_info_callback_(info);
+                }
+            }
+        );
+    }
+}
+
+void TETRASiteMonitor::reset() {
+    for (size_t i = 1; i < carriers_.size(); i++) {
+        if (carriers_[i]->active) {
+            releaseCarrier(*carriers_[i]);
+        }
+    }
+    if (!carriers_.empty()) {
+        Carrier& main = *carriers_[0];
+        main.ddc.reset();
+        main.demod.reset();
+        main.decoder.reset();
+        main.timeslots.fill(0);
+    }
+}
+
+void TETRASiteMonitor::setExpectedCell(uint16_t mcc, uint16_t mnc, uint8_t colour_code) {
+    for (auto& carrier : carriers_) {
+        carrier->decoder.setExpectedMCC(mcc);
+        carrier->decoder.setExpectedMNC(mnc);
+        carrier->decoder.setColorCode(colour_code);
+    }
+}
+
+void TETRASiteMonitor::process(const Complex* samples, size_t count) {
+    // Carriers are processed in chunks so the baseband buffer stays fixed
+    size_t chunk = (baseband_.size() - 1) * carriers_[0]->ddc.getDecimation();
+    for (size_t offset = 0; offset < count; offset += chunk) {
+        size_t n = std::min(chunk, count - offset);
+        for (auto& carrier : carriers_) {
+            if (carrier->active) {
+                processCarrier(*carrier, samples + offset, n);
+            }
+        }
+    }
+}
+
+void TETRASiteMonitor::processCarrier(Carrier& carrier, const Complex* samples, size_t count) {
+    uint64_t start = threadCpuNanoseconds();
+
+    size_t produced = carrier.ddc.process(samples, count, baseband_.data());
+    carrier.demod.process(baseband_.data(), produced);
+
+    carrier.cpu_ns += threadCpuNanoseconds() - start;
+    carrier.samples += count;
+
+    // A traffic carrier that has not been locked for a second is gone
+    if (carrier.decoder.isLocked()) {
+        carrier.idle_samples = 0;
+    } else {
+        carrier.idle_samples += count;
+        if (&carrier != carriers_[0].get() && carrier.idle_samples > sample_rate_) {
+            Logger::instance().info("TETRA carrier", carrier.frequency / 1e6, "MHz lost, releasing");
+            for (TalkgroupID talkgroup : carrier.timeslots) {
+                if (talkgroup != 0 && call_end_callback_) {
+                    call_end_callback_(talkgroup);
+                }
+            }
+            releaseCarrier(carrier);
+        }
+    }
+}
+
+void TETRASiteMonitor::handleGrant(const CallGrant& grant) {
+    if (grant.slot < 1 || grant.slot > TETRA_SLOTS_PER_FRAME) {
+        return;
+    }
+
+    Carrier* carrier = findCarrier(grant.frequency);
+    if (!carrier) {
+        carrier = startCarrier(grant.frequency);
+    }
+    if (!carrier) {
+        grants_dropped_++;
+    } else {
+        carrier->timeslots[grant.slot - 1] = grant.talkgroup;
+    }
+
+    if (grant_callback_) {
+        grant_callback_(grant);
+    }
+}
+
+void TETRASiteMonitor::handleCallEnd(TalkgroupID talkgroup) {
+    for (size_t i = 0; i < carriers_.size(); i++) {
+        Carrier& carrier = *carriers_[i];
+        bool remaining = false;
+        for (TalkgroupID& slot : carrier.timeslots) {
+            if (slot == talkgroup) {
+                slot = 0;
+            }
+            remaining = remaining || slot != 0;
+        }
+
+        // The main carrier always stays up
+        if (i > 0 && carrier.active && !remaining) {
+            releaseCarrier(carrier);
+        }
+    }
+
+    if (call_end_callback_) {
+        call_end_callback_(talkgroup);
+    }
+}
+
+TETRASiteMonitor::Carrier* TETRASiteMonitor::findCarrier(Frequency freq) {
+    for (auto& carrier : carriers_) {
+        if (carrier->active && std::abs(carrier->frequency - freq) < CARRIER_MATCH_TOLERANCE) {
+            return carrier.get();
+        }
+    }
+    return nullptr;
+}
+
+TETRASiteMonitor::Carrier* TETRASiteMonitor::startCarrier(Frequency freq) {
+    double offset = freq - center_freq_;
+    if (std::abs(offset) > sample_rate_ * USABLE_BANDWIDTH_FRACTION) {
+        Logger::instance().warning("TETRA carrier", freq / 1e6, "MHz outside capture bandwidth");
+        return nullptr;
+    }
+
+    const TETRADecoder& main = carriers_[0]->decoder;
+    if (!main.hasSystemInfo()) {
+        return nullptr;
+    }
+
+    for (size_t i = 1; i < carriers_.size(); i++) {
+        Carrier& carrier = *carriers_[i];
+        if (carrier.active) {
+            continue;
+        }
+
+        carrier.ddc.setOffset(offset);
+        carrier.ddc.reset();
+        carrier.demod.reset();
+        carrier.decoder.reset();
+        carrier.decoder.followCell(main);
+
+        carrier.active = true;
+        carrier.frequency = freq;
+        carrier.timeslots.fill(0);
+        carrier.idle_samples = 0;
+
+        Logger::instance().info("TETRA following carrier", freq / 1e6, "MHz");
+        return &carrier;
+    }
+
+    Logger::instance().warning("TETRA: no free carrier instance for", freq / 1e6, "MHz");
+    return nullptr;
+}
+
+void TETRASiteMonitor::releaseCarrier(Carrier& carrier) {
+    carrier.active = false;
+    carrier.timeslots.fill(0);
+    carrier.idle_samples = 0;
+}
+
+bool TETRASiteMonitor::isLocked() const {
+    return !carriers_.empty() && carriers_[0]->decoder.isLocked();
+}
+
+std::vector<TETRACarrierStats> TETRASiteMonitor::getCarrierStats() const {
+    std::vector<TETRACarrierStats> stats;
+    for (size_t i = 0; i < carriers_.size(); i++) {
+        const Carrier& carrier = *carriers_[i];
+        if (!carrier.active) {
+            continue;
+        }
+        TETRACarrierStats entry;
+        entry.frequency = carrier.frequency;
+        entry.main_carrier = i == 0;
+        entry.locked = carrier.decoder.isLocked();
+        entry.timeslots = carrier.timeslots;
+        entry.samples = carrier.samples;
+        entry.cpu_seconds = carrier.cpu_ns / 1e9;
+        entry.calls_decoded = carrier.decoder.getCallsDecoded();
+        entry.signal_quality = carrier.decoder.getSignalQuality();
+        stats.push_back(entry);
+    }
+    return stats;
+}
+
+size_t TETRASiteMonitor::getActiveCarriers() const {
+    size_t active = 0;
+    for (const auto& carrier : carriers_) {
+        if (carrier->active) {
+            active++;
+        }
+    }
+    return active;
+}
+
+} // namespace European
+} // namespace TrunkSDR
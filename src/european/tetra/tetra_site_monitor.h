@@ -0,0 +1,117 @@
+#ifndef TETRA_SITE_MONITOR_H
+#define TETRA_SITE_MONITOR_H
+
+#include "tetra_decoder.h"
+#include "../../dsp/ddc.h"
+#include "../../dsp/dqpsk_demod.h"
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace TrunkSDR {
+namespace European {
+
+/**
+ * TETRA site monitor
+ *
+ * Follows every carrier of a TETRA site from one wideband capture. Each
+ * carrier is mixed down by its own DDC and runs its own π/4-DQPSK
+ * demodulator and TETRA decoder (PHY + MAC):
+ * - The main carrier is always monitored and carries the MCCH
+ * - Grants on the MCCH name a carrier and timeslot; the carrier is
+ *   started from a fixed pool of carrier instances the first time a
+ *   timeslot on it is granted, and released when its last call ends
+ * - Traffic carriers have no sync bursts, so they are acquired on their
+ *   normal training sequences using the main carrier's scrambling code
+ *
+ * Processing time is accounted per carrier (thread CPU time), so the cost
+ * of following more carriers can be seen directly.
+ */
+
+// Carrier instances besides the main carrier
+constexpr size_t TETRA_DEFAULT_TRAFFIC_CARRIERS = 8;
+
+// Per-carrier statistics
+struct TETRACarrierStats {
+    Frequency frequency;
+    bool main_carrier;
+    bool locked;
+    std::array<TalkgroupID, TETRA_SLOTS_PER_FRAME> timeslots;  // 0 = idle
+    uint64_t samples;           // Input samples processed
+    double cpu_seconds;         // Thread CPU time spent on this carrier
+    size_t calls_decoded;
+    float signal_quality;
+};
+
+class TETRASiteMonitor {
+public:
+    TETRASiteMonitor();
+    ~TETRASiteMonitor() = default;
+
+    // sample_rate/center_freq describe the capture; the main carrier must
+    // lie inside it
+    bool initialize(uint32_t sample_rate, Frequency center_freq, Frequency main_carrier,
+                    size_t traffic_carriers = TETRA_DEFAULT_TRAFFIC_CARRIERS);
+    void reset();
+
+    // Wideband samples from the SDR
+    void process(const Complex* samples, size_t count);
+
+    // Only follow this cell (0 = any)
+    void setExpectedCell(uint16_t mcc, uint16_t mnc, uint8_t colour_code);
+
+    void setGrantCallback(GrantCallback callback) { grant_callback_ = callback; }
+    void setSystemInfoCallback(SystemInfoCallback callback) { system_info_callback_ = callback; }
+    void setCallEndCallback(CallEndCallback callback) { call_end_callback_ = callback; }
+
+    bool isLocked() const;
+    const TETRADecoder& getMainDecoder() const { return carriers_[0]->decoder; }
+
+    // Active carriers, main carrier first
+    std::vector<TETRACarrierStats> getCarrierStats() const;
+    size_t getActiveCarriers() const;
+    size_t getGrantsDropped() const { return grants_dropped_; }
+
+private:
+    struct Carrier {
+        bool active;
+        Frequency frequency;
+        DigitalDownConverter ddc;
+        DQPSKDemodulator demod;
+        TETRADecoder decoder;
+        std::array<TalkgroupID, TETRA_SLOTS_PER_FRAME> timeslots;
+        uint64_t samples;
+        uint64_t idle_samples;      // Samples since the carrier was last locked
+        uint64_t cpu_ns;
+    };
+
+    void setupCarrier(Carrier& carrier, bool main_carrier);
+    void processCarrier(Carrier& carrier, const Complex* samples, size_t count);
+
+    void handleGrant(const CallGrant& grant);
+    void handleCallEnd(TalkgroupID talkgroup);
+    Carrier* findCarrier(Frequency freq);
+    Carrier* startCarrier(Frequency freq);
+    void releaseCarrier(Carrier& carrier);
+
+    uint32_t sample_rate_;
+    Frequency center_freq_;
+
+    // carriers_[0] is the main carrier; the rest are a fixed pool
+    std::vector<std::unique_ptr<Carrier>> carriers_;
+    std::vector<Complex> baseband_;
+
+    GrantCallback grant_callback_;
+    SystemInfoCallback system_info_callback_;
+    CallEndCallback call_end_callback_;
+
+    size_t grants_dropped_;
+
+    // Carriers are decimated to 4 samples per symbol
+    static constexpr uint32_t CARRIER_RATE = TETRA_SYMBOL_RATE * 4;
+};
+
+} // namespace European
+} // namespace TrunkSDR
+
+#endif // TETRA_SITE_MONITOR_H
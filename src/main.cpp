@@ -1,21 +1,27 @@
 #include "utils/logger.h"
 #include "utils/config_parser.h"
+#include "dsp/filter_tap_cache.h"
 #include "trunking/trunk_controller.h"
 #include "sdr/rtlsdr_source.h"
+#include "net/decode_worker.h"
 #include <iostream>
 #include <csignal>
 #include <atomic>
 #include <thread>
 #include <chrono>
+#include <sys/stat.h>
 
 using namespace TrunkSDR;
 
 std::atomic<bool> g_running(true);
+std::atomic<bool> g_reload(false);
 
 void signalHandler(int signal) {
     if (signal == SIGINT || signal == SIGTERM) {
         std::cout << "\nReceived shutdown signal..." << std::endl;
         g_running = false;
+    } else if (signal == SIGHUP) {
+        g_reload = true;
     }
 }
 
@@ -35,13 +41,22 @@ void printUsage(const char* prog_name) {
               << "\n"
               << "Options:\n"
               << "  -c, --config FILE    Configuration file (default: config.json)\n"
+              << "  -C, --config-cache FILE\n"
+              << "                       Compiled configuration (default: the config file + .cache)\n"
+              << "      --no-config-cache\n"
+              << "                       Always parse the configuration file\n"
+              << "  -W, --watch-config   Reload the configuration when the file changes\n"
+              << "                       (SIGHUP always reloads it)\n"
               << "  -l, --log-level LVL  Log level: debug, info, warning, error (default: info)\n"
               << "  -f, --log-file FILE  Log to file instead of stdout\n"
               << "  -d, --devices        List available RTL-SDR devices and exit\n"
+              << "  -w, --worker ADDR    Decode channels for a front end instead of reading an SDR\n"
+              << "                       (unix:PATH or tcp:HOST:PORT)\n"
               << "  -h, --help           Show this help message\n"
               << "\n"
               << "Example:\n"
               << "  " << prog_name << " --config /etc/trunksdr/config.json\n"
+              << "  " << prog_name << " --config /etc/trunksdr/config.json --worker unix:/run/trunksdr/worker0\n"
               << std::endl;
 }
 
@@ -60,23 +75,25 @@ void listDevices() {
 
 void printSystemInfo(const Config& config) {
     std::cout << "System Information:" << std::endl;
-    std::cout << "  Type: " << ConfigParser::systemTypeToString(config.system.type) << std::endl;
-    std::cout << "  Name: " << config.system.name << std::endl;
+    for (const SystemInfo& system : config.systems) {
+        std::cout << "  Type: " << ConfigParser::systemTypeToString(system.type) << std::endl;
+        std::cout << "  Name: " << system.name << std::endl;
 
-    if (config.system.system_id != 0) {
-        std::cout << "  System ID: 0x" << std::hex << config.system.system_id << std::dec << std::endl;
-    }
+        if (system.system_id != 0) {
+            std::cout << "  System ID: 0x" << std::hex << system.system_id << std::dec << std::endl;
+        }
 
-    if (config.system.nac != 0) {
-        std::cout << "  NAC: 0x" << std::hex << config.system.nac << std::dec << std::endl;
-    }
+        if (system.nac != 0) {
+            std::cout << "  NAC: 0x" << std::hex << system.nac << std::dec << std::endl;
+        }
 
-    std::cout << "  Control Channels: ";
-    for (size_t i = 0; i < config.system.control_channels.size(); i++) {
-        if (i > 0) std::cout << ", ";
-        std::cout << config.system.control_channels[i] / 1e6 << " MHz";
+        std::cout << "  Control Channels: ";
+        for (size_t i = 0; i < system.control_channels.size(); i++) {
+            if (i > 0) std::cout << ", ";
+            std::cout << system.control_channels[i] / 1e6 << " MHz";
+        }
+        std::cout << std::endl;
     }
-    std::cout << std::endl;
 
     std::cout << "  Enabled Talkgroups: " << config.talkgroups.enabled.size() << std::endl;
 
@@ -88,13 +105,98 @@ void printSystemInfo(const Config& config) {
     std::cout << std::endl;
 }
 
+// Identifies a version of the configuration file for --watch-config
+struct FileStamp {
+    bool exists = false;
+    int64_t mtime_ns = 0;
+    int64_t size = 0;
+
+    bool operator==(const FileStamp& other) const {
+        return exists == other.exists && mtime_ns == other.mtime_ns && size == other.size;
+    }
+    bool operator!=(const FileStamp& other) const { return !(*this == other); }
+};
+
+FileStamp stampFile(const std::string& path) {
+    FileStamp stamp;
+    struct stat info;
+    if (stat(path.c_str(), &info) == 0) {
+        stamp.exists = true;
+        stamp.mtime_ns = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+        stamp.size = info.st_size;
+    }
+    return stamp;
+}
+
+// Re-reads the configuration and applies what can change while running;
+// on any error the running configuration stays as it is
+void reloadConfig(TrunkController& controller, const std::string& config_file,
+                  const std::string& config_cache, const char* reason) {
+    LOG_INFO("Reloading configuration", config_file, "(", reason, ")");
+    auto start = std::chrono::steady_clock::now();
+
+    ConfigParser parser;
+    if (!parser.loadFromFile(config_file, config_cache)) {
+        LOG_ERROR("Configuration reload failed, keeping the running configuration");
+        return;
+    }
+    if (!controller.reloadConfig(parser.getConfig())) {
+        return;
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    LOG_INFO("Reload latency:", elapsed.count(), "us including reading the file");
+    parser.saveCache(FilterTapCache::instance().getDesigns());
+}
+
+// Decode channels streamed by a front end until interrupted
+int runWorker(ConfigParser& parser, const std::string& address) {
+    DecodeWorker worker;
+    if (!worker.initialize(parser.getConfig(), address) || !worker.start()) {
+        LOG_CRITICAL("Failed to start decode worker on", address);
+        std::cerr << "Failed to start decode worker. Check logs for details." << std::endl;
+        return 1;
+    }
+    parser.saveCache(FilterTapCache::instance().getDesigns());
+
+    std::signal(SIGINT, signalHandler);
+    std::signal(SIGTERM, signalHandler);
+    std::signal(SIGHUP, SIG_IGN);      // Workers take everything from the front end
+
+    std::cout << "Decode worker listening on " << address << ". Press Ctrl+C to stop." << std::endl;
+
+    auto last_status = std::chrono::steady_clock::now();
+    while (g_running) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+
+        auto now = std::chrono::steady_clock::now();
+        if (std::chrono::duration_cast<std::chrono::seconds>(now - last_status).count() >= 10) {
+            DecodeWorker::Stats stats = worker.getStats();
+            std::cout << "Worker: Front ends: " << stats.connections
+                      << " | Channels: " << stats.channels
+                      << " | Samples: " << stats.samples
+                      << " | Events: " << stats.events << std::endl;
+            last_status = now;
+        }
+    }
+
+    std::cout << "Shutting down..." << std::endl;
+    worker.stop();
+    return 0;
+}
+
 int main(int argc, char* argv[]) {
     printBanner();
 
     // Default configuration
     std::string config_file = "config.json";
+    std::string config_cache;
+    bool use_config_cache = true;
+    bool watch_config = false;
     std::string log_level = "info";
     std::string log_file;
+    std::string worker_address;
 
     // Parse command line arguments
     for (int i = 1; i < argc; i++) {
@@ -113,6 +215,17 @@ int main(int argc, char* argv[]) {
                 std::cerr << "Error: --config requires a filename" << std::endl;
                 return 1;
             }
+        } else if (arg == "-C" || arg == "--config-cache") {
+            if (i + 1 < argc) {
+                config_cache = argv[++i];
+            } else {
+                std::cerr << "Error: --config-cache requires a filename" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--no-config-cache") {
+            use_config_cache = false;
+        } else if (arg == "-W" || arg == "--watch-config") {
+            watch_config = true;
         } else if (arg == "-l" || arg == "--log-level") {
             if (i + 1 < argc) {
                 log_level = argv[++i];
@@ -120,6 +233,13 @@ int main(int argc, char* argv[]) {
                 std::cerr << "Error: --log-level requires a level" << std::endl;
                 return 1;
             }
+        } else if (arg == "-w" || arg == "--worker") {
+            if (i + 1 < argc) {
+                worker_address = argv[++i];
+            } else {
+                std::cerr << "Error: --worker requires an address" << std::endl;
+                return 1;
+            }
         } else if (arg == "-f" || arg == "--log-file") {
             if (i + 1 < argc) {
                 log_file = argv[++i];
@@ -152,17 +272,29 @@ int main(int argc, char* argv[]) {
     LOG_INFO("TrunkSDR starting up...");
     LOG_INFO("Configuration file:", config_file);
 
-    // Load configuration
+    // Load configuration, from the compiled cache when the file is unchanged
+    if (!use_config_cache) {
+        config_cache.clear();
+    } else if (config_cache.empty()) {
+        config_cache = config_file + ".cache";
+    }
+
     ConfigParser parser;
-    if (!parser.loadFromFile(config_file)) {
+    if (!parser.loadFromFile(config_file, config_cache)) {
         LOG_CRITICAL("Failed to load configuration file:", config_file);
         std::cerr << "Failed to load configuration. Please check your config file." << std::endl;
         return 1;
     }
 
+    FilterTapCache::instance().preload(parser.getCachedFilters());
+
     const Config& config = parser.getConfig();
     printSystemInfo(config);
 
+    if (!worker_address.empty()) {
+        return runWorker(parser, worker_address);
+    }
+
     // Check for RTL-SDR devices
     uint32_t device_count = RTLSDRSource::getDeviceCount();
     if (device_count == 0) {
@@ -181,6 +313,9 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    // Every channel filter is designed by now; keep them with the config
+    parser.saveCache(FilterTapCache::instance().getDesigns());
+
     // Start the controller
     if (!controller.start()) {
         LOG_CRITICAL("Failed to start trunk controller");
@@ -191,14 +326,32 @@ int main(int argc, char* argv[]) {
     // Set up signal handlers
     std::signal(SIGINT, signalHandler);
     std::signal(SIGTERM, signalHandler);
+    std::signal(SIGHUP, signalHandler);
 
     std::cout << "TrunkSDR is running. Press Ctrl+C to stop." << std::endl;
     std::cout << "Monitoring control channel..." << std::endl;
 
+    // A changed file is reloaded once it has stopped changing for a poll,
+    // so an editor's partial write is not picked up
+    FileStamp config_stamp = stampFile(config_file);
+    FileStamp changed_stamp = config_stamp;
+
     // Main loop
     auto last_status = std::chrono::steady_clock::now();
     while (g_running) {
-        std::this_thread::sleep_for(std::chrono::seconds(1));
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        if (g_reload.exchange(false)) {
+            reloadConfig(controller, config_file, config_cache, "SIGHUP");
+            config_stamp = changed_stamp = stampFile(config_file);
+        } else if (watch_config) {
+            FileStamp stamp = stampFile(config_file);
+            if (stamp.exists && stamp != config_stamp && stamp == changed_stamp) {
+                reloadConfig(controller, config_file, config_cache, "file changed");
+                config_stamp = stamp;
+            }
+            changed_stamp = stamp;
+        }
 
         // Print status every 10 seconds
         auto now = std::chrono::steady_clock::now();
@@ -208,8 +361,31 @@ int main(int argc, char* argv[]) {
                 size_t active_calls = call_mgr->getActiveCallCount();
                 uint64_t total_calls = call_mgr->getTotalCallCount();
 
+                ReceiverScheduler::Stats receivers = controller.getSchedulerStats();
+
                 std::cout << "Status: Active calls: " << active_calls
-                         << " | Total: " << total_calls << std::endl;
+                         << " | Total: " << total_calls
+                         << " | Receivers: " << controller.getVoiceReceivers().getActiveCount()
+                         << "/" << controller.getVoiceReceivers().size()
+                         << " | Waiting: " << receivers.pending
+                         << " | Missed: " << receivers.missed
+                         << " (emergency " << receivers.missed_emergency << ")"
+                         << " | Preempted: " << receivers.preempted;
+
+                const DecodeLink* link = controller.getDecodeLink();
+                if (link) {
+                    DecodeLink::Stats remote = link->getStats();
+                    std::cout << " | Workers: " << remote.connected << "/" << remote.workers
+                              << " | Remote channels: " << remote.channels;
+                }
+
+                const IQRecorder* recorder = controller.getIQRecorder();
+                if (recorder) {
+                    IQRecorder::Stats capture = recorder->getStats();
+                    std::cout << " | IQ captures: " << capture.captures
+                              << (capture.capturing ? " (recording)" : "");
+                }
+                std::cout << std::endl;
             }
 
             last_status = now;
@@ -0,0 +1,328 @@
+#include "decode_link.h"
+#include "../utils/logger.h"
+#include <algorithm>
+
+namespace TrunkSDR {
+
+namespace {
+
+bool sendHello(SocketStream& stream) {
+    MessageWriter writer;
+    writer.begin(MessageType::HELLO, 0, 0);
+    writer.put32(DECODE_PROTOCOL_MAGIC);
+    writer.put32(DECODE_PROTOCOL_VERSION);
+    const uint8_t* data = writer.data();
+    return stream.sendAll(data, writer.size());
+}
+
+} // anonymous namespace
+
+RemoteChannel::RemoteChannel(DecodeLink* link, size_t worker, uint16_t id, SampleFormat format)
+    : link_(link)
+    , worker_(worker)
+    , id_(id)
+    , format_(format)
+    , closed_(false)
+    , position_(0)
+    , reset_at_(0) {
+}
+
+void RemoteChannel::sendSamples(const Complex* samples, size_t count) {
+    while (count > 0) {
+        size_t block = std::min(count, MAX_SAMPLES_PER_MESSAGE);
+        writer_.begin(MessageType::SAMPLES, id_, position_, static_cast<uint8_t>(format_));
+        writeSamples(writer_, format_, samples, block);
+        link_->send(worker_, writer_);
+
+        position_ += block;
+        samples += block;
+        count -= block;
+    }
+}
+
+void RemoteChannel::sendReset() {
+    reset_at_ = position_;
+    writer_.begin(MessageType::RESET, id_, position_);
+    link_->send(worker_, writer_);
+}
+
+void RemoteChannel::sendTalkgroup(TalkgroupID talkgroup, RadioID source) {
+    writer_.begin(MessageType::TALKGROUP, id_, position_);
+    writer_.put32(talkgroup);
+    writer_.put32(source);
+    link_->send(worker_, writer_);
+}
+
+void RemoteChannel::close() {
+    if (closed_) {
+        return;
+    }
+    closed_ = true;
+    writer_.begin(MessageType::CLOSE, id_, position_);
+    link_->send(worker_, writer_);
+    link_->closeChannel(*this);
+}
+
+void RemoteChannel::takeEvents(std::vector<Event>& events) {
+    events.clear();
+    {
+        std::lock_guard<std::mutex> lock(events_mutex_);
+        events.swap(events_);
+    }
+
+    // Still in flight when the channel was reset for another call
+    uint64_t reset_at = reset_at_;
+    events.erase(std::remove_if(events.begin(), events.end(),
+                                [reset_at](const Event& event) {
+                                    return event.timestamp <= reset_at;
+                                }),
+                 events.end());
+}
+
+void RemoteChannel::post(const Event& event) {
+    std::lock_guard<std::mutex> lock(events_mutex_);
+    events_.push_back(event);
+}
+
+DecodeLink::DecodeLink()
+    : format_(SampleFormat::CS16)
+    , next_id_(0)
+    , bytes_sent_(0)
+    , events_(0) {
+}
+
+DecodeLink::~DecodeLink() {
+    stop();
+}
+
+bool DecodeLink::initialize(const std::vector<std::string>& workers, SampleFormat format) {
+    format_ = format;
+
+    for (const std::string& address : workers) {
+        auto worker = std::make_unique<Worker>();
+        worker->address = address;
+        if (!connect(*worker)) {
+            return false;
+        }
+        workers_.push_back(std::move(worker));
+    }
+
+    for (auto& worker : workers_) {
+        worker->reader = std::thread(&DecodeLink::readerThread, this, worker.get());
+    }
+
+    LOG_INFO("Decode link:", workers_.size(), "worker(s),",
+             format == SampleFormat::CS8 ? "cs8" : "cs16", "samples");
+    return true;
+}
+
+bool DecodeLink::connect(Worker& worker) {
+    worker.stream = SocketStream::connect(worker.address);
+    if (!worker.stream) {
+        return false;
+    }
+
+    // The worker answers with its own hello before anything else
+    uint8_t buffer[sizeof(MessageHeader) + 8];
+    if (!sendHello(*worker.stream) || !worker.stream->receiveAll(buffer, sizeof(buffer))) {
+        LOG_ERROR("No hello from decode worker", worker.address);
+        return false;
+    }
+
+    MessageHeader header = decodeHeader(buffer);
+    MessageReader reader(buffer + sizeof(MessageHeader), 8);
+    uint32_t magic = reader.get32();
+    uint32_t version = reader.get32();
+    if (header.type != MessageType::HELLO || header.length != 8 ||
+        magic != DECODE_PROTOCOL_MAGIC || version != DECODE_PROTOCOL_VERSION) {
+        LOG_ERROR("Decode worker", worker.address, "speaks another protocol (version", version, ")");
+        return false;
+    }
+
+    worker.connected = true;
+    LOG_INFO("Connected to decode worker:", worker.address);
+    return true;
+}
+
+void DecodeLink::stop() {
+    // An orderly stop is not a lost worker
+    for (auto& worker : workers_) {
+        worker->connected = false;
+        if (worker->stream) {
+            worker->stream->shutdown();
+        }
+    }
+    for (auto& worker : workers_) {
+        if (worker->reader.joinable()) {
+            worker->reader.join();
+        }
+    }
+}
+
+std::shared_ptr<RemoteChannel> DecodeLink::openChannel(const ChannelOpen& open) {
+    std::shared_ptr<RemoteChannel> channel;
+    {
+        std::lock_guard<std::mutex> lock(channels_mutex_);
+
+        // Least loaded worker still connected
+        int target = -1;
+        for (size_t i = 0; i < workers_.size(); i++) {
+            if (workers_[i]->connected &&
+                (target < 0 || workers_[i]->channels < workers_[target]->channels)) {
+                target = static_cast<int>(i);
+            }
+        }
+        if (target < 0) {
+            LOG_ERROR("No decode worker connected");
+            return nullptr;
+        }
+
+        // Next ID in turn. A closed channel's ID only comes round again
+        // after every other ID has been used, so late events for it are
+        // dropped instead of reaching a new channel.
+        if (channels_.size() > UINT16_MAX) {
+            LOG_ERROR("Too many remote channels");
+            return nullptr;
+        }
+        while (channels_.count(next_id_) != 0) {
+            next_id_++;
+        }
+        uint16_t id = next_id_++;
+
+        channel = std::make_shared<RemoteChannel>(this, target, id, format_);
+        channels_[id] = channel;
+        workers_[target]->channels++;
+    }
+
+    MessageWriter writer;
+    writer.begin(MessageType::OPEN, channel->getId(), 0);
+    writeChannelOpen(writer, open);
+    if (!send(channel->getWorker(), writer)) {
+        closeChannel(*channel);
+        return nullptr;
+    }
+
+    LOG_DEBUG("Remote channel", channel->getId(), "on", workers_[channel->getWorker()]->address);
+    return channel;
+}
+
+bool DecodeLink::send(size_t index, MessageWriter& writer) {
+    Worker& worker = *workers_[index];
+    if (!worker.connected) {
+        return false;
+    }
+
+    const uint8_t* data = writer.data();
+    std::lock_guard<std::mutex> lock(worker.send_mutex);
+    if (!worker.stream->sendAll(data, writer.size())) {
+        if (worker.connected.exchange(false)) {
+            LOG_ERROR("Lost decode worker", worker.address);
+        }
+        return false;
+    }
+    bytes_sent_ += writer.size();
+    return true;
+}
+
+void DecodeLink::closeChannel(const RemoteChannel& channel) {
+    std::lock_guard<std::mutex> lock(channels_mutex_);
+    auto it = channels_.find(channel.getId());
+    if (it != channels_.end() && it->second.get() == &channel) {
+        channels_.erase(it);
+        workers_[channel.getWorker()]->channels--;
+    }
+}
+
+void DecodeLink::readerThread(Worker* worker) {
+    std::vector<uint8_t> payload;
+    RemoteChannel::Event event;
+
+    while (true) {
+        uint8_t header_bytes[sizeof(MessageHeader)];
+        if (!worker->stream->receiveAll(header_bytes, sizeof(header_bytes))) {
+            break;
+        }
+        MessageHeader header = decodeHeader(header_bytes);
+        if (header.length > MAX_MESSAGE_BYTES) {
+            LOG_ERROR("Corrupt stream from decode worker", worker->address);
+            break;
+        }
+        payload.resize(header.length);
+        if (!worker->stream->receiveAll(payload.data(), payload.size())) {
+            break;
+        }
+
+        std::shared_ptr<RemoteChannel> channel;
+        {
+            std::lock_guard<std::mutex> lock(channels_mutex_);
+            auto it = channels_.find(header.channel);
+            if (it != channels_.end()) {
+                channel = it->second;
+            }
+        }
+        if (!channel) {
+            // Closed while the worker was still sending for it
+            continue;
+        }
+
+        MessageReader reader(payload.data(), payload.size());
+        event.type = header.type;
+        event.timestamp = header.timestamp;
+        bool valid = true;
+        switch (header.type) {
+            case MessageType::GRANT:
+                valid = readGrant(reader, event.grant);
+                break;
+            case MessageType::VOICE_FRAMES:
+                valid = readVoiceFrames(reader, event.voice);
+                break;
+            case MessageType::CALL_END:
+                event.talkgroup = reader.get32();
+                valid = reader.ok();
+                break;
+            case MessageType::LOCK:
+                event.locked = reader.get8() != 0;
+                valid = reader.ok();
+                break;
+            case MessageType::REST_CHANNEL:
+                event.frequency = reader.getDouble();
+                valid = reader.ok();
+                break;
+            default:
+                valid = false;
+                break;
+        }
+        if (!valid) {
+            LOG_WARNING("Bad message", static_cast<int>(header.type), "from decode worker",
+                        worker->address);
+            continue;
+        }
+
+        channel->post(event);
+        events_++;
+    }
+
+    if (worker->connected.exchange(false)) {
+        LOG_ERROR("Lost decode worker", worker->address);
+    }
+}
+
+DecodeLink::Stats DecodeLink::getStats() const {
+    Stats stats;
+    stats.workers = workers_.size();
+    stats.connected = 0;
+    for (const auto& worker : workers_) {
+        if (worker->connected) {
+            stats.connected++;
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(channels_mutex_);
+        stats.channels = channels_.size();
+    }
+    stats.bytes_sent = bytes_sent_;
+    stats.events = events_;
+    return stats;
+}
+
+} // namespace TrunkSDR
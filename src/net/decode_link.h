@@ -0,0 +1,129 @@
+#ifndef DECODE_LINK_H
+#define DECODE_LINK_H
+
+#include "decode_protocol.h"
+#include "socket_stream.h"
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace TrunkSDR {
+
+class DecodeLink;
+
+// One narrowband channel decoded by a worker.
+//
+// The thread that owns the channel streams its baseband and drains the
+// events the worker sent back; the link's reader threads only queue them.
+// Events decoded from samples sent before the last reset belong to the
+// previous call and are dropped.
+class RemoteChannel {
+public:
+    struct Event {
+        MessageType type;
+        uint64_t timestamp;
+        CallGrant grant;            // GRANT
+        VoiceFrameBatch voice;      // VOICE_FRAMES
+        TalkgroupID talkgroup;      // CALL_END
+        Frequency frequency;        // REST_CHANNEL
+        bool locked;                // LOCK
+    };
+
+    RemoteChannel(DecodeLink* link, size_t worker, uint16_t id, SampleFormat format);
+
+    uint16_t getId() const { return id_; }
+    size_t getWorker() const { return worker_; }
+
+    // Owning thread
+    void sendSamples(const Complex* samples, size_t count);
+    void sendReset();
+    void sendTalkgroup(TalkgroupID talkgroup, RadioID source);
+    void close();
+
+    // Events received since the last call, oldest first
+    void takeEvents(std::vector<Event>& events);
+
+    // Link reader thread
+    void post(const Event& event);
+
+private:
+    DecodeLink* link_;
+    size_t worker_;
+    uint16_t id_;
+    SampleFormat format_;
+    bool closed_;
+
+    MessageWriter writer_;
+    uint64_t position_;     // Samples sent
+    uint64_t reset_at_;     // Position of the last reset
+
+    std::mutex events_mutex_;
+    std::vector<Event> events_;
+};
+
+// Front end's connections to its decode workers.
+//
+// Every worker gets one socket. Channels are spread over the workers as
+// they are opened, to the one carrying the fewest; a reader thread per
+// worker routes its events to the channels. A worker that disconnects is
+// not replaced: its channels stop decoding and the loss is logged.
+class DecodeLink {
+public:
+    struct Stats {
+        size_t workers;
+        size_t connected;
+        size_t channels;
+        uint64_t bytes_sent;
+        uint64_t events;
+    };
+
+    DecodeLink();
+    ~DecodeLink();
+
+    // Connect to every worker ("unix:<path>" or "tcp:<host>:<port>")
+    bool initialize(const std::vector<std::string>& workers, SampleFormat format);
+    void stop();
+
+    std::shared_ptr<RemoteChannel> openChannel(const ChannelOpen& open);
+
+    Stats getStats() const;
+
+private:
+    friend class RemoteChannel;
+
+    struct Worker {
+        std::string address;
+        std::unique_ptr<SocketStream> stream;
+        std::mutex send_mutex;
+        std::thread reader;
+        std::atomic<bool> connected{false};
+        size_t channels = 0;
+    };
+
+    bool connect(Worker& worker);
+    void readerThread(Worker* worker);
+
+    bool send(size_t worker, MessageWriter& writer);
+    void closeChannel(const RemoteChannel& channel);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    SampleFormat format_;
+
+    // Open channels by ID. IDs are handed out in turn, skipping open ones,
+    // so a closed channel's ID is not reused while the worker may still be
+    // sending events for it.
+    mutable std::mutex channels_mutex_;
+    std::map<uint16_t, std::shared_ptr<RemoteChannel>> channels_;
+    uint16_t next_id_;
+
+    std::atomic<uint64_t> bytes_sent_;
+    std::atomic<uint64_t> events_;
+};
+
+} // namespace TrunkSDR
+
+#endif // DECODE_LINK_H
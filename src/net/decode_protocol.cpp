@@ -0,0 +1,266 @@
+#include "decode_protocol.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace TrunkSDR {
+
+void MessageWriter::begin(MessageType type, uint16_t channel, uint64_t timestamp, uint8_t format) {
+    // The header is filled in by data() once the length is known
+    buffer_.clear();
+    buffer_.resize(sizeof(MessageHeader));
+    MessageHeader header{type, format, channel, 0, timestamp};
+    encodeHeader(header, buffer_.data());
+}
+
+void MessageWriter::put16(uint16_t value) {
+    put8(static_cast<uint8_t>(value));
+    put8(static_cast<uint8_t>(value >> 8));
+}
+
+void MessageWriter::put32(uint32_t value) {
+    put16(static_cast<uint16_t>(value));
+    put16(static_cast<uint16_t>(value >> 16));
+}
+
+void MessageWriter::put64(uint64_t value) {
+    put32(static_cast<uint32_t>(value));
+    put32(static_cast<uint32_t>(value >> 32));
+}
+
+void MessageWriter::putFloat(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    put32(bits);
+}
+
+void MessageWriter::putDouble(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    put64(bits);
+}
+
+void MessageWriter::putBytes(const void* data, size_t count) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    buffer_.insert(buffer_.end(), bytes, bytes + count);
+}
+
+const uint8_t* MessageWriter::data() {
+    uint32_t length = static_cast<uint32_t>(buffer_.size() - sizeof(MessageHeader));
+    for (int i = 0; i < 4; i++) {
+        buffer_[4 + i] = static_cast<uint8_t>(length >> (8 * i));
+    }
+    return buffer_.data();
+}
+
+MessageReader::MessageReader(const uint8_t* data, size_t size)
+    : data_(data)
+    , size_(size)
+    , offset_(0)
+    , ok_(true) {
+}
+
+bool MessageReader::take(size_t count) {
+    if (!ok_ || size_ - offset_ < count) {
+        ok_ = false;
+        return false;
+    }
+    return true;
+}
+
+uint8_t MessageReader::get8() {
+    if (!take(1)) {
+        return 0;
+    }
+    return data_[offset_++];
+}
+
+uint16_t MessageReader::get16() {
+    uint16_t low = get8();
+    return static_cast<uint16_t>(low | (get8() << 8));
+}
+
+uint32_t MessageReader::get32() {
+    uint32_t low = get16();
+    return low | (static_cast<uint32_t>(get16()) << 16);
+}
+
+uint64_t MessageReader::get64() {
+    uint64_t low = get32();
+    return low | (static_cast<uint64_t>(get32()) << 32);
+}
+
+float MessageReader::getFloat() {
+    uint32_t bits = get32();
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+double MessageReader::getDouble() {
+    uint64_t bits = get64();
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+bool MessageReader::getBytes(void* out, size_t count) {
+    if (!take(count)) {
+        return false;
+    }
+    std::memcpy(out, data_ + offset_, count);
+    offset_ += count;
+    return true;
+}
+
+void encodeHeader(const MessageHeader& header, uint8_t* out) {
+    out[0] = static_cast<uint8_t>(header.type);
+    out[1] = header.format;
+    out[2] = static_cast<uint8_t>(header.channel);
+    out[3] = static_cast<uint8_t>(header.channel >> 8);
+    for (int i = 0; i < 4; i++) {
+        out[4 + i] = static_cast<uint8_t>(header.length >> (8 * i));
+    }
+    for (int i = 0; i < 8; i++) {
+        out[8 + i] = static_cast<uint8_t>(header.timestamp >> (8 * i));
+    }
+}
+
+MessageHeader decodeHeader(const uint8_t* in) {
+    MessageReader reader(in, sizeof(MessageHeader));
+    MessageHeader header;
+    header.type = static_cast<MessageType>(reader.get8());
+    header.format = reader.get8();
+    header.channel = reader.get16();
+    header.length = reader.get32();
+    header.timestamp = reader.get64();
+    return header;
+}
+
+bool parseSampleFormat(const std::string& name, SampleFormat& format) {
+    if (name == "cs8") {
+        format = SampleFormat::CS8;
+        return true;
+    }
+    if (name == "cs16") {
+        format = SampleFormat::CS16;
+        return true;
+    }
+    return false;
+}
+
+void writeChannelOpen(MessageWriter& writer, const ChannelOpen& open) {
+    writer.put16(open.system);
+    writer.put8(static_cast<uint8_t>(open.role));
+    writer.put32(open.sample_rate);
+    writer.putDouble(open.frequency);
+}
+
+bool readChannelOpen(MessageReader& reader, ChannelOpen& open) {
+    open.system = reader.get16();
+    open.role = static_cast<ChannelRole>(reader.get8());
+    open.sample_rate = reader.get32();
+    open.frequency = reader.getDouble();
+    return reader.ok() && open.sample_rate != 0 &&
+           (open.role == ChannelRole::CONTROL || open.role == ChannelRole::VOICE);
+}
+
+void writeSamples(MessageWriter& writer, SampleFormat format, const Complex* samples, size_t count) {
+    // One scale for the block keeps weak and strong channels at full
+    // resolution without per-sample exponents
+    float peak = 0.0f;
+    for (size_t i = 0; i < count; i++) {
+        peak = std::max(peak, std::max(std::abs(samples[i].real()), std::abs(samples[i].imag())));
+    }
+
+    float full_scale = format == SampleFormat::CS8 ? 127.0f : 32767.0f;
+    float scale = peak > 0.0f ? peak / full_scale : 1.0f;
+    float gain = 1.0f / scale;
+    writer.putFloat(scale);
+
+    if (format == SampleFormat::CS8) {
+        for (size_t i = 0; i < count; i++) {
+            writer.put8(static_cast<uint8_t>(static_cast<int8_t>(std::lrint(samples[i].real() * gain))));
+            writer.put8(static_cast<uint8_t>(static_cast<int8_t>(std::lrint(samples[i].imag() * gain))));
+        }
+    } else {
+        for (size_t i = 0; i < count; i++) {
+            writer.put16(static_cast<uint16_t>(static_cast<int16_t>(std::lrint(samples[i].real() * gain))));
+            writer.put16(static_cast<uint16_t>(static_cast<int16_t>(std::lrint(samples[i].imag() * gain))));
+        }
+    }
+}
+
+bool readSamples(MessageReader& reader, SampleFormat format, std::vector<Complex>& samples) {
+    float scale = reader.getFloat();
+    size_t bytes_per_sample = format == SampleFormat::CS8 ? 2 : 4;
+    if (!reader.ok() || reader.remaining() % bytes_per_sample != 0) {
+        return false;
+    }
+
+    size_t count = reader.remaining() / bytes_per_sample;
+    samples.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        if (format == SampleFormat::CS8) {
+            float re = static_cast<int8_t>(reader.get8());
+            float im = static_cast<int8_t>(reader.get8());
+            samples[i] = Complex(re * scale, im * scale);
+        } else {
+            float re = static_cast<int16_t>(reader.get16());
+            float im = static_cast<int16_t>(reader.get16());
+            samples[i] = Complex(re * scale, im * scale);
+        }
+    }
+    return reader.ok();
+}
+
+void writeGrant(MessageWriter& writer, const CallGrant& grant) {
+    writer.put32(grant.talkgroup);
+    writer.put32(grant.radio_id);
+    writer.putDouble(grant.frequency);
+    writer.put8(grant.slot);
+    writer.put8(static_cast<uint8_t>(grant.type));
+    writer.put8(grant.priority);
+    writer.put8(grant.encrypted ? 1 : 0);
+    writer.put64(grant.timestamp);
+}
+
+bool readGrant(MessageReader& reader, CallGrant& grant) {
+    grant.talkgroup = reader.get32();
+    grant.radio_id = reader.get32();
+    grant.frequency = reader.getDouble();
+    grant.slot = reader.get8();
+    grant.type = static_cast<CallType>(reader.get8());
+    grant.priority = reader.get8();
+    grant.encrypted = reader.get8() != 0;
+    grant.timestamp = reader.get64();
+    return reader.ok();
+}
+
+void writeVoiceFrames(MessageWriter& writer, const VoiceFrameBatch& batch) {
+    writer.put8(static_cast<uint8_t>(batch.codec));
+    writer.put32(batch.talkgroup);
+    writer.put32(batch.radio_id);
+    writer.put8(batch.slot);
+    writer.put8(static_cast<uint8_t>(batch.frame_count));
+    writer.put8(static_cast<uint8_t>(batch.frame_bytes));
+    writer.put32(batch.bit_errors);
+    writer.putBytes(batch.data.data(), batch.frame_count * batch.frame_bytes);
+}
+
+bool readVoiceFrames(MessageReader& reader, VoiceFrameBatch& batch) {
+    batch.codec = static_cast<CodecType>(reader.get8());
+    batch.talkgroup = reader.get32();
+    batch.radio_id = reader.get32();
+    batch.slot = reader.get8();
+    batch.frame_count = reader.get8();
+    batch.frame_bytes = reader.get8();
+    batch.bit_errors = reader.get32();
+    if (!reader.ok() || batch.frame_count > MAX_VOICE_FRAMES_PER_BATCH ||
+        batch.frame_bytes > MAX_VOICE_FRAME_BYTES) {
+        return false;
+    }
+    return reader.getBytes(batch.data.data(), batch.frame_count * batch.frame_bytes);
+}
+
+} // namespace TrunkSDR
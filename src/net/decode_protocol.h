@@ -0,0 +1,146 @@
+#ifndef DECODE_PROTOCOL_H
+#define DECODE_PROTOCOL_H
+
+#include "../utils/types.h"
+#include "../decoders/base_decoder.h"
+#include <cstdint>
+#include <vector>
+
+namespace TrunkSDR {
+
+// Wire format between a front end and its decode workers.
+//
+// A stream of messages over one TCP or Unix socket, each a 16-byte header
+// followed by 'length' payload bytes. All fields are little-endian. The
+// front end opens numbered channels, streams their baseband and sends the
+// few calls it would otherwise make on a local decoder (reset, voice
+// talkgroup); the worker answers with what that decoder would have called
+// back with. Timestamps count samples on the channel: a SAMPLES message
+// carries the index of its first sample, an event the index of the end of
+// the block it was decoded from.
+enum class MessageType : uint8_t {
+    // Both ways, first message on a connection
+    HELLO = 1,
+
+    // Front end to worker
+    OPEN = 2,           // ChannelOpen
+    CLOSE = 3,
+    SAMPLES = 4,        // Scale (float), then I/Q pairs in 'format'
+    RESET = 5,          // Decoder and demodulator reset
+    TALKGROUP = 6,      // Talkgroup, source: BaseDecoder::setVoiceTalkgroup
+
+    // Worker to front end
+    GRANT = 16,         // CallGrant
+    CALL_END = 17,      // Talkgroup
+    VOICE_FRAMES = 18,  // VoiceFrameBatch
+    LOCK = 19,          // Decoder lock state changed
+    REST_CHANNEL = 20   // DMR rest channel moved (frequency)
+};
+
+// Baseband is sent as block floating point: one scale per message, then
+// integers at 8 or 16 bits per component (a quarter or half of the
+// complex-float size)
+enum class SampleFormat : uint8_t {
+    CS8 = 1,
+    CS16 = 2
+};
+
+// What a channel carries; decides the decoder's configuration
+enum class ChannelRole : uint8_t {
+    CONTROL = 0,
+    VOICE = 1
+};
+
+struct MessageHeader {
+    MessageType type;
+    uint8_t format;         // SampleFormat of a SAMPLES message
+    uint16_t channel;
+    uint32_t length;        // Payload bytes
+    uint64_t timestamp;
+};
+
+static_assert(sizeof(MessageHeader) == 16, "MessageHeader must be packed");
+
+struct ChannelOpen {
+    uint16_t system;        // Index into the configured systems
+    ChannelRole role;
+    uint32_t sample_rate;
+    Frequency frequency;
+};
+
+constexpr uint32_t DECODE_PROTOCOL_VERSION = 1;
+constexpr uint32_t DECODE_PROTOCOL_MAGIC = 0x44535254;  // "TRSD"
+
+// Larger payloads are a corrupt stream
+constexpr uint32_t MAX_MESSAGE_BYTES = 1u << 20;
+
+// Samples per SAMPLES message; longer blocks are split
+constexpr size_t MAX_SAMPLES_PER_MESSAGE = 16384;
+
+// Builds one message in a reusable buffer
+class MessageWriter {
+public:
+    void begin(MessageType type, uint16_t channel, uint64_t timestamp, uint8_t format = 0);
+
+    void put8(uint8_t value) { buffer_.push_back(value); }
+    void put16(uint16_t value);
+    void put32(uint32_t value);
+    void put64(uint64_t value);
+    void putFloat(float value);
+    void putDouble(double value);
+    void putBytes(const void* data, size_t count);
+
+    // Header and payload, ready to send
+    const uint8_t* data();
+    size_t size() const { return buffer_.size(); }
+
+private:
+    std::vector<uint8_t> buffer_;
+};
+
+// Reads a payload; a short payload leaves ok() false and reads zeros
+class MessageReader {
+public:
+    MessageReader(const uint8_t* data, size_t size);
+
+    uint8_t get8();
+    uint16_t get16();
+    uint32_t get32();
+    uint64_t get64();
+    float getFloat();
+    double getDouble();
+    bool getBytes(void* out, size_t count);
+
+    size_t remaining() const { return size_ - offset_; }
+    bool ok() const { return ok_; }
+
+private:
+    bool take(size_t count);
+
+    const uint8_t* data_;
+    size_t size_;
+    size_t offset_;
+    bool ok_;
+};
+
+void encodeHeader(const MessageHeader& header, uint8_t* out);
+MessageHeader decodeHeader(const uint8_t* in);
+
+bool parseSampleFormat(const std::string& name, SampleFormat& format);
+
+// Payloads
+void writeChannelOpen(MessageWriter& writer, const ChannelOpen& open);
+bool readChannelOpen(MessageReader& reader, ChannelOpen& open);
+
+void writeSamples(MessageWriter& writer, SampleFormat format, const Complex* samples, size_t count);
+bool readSamples(MessageReader& reader, SampleFormat format, std::vector<Complex>& samples);
+
+void writeGrant(MessageWriter& writer, const CallGrant& grant);
+bool readGrant(MessageReader& reader, CallGrant& grant);
+
+void writeVoiceFrames(MessageWriter& writer, const VoiceFrameBatch& batch);
+bool readVoiceFrames(MessageReader& reader, VoiceFrameBatch& batch);
+
+} // namespace TrunkSDR
+
+#endif // DECODE_PROTOCOL_H
@@ -0,0 +1,288 @@
+#include "decode_worker.h"
+#include "../utils/logger.h"
+
+namespace TrunkSDR {
+
+DecodeWorker::DecodeWorker()
+    : running_(false)
+    , channels_(0)
+    , samples_(0)
+    , events_(0) {
+}
+
+DecodeWorker::~DecodeWorker() {
+    stop();
+}
+
+bool DecodeWorker::initialize(const Config& config, const std::string& address) {
+    address_ = address;
+
+    systems_.clear();
+    for (size_t i = 0; i < config.systems.size(); i++) {
+        systems_.push_back(std::make_unique<ChannelGroup>(config.systems[i], i));
+    }
+
+    if (!listener_.listen(address)) {
+        return false;
+    }
+
+    LOG_INFO("Decode worker listening on", address, "for", systems_.size(), "system(s)");
+    return true;
+}
+
+bool DecodeWorker::start() {
+    if (running_) {
+        LOG_WARNING("Decode worker already running");
+        return true;
+    }
+
+    running_ = true;
+    accept_thread_ = std::thread(&DecodeWorker::acceptThread, this);
+    return true;
+}
+
+void DecodeWorker::stop() {
+    if (!running_) {
+        return;
+    }
+    running_ = false;
+
+    listener_.close();
+    if (accept_thread_.joinable()) {
+        accept_thread_.join();
+    }
+
+    std::lock_guard<std::mutex> lock(sessions_mutex_);
+    for (auto& session : sessions_) {
+        session->stream->shutdown();
+    }
+    for (auto& session : sessions_) {
+        if (session->thread.joinable()) {
+            session->thread.join();
+        }
+    }
+    sessions_.clear();
+
+    LOG_INFO("Decode worker stopped");
+}
+
+void DecodeWorker::acceptThread() {
+    while (running_) {
+        std::unique_ptr<SocketStream> stream = listener_.accept();
+        if (!stream) {
+            break;
+        }
+
+        std::lock_guard<std::mutex> lock(sessions_mutex_);
+
+        // Reap front ends that have gone
+        for (size_t i = sessions_.size(); i-- > 0;) {
+            if (sessions_[i]->done) {
+                sessions_[i]->thread.join();
+                sessions_.erase(sessions_.begin() + i);
+            }
+        }
+
+        auto session = std::make_unique<Session>();
+        session->stream = std::move(stream);
+        session->thread = std::thread(&DecodeWorker::serve, this, session.get());
+        sessions_.push_back(std::move(session));
+    }
+}
+
+bool DecodeWorker::handshake(Session& session) {
+    uint8_t buffer[sizeof(MessageHeader) + 8];
+    if (!session.stream->receiveAll(buffer, sizeof(buffer))) {
+        return false;
+    }
+
+    MessageHeader header = decodeHeader(buffer);
+    MessageReader reader(buffer + sizeof(MessageHeader), 8);
+    uint32_t magic = reader.get32();
+    uint32_t version = reader.get32();
+    if (header.type != MessageType::HELLO || header.length != 8 ||
+        magic != DECODE_PROTOCOL_MAGIC || version != DECODE_PROTOCOL_VERSION) {
+        LOG_ERROR("Front end speaks another protocol (version", version, ")");
+        return false;
+    }
+
+    session.events.begin(MessageType::HELLO, 0, 0);
+    session.events.put32(DECODE_PROTOCOL_MAGIC);
+    session.events.put32(DECODE_PROTOCOL_VERSION);
+    const uint8_t* data = session.events.data();
+    return session.stream->sendAll(data, session.events.size());
+}
+
+void DecodeWorker::serve(Session* session) {
+    if (!handshake(*session)) {
+        session->done = true;
+        return;
+    }
+    LOG_INFO("Front end connected");
+
+    while (true) {
+        uint8_t header_bytes[sizeof(MessageHeader)];
+        if (!session->stream->receiveAll(header_bytes, sizeof(header_bytes))) {
+            break;
+        }
+        MessageHeader header = decodeHeader(header_bytes);
+        if (header.length > MAX_MESSAGE_BYTES) {
+            LOG_ERROR("Corrupt stream from front end");
+            break;
+        }
+        session->payload.resize(header.length);
+        if (!session->stream->receiveAll(session->payload.data(), session->payload.size())) {
+            break;
+        }
+        MessageReader reader(session->payload.data(), session->payload.size());
+
+        if (header.type == MessageType::OPEN) {
+            openChannel(*session, header.channel, reader);
+            continue;
+        }
+
+        auto it = session->channels.find(header.channel);
+        if (it == session->channels.end()) {
+            continue;
+        }
+        Channel& channel = *it->second;
+
+        switch (header.type) {
+            case MessageType::SAMPLES:
+                processSamples(*session, channel, header.channel, header, reader);
+                break;
+            case MessageType::RESET:
+                channel.chain.demod->reset();
+                channel.chain.decoder->reset();
+                break;
+            case MessageType::TALKGROUP: {
+                TalkgroupID talkgroup = reader.get32();
+                RadioID source = reader.get32();
+                if (reader.ok()) {
+                    channel.chain.decoder->setVoiceTalkgroup(talkgroup, source);
+                }
+                break;
+            }
+            case MessageType::CLOSE:
+                session->channels.erase(it);
+                channels_--;
+                break;
+            default:
+                LOG_WARNING("Unexpected message", static_cast<int>(header.type), "from front end");
+                break;
+        }
+    }
+
+    channels_ -= session->channels.size();
+    session->channels.clear();
+    LOG_INFO("Front end disconnected");
+    session->done = true;
+}
+
+bool DecodeWorker::openChannel(Session& session, uint16_t id, MessageReader& reader) {
+    ChannelOpen open;
+    if (!readChannelOpen(reader, open) || open.system >= systems_.size()) {
+        LOG_ERROR("Bad channel open from front end (system", open.system, "of", systems_.size(), ")");
+        return false;
+    }
+
+    const ChannelGroup& system = *systems_[open.system];
+    auto channel = std::make_unique<Channel>();
+    channel->chain.frequency = open.frequency;
+
+    // The decoder's callbacks run inside processSamples() on this thread
+    Session* target = &session;
+    Channel* state = channel.get();
+    bool built = system.createDecoderChain(channel->chain, open.role, open.sample_rate,
+        [this, target, state, id](Frequency freq) {
+            target->events.begin(MessageType::REST_CHANNEL, id, state->position);
+            target->events.putDouble(freq);
+            sendEvent(*target);
+        });
+    if (!built) {
+        LOG_ERROR("Failed to build decoder for", system.getSystem().name);
+        return false;
+    }
+
+    BaseDecoder* decoder = channel->chain.decoder.get();
+    decoder->setGrantCallback(
+        [this, target, state, id](const CallGrant& grant) {
+            target->events.begin(MessageType::GRANT, id, state->position);
+            writeGrant(target->events, grant);
+            sendEvent(*target);
+        }
+    );
+    decoder->setVoiceFrameCallback(
+        [this, target, state, id](const VoiceFrameBatch& batch) {
+            target->events.begin(MessageType::VOICE_FRAMES, id, state->position);
+            writeVoiceFrames(target->events, batch);
+            sendEvent(*target);
+        }
+    );
+    decoder->setCallEndCallback(
+        [this, target, state, id](TalkgroupID talkgroup) {
+            target->events.begin(MessageType::CALL_END, id, state->position);
+            target->events.put32(talkgroup);
+            sendEvent(*target);
+        }
+    );
+
+    // Reopening an ID replaces the channel
+    if (session.channels.count(id) == 0) {
+        channels_++;
+    }
+    session.channels[id] = std::move(channel);
+
+    LOG_DEBUG("Channel", id, "opened:", system.getSystem().name,
+              open.role == ChannelRole::CONTROL ? "control" : "voice", open.sample_rate, "S/s");
+    return true;
+}
+
+void DecodeWorker::processSamples(Session& session, Channel& channel, uint16_t id,
+                                  const MessageHeader& header, MessageReader& reader) {
+    SampleFormat format = static_cast<SampleFormat>(header.format);
+    if ((format != SampleFormat::CS8 && format != SampleFormat::CS16) ||
+        !readSamples(reader, format, session.samples)) {
+        LOG_WARNING("Bad samples for channel", id);
+        return;
+    }
+
+    channel.position = header.timestamp + session.samples.size();
+    channel.chain.demod->process(session.samples.data(), session.samples.size());
+    samples_ += session.samples.size();
+
+    bool locked = channel.chain.decoder->isLocked();
+    if (locked != channel.locked) {
+        channel.locked = locked;
+        session.events.begin(MessageType::LOCK, id, channel.position);
+        session.events.put8(locked ? 1 : 0);
+        sendEvent(session);
+    }
+}
+
+void DecodeWorker::sendEvent(Session& session) {
+    // A failed send ends the session at its next read
+    const uint8_t* data = session.events.data();
+    if (session.stream->sendAll(data, session.events.size())) {
+        events_++;
+    }
+}
+
+DecodeWorker::Stats DecodeWorker::getStats() const {
+    Stats stats;
+    {
+        std::lock_guard<std::mutex> lock(sessions_mutex_);
+        stats.connections = 0;
+        for (const auto& session : sessions_) {
+            if (!session->done) {
+                stats.connections++;
+            }
+        }
+    }
+    stats.channels = channels_;
+    stats.samples = samples_;
+    stats.events = events_;
+    return stats;
+}
+
+} // namespace TrunkSDR
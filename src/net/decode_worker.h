@@ -0,0 +1,89 @@
+#ifndef DECODE_WORKER_H
+#define DECODE_WORKER_H
+
+#include "../utils/config_parser.h"
+#include "../trunking/channel_group.h"
+#include "decode_protocol.h"
+#include "socket_stream.h"
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace TrunkSDR {
+
+// Decodes channels for front ends (trunksdr --worker <address>).
+//
+// Runs the same demodulators and decoders as a front end would, built
+// from the same configuration: a channel names its system by index, so
+// both sides must load the same systems in the same order. Each connection
+// is served by its own thread, which decodes its channels in the order
+// their samples arrive and sends the decoders' callbacks straight back.
+class DecodeWorker {
+public:
+    struct Stats {
+        size_t connections;
+        size_t channels;
+        uint64_t samples;
+        uint64_t events;
+    };
+
+    DecodeWorker();
+    ~DecodeWorker();
+
+    bool initialize(const Config& config, const std::string& address);
+    bool start();
+    void stop();
+
+    Stats getStats() const;
+
+private:
+    struct Channel {
+        ChannelReceiver chain;
+        uint64_t position = 0;      // End of the block being decoded
+        bool locked = false;
+    };
+
+    struct Session {
+        std::unique_ptr<SocketStream> stream;
+        std::thread thread;
+        std::atomic<bool> done{false};
+
+        std::map<uint16_t, std::unique_ptr<Channel>> channels;
+        MessageWriter events;
+        std::vector<uint8_t> payload;
+        std::vector<Complex> samples;
+    };
+
+    void acceptThread();
+    void serve(Session* session);
+    bool handshake(Session& session);
+
+    bool openChannel(Session& session, uint16_t id, MessageReader& reader);
+    void processSamples(Session& session, Channel& channel, uint16_t id,
+                        const MessageHeader& header, MessageReader& reader);
+
+    // Send the event built in the session's writer
+    void sendEvent(Session& session);
+
+    // Chain factories only; never initialized against a capture
+    std::vector<std::unique_ptr<ChannelGroup>> systems_;
+
+    std::string address_;
+    SocketListener listener_;
+    std::atomic<bool> running_;
+    std::thread accept_thread_;
+
+    mutable std::mutex sessions_mutex_;
+    std::vector<std::unique_ptr<Session>> sessions_;
+
+    std::atomic<size_t> channels_;
+    std::atomic<uint64_t> samples_;
+    std::atomic<uint64_t> events_;
+};
+
+} // namespace TrunkSDR
+
+#endif // DECODE_WORKER_H
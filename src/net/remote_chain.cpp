@@ -0,0 +1,74 @@
+#include "remote_chain.h"
+
+namespace TrunkSDR {
+
+RemoteDecoder::RemoteDecoder(std::shared_ptr<RemoteChannel> channel, SystemType type)
+    : channel_(channel)
+    , type_(type)
+    , locked_(false) {
+}
+
+RemoteDecoder::~RemoteDecoder() {
+    channel_->close();
+}
+
+void RemoteDecoder::processSymbols(const float* symbols, size_t count) {
+    // Symbols are recovered on the worker; nothing feeds them here
+    (void)symbols;
+    (void)count;
+}
+
+void RemoteDecoder::reset() {
+    locked_ = false;
+    channel_->sendReset();
+}
+
+void RemoteDecoder::setVoiceTalkgroup(TalkgroupID talkgroup, RadioID source) {
+    channel_->sendTalkgroup(talkgroup, source);
+}
+
+void RemoteDecoder::dispatch() {
+    channel_->takeEvents(events_);
+
+    for (const RemoteChannel::Event& event : events_) {
+        switch (event.type) {
+            case MessageType::GRANT:
+                if (grant_callback_) {
+                    grant_callback_(event.grant);
+                }
+                break;
+            case MessageType::VOICE_FRAMES:
+                if (voice_frame_callback_) {
+                    voice_frame_callback_(event.voice);
+                }
+                break;
+            case MessageType::CALL_END:
+                if (call_end_callback_) {
+                    call_end_callback_(event.talkgroup);
+                }
+                break;
+            case MessageType::LOCK:
+                locked_ = event.locked;
+                break;
+            case MessageType::REST_CHANNEL:
+                if (rest_channel_callback_) {
+                    rest_channel_callback_(event.frequency);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+RemoteDemodulator::RemoteDemodulator(std::shared_ptr<RemoteChannel> channel, RemoteDecoder* decoder)
+    : channel_(channel)
+    , decoder_(decoder) {
+}
+
+void RemoteDemodulator::process(const Complex* samples, size_t count) {
+    channel_->sendSamples(samples, count);
+    decoder_->dispatch();
+}
+
+} // namespace TrunkSDR
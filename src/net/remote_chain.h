@@ -0,0 +1,68 @@
+#ifndef REMOTE_CHAIN_H
+#define REMOTE_CHAIN_H
+
+#include "../dsp/demodulator.h"
+#include "../decoders/base_decoder.h"
+#include "decode_link.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+
+namespace TrunkSDR {
+
+// Stand-in for a decoder running on a decode worker.
+//
+// Looks like the local decoder to whoever wired its callbacks: reset() and
+// setVoiceTalkgroup() are forwarded, and the worker's grants, voice frames
+// and call ends are delivered by dispatch() on the channel's own thread,
+// exactly where the local decoder would have called back.
+class RemoteDecoder : public BaseDecoder {
+public:
+    using RestChannelCallback = std::function<void(Frequency)>;
+
+    RemoteDecoder(std::shared_ptr<RemoteChannel> channel, SystemType type);
+    ~RemoteDecoder() override;
+
+    void initialize() override {}
+    void processSymbols(const float* symbols, size_t count) override;
+    void reset() override;
+
+    SystemType getSystemType() const override { return type_; }
+    bool isLocked() const override { return locked_; }
+
+    void setVoiceTalkgroup(TalkgroupID talkgroup, RadioID source) override;
+
+    // DMR control channels moving between repeaters
+    void setRestChannelCallback(RestChannelCallback callback) { rest_channel_callback_ = callback; }
+
+    // Deliver the events received since the last call
+    void dispatch();
+
+private:
+    std::shared_ptr<RemoteChannel> channel_;
+    SystemType type_;
+    std::atomic<bool> locked_;
+    RestChannelCallback rest_channel_callback_;
+    std::vector<RemoteChannel::Event> events_;
+};
+
+// Stand-in for the demodulator: ships the channel's baseband to the
+// worker, then hands whatever came back to the decoder
+class RemoteDemodulator : public Demodulator {
+public:
+    RemoteDemodulator(std::shared_ptr<RemoteChannel> channel, RemoteDecoder* decoder);
+
+    void initialize(uint32_t sample_rate) override { (void)sample_rate; }
+    void process(const Complex* samples, size_t count) override;
+
+    // The worker resets its demodulator with the decoder
+    void reset() override {}
+
+private:
+    std::shared_ptr<RemoteChannel> channel_;
+    RemoteDecoder* decoder_;
+};
+
+} // namespace TrunkSDR
+
+#endif // REMOTE_CHAIN_H
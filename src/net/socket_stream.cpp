@@ -0,0 +1,254 @@
+#include "socket_stream.h"
+#include "../utils/logger.h"
+#include <cerrno>
+#include <cstring>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace TrunkSDR {
+
+namespace {
+
+const std::string UNIX_PREFIX = "unix:";
+const std::string TCP_PREFIX = "tcp:";
+
+bool isUnixAddress(const std::string& address) {
+    return address.compare(0, UNIX_PREFIX.size(), UNIX_PREFIX) == 0;
+}
+
+bool makeUnixAddress(const std::string& path, sockaddr_un& addr) {
+    if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+        LOG_ERROR("Invalid Unix socket path:", path);
+        return false;
+    }
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, path.c_str(), path.size());
+    return true;
+}
+
+// "tcp:host:port"; the port follows the last colon
+addrinfo* resolveTCP(const std::string& address, bool passive) {
+    if (address.compare(0, TCP_PREFIX.size(), TCP_PREFIX) != 0) {
+        LOG_ERROR("Unknown socket address (expected unix:<path> or tcp:<host>:<port>):", address);
+        return nullptr;
+    }
+
+    std::string rest = address.substr(TCP_PREFIX.size());
+    size_t colon = rest.rfind(':');
+    if (colon == std::string::npos) {
+        LOG_ERROR("Missing port in", address);
+        return nullptr;
+    }
+    std::string host = rest.substr(0, colon);
+    std::string port = rest.substr(colon + 1);
+
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = passive ? AI_PASSIVE : 0;
+
+    addrinfo* result = nullptr;
+    int error = getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &result);
+    if (error != 0) {
+        LOG_ERROR("Failed to resolve", address, ":", gai_strerror(error));
+        return nullptr;
+    }
+    return result;
+}
+
+void setNoDelay(int fd) {
+    // Events are small and latency matters more than packet count
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+} // anonymous namespace
+
+SocketStream::SocketStream(int fd)
+    : fd_(fd) {
+}
+
+SocketStream::~SocketStream() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+std::unique_ptr<SocketStream> SocketStream::connect(const std::string& address) {
+    if (isUnixAddress(address)) {
+        sockaddr_un addr;
+        if (!makeUnixAddress(address.substr(UNIX_PREFIX.size()), addr)) {
+            return nullptr;
+        }
+        int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            LOG_ERROR("Failed to connect to", address, ":", std::strerror(errno));
+            if (fd >= 0) {
+                ::close(fd);
+            }
+            return nullptr;
+        }
+        return std::make_unique<SocketStream>(fd);
+    }
+
+    addrinfo* result = resolveTCP(address, false);
+    if (!result) {
+        return nullptr;
+    }
+
+    int fd = -1;
+    for (addrinfo* ai = result; ai; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        if (::connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+            break;
+        }
+        ::close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(result);
+
+    if (fd < 0) {
+        LOG_ERROR("Failed to connect to", address, ":", std::strerror(errno));
+        return nullptr;
+    }
+    setNoDelay(fd);
+    return std::make_unique<SocketStream>(fd);
+}
+
+bool SocketStream::sendAll(const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t sent = ::send(fd_, bytes, size, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        bytes += sent;
+        size -= sent;
+    }
+    return true;
+}
+
+bool SocketStream::receiveAll(void* data, size_t size) {
+    char* bytes = static_cast<char*>(data);
+    while (size > 0) {
+        ssize_t got = ::recv(fd_, bytes, size, 0);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            return false;
+        }
+        bytes += got;
+        size -= got;
+    }
+    return true;
+}
+
+void SocketStream::shutdown() {
+    ::shutdown(fd_, SHUT_RDWR);
+}
+
+SocketListener::SocketListener()
+    : fd_(-1)
+    , tcp_(false) {
+}
+
+SocketListener::~SocketListener() {
+    close();
+}
+
+bool SocketListener::listen(const std::string& address) {
+    close();
+    tcp_ = false;
+
+    if (isUnixAddress(address)) {
+        std::string path = address.substr(UNIX_PREFIX.size());
+        sockaddr_un addr;
+        if (!makeUnixAddress(path, addr)) {
+            return false;
+        }
+
+        // A socket file left by an earlier run would make bind fail
+        unlink(path.c_str());
+        fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd_ < 0 || bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+            ::listen(fd_, 16) < 0) {
+            LOG_ERROR("Failed to listen on", address, ":", std::strerror(errno));
+            close();
+            return false;
+        }
+        unix_path_ = path;
+        return true;
+    }
+
+    addrinfo* result = resolveTCP(address, true);
+    if (!result) {
+        return false;
+    }
+
+    for (addrinfo* ai = result; ai; ai = ai->ai_next) {
+        fd_ = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+        if (fd_ < 0) {
+            continue;
+        }
+        int one = 1;
+        setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (bind(fd_, ai->ai_addr, ai->ai_addrlen) == 0 && ::listen(fd_, 16) == 0) {
+            break;
+        }
+        ::close(fd_);
+        fd_ = -1;
+    }
+    freeaddrinfo(result);
+
+    if (fd_ < 0) {
+        LOG_ERROR("Failed to listen on", address, ":", std::strerror(errno));
+        return false;
+    }
+    tcp_ = true;
+    return true;
+}
+
+std::unique_ptr<SocketStream> SocketListener::accept() {
+    int listen_fd;
+    while ((listen_fd = fd_) >= 0) {
+        int fd = ::accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd >= 0) {
+            if (tcp_) {
+                setNoDelay(fd);
+            }
+            return std::make_unique<SocketStream>(fd);
+        }
+        if (errno != EINTR && errno != ECONNABORTED) {
+            break;
+        }
+    }
+    return nullptr;
+}
+
+void SocketListener::close() {
+    int fd = fd_.exchange(-1);
+    if (fd >= 0) {
+        // Wakes a thread blocked in accept()
+        ::shutdown(fd, SHUT_RDWR);
+        ::close(fd);
+    }
+    if (!unix_path_.empty()) {
+        unlink(unix_path_.c_str());
+        unix_path_.clear();
+    }
+}
+
+} // namespace TrunkSDR
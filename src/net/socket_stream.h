@@ -0,0 +1,61 @@
+#ifndef SOCKET_STREAM_H
+#define SOCKET_STREAM_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace TrunkSDR {
+
+// A connected stream socket with blocking whole-buffer reads and writes.
+//
+// Addresses are "unix:<path>" or "tcp:<host>:<port>"; a listener's host may
+// be empty to accept on every interface.
+class SocketStream {
+public:
+    explicit SocketStream(int fd);
+    ~SocketStream();
+
+    SocketStream(const SocketStream&) = delete;
+    SocketStream& operator=(const SocketStream&) = delete;
+
+    static std::unique_ptr<SocketStream> connect(const std::string& address);
+
+    // False once the peer has gone or the socket was shut down
+    bool sendAll(const void* data, size_t size);
+    bool receiveAll(void* data, size_t size);
+
+    // Wakes a thread blocked in receiveAll(); the socket is closed by the
+    // destructor
+    void shutdown();
+
+private:
+    int fd_;
+};
+
+class SocketListener {
+public:
+    SocketListener();
+    ~SocketListener();
+
+    SocketListener(const SocketListener&) = delete;
+    SocketListener& operator=(const SocketListener&) = delete;
+
+    bool listen(const std::string& address);
+
+    // Blocks for the next connection; nullptr once closed
+    std::unique_ptr<SocketStream> accept();
+
+    // Also wakes a thread blocked in accept()
+    void close();
+
+private:
+    std::atomic<int> fd_;
+    bool tcp_;
+    std::string unix_path_;   // Removed again on close
+};
+
+} // namespace TrunkSDR
+
+#endif // SOCKET_STREAM_H
@@ -0,0 +1,433 @@
+#include "iq_recorder.h"
+#include "../utils/logger.h"
+#include <json/json.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <sys/stat.h>
+
+namespace TrunkSDR {
+
+namespace {
+
+// Room beyond the pre-trigger time for the writer to fall behind, and the
+// most the SDR thread writes before publishing its index
+constexpr uint32_t SLACK_MS = 1000;
+constexpr uint32_t GUARD_MS = 100;
+
+// How often a capture looks for new samples
+constexpr auto POLL_INTERVAL = std::chrono::milliseconds(20);
+
+inline uint8_t packCU8(float value) {
+    // Inverse of the RTL-SDR conversion, (byte - 127.4) / 128, rounded by
+    // truncating half a step up; branch free so the loop vectorizes
+    float packed = value * 128.0f + 127.9f;
+    return static_cast<uint8_t>(std::min(255.0f, std::max(0.0f, packed)));
+}
+
+std::string formatTime(std::chrono::system_clock::time_point when, bool file_name) {
+    std::time_t seconds = std::chrono::system_clock::to_time_t(when);
+    std::tm utc;
+    gmtime_r(&seconds, &utc);
+
+    char buffer[40];
+    if (file_name) {
+        std::strftime(buffer, sizeof(buffer), "%Y%m%d_%H%M%S", &utc);
+        return buffer;
+    }
+
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        when.time_since_epoch()).count() % 1000;
+    size_t length = std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", &utc);
+    std::snprintf(buffer + length, sizeof(buffer) - length, ".%03dZ", static_cast<int>(ms));
+    return buffer;
+}
+
+} // anonymous namespace
+
+IQRecorder::IQRecorder()
+    : sample_rate_(0)
+    , bytes_per_sample_(0)
+    , capacity_(0)
+    , guard_(0)
+    , write_index_(0)
+    , center_freq_(0)
+    , retune_index_(0)
+    , running_(false)
+    , captures_(0)
+    , triggers_(0)
+    , dropped_samples_(0)
+    , capturing_(false) {
+}
+
+IQRecorder::~IQRecorder() {
+    stop();
+}
+
+bool IQRecorder::parseFormat(const std::string& name, Format& format) {
+    if (name == "cu8") {
+        format = Format::CU8;
+        return true;
+    }
+    if (name == "cf32") {
+        format = Format::CF32;
+        return true;
+    }
+    return false;
+}
+
+bool IQRecorder::initialize(const Settings& settings, uint32_t sample_rate, Frequency center_freq) {
+    if (settings.directory.empty() || sample_rate == 0) {
+        LOG_ERROR("IQ capture needs a directory and a sample rate");
+        return false;
+    }
+    if (mkdir(settings.directory.c_str(), 0755) != 0 && errno != EEXIST) {
+        LOG_ERROR("Cannot create IQ capture directory", settings.directory, ":", std::strerror(errno));
+        return false;
+    }
+
+    settings_ = settings;
+    settings_.max_capture_ms = std::max(settings.max_capture_ms,
+                                        settings.pre_trigger_ms + settings.post_trigger_ms);
+    sample_rate_ = sample_rate;
+    bytes_per_sample_ = settings.format == Format::CU8 ? 2 : sizeof(Complex);
+
+    guard_ = static_cast<uint64_t>(sample_rate) * GUARD_MS / 1000;
+    capacity_ = static_cast<uint64_t>(sample_rate) * (settings.pre_trigger_ms + SLACK_MS) / 1000 + guard_;
+    ring_.assign(capacity_ * bytes_per_sample_, 0);
+    staging_.resize(guard_ * bytes_per_sample_);
+    write_index_ = 0;
+
+    center_freq_ = center_freq;
+    retune_index_ = 0;
+
+    LOG_INFO("IQ capture to", settings.directory, ":", settings.pre_trigger_ms, "ms before and",
+             settings.post_trigger_ms, "ms after a trigger,",
+             settings.format == Format::CU8 ? "cu8," : "cf32,",
+             ring_.size() / (1024 * 1024), "MB ring");
+    return true;
+}
+
+void IQRecorder::start() {
+    if (running_ || ring_.empty()) {
+        return;
+    }
+    running_ = true;
+    writer_ = std::thread(&IQRecorder::writerThread, this);
+}
+
+void IQRecorder::stop() {
+    if (!running_) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    wake_.notify_all();
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+}
+
+void IQRecorder::write(const Complex* samples, size_t count) {
+    if (ring_.empty()) {
+        return;
+    }
+
+    // Publish at least every guard_ samples, so a reader knows which slots
+    // may be changing under it
+    uint64_t index = write_index_.load(std::memory_order_relaxed);
+    while (count > 0) {
+        size_t block = static_cast<size_t>(std::min<uint64_t>(count, guard_));
+        for (size_t done = 0; done < block;) {
+            uint64_t slot = (index + done) % capacity_;
+            size_t run = static_cast<size_t>(std::min<uint64_t>(block - done, capacity_ - slot));
+            if (settings_.format == Format::CU8) {
+                const float* in = reinterpret_cast<const float*>(samples + done);
+                uint8_t* out = &ring_[slot * 2];
+                for (size_t i = 0; i < run * 2; i++) {
+                    out[i] = packCU8(in[i]);
+                }
+            } else {
+                std::memcpy(&ring_[slot * sizeof(Complex)], samples + done, run * sizeof(Complex));
+            }
+            done += run;
+        }
+
+        index += block;
+        samples += block;
+        count -= block;
+        write_index_.store(index, std::memory_order_release);
+    }
+}
+
+void IQRecorder::setCenterFrequency(Frequency freq) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    center_freq_ = freq;
+    retune_index_ = write_index_.load(std::memory_order_relaxed);
+}
+
+void IQRecorder::trigger(const std::string& reason) {
+    if (!running_) {
+        return;
+    }
+
+    Trigger event;
+    event.reason = reason;
+    event.index = write_index_.load(std::memory_order_acquire);
+    event.time = formatTime(std::chrono::system_clock::now(), false);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.push_back(std::move(event));
+    }
+    triggers_++;
+    wake_.notify_one();
+}
+
+uint64_t IQRecorder::oldestReadable(uint64_t write_index) const {
+    uint64_t span = capacity_ - guard_;
+    return write_index > span ? write_index - span : 0;
+}
+
+void IQRecorder::writerThread() {
+    while (true) {
+        Trigger first;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [this]() { return !pending_.empty() || !running_; });
+            if (pending_.empty()) {
+                break;
+            }
+            first = std::move(pending_.front());
+            pending_.erase(pending_.begin());
+        }
+        capture(std::move(first));
+    }
+}
+
+void IQRecorder::capture(Trigger first) {
+    const uint64_t pre = static_cast<uint64_t>(sample_rate_) * settings_.pre_trigger_ms / 1000;
+    const uint64_t post = static_cast<uint64_t>(sample_rate_) * settings_.post_trigger_ms / 1000;
+    const uint64_t longest = static_cast<uint64_t>(sample_rate_) * settings_.max_capture_ms / 1000;
+
+    // Never mix samples from two tunings in one recording
+    Frequency center_freq;
+    uint64_t retune_index;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        center_freq = center_freq_;
+        retune_index = retune_index_;
+    }
+
+    uint64_t start = first.index > pre ? first.index - pre : 0;
+    start = std::max(start, oldestReadable(write_index_.load(std::memory_order_acquire)));
+    start = std::max(start, retune_index);
+    uint64_t end = first.index + post;
+    const uint64_t limit = start + longest;
+
+    std::string name = settings_.directory + "/iq_" +
+                       formatTime(std::chrono::system_clock::now(), true) + "_" + first.reason + "_" +
+                       std::to_string(static_cast<uint64_t>(center_freq));
+    std::string data_path = name + ".sigmf-data";
+    std::ofstream file(data_path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        LOG_ERROR("Cannot write IQ capture:", data_path);
+        return;
+    }
+
+    LOG_INFO("IQ capture triggered by", first.reason, "->", data_path);
+    capturing_ = true;
+
+    std::vector<Trigger> triggers;
+    triggers.push_back(std::move(first));
+
+    uint64_t position = start;
+    uint64_t written = 0;
+    std::vector<Gap> gaps;
+    bool ok = true;
+    while (ok) {
+        bool running = running_;
+        uint64_t write_index = write_index_.load(std::memory_order_acquire);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            // Triggers while recording extend it rather than start another
+            while (!pending_.empty() && pending_.front().index < limit) {
+                end = std::min(limit, std::max(end, pending_.front().index + post));
+                triggers.push_back(std::move(pending_.front()));
+                pending_.erase(pending_.begin());
+            }
+
+            // Retuned: the recording ends where the old tuning did
+            if (retune_index_ > start) {
+                end = std::min(end, retune_index_);
+            }
+        }
+
+        uint64_t to = std::min(write_index, end);
+        if (to > position) {
+            ok = save(file, position, to, written, gaps);
+            position = to;
+        }
+        if (position >= end || !running) {
+            break;
+        }
+        std::this_thread::sleep_for(POLL_INTERVAL);
+    }
+    file.close();
+    capturing_ = false;
+
+    if (!ok || file.fail()) {
+        LOG_ERROR("Failed writing IQ capture:", data_path);
+        return;
+    }
+    if (!gaps.empty()) {
+        uint64_t lost = position - start - written;
+        LOG_WARNING("IQ capture fell behind and lost", lost, "samples in", gaps.size(),
+                    "gap(s):", data_path);
+        dropped_samples_ += lost;
+    }
+
+    if (!writeMetadata(name + ".sigmf-meta", start, triggers, gaps, center_freq)) {
+        return;
+    }
+    captures_++;
+    LOG_INFO("IQ capture saved:", data_path, "(", written * 1000 / sample_rate_,
+             "ms,", triggers.size(), "trigger(s) )");
+}
+
+bool IQRecorder::save(std::ofstream& file, uint64_t from, uint64_t to, uint64_t& written,
+                      std::vector<Gap>& gaps) {
+    while (from < to) {
+        // Overwritten before we got here; continue from the oldest left
+        uint64_t oldest = oldestReadable(write_index_.load(std::memory_order_acquire));
+        if (from < oldest) {
+            uint64_t skip = std::min(oldest, to) - from;
+            from += skip;
+            if (!gaps.empty() && gaps.back().position == written) {
+                // Nothing saved since the last gap; it just got longer
+                gaps.back().index = from;
+                gaps.back().skipped += skip;
+            } else {
+                gaps.push_back({from, written, skip});
+            }
+            continue;
+        }
+
+        uint64_t slot = from % capacity_;
+        size_t run = static_cast<size_t>(std::min({to - from, guard_, capacity_ - slot}));
+        size_t bytes = run * bytes_per_sample_;
+        std::memcpy(staging_.data(), &ring_[slot * bytes_per_sample_], bytes);
+
+        // The SDR thread may have lapped the copy while it was made
+        if (from < oldestReadable(write_index_.load(std::memory_order_acquire))) {
+            continue;
+        }
+
+        file.write(reinterpret_cast<const char*>(staging_.data()), bytes);
+        if (!file) {
+            return false;
+        }
+        from += run;
+        written += run;
+    }
+    return true;
+}
+
+bool IQRecorder::writeMetadata(const std::string& path, uint64_t start,
+                               const std::vector<Trigger>& triggers, const std::vector<Gap>& gaps,
+                               Frequency center_freq) const {
+    // Write index to file sample; an index lost in a gap maps to where the
+    // recording resumed
+    auto filePosition = [&](uint64_t index) {
+        uint64_t position = index > start ? index - start : 0;
+        for (const Gap& gap : gaps) {
+            if (index < gap.index - gap.skipped) {
+                break;
+            }
+            position = index >= gap.index ? position - gap.skipped : gap.position;
+        }
+        return position;
+    };
+
+    Json::Value global;
+    global["core:datatype"] = settings_.format == Format::CU8 ? "cu8" : "cf32_le";
+    global["core:sample_rate"] = static_cast<double>(sample_rate_);
+    global["core:version"] = "1.0.0";
+    global["core:recorder"] = "trunksdr";
+    global["core:description"] = "Raw capture around " + triggers.front().reason;
+
+    // One segment per continuous run of samples; global_index counts
+    // samples from the start of the recording, lost ones included
+    Json::Value captures(Json::arrayValue);
+    Json::Value capture;
+    capture["core:sample_start"] = Json::UInt64(0);
+    capture["core:global_index"] = Json::UInt64(0);
+    capture["core:frequency"] = center_freq;
+    capture["core:datetime"] = triggers.front().time;
+    captures.append(capture);
+
+    std::vector<Json::Value> notes;
+    for (const Gap& gap : gaps) {
+        Json::Value segment;
+        segment["core:sample_start"] = Json::UInt64(gap.position);
+        segment["core:global_index"] = Json::UInt64(gap.index - start);
+        segment["core:frequency"] = center_freq;
+        captures.append(segment);
+
+        Json::Value annotation;
+        annotation["core:sample_start"] = Json::UInt64(gap.position);
+        annotation["core:label"] = "gap";
+        annotation["core:comment"] = std::to_string(gap.skipped) + " samples skipped";
+        notes.push_back(annotation);
+    }
+    for (const Trigger& event : triggers) {
+        Json::Value annotation;
+        annotation["core:sample_start"] = Json::UInt64(filePosition(event.index));
+        annotation["core:sample_count"] = Json::UInt64(1);
+        annotation["core:label"] = event.reason;
+        annotation["core:comment"] = event.time;
+        notes.push_back(annotation);
+    }
+
+    // SigMF wants annotations in sample order
+    std::stable_sort(notes.begin(), notes.end(), [](const Json::Value& a, const Json::Value& b) {
+        return a["core:sample_start"].asUInt64() < b["core:sample_start"].asUInt64();
+    });
+    Json::Value annotations(Json::arrayValue);
+    for (Json::Value& note : notes) {
+        annotations.append(std::move(note));
+    }
+
+    Json::Value root;
+    root["global"] = global;
+    root["captures"] = captures;
+    root["annotations"] = annotations;
+
+    std::ofstream file(path, std::ios::trunc);
+    if (!file.is_open()) {
+        LOG_ERROR("Cannot write IQ capture metadata:", path);
+        return false;
+    }
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "  ";
+    file << Json::writeString(builder, root) << "\n";
+    return static_cast<bool>(file);
+}
+
+IQRecorder::Stats IQRecorder::getStats() const {
+    Stats stats;
+    stats.captures = captures_;
+    stats.triggers = triggers_;
+    stats.dropped_samples = dropped_samples_;
+    stats.capturing = capturing_;
+    return stats;
+}
+
+} // namespace TrunkSDR
@@ -0,0 +1,133 @@
+#ifndef IQ_RECORDER_H
+#define IQ_RECORDER_H
+
+#include "../utils/types.h"
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace TrunkSDR {
+
+// Raw IQ around interesting events, for analysis after the fact.
+//
+// The capture is copied into a fixed ring holding the last few seconds,
+// either as complex floats or packed to 8-bit unsigned I/Q the way an
+// RTL-SDR delivers it (a quarter of the memory of cf32, and lossless for
+// dongle samples). write() is a copy and an atomic store; it
+// never blocks or allocates. trigger() wakes a writer thread that saves
+// the pre-trigger seconds still in the ring, then follows the ring for the
+// post-trigger time. Further triggers while a capture is being written
+// extend it, up to a maximum length. Each capture is a SigMF recording:
+// <name>.sigmf-data with the samples and <name>.sigmf-meta describing
+// them, with one annotation per trigger.
+//
+// A writer that falls more than a ring behind (a slow disk) loses samples;
+// they are counted and the capture continues from the newest data. Each
+// gap starts a new SigMF capture segment, whose core:global_index gives
+// its place in the recording's timeline, and is annotated with the number
+// of samples skipped.
+class IQRecorder {
+public:
+    enum class Format {
+        CF32,       // Complex float, 8 bytes per sample
+        CU8         // Unsigned 8-bit I/Q, 2 bytes per sample
+    };
+
+    struct Settings {
+        std::string directory;
+        Format format;
+        uint32_t pre_trigger_ms;
+        uint32_t post_trigger_ms;
+        uint32_t max_capture_ms;
+    };
+
+    struct Stats {
+        uint64_t captures;
+        uint64_t triggers;
+        uint64_t dropped_samples;   // Overwritten before the writer saved them
+        bool capturing;
+    };
+
+    IQRecorder();
+    ~IQRecorder();
+
+    bool initialize(const Settings& settings, uint32_t sample_rate, Frequency center_freq);
+    void start();
+    void stop();
+
+    // SDR thread
+    void write(const Complex* samples, size_t count);
+
+    // The capture was retuned; a capture in progress ends here
+    void setCenterFrequency(Frequency freq);
+
+    // Any thread. 'reason' becomes the annotation and part of the file name.
+    void trigger(const std::string& reason);
+
+    Stats getStats() const;
+
+    static bool parseFormat(const std::string& name, Format& format);
+
+private:
+    struct Trigger {
+        std::string reason;
+        uint64_t index;         // Write index when it fired
+        std::string time;       // ISO 8601, UTC
+    };
+
+    // Samples overwritten before the writer saved them
+    struct Gap {
+        uint64_t index;         // Write index the recording resumed at
+        uint64_t position;      // Samples in the file before it
+        uint64_t skipped;
+    };
+
+    void writerThread();
+    void capture(Trigger first);
+
+    // Oldest sample the SDR thread cannot be overwriting
+    uint64_t oldestReadable(uint64_t write_index) const;
+
+    // Copy ring samples [from, to) to the file, counting them in 'written'
+    // and recording a gap for any the SDR thread overwrote first; false on
+    // a write error
+    bool save(std::ofstream& file, uint64_t from, uint64_t to, uint64_t& written,
+              std::vector<Gap>& gaps);
+    bool writeMetadata(const std::string& path, uint64_t start, const std::vector<Trigger>& triggers,
+                       const std::vector<Gap>& gaps, Frequency center_freq) const;
+
+    Settings settings_;
+    uint32_t sample_rate_;
+    size_t bytes_per_sample_;
+
+    // Ring of the newest samples; sample i lives at (i % capacity_).
+    // 'guard_' samples behind the write index may be mid-overwrite.
+    std::vector<uint8_t> ring_;
+    uint64_t capacity_;
+    uint64_t guard_;
+    std::atomic<uint64_t> write_index_;
+    std::vector<uint8_t> staging_;
+
+    // Centre of the samples from retune_index_ on (under mutex_)
+    Frequency center_freq_;
+    uint64_t retune_index_;
+
+    std::thread writer_;
+    std::atomic<bool> running_;
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::vector<Trigger> pending_;
+
+    std::atomic<uint64_t> captures_;
+    std::atomic<uint64_t> triggers_;
+    std::atomic<uint64_t> dropped_samples_;
+    std::atomic<bool> capturing_;
+};
+
+} // namespace TrunkSDR
+
+#endif // IQ_RECORDER_H
@@ -21,7 +21,9 @@ public:
     virtual bool stop() = 0;
     virtual bool isRunning() const = 0;
 
-    // Frequency control
+    // Frequency control. A source that is not tunable (another process's
+    // capture) stays on getFrequency() whatever is asked of it.
+    virtual bool isTunable() const { return true; }
     virtual bool setFrequency(Frequency freq) = 0;
     virtual Frequency getFrequency() const = 0;
 
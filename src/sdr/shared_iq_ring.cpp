@@ -0,0 +1,243 @@
+#include "shared_iq_ring.h"
+#include "../utils/logger.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace TrunkSDR {
+
+namespace {
+
+uint64_t frequencyBits(Frequency freq) {
+    uint64_t bits;
+    std::memcpy(&bits, &freq, sizeof(bits));
+    return bits;
+}
+
+Frequency frequencyFromBits(uint64_t bits) {
+    Frequency freq;
+    std::memcpy(&freq, &bits, sizeof(freq));
+    return freq;
+}
+
+size_t pageSize() {
+    static const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return page;
+}
+
+} // anonymous namespace
+
+size_t SharedIQRing::headerBytes() {
+    size_t page = pageSize();
+    return (sizeof(SharedIQHeader) + page - 1) / page * page;
+}
+
+SharedIQRing::SharedIQRing()
+    : owner_(false)
+    , mapping_(nullptr)
+    , mapping_bytes_(0)
+    , header_(nullptr)
+    , data_(nullptr)
+    , mask_(0) {
+}
+
+SharedIQRing::~SharedIQRing() {
+    close();
+}
+
+bool SharedIQRing::create(const std::string& name, uint32_t capacity,
+                          uint32_t sample_rate, Frequency center_freq) {
+    close();
+
+    // The mirror is mapped at the end of the data, so the data must be
+    // whole pages
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0 ||
+        (static_cast<size_t>(capacity) * sizeof(Complex)) % pageSize() != 0) {
+        LOG_ERROR("Shared IQ ring capacity must be a power of two of at least",
+                  pageSize() / sizeof(Complex), "samples");
+        return false;
+    }
+
+    segment_ = segmentName(name);
+
+    // A stale segment from an earlier run is replaced; readers still
+    // mapping it keep their copy until they reopen
+    shm_unlink(segment_.c_str());
+    int fd = shm_open(segment_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        LOG_ERROR("Failed to create shared memory", segment_, ":", std::strerror(errno));
+        return false;
+    }
+
+    size_t bytes = headerBytes() + static_cast<size_t>(capacity) * sizeof(Complex);
+    if (ftruncate(fd, bytes) < 0) {
+        LOG_ERROR("Failed to size shared memory", segment_, ":", std::strerror(errno));
+        ::close(fd);
+        shm_unlink(segment_.c_str());
+        return false;
+    }
+
+    owner_ = true;
+    bool mapped = map(fd, capacity, true);
+    ::close(fd);
+    if (!mapped) {
+        close();
+        return false;
+    }
+
+    header_->capacity = capacity;
+    header_->writer_pid = static_cast<uint32_t>(getpid());
+    header_->sequence.store(0, std::memory_order_relaxed);
+    header_->sample_rate.store(sample_rate, std::memory_order_relaxed);
+    header_->center_freq.store(frequencyBits(center_freq), std::memory_order_relaxed);
+    header_->info_index.store(0, std::memory_order_relaxed);
+    header_->write_index.store(0, std::memory_order_relaxed);
+    header_->version = VERSION;
+
+    // Readers check the magic last
+    std::atomic_thread_fence(std::memory_order_release);
+    header_->magic = MAGIC;
+
+    LOG_INFO("Publishing IQ to shared memory:", segment_, "(", capacity, "samples )");
+    return true;
+}
+
+bool SharedIQRing::open(const std::string& name) {
+    close();
+    segment_ = segmentName(name);
+
+    int fd = shm_open(segment_.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        LOG_ERROR("Failed to open shared memory", segment_, ":", std::strerror(errno));
+        return false;
+    }
+
+    // Read magic, version and capacity first to learn the ring size. The
+    // writer shares this machine's page size, so the sizes must agree.
+    uint32_t probe[3] = {};
+    ssize_t got = pread(fd, probe, sizeof(probe), 0);
+    struct stat st;
+    size_t data_bytes = static_cast<size_t>(probe[2]) * sizeof(Complex);
+    if (got != static_cast<ssize_t>(sizeof(probe)) || fstat(fd, &st) < 0 ||
+        probe[0] != MAGIC || probe[1] != VERSION || data_bytes % pageSize() != 0 ||
+        st.st_size != static_cast<off_t>(headerBytes() + data_bytes)) {
+        LOG_ERROR("Not a TrunkSDR IQ stream:", segment_);
+        ::close(fd);
+        return false;
+    }
+
+    bool mapped = map(fd, probe[2], false);
+    ::close(fd);
+    if (!mapped) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool SharedIQRing::map(int fd, uint32_t capacity, bool writable) {
+    size_t header_bytes = headerBytes();
+    size_t data_bytes = static_cast<size_t>(capacity) * sizeof(Complex);
+    int prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+
+    // Reserve header + data + mirror, then map the segment over the first
+    // two and its data again over the third
+    mapping_bytes_ = header_bytes + 2 * data_bytes;
+    mapping_ = mmap(nullptr, mapping_bytes_, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping_ == MAP_FAILED) {
+        mapping_ = nullptr;
+        LOG_ERROR("Failed to reserve shared IQ mapping:", std::strerror(errno));
+        return false;
+    }
+
+    char* base = static_cast<char*>(mapping_);
+    if (mmap(base, header_bytes + data_bytes, prot, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED ||
+        mmap(base + header_bytes + data_bytes, data_bytes, prot, MAP_SHARED | MAP_FIXED,
+             fd, header_bytes) == MAP_FAILED) {
+        LOG_ERROR("Failed to map shared IQ ring:", std::strerror(errno));
+        return false;
+    }
+
+    header_ = reinterpret_cast<SharedIQHeader*>(base);
+    data_ = reinterpret_cast<Complex*>(base + header_bytes);
+    mask_ = capacity - 1;
+    return true;
+}
+
+void SharedIQRing::close() {
+    if (mapping_) {
+        munmap(mapping_, mapping_bytes_);
+    }
+    if (owner_) {
+        shm_unlink(segment_.c_str());
+    }
+    mapping_ = nullptr;
+    mapping_bytes_ = 0;
+    header_ = nullptr;
+    data_ = nullptr;
+    owner_ = false;
+}
+
+void SharedIQRing::write(const Complex* samples, size_t count) {
+    // Only the newest ring's worth can be kept
+    uint64_t index = header_->write_index.load(std::memory_order_relaxed);
+    if (count > header_->capacity) {
+        samples += count - header_->capacity;
+        index += count - header_->capacity;
+        count = header_->capacity;
+    }
+
+    // The mirror makes the destination contiguous
+    std::memcpy(data_ + (index & mask_), samples, count * sizeof(Complex));
+    header_->write_index.store(index + count, std::memory_order_release);
+}
+
+void SharedIQRing::setInfo(uint32_t sample_rate, Frequency center_freq) {
+    uint32_t sequence = header_->sequence.load(std::memory_order_relaxed);
+    header_->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    header_->sample_rate.store(sample_rate, std::memory_order_relaxed);
+    header_->center_freq.store(frequencyBits(center_freq), std::memory_order_relaxed);
+    header_->info_index.store(header_->write_index.load(std::memory_order_relaxed),
+                              std::memory_order_relaxed);
+
+    header_->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+SharedIQInfo SharedIQRing::readInfo() const {
+    SharedIQInfo info;
+    uint32_t before;
+    uint32_t after;
+    do {
+        before = header_->sequence.load(std::memory_order_acquire);
+        info.sample_rate = header_->sample_rate.load(std::memory_order_relaxed);
+        info.center_freq = frequencyFromBits(header_->center_freq.load(std::memory_order_relaxed));
+        info.since = header_->info_index.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = header_->sequence.load(std::memory_order_relaxed);
+    } while ((before & 1) != 0 || before != after);
+    return info;
+}
+
+bool SharedIQPublisher::initialize(const std::string& name, uint32_t capacity,
+                                   uint32_t sample_rate, Frequency center_freq) {
+    name_ = name;
+    sample_rate_ = sample_rate;
+    center_freq_ = center_freq;
+    return ring_.create(name, capacity, sample_rate, center_freq);
+}
+
+void SharedIQPublisher::setInfo(uint32_t sample_rate, Frequency center_freq) {
+    if (sample_rate == sample_rate_ && center_freq == center_freq_) {
+        return;
+    }
+    sample_rate_ = sample_rate;
+    center_freq_ = center_freq;
+    ring_.setInfo(sample_rate, center_freq);
+}
+
+} // namespace TrunkSDR
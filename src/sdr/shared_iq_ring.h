@@ -0,0 +1,126 @@
+#ifndef SHARED_IQ_RING_H
+#define SHARED_IQ_RING_H
+
+#include "../utils/types.h"
+#include <atomic>
+#include <string>
+
+namespace TrunkSDR {
+
+// Header at the start of a shared IQ segment. Everything another process
+// may read while the writer changes it is atomic; the stream parameters
+// are additionally covered by a seqlock so a reader never sees a centre
+// frequency from one tune and a sample rate from another.
+struct SharedIQHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;                  // Samples, power of two
+    uint32_t writer_pid;
+
+    std::atomic<uint32_t> sequence;     // Odd while the parameters change
+    std::atomic<uint32_t> sample_rate;
+    std::atomic<uint64_t> center_freq;  // Bits of a double, Hz
+    std::atomic<uint64_t> info_index;   // First sample with these parameters
+
+    // Samples written since the stream was created; the sample at index i
+    // lives at data[i & (capacity - 1)] until it is overwritten
+    std::atomic<uint64_t> write_index;
+};
+
+// Stream parameters read under the seqlock
+struct SharedIQInfo {
+    uint32_t sample_rate;
+    Frequency center_freq;
+    uint64_t since;         // Write index at which they took effect
+};
+
+// A complex-float sample ring in POSIX shared memory ("/trunksdr-<name>").
+//
+// One process writes, any number of local processes read without copying.
+// The data area is mapped twice, back to back, so every run of up to
+// 'capacity' samples is contiguous in memory however it straddles the end
+// of the ring: the writer copies each block in with one memcpy and readers
+// hand out pointers straight into the segment. Readers that fall more than
+// a ring behind lose samples; the writer never waits for them.
+class SharedIQRing {
+public:
+    SharedIQRing();
+    ~SharedIQRing();
+
+    SharedIQRing(const SharedIQRing&) = delete;
+    SharedIQRing& operator=(const SharedIQRing&) = delete;
+
+    // Writer: create (or replace) the named segment
+    bool create(const std::string& name, uint32_t capacity,
+                uint32_t sample_rate, Frequency center_freq);
+
+    // Reader: map an existing segment read-only
+    bool open(const std::string& name);
+
+    void close();
+    bool isOpen() const { return header_ != nullptr; }
+
+    // Writer side
+    void write(const Complex* samples, size_t count);
+    void setInfo(uint32_t sample_rate, Frequency center_freq);
+
+    // Reader side
+    SharedIQInfo readInfo() const;
+    uint64_t getWriteIndex() const { return header_->write_index.load(std::memory_order_acquire); }
+    const Complex* at(uint64_t index) const { return data_ + (index & mask_); }
+    uint32_t getCapacity() const { return header_->capacity; }
+
+    static std::string segmentName(const std::string& name) { return "/trunksdr-" + name; }
+
+    static constexpr uint32_t MAGIC = 0x51495354;  // "TSIQ"
+    static constexpr uint32_t VERSION = 1;
+
+private:
+    bool map(int fd, uint32_t capacity, bool writable);
+
+    std::string segment_;
+    bool owner_;
+
+    void* mapping_;           // Whole reservation: header, data, data mirror
+    size_t mapping_bytes_;
+    SharedIQHeader* header_;
+    Complex* data_;
+    uint64_t mask_;
+
+    // Header area: the header rounded up to whole pages, so the data starts
+    // on a page and can be mapped twice
+    static size_t headerBytes();
+};
+
+// Ring sizes: about 1.7 s of a 2.4 MS/s capture, 4 s of a channel
+constexpr uint32_t SHARED_IQ_CAPTURE_SAMPLES = 1u << 22;
+constexpr uint32_t SHARED_IQ_CHANNEL_SAMPLES = 1u << 18;
+
+// Publishes one sample stream to other processes, e.g. the converted
+// capture or a channel's baseband. Single writer; publish() is a memcpy
+// and an atomic store.
+class SharedIQPublisher {
+public:
+    SharedIQPublisher() = default;
+
+    bool initialize(const std::string& name, uint32_t capacity,
+                    uint32_t sample_rate, Frequency center_freq);
+
+    void publish(const Complex* samples, size_t count) { ring_.write(samples, count); }
+
+    // The stream was retuned or resampled
+    void setInfo(uint32_t sample_rate, Frequency center_freq);
+    Frequency getCenterFrequency() const { return center_freq_; }
+
+    const std::string& getName() const { return name_; }
+
+private:
+    SharedIQRing ring_;
+    std::string name_;
+    uint32_t sample_rate_ = 0;
+    Frequency center_freq_ = 0;
+};
+
+} // namespace TrunkSDR
+
+#endif // SHARED_IQ_RING_H
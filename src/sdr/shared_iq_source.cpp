@@ -0,0 +1,159 @@
+#include "shared_iq_source.h"
+#include "../utils/logger.h"
+#include <algorithm>
+#include <chrono>
+
+namespace TrunkSDR {
+
+SharedIQSource::SharedIQSource(const std::string& name)
+    : name_(name)
+    , running_(false)
+    , current_frequency_(0)
+    , sample_rate_(0)
+    , dropped_samples_(0) {
+}
+
+SharedIQSource::~SharedIQSource() {
+    stop();
+}
+
+bool SharedIQSource::initialize(const SDRConfig& config) {
+    (void)config;
+
+    if (!ring_.open(name_)) {
+        LOG_ERROR("No IQ stream published as", name_);
+        return false;
+    }
+
+    SharedIQInfo info = ring_.readInfo();
+    current_frequency_ = info.center_freq;
+    sample_rate_ = info.sample_rate;
+
+    LOG_INFO("Opened shared IQ stream:", getDeviceInfo());
+    return true;
+}
+
+bool SharedIQSource::start() {
+    if (running_) {
+        LOG_WARNING("Shared IQ source already running");
+        return true;
+    }
+
+    if (!ring_.isOpen()) {
+        LOG_ERROR("Shared IQ stream not opened");
+        return false;
+    }
+
+    running_ = true;
+    reader_thread_ = std::thread(&SharedIQSource::readerThread, this);
+
+    LOG_INFO("Shared IQ source started");
+    return true;
+}
+
+bool SharedIQSource::stop() {
+    if (!running_) {
+        return true;
+    }
+
+    running_ = false;
+    if (reader_thread_.joinable()) {
+        reader_thread_.join();
+    }
+
+    LOG_INFO("Shared IQ source stopped");
+    return true;
+}
+
+bool SharedIQSource::setFrequency(Frequency freq) {
+    // The publisher's capture is fixed; asking for its own centre is fine
+    if (freq != current_frequency_) {
+        LOG_WARNING("Shared IQ stream", name_, "is centred on", current_frequency_.load(),
+                    "Hz and cannot be tuned to", freq, "Hz");
+    }
+    return true;
+}
+
+bool SharedIQSource::setGain(double gain) {
+    (void)gain;
+    return true;
+}
+
+bool SharedIQSource::setAutoGain(bool enable) {
+    (void)enable;
+    return true;
+}
+
+bool SharedIQSource::setSampleRate(uint32_t rate) {
+    if (rate != sample_rate_) {
+        LOG_WARNING("Shared IQ stream", name_, "runs at", sample_rate_.load(), "Hz, not", rate);
+    }
+    return true;
+}
+
+bool SharedIQSource::setPPMCorrection(int32_t ppm) {
+    (void)ppm;
+    return true;
+}
+
+std::string SharedIQSource::getDeviceInfo() const {
+    return "shm:" + name_ + " (" + std::to_string(static_cast<uint64_t>(current_frequency_)) +
+           " Hz, " + std::to_string(sample_rate_) + " S/s)";
+}
+
+void SharedIQSource::readerThread() {
+    LOG_INFO("Shared IQ reader thread started");
+
+    const uint64_t capacity = ring_.getCapacity();
+    uint64_t applied_since = ring_.readInfo().since;
+
+    // Join the stream live rather than replaying the ring
+    uint64_t read_index = ring_.getWriteIndex();
+
+    while (running_) {
+        uint64_t write_index = ring_.getWriteIndex();
+        if (write_index == read_index) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+
+        // Lapped by the publisher: resume half a ring behind it
+        if (write_index - read_index > capacity) {
+            uint64_t resume = write_index - capacity / 2;
+            dropped_samples_ += resume - read_index;
+            read_index = resume;
+        }
+
+        size_t count = std::min<uint64_t>(write_index - read_index, MAX_BLOCK_SAMPLES);
+
+        // A retune splits the block, so every block has one centre
+        SharedIQInfo info = ring_.readInfo();
+        if (info.since != applied_since) {
+            if (info.since <= read_index) {
+                applied_since = info.since;
+                if (info.center_freq != current_frequency_) {
+                    LOG_WARNING("Shared IQ stream", name_, "retuned to", info.center_freq, "Hz");
+                }
+                current_frequency_ = info.center_freq;
+                sample_rate_ = info.sample_rate;
+            } else if (info.since < read_index + count) {
+                count = info.since - read_index;
+            }
+        }
+
+        if (sample_callback_) {
+            sample_callback_(ring_.at(read_index), count);
+        }
+
+        // Samples the publisher overwrote while they were being processed
+        // were decoded as garbage
+        if (ring_.getWriteIndex() - read_index > capacity) {
+            dropped_samples_ += count;
+        }
+        read_index += count;
+    }
+
+    LOG_INFO("Shared IQ reader thread stopped");
+}
+
+} // namespace TrunkSDR
@@ -0,0 +1,75 @@
+#ifndef SHARED_IQ_SOURCE_H
+#define SHARED_IQ_SOURCE_H
+
+#include "sdr_interface.h"
+#include "shared_iq_ring.h"
+#include <atomic>
+#include <string>
+#include <thread>
+
+namespace TrunkSDR {
+
+// Samples from another TrunkSDR process instead of a dongle.
+//
+// Reads a stream published with SharedIQPublisher (sdr.source
+// "shm:<name>"). Blocks are passed to the callback as pointers into the
+// shared ring, without a copy. The publisher owns the tuner, so the
+// centre frequency and sample rate are whatever it publishes: the source
+// is not tunable and the gain and PPM settings do nothing. A reader that
+// falls more than a ring behind skips ahead and counts the lost samples
+// as dropped.
+class SharedIQSource : public SDRInterface {
+public:
+    explicit SharedIQSource(const std::string& name);
+    ~SharedIQSource() override;
+
+    // SDRInterface implementation
+    bool initialize(const SDRConfig& config) override;
+    bool start() override;
+    bool stop() override;
+    bool isRunning() const override { return running_; }
+
+    bool isTunable() const override { return false; }
+    bool setFrequency(Frequency freq) override;
+    Frequency getFrequency() const override { return current_frequency_; }
+
+    bool setGain(double gain) override;
+    double getGain() const override { return 0; }
+    bool setAutoGain(bool enable) override;
+
+    bool setSampleRate(uint32_t rate) override;
+    uint32_t getSampleRate() const override { return sample_rate_; }
+
+    bool setPPMCorrection(int32_t ppm) override;
+
+    void setSampleCallback(SampleCallback callback) override {
+        sample_callback_ = callback;
+    }
+
+    size_t getDroppedSamples() const override { return dropped_samples_; }
+    double getRSSI() const override { return -50.0; }
+
+    std::string getDeviceInfo() const override;
+
+private:
+    void readerThread();
+
+    std::string name_;
+    SharedIQRing ring_;
+
+    std::atomic<bool> running_;
+    std::thread reader_thread_;
+
+    std::atomic<Frequency> current_frequency_;
+    std::atomic<uint32_t> sample_rate_;
+
+    SampleCallback sample_callback_;
+    std::atomic<size_t> dropped_samples_;
+
+    // Largest block handed to the callback at once
+    static constexpr size_t MAX_BLOCK_SAMPLES = 64 * 1024;
+};
+
+} // namespace TrunkSDR
+
+#endif // SHARED_IQ_SOURCE_H
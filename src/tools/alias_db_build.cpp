@@ -0,0 +1,187 @@
+/**
+ * Alias Database Builder
+ *
+ * Compiles talkgroup and radio ID aliases from CSV into the mapped alias
+ * database trunksdr reads (talkgroups.alias_db). Each CSV line is an ID
+ * and a name; further columns are ignored, as is any line (a header, say)
+ * whose first column is not a number. IDs are decimal, leading zeros
+ * included, or hexadecimal with a "0x" prefix. Fields may be quoted, with
+ * "" for a quote inside one.
+ *
+ * Usage:
+ *   alias_db_build [--talkgroups <csv>] [--radios <csv>] --output <file>
+ *
+ * Author: TrunkSDR Project
+ * License: MIT
+ */
+
+#include "../utils/alias_db.h"
+#include "../utils/logger.h"
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <getopt.h>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace TrunkSDR;
+
+namespace {
+
+void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options] --output <file>\n"
+              << "  -t, --talkgroups <csv>  Talkgroup ID,name lines\n"
+              << "  -r, --radios <csv>      Radio ID,name lines\n"
+              << "  -o, --output <file>     Database to write (replaced atomically)\n"
+              << "  -h, --help              Show this help\n";
+}
+
+std::vector<std::string> splitCSV(const std::string& line) {
+    std::vector<std::string> fields(1);
+    bool quoted = false;
+    for (size_t i = 0; i < line.size(); i++) {
+        char c = line[i];
+        if (quoted) {
+            if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+                fields.back() += '"';
+                i++;
+            } else if (c == '"') {
+                quoted = false;
+            } else {
+                fields.back() += c;
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            fields.emplace_back();
+        } else if (c != '\r') {
+            fields.back() += c;
+        }
+    }
+    return fields;
+}
+
+std::string trim(const std::string& text) {
+    size_t first = text.find_first_not_of(" \t");
+    if (first == std::string::npos) {
+        return "";
+    }
+    size_t last = text.find_last_not_of(" \t");
+    return text.substr(first, last - first + 1);
+}
+
+// Decimal, or hexadecimal after "0x"; zero padding is not an octal prefix
+bool parseID(const std::string& text, uint32_t& id) {
+    int base = 10;
+    size_t start = 0;
+    if (text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+        base = 16;
+        start = 2;
+    }
+    if (start >= text.size() || !std::isxdigit(static_cast<unsigned char>(text[start]))) {
+        return false;
+    }
+    char* end = nullptr;
+    unsigned long long value = std::strtoull(text.c_str() + start, &end, base);
+    if (*end != '\0' || value > UINT32_MAX) {
+        return false;
+    }
+    id = static_cast<uint32_t>(value);
+    return true;
+}
+
+// Adds every ID,name line; returns false if the file cannot be read
+template <typename Add>
+bool loadCSV(const std::string& path, Add add, size_t& loaded, size_t& skipped) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Cannot read " << path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        std::vector<std::string> fields = splitCSV(line);
+        uint32_t id = 0;
+        if (!parseID(trim(fields[0]), id) || fields.size() < 2) {
+            skipped++;
+            continue;
+        }
+        std::string name = trim(fields[1]);
+        if (name.empty()) {
+            skipped++;
+            continue;
+        }
+        add(id, name);
+        loaded++;
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+    std::string talkgroups_path;
+    std::string radios_path;
+    std::string output_path;
+
+    static struct option long_options[] = {
+        {"talkgroups", required_argument, nullptr, 't'},
+        {"radios", required_argument, nullptr, 'r'},
+        {"output", required_argument, nullptr, 'o'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "t:r:o:h", long_options, nullptr)) != -1) {
+        switch (opt) {
+            case 't': talkgroups_path = optarg; break;
+            case 'r': radios_path = optarg; break;
+            case 'o': output_path = optarg; break;
+            default:
+                printUsage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (output_path.empty() || (talkgroups_path.empty() && radios_path.empty())) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    Logger::instance().setLogLevel(LogLevel::WARNING);
+
+    AliasDBBuilder builder;
+    size_t loaded = 0;
+    size_t skipped = 0;
+    if (!talkgroups_path.empty() &&
+        !loadCSV(talkgroups_path,
+                 [&builder](uint32_t id, const std::string& name) { builder.addTalkgroup(id, name); },
+                 loaded, skipped)) {
+        return 1;
+    }
+    if (!radios_path.empty() &&
+        !loadCSV(radios_path,
+                 [&builder](uint32_t id, const std::string& name) { builder.addRadio(id, name); },
+                 loaded, skipped)) {
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    if (!builder.write(output_path)) {
+        return 1;
+    }
+    double elapsed_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+
+    AliasDB db;
+    if (!db.open(output_path)) {
+        return 1;
+    }
+    std::cout << output_path << ": " << db.getTalkgroupCount() << " talkgroups, "
+              << db.getRadioCount() << " radios (" << loaded << " lines read, "
+              << skipped << " skipped) in " << elapsed_ms << " ms" << std::endl;
+    return 0;
+}
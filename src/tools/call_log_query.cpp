@@ -0,0 +1,163 @@
+/**
+ * Call Log Query
+ *
+ * Lists calls from a call log (audio.call_log) without loading it: the
+ * file is mapped and only the columns a query filters on are read.
+ *
+ * Usage:
+ *   call_log_query <file> [--talkgroup <id>] [--source <id>] [--site <n>]
+ *                  [--since <age|unix time>] [--until <age|unix time>] [--count]
+ *
+ * Ages are a number with s, m, h or d ("24h", "7d"); a plain number is a
+ * Unix time in seconds.
+ *
+ * Author: TrunkSDR Project
+ * License: MIT
+ */
+
+#include "../audio/call_log.h"
+#include "../utils/logger.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <getopt.h>
+#include <iostream>
+
+using namespace TrunkSDR;
+
+namespace {
+
+void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " <file> [options]\n"
+              << "  -t, --talkgroup <id>   Calls on this talkgroup\n"
+              << "  -r, --source <id>      Calls from this radio\n"
+              << "  -s, --site <n>         Calls on this site (position in 'systems')\n"
+              << "  -S, --since <time>     Calls started at or after: an age (30m, 24h, 7d)\n"
+              << "                         or a Unix time in seconds\n"
+              << "  -U, --until <time>     Calls started at or before, as --since\n"
+              << "  -c, --count            Print only the number of calls\n"
+              << "  -h, --help             Show this help\n";
+}
+
+// "24h" is 24 hours before now; a plain number is a Unix time
+bool parseTime(const char* text, uint64_t now_ms, uint64_t& time_ms) {
+    char* end = nullptr;
+    double value = std::strtod(text, &end);
+    if (end == text || value < 0) {
+        return false;
+    }
+
+    double scale;
+    switch (*end) {
+        case '\0': time_ms = static_cast<uint64_t>(value * 1000); return true;
+        case 's': scale = 1; break;
+        case 'm': scale = 60; break;
+        case 'h': scale = 3600; break;
+        case 'd': scale = 86400; break;
+        default: return false;
+    }
+    if (end[1] != '\0') {
+        return false;
+    }
+    uint64_t age_ms = static_cast<uint64_t>(value * scale * 1000);
+    time_ms = age_ms < now_ms ? now_ms - age_ms : 0;
+    return true;
+}
+
+void printCall(const CallRecord& call) {
+    std::time_t seconds = static_cast<std::time_t>(call.start_ms / 1000);
+    std::tm local;
+    localtime_r(&seconds, &local);
+    char when[32];
+    std::strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", &local);
+
+    char rssi[8] = "-";
+    if (call.rssi != CALL_RSSI_UNKNOWN) {
+        std::snprintf(rssi, sizeof(rssi), "%d", call.rssi);
+    }
+
+    std::printf("%s  %7.1fs  TG %-8u  src %-8u  %10.5f MHz  site %-2u  %4s dBFS%s%s\n",
+                when, call.duration_ms / 1000.0, call.talkgroup, call.source,
+                call.frequency / 1e6, call.site, rssi,
+                (call.flags & CALL_FLAG_ENCRYPTED) ? "  encrypted" : "",
+                (call.flags & CALL_FLAG_EMERGENCY) ? "  EMERGENCY" : "");
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+    CallLogReader::Query query;
+    bool count_only = false;
+    uint64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    static struct option long_options[] = {
+        {"talkgroup", required_argument, nullptr, 't'},
+        {"source", required_argument, nullptr, 'r'},
+        {"site", required_argument, nullptr, 's'},
+        {"since", required_argument, nullptr, 'S'},
+        {"until", required_argument, nullptr, 'U'},
+        {"count", no_argument, nullptr, 'c'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "t:r:s:S:U:ch", long_options, nullptr)) != -1) {
+        switch (opt) {
+            case 't':
+                query.by_talkgroup = true;
+                query.talkgroup = std::strtoul(optarg, nullptr, 0);
+                break;
+            case 'r':
+                query.by_source = true;
+                query.source = std::strtoul(optarg, nullptr, 0);
+                break;
+            case 's':
+                query.by_site = true;
+                query.site = static_cast<uint16_t>(std::strtoul(optarg, nullptr, 0));
+                break;
+            case 'S':
+            case 'U':
+                if (!parseTime(optarg, now_ms, opt == 'S' ? query.since_ms : query.until_ms)) {
+                    std::cerr << "Bad time: " << optarg << std::endl;
+                    return 1;
+                }
+                break;
+            case 'c':
+                count_only = true;
+                break;
+            default:
+                printUsage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (optind != argc - 1) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    Logger::instance().setLogLevel(LogLevel::WARNING);
+
+    auto start = std::chrono::steady_clock::now();
+    CallLogReader log;
+    if (!log.open(argv[optind])) {
+        return 1;
+    }
+
+    size_t found = log.query(query, [count_only](const CallRecord& call) {
+        if (!count_only) {
+            printCall(call);
+        }
+    });
+    double elapsed_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+
+    if (count_only) {
+        std::cout << found << std::endl;
+    }
+    std::cerr << found << " of " << log.getRecordCount() << " calls (" << log.getChunkCount()
+              << " chunks) in " << elapsed_ms << " ms" << std::endl;
+    return 0;
+}
@@ -0,0 +1,582 @@
+#include "channel_group.h"
+#include "../dsp/c4fm_demod.h"
+#include "../dsp/fsk_demod.h"
+#include "../decoders/p25_decoder.h"
+#include "../decoders/smartnet_decoder.h"
+#include "../decoders/edacs_decoder.h"
+#include "../decoders/ltr_decoder.h"
+#if defined(ENABLE_DMR_TIER3) || defined(ENABLE_NXDN) || defined(ENABLE_DPMR)
+#include "../dsp/fsk4_demod.h"
+#endif
+#ifdef ENABLE_DMR_TIER3
+#include "../european/dmr/dmr_decoder.h"
+#endif
+#ifdef ENABLE_NXDN
+#include "../european/nxdn/nxdn_decoder.h"
+#endif
+#ifdef ENABLE_DPMR
+#include "../european/dpmr/dpmr_decoder.h"
+#endif
+#ifdef ENABLE_TETRA
+#include "../european/tetra/tetra_site_monitor.h"
+#endif
+#include "../net/remote_chain.h"
+#include "../utils/config_parser.h"
+#include "../utils/logger.h"
+#include <algorithm>
+#include <cmath>
+
+namespace TrunkSDR {
+
+namespace {
+
+// Channels must fall inside this fraction of the capture
+constexpr double USABLE_BANDWIDTH_FRACTION = 0.4;
+
+bool isDMRSystem(SystemType type) {
+    return type == SystemType::DMR ||
+           type == SystemType::DMR_TIER2 ||
+           type == SystemType::DMR_TIER3;
+}
+
+bool isNXDNSystem(SystemType type) {
+    return type == SystemType::NXDN ||
+           type == SystemType::NXDN_NEXEDGE;
+}
+
+bool isTETRASystem(SystemType type) {
+    return type == SystemType::TETRA ||
+           type == SystemType::TETRA_EMERGENCY;
+}
+
+bool isDPMRSystem(SystemType type) {
+    return type == SystemType::DPMR ||
+           type == SystemType::DPMR_MODE2;
+}
+
+uint32_t nxdnSymbolRate(const SystemInfo& system) {
+    return system.symbol_rate ? system.symbol_rate : NXDN_SYMBOL_RATE;
+}
+
+uint32_t smartnetBaudRate(const SystemInfo& system) {
+    return system.symbol_rate ? system.symbol_rate : 3600;
+}
+
+uint32_t edacsBaudRate(const SystemInfo& system) {
+    return system.symbol_rate ? system.symbol_rate : 9600;
+}
+
+#ifdef ENABLE_DMR_TIER3
+std::unique_ptr<European::DMRDecoder> createDMRDecoder(const SystemInfo& system) {
+    using European::DMRTrunkingType;
+
+    auto decoder = std::make_unique<European::DMRDecoder>();
+    decoder->setColorCode(system.color_code);
+    decoder->setChannelMap(system.channels);
+
+    if (system.trunking == "capacity_plus") {
+        decoder->setTrunkingType(DMRTrunkingType::CAPACITY_PLUS);
+    } else if (system.trunking == "connect_plus") {
+        decoder->setTrunkingType(DMRTrunkingType::CONNECT_PLUS);
+    } else if (system.trunking == "tier3" || system.type == SystemType::DMR_TIER3) {
+        decoder->setTrunkingType(DMRTrunkingType::TIER3);
+    } else {
+        decoder->setTrunkingType(DMRTrunkingType::NONE);
+    }
+    return decoder;
+}
+#endif
+
+#ifdef ENABLE_NXDN
+std::unique_ptr<European::NXDNDecoder> createNXDNDecoder(const SystemInfo& system) {
+    auto decoder = std::make_unique<European::NXDNDecoder>(nxdnSymbolRate(system));
+    decoder->setRAN(system.color_code);
+    decoder->setChannelMap(system.channels);
+    return decoder;
+}
+#endif
+
+} // anonymous namespace
+
+void ChannelReceiver::process(const Complex* samples, size_t count) {
+    if (!ddc) {
+        demod->process(samples, count);
+        return;
+    }
+
+    size_t needed = count / ddc->getDecimation() + 1;
+    if (baseband.size() < needed) {
+        baseband.resize(needed);
+    }
+
+    size_t produced = ddc->process(samples, count, baseband.data());
+    float power = 0;
+    for (size_t i = 0; i < produced; i++) {
+        power += std::norm(baseband[i]);
+    }
+    power_sum += power;
+    power_samples += produced;
+
+    if (tap) {
+        tap->setInfo(ddc->getOutputRate(), frequency);
+        tap->publish(baseband.data(), produced);
+    }
+    demod->process(baseband.data(), produced);
+}
+
+int8_t ChannelReceiver::getLevel() const {
+    if (power_samples == 0) {
+        return CALL_RSSI_UNKNOWN;
+    }
+    double mean = power_sum / power_samples;
+    double dbfs = mean > 0 ? 10.0 * std::log10(mean) : -127.0;
+    return static_cast<int8_t>(std::lround(std::min(0.0, std::max(-127.0, dbfs))));
+}
+
+void ChannelReceiver::resetLevel() {
+    power_sum = 0;
+    power_samples = 0;
+}
+
+ChannelGroup::ChannelGroup(const SystemInfo& system, size_t index)
+    : system_(system)
+    , index_(index)
+    , host_{0, 0, nullptr, nullptr, nullptr}
+    , samples_seen_(0)
+    , control_freq_(system.control_channels.empty() ? 0 : system.control_channels[0]) {
+    control_.frequency = control_freq_;
+}
+
+ChannelGroup::~ChannelGroup() = default;
+
+bool ChannelGroup::initialize(const Host& host) {
+    host_ = host;
+
+    LOG_INFO("Channel group:", system_.name, "(", ConfigParser::systemTypeToString(system_.type), ")");
+
+    if (system_.control_channels.empty()) {
+        LOG_ERROR("No control channels configured for", system_.name);
+        return false;
+    }
+
+    if (isDPMRSystem(system_.type)) {
+        return initializeConventional();
+    }
+
+    return initializeControl();
+}
+
+bool ChannelGroup::initializeControl() {
+    if (!inCapture(control_freq_)) {
+        LOG_ERROR("Control channel", control_freq_, "Hz outside capture bandwidth");
+        return false;
+    }
+
+    if (isTETRASystem(system_.type)) {
+#ifdef ENABLE_TETRA
+        // Traffic carriers are mixed down from the capture as they are
+        // granted
+        size_t traffic_carriers = system_.traffic_carriers
+                                ? system_.traffic_carriers
+                                : European::TETRA_DEFAULT_TRAFFIC_CARRIERS;
+        tetra_monitor_ = std::make_unique<European::TETRASiteMonitor>();
+        if (!tetra_monitor_->initialize(host_.sample_rate, host_.center_freq,
+                                        control_freq_, traffic_carriers)) {
+            return false;
+        }
+        tetra_monitor_->setExpectedCell(0, 0, system_.color_code);
+
+        tetra_monitor_->setGrantCallback(
+            [this](const CallGrant& grant) {
+                handleCallGrant(grant);
+            }
+        );
+        tetra_monitor_->setCallEndCallback(
+            [this](TalkgroupID talkgroup) {
+                handleCallEnd(talkgroup);
+            }
+        );
+        return true;
+#else
+        LOG_ERROR("TETRA support not compiled in (ENABLE_TETRA)");
+        return false;
+#endif
+    }
+
+    // Full-rate demodulators need the capture centred on the control
+    // channel; anywhere else it is mixed down like the narrowband ones.
+    // LTR data rides under the repeater's FM voice, the DMR rest channel
+    // moves between repeaters of the site without retuning and NXDN48 is
+    // narrower still, so those are always mixed down.
+    bool centred = control_freq_ == host_.center_freq &&
+                   (system_.type == SystemType::P25_PHASE1 ||
+                    system_.type == SystemType::P25_PHASE2 ||
+                    system_.type == SystemType::SMARTNET ||
+                    system_.type == SystemType::SMARTZONE ||
+                    system_.type == SystemType::EDACS);
+    if (!centred) {
+        control_.ddc = createChannelDDC(control_freq_);
+    }
+
+    if (!createChannelChain(control_, ChannelRole::CONTROL,
+                            [this](Frequency freq) {
+                                followRestChannel(freq);
+                            })) {
+        return false;
+    }
+
+    // No voice chain follows LTR; calls end when the repeater data does
+    if (system_.type == SystemType::LTR) {
+        control_.decoder->setCallEndCallback(
+            [this](TalkgroupID talkgroup) {
+                if (host_.call_manager) {
+                    host_.call_manager->endCall({getSite(), talkgroup});
+                }
+            }
+        );
+    }
+
+    control_.decoder->setGrantCallback(
+        [this](const CallGrant& grant) {
+            handleCallGrant(grant);
+        }
+    );
+    return true;
+}
+
+bool ChannelGroup::initializeConventional() {
+#ifdef ENABLE_DPMR
+    // dPMR has no control channel: every listed channel is watched by its
+    // own receiver, and a header on one is the call grant
+    for (Frequency freq : system_.control_channels) {
+        if (!inCapture(freq)) {
+            LOG_ERROR("dPMR channel", freq, "Hz outside capture bandwidth");
+            return false;
+        }
+
+        auto receiver = std::make_unique<ChannelReceiver>();
+        receiver->frequency = freq;
+        receiver->ddc = std::make_unique<DigitalDownConverter>();
+        receiver->ddc->initialize(host_.sample_rate, host_.sample_rate / VOICE_CHANNEL_RATE,
+                                  DPMR_CHANNEL_BANDWIDTH);
+        receiver->ddc->setOffset(freq - host_.center_freq);
+        receiver->demod = std::make_unique<FSK4Demodulator>(DPMR_SYMBOL_RATE);
+        receiver->demod->initialize(receiver->ddc->getOutputRate());
+
+        auto dpmr_decoder = std::make_unique<European::DPMRDecoder>();
+        dpmr_decoder->setChannelFrequency(freq);
+        dpmr_decoder->setColourCode(system_.color_code);
+        dpmr_decoder->initialize();
+        dpmr_decoder->setGrantCallback(
+            [this](const CallGrant& grant) {
+                handleCallGrant(grant);
+            }
+        );
+        dpmr_decoder->setVoiceFrameCallback(
+            [this](const VoiceFrameBatch& batch) {
+                handleVoiceFrames(batch);
+            }
+        );
+        dpmr_decoder->setCallEndCallback(
+            [this](TalkgroupID talkgroup) {
+                handleCallEnd(talkgroup);
+            }
+        );
+        receiver->decoder = std::move(dpmr_decoder);
+
+        BaseDecoder* decoder = receiver->decoder.get();
+        receiver->demod->setSymbolCallback(
+            [decoder](const float* symbols, size_t count) {
+                decoder->processSymbols(symbols, count);
+            }
+        );
+        conventional_.push_back(std::move(receiver));
+    }
+
+    LOG_INFO("dPMR:", conventional_.size(), "channel(s) monitored");
+    return true;
+#else
+    LOG_ERROR("dPMR support not compiled in (ENABLE_DPMR)");
+    return false;
+#endif
+}
+
+std::unique_ptr<DigitalDownConverter> ChannelGroup::createChannelDDC(Frequency freq) const {
+    auto ddc = std::make_unique<DigitalDownConverter>();
+    ddc->initialize(host_.sample_rate, host_.sample_rate / VOICE_CHANNEL_RATE,
+                    VOICE_CHANNEL_BANDWIDTH);
+    if (freq != 0) {
+        ddc->setOffset(freq - host_.center_freq);
+    }
+    return ddc;
+}
+
+bool ChannelGroup::inCapture(Frequency freq) const {
+    return std::abs(freq - host_.center_freq) <= host_.sample_rate * USABLE_BANDWIDTH_FRACTION;
+}
+
+bool ChannelGroup::followsVoice() const {
+    return system_.type == SystemType::P25_PHASE1 || isDMRSystem(system_.type) ||
+           isNXDNSystem(system_.type);
+}
+
+bool ChannelGroup::createVoiceChain(ChannelReceiver& chain) const {
+    // Same capture as the control channel: decimate to a rate every
+    // narrowband demodulator handles
+    chain.ddc = createChannelDDC(0);
+    return createChannelChain(chain, ChannelRole::VOICE);
+}
+
+bool ChannelGroup::createChannelChain(ChannelReceiver& chain, ChannelRole role,
+                                      RestChannelCallback rest_callback) const {
+    if (host_.decode_link && chain.ddc) {
+        return createRemoteChain(chain, role, rest_callback);
+    }
+    return createDecoderChain(chain, role,
+                              chain.ddc ? chain.ddc->getOutputRate() : host_.sample_rate,
+                              rest_callback);
+}
+
+bool ChannelGroup::createRemoteChain(ChannelReceiver& chain, ChannelRole role,
+                                     RestChannelCallback rest_callback) const {
+    ChannelOpen open;
+    open.system = static_cast<uint16_t>(index_);
+    open.role = role;
+    open.sample_rate = chain.ddc->getOutputRate();
+    open.frequency = chain.frequency;
+
+    std::shared_ptr<RemoteChannel> channel = host_.decode_link->openChannel(open);
+    if (!channel) {
+        LOG_ERROR("No decode worker for a channel of", system_.name);
+        return false;
+    }
+
+    auto decoder = std::make_unique<RemoteDecoder>(channel, system_.type);
+    decoder->setRestChannelCallback(rest_callback);
+    chain.demod = std::make_unique<RemoteDemodulator>(channel, decoder.get());
+    chain.decoder = std::move(decoder);
+    return true;
+}
+
+bool ChannelGroup::createDecoderChain(ChannelReceiver& chain, ChannelRole role,
+                                      uint32_t sample_rate,
+                                      RestChannelCallback rest_callback) const {
+    bool control = role == ChannelRole::CONTROL;
+
+    if (system_.type == SystemType::P25_PHASE1 ||
+        system_.type == SystemType::P25_PHASE2) {
+        // C4FM for P25
+        chain.demod = std::make_unique<C4FMDemodulator>();
+        auto p25_decoder = std::make_unique<P25Decoder>();
+        p25_decoder->setNAC(system_.nac);
+        if (control) {
+            p25_decoder->setSiteCacheFile(system_.site_cache_file);
+        }
+        chain.decoder = std::move(p25_decoder);
+    } else if (system_.type == SystemType::SMARTNET ||
+               system_.type == SystemType::SMARTZONE) {
+        // FSK2 for SmartNet
+        SmartNetBandplan bandplan;
+        if (!bandplan.configure(system_.bandplan, system_.bandplan_base,
+                                system_.bandplan_spacing, system_.bandplan_offset)) {
+            return false;
+        }
+        chain.demod = std::make_unique<FSKDemodulator>(smartnetBaudRate(system_), 2);
+        auto smartnet_decoder = std::make_unique<SmartNetDecoder>();
+        smartnet_decoder->setBaudRate(smartnetBaudRate(system_));
+        smartnet_decoder->setBandplan(bandplan);
+        chain.decoder = std::move(smartnet_decoder);
+    } else if (system_.type == SystemType::EDACS) {
+        // FSK2, 9600 baud (4800 on narrowband sites)
+        chain.demod = std::make_unique<FSKDemodulator>(edacsBaudRate(system_), 2);
+        auto edacs_decoder = std::make_unique<EDACSDecoder>(edacsBaudRate(system_));
+        edacs_decoder->setChannelMap(system_.channels);
+        chain.decoder = std::move(edacs_decoder);
+    } else if (system_.type == SystemType::LTR) {
+        // Sub-audible data under the repeater's FM voice
+        auto demod = std::make_unique<FSKDemodulator>(LTR_SYMBOL_RATE, 2);
+        demod->setSubAudible(true);
+        chain.demod = std::move(demod);
+        auto ltr_decoder = std::make_unique<LTRDecoder>();
+        ltr_decoder->setChannelMap(system_.channels);
+        chain.decoder = std::move(ltr_decoder);
+    } else if (isDMRSystem(system_.type)) {
+#ifdef ENABLE_DMR_TIER3
+        // 4FSK; one decoder follows both timeslots of a carrier
+        chain.demod = std::make_unique<FSK4Demodulator>(DMR_SYMBOL_RATE);
+        auto dmr_decoder = createDMRDecoder(system_);
+        if (control) {
+            dmr_decoder->setRestChannel(chain.frequency);
+            if (rest_callback) {
+                dmr_decoder->setRestChannelCallback(rest_callback);
+            }
+        }
+        chain.decoder = std::move(dmr_decoder);
+#else
+        LOG_ERROR("DMR support not compiled in (ENABLE_DMR_TIER3)");
+        return false;
+#endif
+    } else if (isNXDNSystem(system_.type)) {
+#ifdef ENABLE_NXDN
+        // NXDN48 occupies 6.25 kHz; the channel filter passes either width
+        chain.demod = std::make_unique<FSK4Demodulator>(nxdnSymbolRate(system_));
+        chain.decoder = createNXDNDecoder(system_);
+#else
+        LOG_ERROR("NXDN support not compiled in (ENABLE_NXDN)");
+        return false;
+#endif
+    } else {
+        LOG_ERROR("Unsupported system type");
+        return false;
+    }
+
+    chain.demod->initialize(sample_rate);
+    chain.decoder->initialize();
+
+    BaseDecoder* decoder = chain.decoder.get();
+    chain.demod->setSymbolCallback(
+        [decoder](const float* symbols, size_t count) {
+            decoder->processSymbols(symbols, count);
+        }
+    );
+    return true;
+}
+
+bool ChannelGroup::sharesVoiceChain(const ChannelGroup& other) const {
+    // Everything createVoiceChain() reads
+    const SystemInfo& a = system_;
+    const SystemInfo& b = other.system_;
+    return a.type == b.type && a.nac == b.nac && a.color_code == b.color_code &&
+           a.trunking == b.trunking && a.symbol_rate == b.symbol_rate &&
+           a.channels == b.channels;
+}
+
+bool ChannelGroup::sharesNetwork(const ChannelGroup& other) const {
+    const SystemInfo& a = system_;
+    const SystemInfo& b = other.system_;
+    if (this == &other) {
+        return true;
+    }
+    if (a.type != b.type) {
+        return false;
+    }
+    if (!a.network.empty() || !b.network.empty()) {
+        return a.network == b.network;
+    }
+    bool identified = a.wacn != 0 || a.system_id != 0 || a.nac != 0;
+    return identified && a.wacn == b.wacn && a.system_id == b.system_id && a.nac == b.nac;
+}
+
+bool ChannelGroup::isLocked() const {
+#ifdef ENABLE_TETRA
+    if (tetra_monitor_) {
+        return tetra_monitor_->isLocked();
+    }
+#endif
+    if (control_.decoder) {
+        return control_.decoder->isLocked();
+    }
+    for (const auto& receiver : conventional_) {
+        if (receiver->decoder->isLocked()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t ChannelGroup::getCRCErrors() const {
+    size_t errors = control_.decoder ? control_.decoder->getCRCErrors() : 0;
+    for (const auto& receiver : conventional_) {
+        errors += receiver->decoder->getCRCErrors();
+    }
+    return errors;
+}
+
+void ChannelGroup::process(const Complex* samples, size_t count) {
+    samples_seen_ += count;
+
+#ifdef ENABLE_TETRA
+    if (tetra_monitor_) {
+        tetra_monitor_->process(samples, count);
+        return;
+    }
+#endif
+
+    for (auto& receiver : conventional_) {
+        receiver->process(samples, count);
+    }
+
+    if (control_.demod) {
+        control_.process(samples, count);
+    }
+}
+
+void ChannelGroup::setCenterFrequency(Frequency freq) {
+    // Retuning moves every channel in the capture
+    host_.center_freq = freq;
+    if (control_.ddc) {
+        control_.ddc->setOffset(control_freq_ - freq);
+    }
+}
+
+bool ChannelGroup::publishControlChannel(const std::string& name) {
+    if (!control_.ddc) {
+        LOG_WARNING("Control channel of", system_.name, "is the whole capture, not published");
+        return false;
+    }
+
+    control_.tap = std::make_unique<SharedIQPublisher>();
+    return control_.tap->initialize(name, SHARED_IQ_CHANNEL_SAMPLES,
+                                    control_.ddc->getOutputRate(), control_freq_);
+}
+
+void ChannelGroup::followRestChannel(Frequency freq) {
+    // Stay on the current capture when the new rest repeater is inside it
+    if (control_.ddc && inCapture(freq)) {
+        control_.ddc->setOffset(freq - host_.center_freq);
+        control_freq_ = freq;
+        control_.frequency = freq;
+        LOG_INFO("Following rest channel:", freq, "Hz");
+        return;
+    }
+
+    // Only a capture this group has to itself can move; the host recentres
+    // between blocks and re-mixes the control channel then
+    if (retune_callback_ && retune_callback_(freq)) {
+        control_freq_ = freq;
+        control_.frequency = freq;
+        return;
+    }
+    LOG_WARNING("Rest channel", freq, "Hz outside shared capture, not followed");
+}
+
+void ChannelGroup::handleCallGrant(const CallGrant& grant) {
+    uint64_t refresh = static_cast<uint64_t>(host_.sample_rate) * GRANT_REFRESH_MS / 1000;
+    if (recent_grants_.isRepeat(grant, samples_seen_, refresh)) {
+        return;
+    }
+
+    LOG_INFO("Call grant received: TG =", grant.talkgroup,
+             "Freq =", grant.frequency);
+
+    // The host deduplicates grants across sites and schedules receivers
+    if (grant_callback_) {
+        grant_callback_(grant);
+    } else {
+        host_.call_manager->handleGrant(grant, getSite());
+    }
+}
+
+void ChannelGroup::handleVoiceFrames(const VoiceFrameBatch& batch) {
+    if (host_.call_manager->isCallActive({getSite(), batch.talkgroup})) {
+        host_.codec_pool->submit(getSite(), batch);
+    }
+}
+
+void ChannelGroup::handleCallEnd(TalkgroupID talkgroup) {
+    CallKey call{getSite(), talkgroup};
+    host_.call_manager->endCall(call);
+    host_.codec_pool->releaseCall(call);
+}
+
+} // namespace TrunkSDR
@@ -0,0 +1,191 @@
+#ifndef CHANNEL_GROUP_H
+#define CHANNEL_GROUP_H
+
+#include "../utils/types.h"
+#include "../dsp/demodulator.h"
+#include "../dsp/ddc.h"
+#include "../decoders/base_decoder.h"
+#include "../codecs/codec_pool.h"
+#include "../audio/call_manager.h"
+#include "../sdr/shared_iq_ring.h"
+#include "../net/decode_protocol.h"
+#include "recent_grant_cache.h"
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace TrunkSDR {
+
+class DecodeLink;
+
+#ifdef ENABLE_TETRA
+namespace European {
+class TETRASiteMonitor;
+}
+#endif
+
+// One demodulated channel of the capture. Without a DDC the demodulator
+// sees the whole capture, which must then be centred on the channel. A
+// tap publishes the mixed-down baseband to other processes. With decode
+// workers the demodulator and decoder are stand-ins that ship the baseband
+// out and replay the worker's events. The mean power of the baseband is
+// kept as the channel's signal level.
+struct ChannelReceiver {
+    Frequency frequency = 0;
+    std::unique_ptr<DigitalDownConverter> ddc;
+    std::unique_ptr<Demodulator> demod;
+    std::unique_ptr<BaseDecoder> decoder;
+    std::vector<Complex> baseband;
+    std::unique_ptr<SharedIQPublisher> tap;
+    double power_sum = 0;
+    uint64_t power_samples = 0;
+
+    void process(const Complex* samples, size_t count);
+
+    // Mean level since the last reset, dBFS; CALL_RSSI_UNKNOWN without a DDC
+    int8_t getLevel() const;
+    void resetLevel();
+};
+
+// One system decoded from a shared wideband capture.
+//
+// A group owns everything specific to its protocol: the control channel
+// mixer, demodulator and decoder (or TETRA's site monitor, or one receiver
+// per dPMR channel). Its grants go to the host, which follows them with
+// voice chains the group builds. The capture, call manager, codec pool and
+// voice receivers belong to the host and are shared by every group. Groups
+// never touch each other's state, so the host can run them on different
+// threads.
+//
+// Given a decode link, narrowband channels (mixed down from the capture)
+// are demodulated and decoded by remote workers; the group still mixes
+// them down and sees the same callbacks. Full-rate control channels, TETRA
+// sites and dPMR channels stay local.
+class ChannelGroup {
+public:
+    // Services shared by all groups. The call manager and codec pool must
+    // outlive the group, as must the decode link when there is one.
+    struct Host {
+        uint32_t sample_rate;
+        Frequency center_freq;
+        CallManager* call_manager;
+        CodecPool* codec_pool;
+        DecodeLink* decode_link;
+    };
+
+    // Asks the host to recentre the capture on a frequency; false when the
+    // capture is shared and cannot move
+    using RetuneCallback = std::function<bool(Frequency)>;
+
+    // Grants decoded on this group's control channel, on its thread.
+    // Repeats of a grant reach it once per refresh interval.
+    using GrantCallback = std::function<void(const CallGrant&)>;
+
+    // DMR control channel moved to another repeater
+    using RestChannelCallback = std::function<void(Frequency)>;
+
+    // 'index' is the system's position in the configuration, which is how
+    // decode workers know it and the site its calls are keyed by
+    explicit ChannelGroup(const SystemInfo& system, size_t index = 0);
+    ~ChannelGroup();
+
+    bool initialize(const Host& host);
+    void setRetuneCallback(RetuneCallback callback) { retune_callback_ = callback; }
+    void setGrantCallback(GrantCallback callback) { grant_callback_ = callback; }
+
+    // Wideband samples from the capture
+    void process(const Complex* samples, size_t count);
+
+    // The host moved the capture; channels are re-mixed from the new centre
+    void setCenterFrequency(Frequency freq);
+
+    // Publish the control channel's baseband as a shared IQ stream; only
+    // for control channels mixed down from the capture
+    bool publishControlChannel(const std::string& name);
+
+    const SystemInfo& getSystem() const { return system_; }
+    uint16_t getSite() const { return static_cast<uint16_t>(index_); }
+    Frequency getControlFrequency() const { return control_freq_; }
+    bool isLocked() const;
+    size_t getCRCErrors() const;
+    bool inCapture(Frequency freq) const;
+
+    // Traffic channels of P25, DMR and NXDN are followed by host receivers
+    bool followsVoice() const;
+
+    // Build a mixer, demodulator and decoder for one of this system's
+    // traffic channels. The caller tunes the mixer and wires the decoder's
+    // voice and call end callbacks.
+    bool createVoiceChain(ChannelReceiver& chain) const;
+
+    // A chain built by either group decodes the other's traffic channels
+    bool sharesVoiceChain(const ChannelGroup& other) const;
+
+    // Both groups are sites of one network, so a talkgroup granted on both
+    // is one call. Sites name their network, or match on a configured
+    // identity (WACN, system ID, NAC); a site with neither stands alone.
+    bool sharesNetwork(const ChannelGroup& other) const;
+
+    // Build and wire the demodulator and decoder this system uses on a
+    // channel at 'sample_rate', here in this process. Decode workers use it
+    // without initializing the group.
+    bool createDecoderChain(ChannelReceiver& chain, ChannelRole role, uint32_t sample_rate,
+                            RestChannelCallback rest_callback = nullptr) const;
+
+private:
+    bool initializeControl();
+    bool initializeConventional();
+
+    std::unique_ptr<DigitalDownConverter> createChannelDDC(Frequency freq) const;
+
+    // Demodulator and decoder for a channel, on a decode worker when the
+    // host has them and the channel is mixed down
+    bool createChannelChain(ChannelReceiver& chain, ChannelRole role,
+                            RestChannelCallback rest_callback = nullptr) const;
+    bool createRemoteChain(ChannelReceiver& chain, ChannelRole role,
+                           RestChannelCallback rest_callback) const;
+
+    void handleCallGrant(const CallGrant& grant);
+    void handleVoiceFrames(const VoiceFrameBatch& batch);
+    void handleCallEnd(TalkgroupID talkgroup);
+
+    // Control channel that can move between repeaters (DMR rest channel)
+    void followRestChannel(Frequency freq);
+
+    SystemInfo system_;
+    size_t index_;
+    Host host_;
+    RetuneCallback retune_callback_;
+    GrantCallback grant_callback_;
+
+    // Repeated grants are dropped before the host sees them; samples
+    // processed serve as the clock
+    RecentGrantCache recent_grants_;
+    uint64_t samples_seen_;
+
+    ChannelReceiver control_;
+    Frequency control_freq_;
+
+#ifdef ENABLE_TETRA
+    // TETRA replaces the control receiver: every carrier of the site is
+    // demodulated from the capture
+    std::unique_ptr<European::TETRASiteMonitor> tetra_monitor_;
+#endif
+
+    // Conventional channels (dPMR), each watched all the time
+    std::vector<std::unique_ptr<ChannelReceiver>> conventional_;
+
+    // Narrowband channels are decimated to about this rate, a whole
+    // multiple of the 2400/4800/9600 symbol rates (the demodulators'
+    // symbol clocks also take a fractional ratio)
+    static constexpr uint32_t VOICE_CHANNEL_RATE = 48000;
+    static constexpr float VOICE_CHANNEL_BANDWIDTH = 12500.0f;
+    static constexpr float DPMR_CHANNEL_BANDWIDTH = 6250.0f;
+
+    // A repeated grant is passed on this often to keep the call alive
+    static constexpr uint32_t GRANT_REFRESH_MS = 500;
+};
+
+} // namespace TrunkSDR
+
+#endif // CHANNEL_GROUP_H
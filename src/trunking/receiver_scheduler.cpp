@@ -0,0 +1,267 @@
+#include "receiver_scheduler.h"
+#include "../utils/logger.h"
+#include <algorithm>
+
+namespace TrunkSDR {
+
+ReceiverScheduler::ReceiverScheduler()
+    : pool_(nullptr)
+    , call_manager_(nullptr)
+    , hold_time_ms_(0)
+    , preempt_priority_(0)
+    , followed_(0)
+    , missed_(0)
+    , missed_emergency_(0)
+    , preempted_(0)
+    , resumed_(0)
+    , pending_count_(0) {
+}
+
+void ReceiverScheduler::initialize(VoiceReceiverPool* pool, CallManager* call_manager,
+                                   uint32_t hold_time_ms, Priority preempt_priority) {
+    pool_ = pool;
+    call_manager_ = call_manager;
+    hold_time_ms_ = hold_time_ms;
+    preempt_priority_ = preempt_priority;
+
+    slots_.assign(pool->size(), Slot());
+    pending_.clear();
+    pending_.reserve(MAX_PENDING);
+
+    LOG_INFO("Receiver scheduler: hold time =", hold_time_ms, "ms, preempt priority =",
+             static_cast<int>(preempt_priority));
+}
+
+void ReceiverScheduler::setPolicy(uint32_t hold_time_ms, Priority preempt_priority) {
+    hold_time_ms_ = hold_time_ms;
+    preempt_priority_ = preempt_priority;
+}
+
+Priority ReceiverScheduler::callPriority(const CallGrant& grant) const {
+    // Configured talkgroup priority, raised when the grant asks for more
+    Priority priority = call_manager_->getTalkgroupPriority(grant.talkgroup);
+    if (grant.type == CallType::EMERGENCY) {
+        priority = std::max(priority, EMERGENCY_PRIORITY);
+    }
+    if (grant.priority > NORMAL_PRIORITY) {
+        priority = std::max(priority, grant.priority);
+    }
+    return priority;
+}
+
+void ReceiverScheduler::handleGrant(const ChannelGroup& group, const CallGrant& grant,
+                                    uint64_t now_ms) {
+    Priority priority = callPriority(grant);
+
+    int carrier = pool_->findCarrier(group, grant);
+    if (carrier >= 0) {
+        Slot& slot = slots_[carrier];
+        slot.priority = std::max(slot.priority, priority);
+        pool_->addCall(carrier, group, grant);
+        return;
+    }
+
+    // A waiting call is scheduled afresh; its grant may have moved or
+    // raised its priority
+    PendingCall call{&group, grant, priority, now_ms, now_ms, false};
+    bool waiting = false;
+    for (size_t i = 0; i < pending_.size(); i++) {
+        if (pending_[i].group == &group && pending_[i].grant.talkgroup == grant.talkgroup) {
+            call.queued_ms = pending_[i].queued_ms;
+            call.priority = std::max(priority, pending_[i].priority);
+            call.preempted = pending_[i].preempted;
+            pending_.erase(pending_.begin() + i);
+            waiting = true;
+            break;
+        }
+    }
+
+    int index = findReceiver(group, grant.talkgroup, call.priority);
+    Priority preempt_priority = preempt_priority_;
+    if (index < 0 && preempt_priority != 0 && call.priority >= preempt_priority) {
+        index = findVictim(call.priority);
+        if (index >= 0) {
+            Slot& victim = slots_[index];
+            LOG_INFO("Preempting TG", victim.talkgroup, "( priority",
+                     static_cast<int>(victim.priority), ") for TG", grant.talkgroup,
+                     "( priority", static_cast<int>(call.priority), ")");
+
+            // The interrupted call waits for a receiver like any other
+            pool_->release(index);
+            enqueue(PendingCall{victim.group, victim.grant, victim.priority,
+                                now_ms, now_ms, true});
+            victim = Slot();
+            preempted_++;
+        }
+    }
+
+    if (index >= 0) {
+        if (follow(index, group, grant, call.priority)) {
+            if (waiting) {
+                resumed_++;
+            }
+        } else if (!call.preempted) {
+            countMissed(grant.talkgroup, call.priority, "voice receiver failed to tune");
+        }
+        pending_count_ = pending_.size();
+        return;
+    }
+
+    if (!waiting) {
+        LOG_INFO("No voice receiver free, call waiting: TG =", grant.talkgroup,
+                 "priority =", static_cast<int>(call.priority));
+    }
+    enqueue(call);
+}
+
+int ReceiverScheduler::findReceiver(const ChannelGroup& group, TalkgroupID talkgroup,
+                                    Priority priority) const {
+    int idle = -1;
+    int held = -1;
+    for (size_t i = 0; i < slots_.size(); i++) {
+        const Slot& slot = slots_[i];
+        if (slot.state == SlotState::HOLD && slot.group == &group && slot.talkgroup == talkgroup) {
+            return static_cast<int>(i);
+        }
+        if (slot.state == SlotState::IDLE) {
+            // Prefer a receiver already built for this network
+            if (idle < 0 || (!pool_->isBuiltFor(idle, group) && pool_->isBuiltFor(i, group))) {
+                idle = static_cast<int>(i);
+            }
+        } else if (slot.state == SlotState::HOLD && slot.priority < priority) {
+            // A hold yields to calls that matter more than its talkgroup
+            if (held < 0 || slot.priority < slots_[held].priority) {
+                held = static_cast<int>(i);
+            }
+        }
+    }
+    return idle >= 0 ? idle : held;
+}
+
+int ReceiverScheduler::findVictim(Priority priority) const {
+    int victim = -1;
+    for (size_t i = 0; i < slots_.size(); i++) {
+        const Slot& slot = slots_[i];
+        if (slot.state == SlotState::ACTIVE && slot.priority < priority &&
+            (victim < 0 || slot.priority < slots_[victim].priority)) {
+            victim = static_cast<int>(i);
+        }
+    }
+    return victim;
+}
+
+bool ReceiverScheduler::follow(size_t index, const ChannelGroup& group,
+                               const CallGrant& grant, Priority priority) {
+    Slot& slot = slots_[index];
+    slot = Slot();
+    if (!pool_->tune(index, group, grant)) {
+        return false;
+    }
+
+    slot.state = SlotState::ACTIVE;
+    slot.talkgroup = grant.talkgroup;
+    slot.priority = priority;
+    slot.group = &group;
+    slot.grant = grant;
+    followed_++;
+    return true;
+}
+
+void ReceiverScheduler::enqueue(const PendingCall& call) {
+    // Full: the lowest-priority waiting call gives way, or the new one is
+    // missed
+    if (pending_.size() >= MAX_PENDING) {
+        if (pending_.back().priority >= call.priority) {
+            countMissed(call.grant.talkgroup, call.priority, "no voice receiver");
+            return;
+        }
+        dropPending(pending_.size() - 1);
+    }
+
+    auto position = std::upper_bound(pending_.begin(), pending_.end(), call,
+        [](const PendingCall& a, const PendingCall& b) {
+            if (a.priority != b.priority) {
+                return a.priority > b.priority;
+            }
+            return a.queued_ms < b.queued_ms;
+        });
+    pending_.insert(position, call);
+    pending_count_ = pending_.size();
+}
+
+void ReceiverScheduler::dropPending(size_t index) {
+    const PendingCall& call = pending_[index];
+    if (!call.preempted) {
+        countMissed(call.grant.talkgroup, call.priority, "no voice receiver");
+    }
+    pending_.erase(pending_.begin() + index);
+    pending_count_ = pending_.size();
+}
+
+void ReceiverScheduler::countMissed(TalkgroupID talkgroup, Priority priority,
+                                     const char* reason) {
+    missed_++;
+    if (priority >= EMERGENCY_PRIORITY) {
+        missed_emergency_++;
+    }
+    LOG_INFO("Call missed:", reason, "TG =", talkgroup,
+             "priority =", static_cast<int>(priority));
+}
+
+void ReceiverScheduler::update(uint64_t now_ms) {
+    // Receivers release themselves when their calls end or go quiet
+    uint32_t hold_time_ms = hold_time_ms_;
+    for (size_t i = 0; i < slots_.size(); i++) {
+        Slot& slot = slots_[i];
+        if (slot.state == SlotState::ACTIVE && !pool_->isActive(i)) {
+            if (hold_time_ms > 0) {
+                slot.state = SlotState::HOLD;
+                slot.hold_until = now_ms + hold_time_ms;
+            } else {
+                slot = Slot();
+            }
+        }
+        if (slot.state == SlotState::HOLD && now_ms >= slot.hold_until) {
+            slot = Slot();
+        }
+    }
+
+    // Waiting calls whose grants stopped are over
+    for (size_t i = pending_.size(); i-- > 0;) {
+        const PendingCall& call = pending_[i];
+        if (now_ms - call.seen_ms > PENDING_TIMEOUT_MS ||
+            !call_manager_->isCallActive({call.group->getSite(), call.grant.talkgroup})) {
+            dropPending(i);
+        }
+    }
+
+    // Highest priority first; a late start beats missing the call
+    for (size_t i = 0; i < pending_.size();) {
+        const PendingCall& call = pending_[i];
+        int index = findReceiver(*call.group, call.grant.talkgroup, call.priority);
+        if (index < 0) {
+            i++;
+            continue;
+        }
+        if (follow(index, *call.group, call.grant, call.priority)) {
+            resumed_++;
+        } else if (!call.preempted) {
+            countMissed(call.grant.talkgroup, call.priority, "voice receiver failed to tune");
+        }
+        pending_.erase(pending_.begin() + i);
+    }
+    pending_count_ = pending_.size();
+}
+
+ReceiverScheduler::Stats ReceiverScheduler::getStats() const {
+    Stats stats;
+    stats.followed = followed_;
+    stats.missed = missed_;
+    stats.missed_emergency = missed_emergency_;
+    stats.preempted = preempted_;
+    stats.resumed = resumed_;
+    stats.pending = pending_count_;
+    return stats;
+}
+
+} // namespace TrunkSDR
@@ -0,0 +1,119 @@
+#ifndef RECEIVER_SCHEDULER_H
+#define RECEIVER_SCHEDULER_H
+
+#include "../utils/types.h"
+#include "../audio/call_manager.h"
+#include "voice_receiver_pool.h"
+#include <atomic>
+#include <vector>
+
+namespace TrunkSDR {
+
+// Decides which calls the voice receivers follow.
+//
+// A call's priority is its talkgroup priority, raised to the grant's own
+// when the control channel signals more (emergency). A grant takes an idle
+// receiver, or one held for a talkgroup of lower priority. Failing that,
+// a call at or above the preemption priority takes the receiver of the
+// lowest-priority call below it, and the interrupted call is queued again.
+// Calls that find no receiver wait in a priority queue (highest priority
+// first, then oldest) until a receiver frees up or their grants stop.
+//
+// After a followed call ends its receiver is held for the talkgroup, so a
+// reply is heard even when other calls are waiting.
+//
+// Runs on the SDR thread between the group and receiver stages; the
+// statistics may be read from any thread.
+class ReceiverScheduler {
+public:
+    struct Stats {
+        uint64_t followed;   // Calls given a receiver
+        uint64_t missed;     // Calls that never got one
+        uint64_t missed_emergency;
+        uint64_t preempted;  // Calls interrupted by a higher priority
+        uint64_t resumed;    // Interrupted or late calls followed after all
+        size_t pending;      // Calls waiting now
+    };
+
+    ReceiverScheduler();
+
+    // hold_time_ms 0 releases at once; preempt_priority 0 never preempts
+    void initialize(VoiceReceiverPool* pool, CallManager* call_manager,
+                    uint32_t hold_time_ms, Priority preempt_priority);
+
+    // Any thread (config reload); applies from the next call or hold
+    void setPolicy(uint32_t hold_time_ms, Priority preempt_priority);
+
+    // A grant the call manager accepted, for a group with voice
+    void handleGrant(const ChannelGroup& group, const CallGrant& grant, uint64_t now_ms);
+
+    // Once per block: notice ended calls, expire holds and stale calls,
+    // give free receivers to waiting calls
+    void update(uint64_t now_ms);
+
+    Stats getStats() const;
+
+private:
+    enum class SlotState {
+        IDLE,
+        ACTIVE,
+        HOLD
+    };
+
+    // Scheduler's view of one pool receiver
+    struct Slot {
+        SlotState state = SlotState::IDLE;
+        TalkgroupID talkgroup = 0;
+        Priority priority = 0;
+        uint64_t hold_until = 0;
+        const ChannelGroup* group = nullptr;  // Call followed, to resume it after preemption
+        CallGrant grant{};
+    };
+
+    struct PendingCall {
+        const ChannelGroup* group;
+        CallGrant grant;
+        Priority priority;
+        uint64_t queued_ms;
+        uint64_t seen_ms;     // Last grant for the call
+        bool preempted;       // Followed before; not missed when dropped
+    };
+
+    Priority callPriority(const CallGrant& grant) const;
+
+    // Receiver for a call of this priority, or -1
+    int findReceiver(const ChannelGroup& group, TalkgroupID talkgroup, Priority priority) const;
+    int findVictim(Priority priority) const;
+
+    bool follow(size_t index, const ChannelGroup& group, const CallGrant& grant, Priority priority);
+    void enqueue(const PendingCall& call);
+    void dropPending(size_t index);
+    void countMissed(TalkgroupID talkgroup, Priority priority, const char* reason);
+
+    VoiceReceiverPool* pool_;
+    CallManager* call_manager_;
+    std::atomic<uint32_t> hold_time_ms_;
+    std::atomic<Priority> preempt_priority_;
+
+    std::vector<Slot> slots_;
+    std::vector<PendingCall> pending_;  // Highest priority first, then oldest
+
+    std::atomic<uint64_t> followed_;
+    std::atomic<uint64_t> missed_;
+    std::atomic<uint64_t> missed_emergency_;
+    std::atomic<uint64_t> preempted_;
+    std::atomic<uint64_t> resumed_;
+    std::atomic<size_t> pending_count_;
+
+    // Priority of a grant the control channel did not single out
+    static constexpr Priority NORMAL_PRIORITY = 5;
+    static constexpr Priority EMERGENCY_PRIORITY = 10;
+
+    // A waiting call whose grant has not repeated for this long is over
+    static constexpr uint64_t PENDING_TIMEOUT_MS = 2000;
+    static constexpr size_t MAX_PENDING = 64;
+};
+
+} // namespace TrunkSDR
+
+#endif // RECEIVER_SCHEDULER_H
@@ -0,0 +1,80 @@
+#ifndef RECENT_GRANT_CACHE_H
+#define RECENT_GRANT_CACHE_H
+
+#include "../utils/types.h"
+#include <array>
+#include <cstdint>
+
+namespace TrunkSDR {
+
+// Recently seen grants of one control channel.
+//
+// Control channels repeat a grant for as long as the call lasts (P25
+// GROUP_VOICE_UPDATE, DMR CSBKs on every burst). Only the first grant and
+// one refresh per interval need to reach the call manager. The cache is a
+// small direct-mapped table keyed by talkgroup and frequency: a lookup is
+// one hash, one compare and no allocation. A colliding grant just evicts
+// the entry, which costs one extra refresh.
+//
+// Time is whatever monotonic count the caller keeps (samples processed).
+// Not thread-safe; each control channel owns its cache.
+class RecentGrantCache {
+public:
+    RecentGrantCache() { clear(); }
+
+    // True when the same grant was passed within refresh; otherwise the
+    // grant is recorded and should be handled
+    bool isRepeat(const CallGrant& grant, uint64_t now, uint64_t refresh) {
+        uint32_t channel = static_cast<uint32_t>(grant.frequency / 100.0);
+        Entry& entry = entries_[index(grant.talkgroup, channel)];
+
+        bool same_channel = entry.talkgroup == grant.talkgroup &&
+                            entry.channel == channel && entry.slot == grant.slot;
+
+        // Updates without a source continue the call; a new source on the
+        // same channel is a new call, and a raised priority (emergency)
+        // must reach the scheduler at once
+        bool same_call = same_channel && entry.priority == grant.priority &&
+                         (grant.radio_id == 0 || entry.source == grant.radio_id);
+        if (same_call && now - entry.passed < refresh) {
+            return true;
+        }
+
+        if (!same_channel || grant.radio_id != 0) {
+            entry.source = grant.radio_id;
+        }
+        entry.talkgroup = grant.talkgroup;
+        entry.channel = channel;
+        entry.slot = grant.slot;
+        entry.priority = grant.priority;
+        entry.passed = now;
+        return false;
+    }
+
+    void clear() {
+        entries_.fill(Entry{0, 0, 0, 0, 0, 0});
+    }
+
+private:
+    struct Entry {
+        TalkgroupID talkgroup;
+        uint32_t channel;   // Frequency in 100 Hz steps
+        RadioID source;
+        uint8_t slot;
+        Priority priority;
+        uint64_t passed;
+    };
+
+    static constexpr size_t SIZE = 64;  // Power of two
+
+    static size_t index(TalkgroupID talkgroup, uint32_t channel) {
+        uint32_t hash = (talkgroup * 0x9E3779B1u) ^ (channel * 0x85EBCA6Bu);
+        return (hash >> 16) & (SIZE - 1);
+    }
+
+    std::array<Entry, SIZE> entries_;
+};
+
+} // namespace TrunkSDR
+
+#endif // RECENT_GRANT_CACHE_H
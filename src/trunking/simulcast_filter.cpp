@@ -0,0 +1,55 @@
+#include "simulcast_filter.h"
+
+namespace TrunkSDR {
+
+SimulcastFilter::SimulcastFilter(uint64_t window_ms)
+    : window_ms_(window_ms)
+    , duplicates_(0) {
+}
+
+bool SimulcastFilter::accept(size_t network, size_t site, const CallGrant& grant,
+                             uint64_t now_ms) {
+    if (calls_.size() > PRUNE_THRESHOLD) {
+        prune(now_ms);
+    }
+
+    Key key{network, grant.talkgroup};
+    auto it = calls_.find(key);
+    if (it == calls_.end()) {
+        calls_[key] = Entry{grant.radio_id, site, now_ms};
+        return true;
+    }
+
+    Entry& entry = it->second;
+    bool same_call = grant.radio_id == 0 || entry.source == 0 ||
+                     grant.radio_id == entry.source;
+    bool recent = now_ms - entry.last_ms <= window_ms_;
+
+    if (same_call && recent && entry.site != site) {
+        // Still the owning site's call; keep it alive while any site
+        // announces it so a late site cannot take over mid-call
+        entry.last_ms = now_ms;
+        duplicates_++;
+        return false;
+    }
+
+    // A new call, or the owning site repeating its grant
+    if (grant.radio_id != 0) {
+        entry.source = grant.radio_id;
+    }
+    entry.site = site;
+    entry.last_ms = now_ms;
+    return true;
+}
+
+void SimulcastFilter::prune(uint64_t now_ms) {
+    for (auto it = calls_.begin(); it != calls_.end();) {
+        if (now_ms - it->second.last_ms > window_ms_) {
+            it = calls_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+} // namespace TrunkSDR
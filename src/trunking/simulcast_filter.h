@@ -0,0 +1,62 @@
+#ifndef SIMULCAST_FILTER_H
+#define SIMULCAST_FILTER_H
+
+#include "../utils/types.h"
+#include <atomic>
+#include <map>
+
+namespace TrunkSDR {
+
+// Collapses the grants of one call seen on several sites.
+//
+// Every site of a wide-area network announces the same call on its own
+// control channel. A grant is a duplicate when another site of the same
+// network reported the same talkgroup and source within the window.
+// Talkgroups of different networks are unrelated even when the numbers
+// match. The site that reported it first owns the call for as long as any
+// site keeps announcing it; only its repeats pass. A grant without a
+// source matches any call on its talkgroup.
+//
+// Not thread-safe; the caller serialises grants. The duplicate count may
+// be read from any thread.
+class SimulcastFilter {
+public:
+    explicit SimulcastFilter(uint64_t window_ms = 3000);
+
+    void setWindow(uint64_t window_ms) { window_ms_ = window_ms; }
+
+    // True when the grant starts or continues a call on this site.
+    // 'network' is the same for every site of one network.
+    bool accept(size_t network, size_t site, const CallGrant& grant, uint64_t now_ms);
+
+    uint64_t getDuplicateCount() const { return duplicates_; }
+
+private:
+    struct Key {
+        size_t network;
+        TalkgroupID talkgroup;
+
+        bool operator<(const Key& other) const {
+            return network != other.network ? network < other.network
+                                             : talkgroup < other.talkgroup;
+        }
+    };
+
+    struct Entry {
+        RadioID source;
+        size_t site;
+        uint64_t last_ms;
+    };
+
+    void prune(uint64_t now_ms);
+
+    uint64_t window_ms_;
+    std::map<Key, Entry> calls_;
+    std::atomic<uint64_t> duplicates_;
+
+    static constexpr size_t PRUNE_THRESHOLD = 256;
+};
+
+} // namespace TrunkSDR
+
+#endif // SIMULCAST_FILTER_H
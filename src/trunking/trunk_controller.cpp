@@ -1,131 +1,354 @@
 #include "trunk_controller.h"
 #include "../sdr/rtlsdr_source.h"
-#include "../dsp/c4fm_demod.h"
-#include "../dsp/fsk_demod.h"
-#include "../decoders/p25_decoder.h"
-#include "../decoders/smartnet_decoder.h"
+#include "../sdr/shared_iq_source.h"
 #include "../utils/logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <sstream>
+#include <thread>
 
 namespace TrunkSDR {
 
+namespace {
+
+// "100, 101, 102 and 7 more" for the reload report
+std::string listTalkgroups(const std::vector<TalkgroupID>& talkgroups) {
+    constexpr size_t SHOWN = 8;
+    std::ostringstream out;
+    for (size_t i = 0; i < talkgroups.size() && i < SHOWN; i++) {
+        out << (i > 0 ? ", " : "") << talkgroups[i];
+    }
+    if (talkgroups.size() > SHOWN) {
+        out << " and " << talkgroups.size() - SHOWN << " more";
+    }
+    return out.str();
+}
+
+bool sameSystem(const SystemInfo& a, const SystemInfo& b) {
+    return a.type == b.type && a.system_id == b.system_id && a.nac == b.nac &&
+           a.wacn == b.wacn && a.network == b.network &&
+           a.control_channels == b.control_channels && a.channels == b.channels &&
+           a.color_code == b.color_code && a.symbol_rate == b.symbol_rate &&
+           a.bandplan == b.bandplan && a.bandplan_base == b.bandplan_base;
+}
+
+// Sections a reload cannot apply while the capture runs
+std::vector<std::string> restartOnlyChanges(const Config& running, const Config& loaded) {
+    std::vector<std::string> sections;
+    const SDRConfig& a = running.sdr;
+    const SDRConfig& b = loaded.sdr;
+    if (a.device_index != b.device_index || a.sample_rate != b.sample_rate ||
+        a.gain != b.gain || a.auto_gain != b.auto_gain || a.ppm_correction != b.ppm_correction ||
+        a.center_frequency != b.center_frequency || a.source != b.source ||
+        a.publish != b.publish || a.dsp_threads != b.dsp_threads) {
+        sections.push_back("sdr");
+    }
+    bool systems = running.systems.size() != loaded.systems.size();
+    for (size_t i = 0; !systems && i < running.systems.size(); i++) {
+        systems = !sameSystem(running.systems[i], loaded.systems[i]);
+    }
+    if (systems) {
+        sections.push_back("systems");
+    }
+    if (running.audio.output_device != loaded.audio.output_device ||
+        running.audio.record_calls != loaded.audio.record_calls ||
+        running.audio.call_log != loaded.audio.call_log ||
+        running.audio.codec_threads != loaded.audio.codec_threads) {
+        sections.push_back("audio");
+    }
+    if (running.receivers.voice_receivers != loaded.receivers.voice_receivers ||
+        running.receivers.simulcast_window_ms != loaded.receivers.simulcast_window_ms) {
+        sections.push_back("receivers.voice_receivers/simulcast_window_ms");
+    }
+    if (running.distributed.workers != loaded.distributed.workers ||
+        running.distributed.sample_format != loaded.distributed.sample_format) {
+        sections.push_back("distributed");
+    }
+    if (running.capture.directory != loaded.capture.directory ||
+        running.capture.format != loaded.capture.format ||
+        running.capture.pre_trigger_ms != loaded.capture.pre_trigger_ms) {
+        sections.push_back("capture");
+    }
+    return sections;
+}
+
+} // anonymous namespace
+
 TrunkController::TrunkController()
-    : running_(false)
-    , current_control_freq_(0)
-    , current_voice_freq_(0)
-    , voice_active_(false) {
+    : tunable_(true)
+    , pending_center_(0)
+    , running_(false)
+    , last_call_cleanup_ms_(0)
+    , center_freq_(0) {
 }
 
 TrunkController::~TrunkController() {
-    stop();
+    // Also after a failed initialize(), whose decode link may be connected
+    running_ = false;
+    shutdown();
 }
 
 bool TrunkController::initialize(const Config& config) {
     config_ = config;
 
     LOG_INFO("Initializing trunk controller");
-    LOG_INFO("System type:", ConfigParser::systemTypeToString(config.system.type));
+    for (const SystemInfo& system : config.systems) {
+        LOG_INFO("System type:", ConfigParser::systemTypeToString(system.type));
+    }
+
+    if (config.systems.empty()) {
+        LOG_ERROR("No systems configured");
+        return false;
+    }
 
     // Initialize SDR for control channel
-    control_sdr_ = std::make_unique<RTLSDRSource>();
-    if (!control_sdr_->initialize(config.sdr)) {
+    control_sdr_ = createSource(config.sdr);
+    if (!control_sdr_ || !control_sdr_->initialize(config.sdr)) {
         LOG_ERROR("Failed to initialize control SDR");
         return false;
     }
 
-    // Initialize demodulator based on system type
-    if (config.system.type == SystemType::P25_PHASE1 ||
-        config.system.type == SystemType::P25_PHASE2) {
-        // C4FM for P25
-        control_demod_ = std::make_unique<C4FMDemodulator>();
-    } else if (config.system.type == SystemType::SMARTNET ||
-               config.system.type == SystemType::SMARTZONE) {
-        // FSK2 for SmartNet
-        control_demod_ = std::make_unique<FSKDemodulator>(3600, 2);
-    } else {
-        LOG_ERROR("Unsupported system type");
+    // Another process's capture stays where its owner tuned it
+    tunable_ = control_sdr_->isTunable();
+    center_freq_ = tunable_ ? captureCenter(config) : control_sdr_->getFrequency();
+    uint32_t sample_rate = control_sdr_->getSampleRate();
+
+    // Initialize call manager
+    call_manager_ = std::make_unique<CallManager>();
+    if (!call_manager_->initialize(config.audio)) {
+        LOG_ERROR("Failed to initialize call manager");
+        return false;
+    }
+
+    // Enabled talkgroups, priorities and names; replaced on a reload
+    if (!call_manager_->applyTalkgroupConfig(config.talkgroups)) {
+        LOG_ERROR("Failed to open alias database:", config.talkgroups.alias_db);
         return false;
     }
 
-    control_demod_->initialize(config.sdr.sample_rate);
+    codec_pool_ = std::make_unique<CodecPool>();
+    codec_pool_->setAudioCallback(
+        [this](const CallKey& call, PooledPCM audio) {
+            call_manager_->handleAudioFrame(call, std::move(audio));
+        }
+    );
 
-    // Initialize protocol decoder
-    if (config.system.type == SystemType::P25_PHASE1 ||
-        config.system.type == SystemType::P25_PHASE2) {
-        auto p25_decoder = std::make_unique<P25Decoder>();
-        p25_decoder->setNAC(config.system.nac);
-        protocol_decoder_ = std::move(p25_decoder);
-    } else if (config.system.type == SystemType::SMARTNET ||
-               config.system.type == SystemType::SMARTZONE) {
-        protocol_decoder_ = std::make_unique<SmartNetDecoder>();
+    ChannelGroup::Host host;
+    host.sample_rate = sample_rate;
+    host.center_freq = center_freq_;
+    host.call_manager = call_manager_.get();
+    host.codec_pool = codec_pool_.get();
+    host.decode_link = nullptr;
+
+    if (!config.distributed.workers.empty()) {
+        SampleFormat format = SampleFormat::CS16;
+        parseSampleFormat(config.distributed.sample_format, format);
+        decode_link_ = std::make_unique<DecodeLink>();
+        if (!decode_link_->initialize(config.distributed.workers, format)) {
+            LOG_ERROR("Failed to connect to decode workers");
+            return false;
+        }
+        host.decode_link = decode_link_.get();
     }
 
-    protocol_decoder_->initialize();
+    simulcast_.setWindow(config.receivers.simulcast_window_ms);
+
+    bool shared = config.systems.size() > 1;
+    size_t voice_systems = 0;
+    for (const SystemInfo& system : config.systems) {
+        auto group = std::make_unique<ChannelGroup>(system, groups_.size());
+        if (!group->initialize(host)) {
+            LOG_ERROR("Failed to initialize system:", system.name);
+            return false;
+        }
 
-    // Set up decoder callback
-    protocol_decoder_->setGrantCallback(
-        [this](const CallGrant& grant) {
-            handleCallGrant(grant);
+        size_t site = groups_.size();
+        size_t network = site;
+        for (size_t i = 0; i < groups_.size(); i++) {
+            if (group->sharesNetwork(*groups_[i])) {
+                network = networks_[i];
+                break;
+            }
+        }
+        networks_.push_back(network);
+        pending_grants_.emplace_back();
+        pending_grants_.back().reserve(MAX_GRANTS_PER_BLOCK);
+        group->setGrantCallback(
+            [this, site](const CallGrant& grant) {
+                submitGrant(site, grant);
+            }
+        );
+
+        // A shared capture cannot follow one system off to another frequency
+        if (!shared && tunable_) {
+            group->setRetuneCallback(
+                [this](Frequency freq) {
+                    return requestRetune(freq);
+                }
+            );
+        }
+
+        if (group->followsVoice()) {
+            voice_systems++;
+        }
+
+        ChannelGroup* target = group.get();
+        channelizer_.addChannel(
+            [target](const Complex* samples, size_t count) {
+                target->process(samples, count);
+            }
+        );
+        groups_.push_back(std::move(group));
+    }
+
+    // Receivers are channelizer consumers in a second stage, after the
+    // grants of the block have been scheduled; idle ones return at once
+    size_t voice_receivers = config.receivers.voice_receivers;
+    if (voice_receivers == 0) {
+        voice_receivers = voice_systems;
+    }
+    voice_pool_.initialize(voice_receivers, sample_rate, center_freq_,
+                           call_manager_.get(), codec_pool_.get());
+    channelizer_.addStage(
+        [this]() {
+            schedulePending();
         }
     );
+    scheduler_.initialize(&voice_pool_, call_manager_.get(),
+                          config.receivers.hold_time_ms, config.receivers.preempt_priority);
+    applied_receivers_ = config.receivers;
+    for (size_t i = 0; i < voice_pool_.size(); i++) {
+        channelizer_.addChannel(
+            [this, i](const Complex* samples, size_t count) {
+                voice_pool_.process(i, samples, count);
+            }
+        );
+    }
 
-    // Initialize call manager
-    call_manager_ = std::make_unique<CallManager>();
-    if (!call_manager_->initialize(config.audio)) {
-        LOG_ERROR("Failed to initialize call manager");
+    if (!config.sdr.publish.empty() && !initializePublishing(config.sdr, sample_rate)) {
+        LOG_ERROR("Failed to publish IQ stream:", config.sdr.publish);
         return false;
     }
 
-    // Configure enabled talkgroups
-    for (TalkgroupID tg : config.talkgroups.enabled) {
-        Priority priority = 5;  // Default
-        if (config.talkgroups.priorities.count(tg)) {
-            priority = config.talkgroups.priorities.at(tg);
+    if (!config.capture.directory.empty()) {
+        IQRecorder::Settings settings;
+        settings.directory = config.capture.directory;
+        settings.format = IQRecorder::Format::CU8;
+        IQRecorder::parseFormat(config.capture.format, settings.format);
+        settings.pre_trigger_ms = config.capture.pre_trigger_ms;
+        settings.post_trigger_ms = config.capture.post_trigger_ms;
+        settings.max_capture_ms = config.capture.max_capture_ms;
+
+        iq_recorder_ = std::make_unique<IQRecorder>();
+        if (!iq_recorder_->initialize(settings, sample_rate, center_freq_)) {
+            LOG_ERROR("Failed to set up IQ capture");
+            return false;
         }
-        call_manager_->enableTalkgroup(tg, priority);
+        capture_watch_.assign(groups_.size(), CaptureWatch{false, 0, 0});
     }
 
     LOG_INFO("Trunk controller initialized successfully");
     return true;
 }
 
+std::unique_ptr<SDRInterface> TrunkController::createSource(const SDRConfig& sdr) const {
+    const std::string shm_prefix = "shm:";
+    if (sdr.source.compare(0, shm_prefix.size(), shm_prefix) == 0) {
+        return std::make_unique<SharedIQSource>(sdr.source.substr(shm_prefix.size()));
+    }
+    if (sdr.source.empty() || sdr.source == "rtlsdr") {
+        return std::make_unique<RTLSDRSource>();
+    }
+    LOG_ERROR("Unknown SDR source:", sdr.source);
+    return nullptr;
+}
+
+bool TrunkController::initializePublishing(const SDRConfig& sdr, uint32_t sample_rate) {
+    iq_publisher_ = std::make_unique<SharedIQPublisher>();
+    if (!iq_publisher_->initialize(sdr.publish, SHARED_IQ_CAPTURE_SAMPLES,
+                                   sample_rate, center_freq_)) {
+        return false;
+    }
+    if (!sdr.publish_channels) {
+        return true;
+    }
+
+    for (size_t i = 0; i < groups_.size(); i++) {
+        groups_[i]->publishControlChannel(sdr.publish + "-site" + std::to_string(i));
+    }
+    return voice_pool_.publishReceivers(sdr.publish + "-voice");
+}
+
+Frequency TrunkController::captureCenter(const Config& config) const {
+    if (config.systems.size() == 1) {
+        return config.systems[0].control_channels[0];
+    }
+    if (config.sdr.center_frequency > 0) {
+        return config.sdr.center_frequency;
+    }
+
+    Frequency low = config.systems[0].control_channels[0];
+    Frequency high = low;
+    for (const SystemInfo& system : config.systems) {
+        for (Frequency freq : system.control_channels) {
+            low = std::min(low, freq);
+            high = std::max(high, freq);
+        }
+    }
+    return std::round((low + high) / 2.0);
+}
+
 bool TrunkController::start() {
     if (running_) {
         LOG_WARNING("Trunk controller already running");
         return true;
     }
 
-    // Tune to first control channel
-    if (config_.system.control_channels.empty()) {
-        LOG_ERROR("No control channels configured");
+    if (!tuneToControlChannel(center_freq_)) {
+        LOG_ERROR("Failed to tune to control channel");
         return false;
     }
 
-    if (!tuneToControlChannel(config_.system.control_channels[0])) {
-        LOG_ERROR("Failed to tune to control channel");
-        return false;
+    // Start vocoder workers before any voice can arrive
+    uint32_t threads = config_.audio.codec_threads;
+    if (threads == 0) {
+        threads = std::max(2u, std::thread::hardware_concurrency()) - 1;
+    }
+    codec_pool_->start(threads);
+
+    // Groups and receivers beyond the first run on helper threads; the
+    // SDR thread takes one itself
+    size_t dsp_threads = config_.sdr.dsp_threads;
+    if (dsp_threads == 0) {
+        dsp_threads = std::min<size_t>(groups_.size() + voice_pool_.size(),
+                                       std::max(1u, std::thread::hardware_concurrency()));
     }
+    channelizer_.start(dsp_threads - 1);
 
-    // Start SDR
-    if (!control_sdr_->start()) {
-        LOG_ERROR("Failed to start control SDR");
-        return false;
+    if (iq_recorder_) {
+        iq_recorder_->start();
     }
 
     // Set up SDR sample callback
     control_sdr_->setSampleCallback(
         [this](const Complex* samples, size_t count) {
-            // Process samples through demodulator
-            control_demod_->process(samples, count);
+            if (iq_publisher_) {
+                iq_publisher_->publish(samples, count);
+            }
+            if (iq_recorder_) {
+                iq_recorder_->write(samples, count);
+            }
+            channelizer_.process(samples, count);
         }
     );
 
-    // Set up demodulator symbol callback
-    control_demod_->setSymbolCallback(
-        [this](const float* symbols, size_t count) {
-            // Process symbols through protocol decoder
-            protocol_decoder_->processSymbols(symbols, count);
-        }
-    );
+    // Start SDR
+    if (!control_sdr_->start()) {
+        LOG_ERROR("Failed to start control SDR");
+        shutdown();
+        return false;
+    }
 
     running_ = true;
 
@@ -139,16 +362,99 @@ bool TrunkController::stop() {
     }
 
     running_ = false;
+    shutdown();
 
+    LOG_INFO("Trunk controller stopped");
+    return true;
+}
+
+void TrunkController::shutdown() {
     if (control_sdr_) {
         control_sdr_->stop();
     }
 
-    if (voice_sdr_) {
-        voice_sdr_->stop();
+    channelizer_.stop();
+
+    // Finishes a capture in progress with the samples it has
+    if (iq_recorder_) {
+        iq_recorder_->stop();
     }
 
-    LOG_INFO("Trunk controller stopped");
+    if (decode_link_) {
+        decode_link_->stop();
+    }
+
+    if (codec_pool_) {
+        codec_pool_->stop();
+    }
+}
+
+bool TrunkController::reloadConfig(const Config& config) {
+    if (!call_manager_) {
+        LOG_ERROR("Cannot reload configuration before initialization");
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    TalkgroupChanges changes;
+    if (!call_manager_->applyTalkgroupConfig(config.talkgroups, &changes)) {
+        LOG_ERROR("Configuration reload failed: cannot open alias database",
+                  config.talkgroups.alias_db, "- keeping the current settings");
+        return false;
+    }
+    scheduler_.setPolicy(config.receivers.hold_time_ms, config.receivers.preempt_priority);
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+
+    // What changed, against the last configuration applied
+    if (changes.enabled_before != changes.enabled_after &&
+        (changes.enabled_before == 0 || changes.enabled_after == 0)) {
+        LOG_INFO("Reload: following",
+                 changes.enabled_after == 0 ? "every talkgroup" :
+                 std::to_string(changes.enabled_after) + " talkgroup(s)",
+                 "instead of",
+                 changes.enabled_before == 0 ? "every talkgroup" :
+                 std::to_string(changes.enabled_before));
+    } else {
+        if (!changes.enabled.empty()) {
+            LOG_INFO("Reload: enabled talkgroups", listTalkgroups(changes.enabled));
+        }
+        if (!changes.disabled.empty()) {
+            LOG_INFO("Reload: disabled talkgroups", listTalkgroups(changes.disabled));
+        }
+    }
+    for (const TalkgroupChanges::PriorityChange& change : changes.priorities) {
+        LOG_INFO("Reload: talkgroup", change.talkgroup, "priority",
+                 static_cast<int>(change.from), "->", static_cast<int>(change.to));
+    }
+    if (changes.labels > 0) {
+        LOG_INFO("Reload:", changes.labels, "talkgroup label(s) changed");
+    }
+    if (changes.alias_db) {
+        LOG_INFO("Reload: alias database",
+                 config.talkgroups.alias_db.empty() ? "closed" : "reopened");
+    }
+    bool receivers = config.receivers.hold_time_ms != applied_receivers_.hold_time_ms ||
+                     config.receivers.preempt_priority != applied_receivers_.preempt_priority;
+    if (receivers) {
+        LOG_INFO("Reload: hold time", applied_receivers_.hold_time_ms, "->",
+                 config.receivers.hold_time_ms, "ms, preempt priority",
+                 static_cast<int>(applied_receivers_.preempt_priority), "->",
+                 static_cast<int>(config.receivers.preempt_priority));
+    }
+    applied_receivers_ = config.receivers;
+
+    for (const std::string& section : restartOnlyChanges(config_, config)) {
+        LOG_WARNING("Reload: changes to", section, "take effect on restart");
+    }
+
+    if (changes.any() || receivers) {
+        LOG_INFO("Configuration reloaded in", elapsed.count(), "us");
+    } else {
+        LOG_INFO("Configuration reloaded in", elapsed.count(), "us, nothing changed");
+    }
     return true;
 }
 
@@ -163,44 +469,122 @@ bool TrunkController::tuneToControlChannel(Frequency freq) {
         return false;
     }
 
-    current_control_freq_ = freq;
+    bool moved = freq != center_freq_;
+    center_freq_ = freq;
+    if (moved) {
+        for (auto& group : groups_) {
+            group->setCenterFrequency(freq);
+        }
+        voice_pool_.setCenterFrequency(freq);
+        if (iq_publisher_) {
+            iq_publisher_->setInfo(control_sdr_->getSampleRate(), freq);
+        }
+        if (iq_recorder_) {
+            iq_recorder_->setCenterFrequency(freq);
+        }
+    }
     LOG_INFO("Tuned to control channel:", freq, "Hz");
     return true;
 }
 
-bool TrunkController::tuneToVoiceChannel(Frequency freq) {
-    // For single-SDR operation, retune the control SDR
-    // In multi-SDR mode, use a separate voice SDR
+void TrunkController::submitGrant(size_t site, const CallGrant& grant) {
+    pending_grants_[site].push_back(grant);
+}
 
-    if (!control_sdr_) {
-        return false;
+bool TrunkController::requestRetune(Frequency freq) {
+    pending_center_ = freq;
+    return true;
+}
+
+void TrunkController::schedulePending() {
+    if (pending_center_ != 0) {
+        tuneToControlChannel(pending_center_);
+        pending_center_ = 0;
     }
 
-    // TODO: Implement voice channel following
-    // This would require:
-    // 1. Saving control channel state
-    // 2. Tuning to voice frequency
-    // 3. Decoding voice
-    // 4. Returning to control channel
+    uint64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+
+    for (size_t site = 0; site < pending_grants_.size(); site++) {
+        for (const CallGrant& grant : pending_grants_[site]) {
+            if (!simulcast_.accept(networks_[site], site, grant, now_ms)) {
+                continue;
+            }
+
+            CallKey call{static_cast<uint16_t>(site), grant.talkgroup};
+            bool followed = call_manager_->isCallActive(call);
+            call_manager_->handleGrant(grant, call.site);
+            if (iq_recorder_ && !followed) {
+                checkCallTrigger(call, grant);
+            }
+
+            // Follow the grant if the call was accepted (grants repeat for
+            // the duration of the call; calls already followed stay put)
+            if (groups_[site]->followsVoice() && call_manager_->isCallActive(call)) {
+                scheduler_.handleGrant(*groups_[site], grant, now_ms);
+            }
+        }
+        pending_grants_[site].clear();
+    }
 
-    current_voice_freq_ = freq;
-    voice_active_ = true;
+    scheduler_.update(now_ms);
 
-    LOG_INFO("Tuned to voice channel:", freq, "Hz");
-    return true;
+    if (now_ms - last_call_cleanup_ms_ >= CALL_CLEANUP_INTERVAL_MS) {
+        call_manager_->cleanupInactiveCalls();
+        last_call_cleanup_ms_ = now_ms;
+    }
+
+    if (iq_recorder_) {
+        checkCaptureTriggers(now_ms);
+    }
 }
 
-void TrunkController::handleCallGrant(const CallGrant& grant) {
-    LOG_INFO("Call grant received: TG =", grant.talkgroup,
-             "Freq =", grant.frequency);
+void TrunkController::checkCallTrigger(const CallKey& call, const CallGrant& grant) {
+    // Only the grant that starts a call
+    if (!call_manager_->isCallActive(call)) {
+        return;
+    }
 
-    // Forward to call manager
-    if (call_manager_) {
-        call_manager_->handleGrant(grant);
+    const CaptureConfig& capture = config_.capture;
+    std::string talkgroup = "tg" + std::to_string(grant.talkgroup);
+    if (capture.on_emergency && grant.type == CallType::EMERGENCY) {
+        iq_recorder_->trigger("emergency-" + talkgroup);
+        return;
     }
+    Priority priority = std::max(call_manager_->getTalkgroupPriority(grant.talkgroup), grant.priority);
+    if (capture.on_priority > 0 && priority >= capture.on_priority) {
+        iq_recorder_->trigger("priority-" + talkgroup);
+    }
+}
 
-    // TODO: Implement voice channel following
-    // For now, we just log the grant
+void TrunkController::checkCaptureTriggers(uint64_t now_ms) {
+    const CaptureConfig& capture = config_.capture;
+
+    for (size_t site = 0; site < groups_.size(); site++) {
+        CaptureWatch& watch = capture_watch_[site];
+        const ChannelGroup& group = *groups_[site];
+
+        bool locked = group.isLocked();
+        if (capture.on_sync_loss && watch.locked && !locked) {
+            iq_recorder_->trigger("sync_loss-site" + std::to_string(site));
+        }
+        watch.locked = locked;
+
+        if (capture.crc_errors == 0) {
+            continue;
+        }
+
+        // Counters start again when a decoder is reset
+        size_t errors = group.getCRCErrors();
+        if (errors < watch.crc_errors || now_ms - watch.window_start_ms >= capture.crc_window_ms) {
+            watch.crc_errors = errors;
+            watch.window_start_ms = now_ms;
+        } else if (errors - watch.crc_errors >= capture.crc_errors) {
+            iq_recorder_->trigger("crc_burst-site" + std::to_string(site));
+            watch.crc_errors = errors;
+            watch.window_start_ms = now_ms;
+        }
+    }
 }
 
 } // namespace TrunkSDR
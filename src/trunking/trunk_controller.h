@@ -2,16 +2,50 @@
 #define TRUNK_CONTROLLER_H
 
 #include "../utils/types.h"
+#include "../utils/config_parser.h"
 #include "../sdr/sdr_interface.h"
-#include "../dsp/demodulator.h"
-#include "../decoders/base_decoder.h"
+#include "../sdr/shared_iq_ring.h"
+#include "../sdr/iq_recorder.h"
+#include "../dsp/channelizer.h"
+#include "../codecs/codec_pool.h"
 #include "../audio/call_manager.h"
+#include "../net/decode_link.h"
+#include "channel_group.h"
+#include "simulcast_filter.h"
+#include "voice_receiver_pool.h"
+#include "receiver_scheduler.h"
 #include <memory>
 #include <atomic>
-#include <thread>
+#include <vector>
 
 namespace TrunkSDR {
 
+// Host for one SDR capture.
+//
+// Every configured system or site becomes a ChannelGroup decoded from the
+// same capture. The groups share one channelizer (and its worker threads),
+// one codec pool, one call manager and one pool of voice receivers. A
+// single system keeps the capture centred on its control channel and may
+// retune it; with several systems the capture stays put and every channel
+// must fall inside it. So does a capture read from another process
+// (sdr.source "shm:<stream>"), which this host cannot move.
+//
+// With sdr.publish set, the converted capture (and optionally every
+// channel's baseband) is published to shared memory for other processes.
+// With decode workers configured (distributed.workers), this host only
+// mixes channels down and the workers demodulate and decode them. With
+// capture.directory set, the last seconds of raw capture are kept in
+// memory and saved around events worth a look: a control channel losing
+// lock, a burst of CRC errors, an emergency or high-priority call.
+//
+// The channelizer runs every block in two stages: the groups, then the
+// voice receivers. Grants a group hears (repeats already dropped by its
+// recent-grant cache) are buffered per site without locking. Between the
+// stages the SDR thread passes them through a simulcast filter, so a call
+// announced by several sites of one network is followed once, and the
+// ReceiverScheduler leases receivers to the new calls by priority. A
+// receiver tuned there decodes the block the grant arrived in. Retunes
+// wait for the same point, so no channel moves while consumers are running.
 class TrunkController {
 public:
     TrunkController();
@@ -23,44 +57,104 @@ public:
 
     bool isRunning() const { return running_; }
 
-    // Tuning control
+    // Applies a reloaded configuration's talkgroup settings (enabled,
+    // priorities, labels, alias database) and receiver hold and preemption
+    // without stopping the capture or any channel: calls already followed
+    // carry on, new grants see the new settings. Other changes are
+    // reported and wait for a restart. Main thread.
+    bool reloadConfig(const Config& config);
+
+    // Recentre the capture; only while stopped or between blocks
     bool tuneToControlChannel(Frequency freq);
-    bool tuneToVoiceChannel(Frequency freq);
 
     // Get components
     CallManager* getCallManager() { return call_manager_.get(); }
+    size_t getChannelGroupCount() const { return groups_.size(); }
+    const ChannelGroup& getChannelGroup(size_t index) const { return *groups_[index]; }
+    const VoiceReceiverPool& getVoiceReceivers() const { return voice_pool_; }
+    ReceiverScheduler::Stats getSchedulerStats() const { return scheduler_.getStats(); }
+    uint64_t getSimulcastDuplicates() const { return simulcast_.getDuplicateCount(); }
+    const DecodeLink* getDecodeLink() const { return decode_link_.get(); }
+    const IQRecorder* getIQRecorder() const { return iq_recorder_.get(); }
 
 private:
-    void controlChannelThread();
-    void voiceChannelThread();
+    // Capture centre: the control channel of a single system, otherwise
+    // the configured centre or the middle of all control channels
+    Frequency captureCenter(const Config& config) const;
+
+    std::unique_ptr<SDRInterface> createSource(const SDRConfig& sdr) const;
+
+    // Stops every thread start() or initialize() set going; each part may
+    // be stopped already
+    void shutdown();
+    bool initializePublishing(const SDRConfig& sdr, uint32_t sample_rate);
 
-    void handleCallGrant(const CallGrant& grant);
+    // Group threads: leave work for the SDR thread
+    void submitGrant(size_t site, const CallGrant& grant);
+    bool requestRetune(Frequency freq);
 
-    Config config_;
+    // SDR thread, between the group and receiver stages
+    void schedulePending();
+    void checkCaptureTriggers(uint64_t now_ms);
+    void checkCallTrigger(const CallKey& call, const CallGrant& grant);
+
+    Config config_;                     // As started; reloads do not change it
+    ReceiverConfig applied_receivers_;  // Hold and preemption last applied
 
     // SDR resources
     std::unique_ptr<SDRInterface> control_sdr_;
-    std::unique_ptr<SDRInterface> voice_sdr_;  // Optional second SDR
+    bool tunable_;
+
+    // Capture published for other processes (sdr.publish)
+    std::unique_ptr<SharedIQPublisher> iq_publisher_;
+
+    // Raw IQ saved around events (capture.directory), and what each site
+    // looked like at the last check. SDR thread only.
+    struct CaptureWatch {
+        bool locked;
+        size_t crc_errors;          // At the start of the window
+        uint64_t window_start_ms;
+    };
+    std::unique_ptr<IQRecorder> iq_recorder_;
+    std::vector<CaptureWatch> capture_watch_;
+
+    // Call management, and vocoder synthesis off the SDR thread, whose
+    // audio goes to the call manager. Declared ahead of the groups and
+    // receivers so they are destroyed after them.
+    std::unique_ptr<CallManager> call_manager_;
+    std::unique_ptr<CodecPool> codec_pool_;
 
-    // DSP chain
-    std::unique_ptr<Demodulator> control_demod_;
-    std::unique_ptr<Demodulator> voice_demod_;
+    // Decode workers; outlives the groups, whose remote channels it carries
+    std::unique_ptr<DecodeLink> decode_link_;
 
-    // Protocol decoder
-    std::unique_ptr<BaseDecoder> protocol_decoder_;
+    // One group per configured system, fed by the channelizer
+    Channelizer channelizer_;
+    std::vector<std::unique_ptr<ChannelGroup>> groups_;
 
-    // Call management
-    std::unique_ptr<CallManager> call_manager_;
+    // Voice chains shared by every group, and who gets them
+    VoiceReceiverPool voice_pool_;
+    ReceiverScheduler scheduler_;
+
+    // Grants waiting for the receiver scheduler, one buffer per site so
+    // group threads never share one, and a pending recentre. Only touched
+    // by the owning group during the first stage and by the SDR thread
+    // between stages.
+    SimulcastFilter simulcast_;
+    std::vector<size_t> networks_;  // Per site: first site of its network
+    std::vector<std::vector<CallGrant>> pending_grants_;
+    Frequency pending_center_;
 
     // Threading
     std::atomic<bool> running_;
-    std::thread control_thread_;
-    std::thread voice_thread_;
+    uint64_t last_call_cleanup_ms_;   // SDR thread only
 
     // Current state
-    Frequency current_control_freq_;
-    Frequency current_voice_freq_;
-    std::atomic<bool> voice_active_;
+    Frequency center_freq_;           // SDR tuner frequency
+
+    // Grants one site can buffer in a block without reallocating
+    static constexpr size_t MAX_GRANTS_PER_BLOCK = 32;
+
+    static constexpr uint64_t CALL_CLEANUP_INTERVAL_MS = 1000;
 };
 
 } // namespace TrunkSDR
@@ -0,0 +1,224 @@
+#include "voice_receiver_pool.h"
+#include "../utils/logger.h"
+#include <algorithm>
+
+namespace TrunkSDR {
+
+VoiceReceiverPool::VoiceReceiverPool()
+    : sample_rate_(0)
+    , center_freq_(0)
+    , call_manager_(nullptr)
+    , codec_pool_(nullptr) {
+}
+
+VoiceReceiverPool::~VoiceReceiverPool() = default;
+
+bool VoiceReceiverPool::initialize(size_t count, uint32_t sample_rate, Frequency center_freq,
+                                   CallManager* call_manager, CodecPool* codec_pool) {
+    sample_rate_ = sample_rate;
+    center_freq_ = center_freq;
+    call_manager_ = call_manager;
+    codec_pool_ = codec_pool;
+
+    receivers_.clear();
+    for (size_t i = 0; i < count; i++) {
+        receivers_.push_back(std::make_unique<Receiver>());
+    }
+
+    LOG_INFO("Voice receiver pool:", count, "receiver(s)");
+    return true;
+}
+
+int VoiceReceiverPool::findCarrier(const ChannelGroup& group, const CallGrant& grant) const {
+    // Grants repeat for the duration of the call, and simulcast sites may
+    // put it on different frequencies; one receiver per call is enough
+    for (size_t i = 0; i < receivers_.size(); i++) {
+        const Receiver& receiver = *receivers_[i];
+        if (!receiver.active) {
+            continue;
+        }
+        CallKey call{group.getSite(), grant.talkgroup};
+        if (std::find(receiver.calls.begin(), receiver.calls.end(), call) != receiver.calls.end()) {
+            return static_cast<int>(i);
+        }
+        // The other timeslot of a carrier being followed is decoded
+        // without retuning
+        if (receiver.chain.frequency == grant.frequency &&
+            group.sharesVoiceChain(*receiver.owner)) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+void VoiceReceiverPool::addCall(size_t index, const ChannelGroup& group, const CallGrant& grant) {
+    // A call on the other timeslot may come from another site of the
+    // network than the one the receiver was tuned for
+    receivers_[index]->calls[slotIndex(grant.slot)] = CallKey{group.getSite(), grant.talkgroup};
+}
+
+size_t VoiceReceiverPool::slotIndex(uint8_t slot) {
+    return std::min<size_t>(slot, SLOTS - 1);
+}
+
+bool VoiceReceiverPool::isBuiltFor(size_t index, const ChannelGroup& group) const {
+    const Receiver& receiver = *receivers_[index];
+    return receiver.owner && group.sharesVoiceChain(*receiver.owner);
+}
+
+bool VoiceReceiverPool::tune(size_t index, const ChannelGroup& group, const CallGrant& grant) {
+    Receiver& receiver = *receivers_[index];
+
+    if (!group.inCapture(grant.frequency)) {
+        LOG_WARNING("Voice channel", grant.frequency, "Hz outside capture bandwidth, offset =",
+                    grant.frequency - center_freq_, "Hz");
+        return false;
+    }
+
+    if (!isBuiltFor(index, group)) {
+        if (!buildChain(receiver, group)) {
+            LOG_ERROR("Failed to build voice chain for", group.getSystem().name);
+            return false;
+        }
+    }
+    receiver.owner = &group;
+
+    ChannelReceiver& chain = receiver.chain;
+    receiver.calls.fill(CallKey{0, 0});
+    receiver.calls[slotIndex(grant.slot)] = CallKey{group.getSite(), grant.talkgroup};
+    chain.decoder->setVoiceTalkgroup(grant.talkgroup, grant.radio_id);
+
+    chain.ddc->setOffset(grant.frequency - center_freq_);
+    chain.ddc->reset();
+    chain.resetLevel();
+    chain.demod->reset();
+    chain.decoder->reset();
+
+    chain.frequency = grant.frequency;
+    receiver.idle_samples = 0;
+    receiver.active = true;
+
+    LOG_INFO("Tuned to voice channel:", grant.frequency, "Hz");
+    return true;
+}
+
+void VoiceReceiverPool::release(size_t index) {
+    release(*receivers_[index], false);
+}
+
+bool VoiceReceiverPool::buildChain(Receiver& receiver, const ChannelGroup& group) {
+    std::unique_ptr<SharedIQPublisher> tap = std::move(receiver.chain.tap);
+    receiver.chain = ChannelReceiver();
+    receiver.chain.tap = std::move(tap);
+    receiver.owner = nullptr;
+    if (!group.createVoiceChain(receiver.chain)) {
+        return false;
+    }
+
+    Receiver* target = &receiver;
+    receiver.chain.decoder->setVoiceFrameCallback(
+        [this, target](const VoiceFrameBatch& batch) {
+            // The slot's call, or else one the leasing site granted
+            CallKey& slot_call = target->calls[slotIndex(batch.slot)];
+            CallKey call{target->owner->getSite(), batch.talkgroup};
+            if (slot_call.talkgroup == batch.talkgroup) {
+                call = slot_call;
+            }
+
+            // The other timeslot may carry a call nobody asked for
+            if (!call_manager_->isCallActive(call)) {
+                return;
+            }
+            target->idle_samples = 0;
+            slot_call = call;
+            codec_pool_->submit(call.site, batch);
+        }
+    );
+
+    receiver.chain.decoder->setCallEndCallback(
+        [this, target](TalkgroupID talkgroup) {
+            // Keep the carrier while a call remains on another timeslot
+            bool remaining = false;
+            for (CallKey& call : target->calls) {
+                if (call.talkgroup != 0 && call.talkgroup == talkgroup) {
+                    call_manager_->endCall(call, target->chain.getLevel());
+                    codec_pool_->releaseCall(call);
+                    call = CallKey{0, 0};
+                }
+                remaining = remaining || call.talkgroup != 0;
+            }
+            if (!remaining) {
+                release(*target);
+            }
+        }
+    );
+    return true;
+}
+
+void VoiceReceiverPool::process(size_t index, const Complex* samples, size_t count) {
+    Receiver& receiver = *receivers_[index];
+    if (!receiver.active) {
+        return;
+    }
+
+    receiver.chain.process(samples, count);
+
+    // Give up on the channel after a second without voice frames
+    receiver.idle_samples += count;
+    if (receiver.active && receiver.idle_samples > sample_rate_) {
+        LOG_INFO("Voice channel idle, releasing:", receiver.chain.frequency, "Hz");
+        release(receiver);
+    }
+}
+
+void VoiceReceiverPool::release(Receiver& receiver, bool end_calls) {
+    if (receiver.active) {
+        for (const CallKey& call : receiver.calls) {
+            if (call.talkgroup != 0) {
+                if (end_calls) {
+                    call_manager_->endCall(call, receiver.chain.getLevel());
+                }
+                codec_pool_->releaseCall(call);
+            }
+        }
+    }
+    receiver.active = false;
+    receiver.calls.fill(CallKey{0, 0});
+    receiver.chain.frequency = 0;
+}
+
+bool VoiceReceiverPool::publishReceivers(const std::string& prefix) {
+    // Rate and frequency are filled in once a receiver is tuned
+    for (size_t i = 0; i < receivers_.size(); i++) {
+        auto tap = std::make_unique<SharedIQPublisher>();
+        if (!tap->initialize(prefix + std::to_string(i), SHARED_IQ_CHANNEL_SAMPLES, 0, 0)) {
+            return false;
+        }
+        receivers_[i]->chain.tap = std::move(tap);
+    }
+    return true;
+}
+
+void VoiceReceiverPool::releaseAll() {
+    for (auto& receiver : receivers_) {
+        release(*receiver);
+    }
+}
+
+void VoiceReceiverPool::setCenterFrequency(Frequency freq) {
+    // Retuning moves every channel in the capture
+    releaseAll();
+    center_freq_ = freq;
+}
+
+size_t VoiceReceiverPool::getActiveCount() const {
+    size_t active = 0;
+    for (const auto& receiver : receivers_) {
+        if (receiver->active) {
+            active++;
+        }
+    }
+    return active;
+}
+
+} // namespace TrunkSDR
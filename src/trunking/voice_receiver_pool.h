@@ -0,0 +1,96 @@
+#ifndef VOICE_RECEIVER_POOL_H
+#define VOICE_RECEIVER_POOL_H
+
+#include "../utils/types.h"
+#include "../codecs/codec_pool.h"
+#include "../audio/call_manager.h"
+#include "channel_group.h"
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace TrunkSDR {
+
+// Voice receivers shared by every channel group of a capture.
+//
+// A fixed number of narrowband chains follow granted calls for whichever
+// site asked. The demodulator and decoder of a receiver are built for the
+// group that leased it and kept while later leases come from groups of the
+// same network (the sites of one P25 system), so following a grant is a
+// retune rather than an allocation. Which call gets which receiver is up to
+// the ReceiverScheduler.
+//
+// tune(), release(), releaseAll() and setCenterFrequency() change receivers
+// and may only be called between blocks, while none is being processed.
+// process() runs on channelizer threads, one receiver per call; a receiver
+// releases itself there when its calls end or go quiet.
+class VoiceReceiverPool {
+public:
+    VoiceReceiverPool();
+    ~VoiceReceiverPool();
+
+    bool initialize(size_t count, uint32_t sample_rate, Frequency center_freq,
+                    CallManager* call_manager, CodecPool* codec_pool);
+
+    size_t size() const { return receivers_.size(); }
+
+    // Receiver already carrying the grant's call, or decoding the carrier
+    // it was granted (the other DMR timeslot); -1 when none is
+    int findCarrier(const ChannelGroup& group, const CallGrant& grant) const;
+
+    // The grant's call rides on a receiver findCarrier() returned
+    void addCall(size_t index, const ChannelGroup& group, const CallGrant& grant);
+
+    bool isActive(size_t index) const { return receivers_[index]->active; }
+
+    // The receiver's chain decodes the group's channels without a rebuild
+    bool isBuiltFor(size_t index, const ChannelGroup& group) const;
+
+    // Follow a grant on an idle receiver
+    bool tune(size_t index, const ChannelGroup& group, const CallGrant& grant);
+
+    // Stop following for a call of higher priority. The call stays active
+    // while it waits for another receiver; CallManager times it out once
+    // its grants stop.
+    void release(size_t index);
+
+    // Wideband samples for one receiver
+    void process(size_t index, const Complex* samples, size_t count);
+
+    // Publish each receiver's baseband as "<prefix><index>"
+    bool publishReceivers(const std::string& prefix);
+
+    // The capture moved; every receiver is released
+    void setCenterFrequency(Frequency freq);
+    void releaseAll();
+
+    size_t getActiveCount() const;
+
+private:
+    // FDMA, then TDMA slots 1 and 2
+    static constexpr size_t SLOTS = 3;
+
+    struct Receiver {
+        ChannelReceiver chain;
+        const ChannelGroup* owner = nullptr;     // Group the chain was built for
+        std::atomic<bool> active{false};
+        std::array<CallKey, SLOTS> calls{};       // Per TDMA slot (0 = FDMA)
+        size_t idle_samples = 0;
+    };
+
+    bool buildChain(Receiver& receiver, const ChannelGroup& group);
+    static size_t slotIndex(uint8_t slot);
+    // Calls still on the receiver are ended unless they are to resume
+    void release(Receiver& receiver, bool end_calls = true);
+
+    std::vector<std::unique_ptr<Receiver>> receivers_;
+    uint32_t sample_rate_;
+    Frequency center_freq_;
+    CallManager* call_manager_;
+    CodecPool* codec_pool_;
+};
+
+} // namespace TrunkSDR
+
+#endif // VOICE_RECEIVER_POOL_H
@@ -0,0 +1,343 @@
+#include "alias_db.h"
+#include "logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace TrunkSDR {
+
+namespace {
+
+inline uint64_t mix64(uint64_t x) {
+    // splitmix64 finalizer
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ull;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBull;
+    x ^= x >> 31;
+    return x;
+}
+
+// Maps a 32-bit hash onto [0, range) without a division
+inline uint32_t reduce(uint32_t hash, uint32_t range) {
+    return static_cast<uint32_t>((static_cast<uint64_t>(hash) * range) >> 32);
+}
+
+constexpr uint32_t KEYS_PER_BUCKET = 3;
+constexpr uint32_t MAX_DISPLACEMENT = 1u << 24;
+constexpr int MAX_SEEDS = 16;
+
+size_t align8(size_t value) {
+    return (value + 7) & ~static_cast<size_t>(7);
+}
+
+} // anonymous namespace
+
+uint32_t AliasDB::bucketOf(uint32_t id, uint64_t seed, uint32_t buckets) {
+    return reduce(static_cast<uint32_t>(mix64(id ^ seed) >> 32), buckets);
+}
+
+uint32_t AliasDB::slotOf(uint32_t id, uint64_t seed, uint32_t displacement, uint32_t count) {
+    uint64_t key = (static_cast<uint64_t>(displacement) << 32) | id;
+    return reduce(static_cast<uint32_t>(mix64(key ^ ~seed)), count);
+}
+
+AliasDB::AliasDB()
+    : mapping_(nullptr)
+    , mapping_bytes_(0)
+    , header_(nullptr) {
+}
+
+AliasDB::~AliasDB() {
+    close();
+}
+
+bool AliasDB::open(const std::string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOG_ERROR("Failed to open alias database", path, ":", std::strerror(errno));
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(AliasDBHeader)) {
+        LOG_ERROR("Not an alias database:", path);
+        ::close(fd);
+        return false;
+    }
+
+    mapping_bytes_ = info.st_size;
+    identity_ = identityOf(info);
+    void* mapping = mmap(nullptr, mapping_bytes_, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        LOG_ERROR("Failed to map alias database", path, ":", std::strerror(errno));
+        mapping_bytes_ = 0;
+        return false;
+    }
+    mapping_ = static_cast<const uint8_t*>(mapping);
+    header_ = reinterpret_cast<const AliasDBHeader*>(mapping_);
+
+    bool valid = header_->magic == ALIAS_DB_MAGIC && header_->version == ALIAS_DB_VERSION &&
+                 header_->file_bytes == mapping_bytes_ &&
+                 header_->names <= mapping_bytes_ && header_->names_bytes > 0 &&
+                 header_->names_bytes <= mapping_bytes_ - header_->names &&
+                 mapping_[header_->names + header_->names_bytes - 1] == '\0' &&
+                 validTable(header_->talkgroups) && validTable(header_->radios);
+    if (!valid) {
+        LOG_ERROR("Not an alias database of this version:", path);
+        close();
+        return false;
+    }
+
+    path_ = path;
+    LOG_INFO("Alias database:", path, "(", header_->talkgroups.count, "talkgroups,",
+             header_->radios.count, "radios )");
+    return true;
+}
+
+bool AliasDB::validTable(const AliasDBTable& table) const {
+    if (table.count == 0) {
+        return true;
+    }
+    return table.buckets > 0 &&
+           table.displacements % alignof(uint32_t) == 0 &&
+           table.displacements <= mapping_bytes_ &&
+           table.buckets * sizeof(uint32_t) <= mapping_bytes_ - table.displacements &&
+           table.entries % alignof(AliasDBEntry) == 0 &&
+           table.entries <= mapping_bytes_ &&
+           table.count * sizeof(AliasDBEntry) <= mapping_bytes_ - table.entries;
+}
+
+void AliasDB::close() {
+    if (mapping_) {
+        munmap(const_cast<uint8_t*>(mapping_), mapping_bytes_);
+    }
+    mapping_ = nullptr;
+    mapping_bytes_ = 0;
+    header_ = nullptr;
+    path_.clear();
+    identity_ = FileIdentity();
+}
+
+AliasDB::FileIdentity AliasDB::identityOf(const struct stat& info) {
+    FileIdentity identity;
+    identity.device = static_cast<uint64_t>(info.st_dev);
+    identity.inode = static_cast<uint64_t>(info.st_ino);
+    identity.mtime_ns = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+    identity.size = info.st_size;
+    return identity;
+}
+
+bool AliasDB::isSameFile(const std::string& path) const {
+    if (!header_ || path != path_) {
+        return false;
+    }
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 && identityOf(info) == identity_;
+}
+
+const char* AliasDB::lookup(const AliasDBTable* table, uint32_t id) const {
+    if (!table || table->count == 0) {
+        return nullptr;
+    }
+
+    const uint32_t* displacements = reinterpret_cast<const uint32_t*>(mapping_ + table->displacements);
+    const AliasDBEntry* entries = reinterpret_cast<const AliasDBEntry*>(mapping_ + table->entries);
+
+    uint32_t displacement = displacements[bucketOf(id, table->seed, table->buckets)];
+    const AliasDBEntry& entry = entries[slotOf(id, table->seed, displacement, table->count)];
+    if (entry.id != id || entry.name >= header_->names_bytes) {
+        return nullptr;
+    }
+    return reinterpret_cast<const char*>(mapping_ + header_->names + entry.name);
+}
+
+void AliasDBBuilder::addTalkgroup(TalkgroupID talkgroup, const std::string& name) {
+    talkgroups_.push_back({talkgroup, name});
+}
+
+void AliasDBBuilder::addRadio(RadioID radio, const std::string& name) {
+    radios_.push_back({radio, name});
+}
+
+void AliasDBBuilder::deduplicate(std::vector<Alias>& aliases) {
+    // Last name given for an ID wins
+    std::stable_sort(aliases.begin(), aliases.end(),
+                     [](const Alias& a, const Alias& b) { return a.id < b.id; });
+    std::vector<Alias> unique;
+    unique.reserve(aliases.size());
+    for (size_t i = 0; i < aliases.size(); i++) {
+        if (i + 1 < aliases.size() && aliases[i + 1].id == aliases[i].id) {
+            continue;
+        }
+        unique.push_back(std::move(aliases[i]));
+    }
+    aliases.swap(unique);
+}
+
+bool AliasDBBuilder::buildTable(std::vector<Alias>& aliases, BuiltTable& built,
+                                std::vector<char>& names) {
+    deduplicate(aliases);
+
+    AliasDBTable& table = built.table;
+    table = AliasDBTable();
+    table.count = static_cast<uint32_t>(aliases.size());
+    if (aliases.empty()) {
+        built.displacements.clear();
+        built.entries.clear();
+        return true;
+    }
+    table.buckets = std::max<uint32_t>(1, table.count / KEYS_PER_BUCKET);
+
+    for (int attempt = 0; attempt < MAX_SEEDS; attempt++) {
+        table.seed = mix64(0x5441534144ull + attempt);
+
+        std::vector<std::vector<uint32_t>> buckets(table.buckets);
+        for (uint32_t i = 0; i < table.count; i++) {
+            buckets[AliasDB::bucketOf(aliases[i].id, table.seed, table.buckets)].push_back(i);
+        }
+
+        // Fullest buckets first, while most slots are free
+        std::vector<uint32_t> order(table.buckets);
+        for (uint32_t b = 0; b < table.buckets; b++) {
+            order[b] = b;
+        }
+        std::stable_sort(order.begin(), order.end(), [&buckets](uint32_t a, uint32_t b) {
+            return buckets[a].size() > buckets[b].size();
+        });
+
+        built.displacements.assign(table.buckets, 0);
+        std::vector<int64_t> owner(table.count, -1);
+        std::vector<uint32_t> slots;
+        bool placed = true;
+        for (uint32_t b : order) {
+            const std::vector<uint32_t>& members = buckets[b];
+            if (members.empty()) {
+                break;
+            }
+
+            bool found = false;
+            for (uint32_t d = 0; d < MAX_DISPLACEMENT && !found; d++) {
+                slots.clear();
+                found = true;
+                for (uint32_t member : members) {
+                    uint32_t slot = AliasDB::slotOf(aliases[member].id, table.seed, d, table.count);
+                    if (owner[slot] >= 0 || std::find(slots.begin(), slots.end(), slot) != slots.end()) {
+                        found = false;
+                        break;
+                    }
+                    slots.push_back(slot);
+                }
+                if (found) {
+                    built.displacements[b] = d;
+                    for (size_t k = 0; k < members.size(); k++) {
+                        owner[slots[k]] = members[k];
+                    }
+                }
+            }
+            if (!found) {
+                placed = false;
+                break;
+            }
+        }
+        if (!placed) {
+            continue;
+        }
+
+        built.entries.resize(table.count);
+        for (uint32_t slot = 0; slot < table.count; slot++) {
+            const Alias& alias = aliases[owner[slot]];
+            built.entries[slot].id = alias.id;
+            built.entries[slot].name = static_cast<uint32_t>(names.size());
+            names.insert(names.end(), alias.name.begin(), alias.name.end());
+            names.push_back('\0');
+        }
+        return true;
+    }
+
+    LOG_ERROR("Failed to build a perfect hash for", table.count, "aliases");
+    return false;
+}
+
+bool AliasDBBuilder::write(const std::string& path) {
+    // Offset 0 is an empty name, so the area is never empty
+    std::vector<char> names(1, '\0');
+    BuiltTable talkgroups;
+    BuiltTable radios;
+    if (!buildTable(talkgroups_, talkgroups, names) || !buildTable(radios_, radios, names)) {
+        return false;
+    }
+    if (names.size() > UINT32_MAX) {
+        LOG_ERROR("Alias names exceed 4 GB");
+        return false;
+    }
+
+    AliasDBHeader header = AliasDBHeader();
+    header.magic = ALIAS_DB_MAGIC;
+    header.version = ALIAS_DB_VERSION;
+
+    size_t offset = align8(sizeof(header));
+    auto place = [&offset](BuiltTable& built) {
+        built.table.displacements = offset;
+        offset = align8(offset + built.displacements.size() * sizeof(uint32_t));
+        built.table.entries = offset;
+        offset = align8(offset + built.entries.size() * sizeof(AliasDBEntry));
+    };
+    place(talkgroups);
+    place(radios);
+    header.talkgroups = talkgroups.table;
+    header.radios = radios.table;
+    header.names = offset;
+    header.names_bytes = names.size();
+    header.file_bytes = offset + names.size();
+
+    // Write beside the database and rename so readers never map half a file
+    std::string temp_path = path + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            LOG_ERROR("Failed to write alias database", temp_path);
+            return false;
+        }
+        auto pad = [&file]() {
+            static const char zeros[8] = {};
+            file.write(zeros, align8(file.tellp()) - static_cast<size_t>(file.tellp()));
+        };
+        auto put = [&file, &pad](const BuiltTable& built) {
+            file.write(reinterpret_cast<const char*>(built.displacements.data()),
+                       built.displacements.size() * sizeof(uint32_t));
+            pad();
+            file.write(reinterpret_cast<const char*>(built.entries.data()),
+                       built.entries.size() * sizeof(AliasDBEntry));
+            pad();
+        };
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        pad();
+        put(talkgroups);
+        put(radios);
+        file.write(names.data(), names.size());
+        if (!file) {
+            LOG_ERROR("Failed to write alias database", temp_path);
+            return false;
+        }
+    }
+
+    // Readers that have the old file mapped keep it until they reopen
+    if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        LOG_ERROR("Failed to replace alias database", path);
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+} // namespace TrunkSDR
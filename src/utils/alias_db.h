@@ -0,0 +1,141 @@
+#ifndef ALIAS_DB_H
+#define ALIAS_DB_H
+
+#include "types.h"
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+namespace TrunkSDR {
+
+// Compiled talkgroup and radio ID aliases (alias_db_build).
+//
+// The file is mapped read-only, so opening it costs nothing however many
+// IDs it names and every process using it shares one copy. Each table is
+// indexed by a minimal perfect hash (hash and displace): the ID picks a
+// bucket, the bucket's displacement picks the one slot its ID can be in.
+// A lookup reads the displacement, the slot and the name: two or three
+// cache lines, no probing. IDs not in the table land on some other ID's
+// slot and are told apart by the ID stored there.
+//
+// Layout (host byte order): AliasDBHeader, then per table the
+// displacements (uint32 per bucket) and entries, then the names,
+// NUL-terminated.
+struct AliasDBTable {
+    uint32_t count;             // Entries, also the number of slots
+    uint32_t buckets;
+    uint64_t seed;
+    uint64_t displacements;     // File offset of uint32_t[buckets]
+    uint64_t entries;           // File offset of AliasDBEntry[count]
+};
+
+struct AliasDBEntry {
+    uint32_t id;
+    uint32_t name;              // Offset into the name area
+};
+
+struct AliasDBHeader {
+    uint32_t magic;
+    uint32_t version;
+    AliasDBTable talkgroups;
+    AliasDBTable radios;
+    uint64_t names;             // File offset of the name area
+    uint64_t names_bytes;
+    uint64_t file_bytes;
+};
+
+constexpr uint32_t ALIAS_DB_MAGIC = 0x44415354;    // "TSAD"
+constexpr uint32_t ALIAS_DB_VERSION = 1;
+
+class AliasDB {
+public:
+    AliasDB();
+    ~AliasDB();
+
+    AliasDB(const AliasDB&) = delete;
+    AliasDB& operator=(const AliasDB&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return header_ != nullptr; }
+
+    // True while 'path' still names the file that is mapped: same path,
+    // same inode, size and modification time. alias_db_build replaces the
+    // file by rename, so a rebuild always shows up as a new inode.
+    bool isSameFile(const std::string& path) const;
+
+    // nullptr when the ID has no alias; valid while the database is open
+    const char* getTalkgroupAlias(TalkgroupID talkgroup) const {
+        return lookup(header_ ? &header_->talkgroups : nullptr, talkgroup);
+    }
+    const char* getRadioAlias(RadioID radio) const {
+        return lookup(header_ ? &header_->radios : nullptr, radio);
+    }
+
+    size_t getTalkgroupCount() const { return header_ ? header_->talkgroups.count : 0; }
+    size_t getRadioCount() const { return header_ ? header_->radios.count : 0; }
+
+    // Hashes shared with the builder
+    static uint32_t bucketOf(uint32_t id, uint64_t seed, uint32_t buckets);
+    static uint32_t slotOf(uint32_t id, uint64_t seed, uint32_t displacement, uint32_t count);
+
+private:
+    const char* lookup(const AliasDBTable* table, uint32_t id) const;
+    bool validTable(const AliasDBTable& table) const;
+
+    // Identity of the mapped file
+    struct FileIdentity {
+        uint64_t device = 0;
+        uint64_t inode = 0;
+        int64_t mtime_ns = 0;
+        int64_t size = 0;
+
+        bool operator==(const FileIdentity& other) const {
+            return device == other.device && inode == other.inode &&
+                   mtime_ns == other.mtime_ns && size == other.size;
+        }
+    };
+
+    static FileIdentity identityOf(const struct stat& info);
+
+    const uint8_t* mapping_;
+    size_t mapping_bytes_;
+    const AliasDBHeader* header_;
+    std::string path_;
+    FileIdentity identity_;
+};
+
+// Compiles aliases into an AliasDB file
+class AliasDBBuilder {
+public:
+    // A repeated ID replaces the earlier name
+    void addTalkgroup(TalkgroupID talkgroup, const std::string& name);
+    void addRadio(RadioID radio, const std::string& name);
+
+    size_t getTalkgroupCount() const { return talkgroups_.size(); }
+    size_t getRadioCount() const { return radios_.size(); }
+
+    bool write(const std::string& path);
+
+private:
+    struct Alias {
+        uint32_t id;
+        std::string name;
+    };
+
+    struct BuiltTable {
+        AliasDBTable table;
+        std::vector<uint32_t> displacements;
+        std::vector<AliasDBEntry> entries;
+    };
+
+    static void deduplicate(std::vector<Alias>& aliases);
+    bool buildTable(std::vector<Alias>& aliases, BuiltTable& built, std::vector<char>& names);
+
+    std::vector<Alias> talkgroups_;
+    std::vector<Alias> radios_;
+};
+
+} // namespace TrunkSDR
+
+#endif // ALIAS_DB_H
@@ -0,0 +1,73 @@
+#ifndef BIT_BUFFER_H
+#define BIT_BUFFER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace TrunkSDR {
+
+// Fixed-capacity bit buffer, packed MSB first.
+//
+// Frame assemblers push demodulated bits into one of these instead of a
+// std::deque<uint8_t>: eight bits per byte, no allocation, and multi-bit
+// fields are read directly with getBits().
+template <size_t MaxBits>
+class PackedBitBuffer {
+public:
+    PackedBitBuffer() : size_(0) { bytes_.fill(0); }
+
+    void clear() {
+        bytes_.fill(0);
+        size_ = 0;
+    }
+
+    size_t size() const { return size_; }
+    bool full() const { return size_ == MaxBits; }
+    static constexpr size_t capacity() { return MaxBits; }
+
+    // Append one bit; ignored when full
+    void push(uint8_t bit) {
+        if (size_ < MaxBits) {
+            set(size_++, bit);
+        }
+    }
+
+    // Append the two bits of a dibit, MSB first
+    void pushDibit(uint8_t dibit) {
+        push((dibit >> 1) & 1);
+        push(dibit & 1);
+    }
+
+    uint8_t get(size_t index) const {
+        return (bytes_[index / 8] >> (7 - (index % 8))) & 1;
+    }
+
+    void set(size_t index, uint8_t bit) {
+        uint8_t mask = static_cast<uint8_t>(0x80 >> (index % 8));
+        if (bit & 1) {
+            bytes_[index / 8] |= mask;
+        } else {
+            bytes_[index / 8] &= static_cast<uint8_t>(~mask);
+        }
+    }
+
+    // Read up to 64 bits starting at 'start', MSB first
+    uint64_t getBits(size_t start, size_t count) const {
+        uint64_t value = 0;
+        for (size_t i = 0; i < count; i++) {
+            value = (value << 1) | get(start + i);
+        }
+        return value;
+    }
+
+    const uint8_t* data() const { return bytes_.data(); }
+
+private:
+    std::array<uint8_t, (MaxBits + 7) / 8> bytes_;
+    size_t size_;
+};
+
+} // namespace TrunkSDR
+
+#endif // BIT_BUFFER_H
@@ -0,0 +1,348 @@
+#include "config_cache.h"
+#include "logger.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+
+namespace TrunkSDR {
+
+namespace {
+
+size_t align8(size_t value) {
+    return (value + 7) & ~static_cast<size_t>(7);
+}
+
+// Field lists shared by the encoder and the decoder, so the two cannot
+// drift apart. New fields go at the end, with a CONFIG_CACHE_VERSION bump.
+template <typename Archive>
+void visit(Archive& ar, SDRConfig& sdr) {
+    ar(sdr.device_index, sdr.sample_rate, sdr.gain, sdr.ppm_correction, sdr.auto_gain,
+       sdr.center_frequency, sdr.dsp_threads, sdr.source, sdr.publish, sdr.publish_channels);
+}
+
+template <typename Archive>
+void visit(Archive& ar, SystemInfo& system) {
+    ar(system.type, system.system_id, system.nac, system.wacn, system.control_channels,
+       system.name, system.color_code, system.trunking, system.channels, system.symbol_rate,
+       system.bandplan, system.bandplan_base, system.bandplan_spacing, system.bandplan_offset,
+       system.site_cache_file, system.traffic_carriers, system.network);
+}
+
+template <typename Archive>
+void visit(Archive& ar, AudioConfig& audio) {
+    ar(audio.output_device, audio.codec, audio.sample_rate, audio.record_calls,
+       audio.recording_path, audio.codec_threads, audio.call_log);
+}
+
+template <typename Archive>
+void visit(Archive& ar, ReceiverConfig& receivers) {
+    ar(receivers.voice_receivers, receivers.simulcast_window_ms, receivers.hold_time_ms,
+       receivers.preempt_priority);
+}
+
+template <typename Archive>
+void visit(Archive& ar, DistributedConfig& distributed) {
+    ar(distributed.workers, distributed.sample_format);
+}
+
+template <typename Archive>
+void visit(Archive& ar, CaptureConfig& capture) {
+    ar(capture.directory, capture.format, capture.pre_trigger_ms, capture.post_trigger_ms,
+       capture.max_capture_ms, capture.on_sync_loss, capture.on_emergency, capture.on_priority,
+       capture.crc_errors, capture.crc_window_ms);
+}
+
+template <typename Archive>
+void visit(Archive& ar, TalkgroupConfig& talkgroups) {
+    ar(talkgroups.enabled, talkgroups.priorities, talkgroups.labels, talkgroups.alias_db);
+}
+
+template <typename Archive>
+void visit(Archive& ar, Config& config) {
+    ar(config.sdr, config.system, config.systems, config.audio, config.receivers,
+       config.distributed, config.capture, config.talkgroups);
+}
+
+class Encoder {
+public:
+    template <typename... T>
+    void operator()(T&... values) {
+        (put(values), ...);
+    }
+
+    std::vector<uint8_t> bytes;
+
+private:
+    template <typename T>
+    void put(T& value) {
+        if constexpr (std::is_arithmetic<T>::value || std::is_enum<T>::value) {
+            const uint8_t* raw = reinterpret_cast<const uint8_t*>(&value);
+            bytes.insert(bytes.end(), raw, raw + sizeof(T));
+        } else {
+            visit(*this, value);
+        }
+    }
+
+    void put(std::string& value) {
+        uint32_t size = value.size();
+        put(size);
+        bytes.insert(bytes.end(), value.begin(), value.end());
+    }
+
+    template <typename T>
+    void put(std::vector<T>& values) {
+        uint32_t size = values.size();
+        put(size);
+        for (T& value : values) {
+            put(value);
+        }
+    }
+
+    template <typename K, typename V>
+    void put(std::map<K, V>& values) {
+        uint32_t size = values.size();
+        put(size);
+        for (auto& entry : values) {
+            K key = entry.first;
+            put(key);
+            put(entry.second);
+        }
+    }
+};
+
+// Reads what Encoder wrote; any overrun clears ok and stops reading
+class Decoder {
+public:
+    Decoder(const uint8_t* data, size_t size)
+        : ok(true)
+        , data_(data)
+        , end_(data + size) {
+    }
+
+    template <typename... T>
+    void operator()(T&... values) {
+        (get(values), ...);
+    }
+
+    bool finished() const { return ok && data_ == end_; }
+
+    bool ok;
+
+private:
+    bool take(void* out, size_t size) {
+        if (!ok || static_cast<size_t>(end_ - data_) < size) {
+            ok = false;
+            return false;
+        }
+        std::memcpy(out, data_, size);
+        data_ += size;
+        return true;
+    }
+
+    template <typename T>
+    void get(T& value) {
+        if constexpr (std::is_arithmetic<T>::value || std::is_enum<T>::value) {
+            take(&value, sizeof(T));
+        } else {
+            visit(*this, value);
+        }
+    }
+
+    void get(std::string& value) {
+        uint32_t size = 0;
+        if (!take(&size, sizeof(size)) || static_cast<size_t>(end_ - data_) < size) {
+            ok = false;
+            return;
+        }
+        value.assign(reinterpret_cast<const char*>(data_), size);
+        data_ += size;
+    }
+
+    template <typename T>
+    void get(std::vector<T>& values) {
+        uint32_t size = 0;
+        // Every element takes at least a byte, which bounds the allocation
+        if (!take(&size, sizeof(size)) || static_cast<size_t>(end_ - data_) < size) {
+            ok = false;
+            return;
+        }
+        values.assign(size, T());
+        for (T& value : values) {
+            get(value);
+        }
+    }
+
+    template <typename K, typename V>
+    void get(std::map<K, V>& values) {
+        uint32_t size = 0;
+        take(&size, sizeof(size));
+        values.clear();
+        for (uint32_t i = 0; i < size && ok; i++) {
+            K key = K();
+            V value = V();
+            get(key);
+            get(value);
+            values[key] = std::move(value);
+        }
+    }
+
+    const uint8_t* data_;
+    const uint8_t* end_;
+};
+
+bool validFilters(const ConfigCacheHeader& header, const uint8_t* file) {
+    if (header.filters % alignof(ConfigCacheFilter) != 0 || header.filters > header.file_bytes ||
+        header.filter_count * sizeof(ConfigCacheFilter) > header.file_bytes - header.filters) {
+        return false;
+    }
+    const ConfigCacheFilter* filters = reinterpret_cast<const ConfigCacheFilter*>(file + header.filters);
+    for (uint32_t i = 0; i < header.filter_count; i++) {
+        if (filters[i].taps % alignof(float) != 0 || filters[i].taps > header.file_bytes ||
+            filters[i].num_taps * sizeof(float) > header.file_bytes - filters[i].taps) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+uint64_t ConfigCache::hash(const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+bool ConfigCache::load(const std::string& path, const std::string& source,
+                       Config& config, std::vector<FilterDesign>& filters) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(ConfigCacheHeader)) {
+        ::close(fd);
+        return false;
+    }
+
+    size_t file_bytes = info.st_size;
+    void* mapping = mmap(nullptr, file_bytes, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        LOG_WARNING("Failed to map config cache", path, ":", std::strerror(errno));
+        return false;
+    }
+    const uint8_t* file = static_cast<const uint8_t*>(mapping);
+    const ConfigCacheHeader& header = *reinterpret_cast<const ConfigCacheHeader*>(file);
+
+    bool loaded = false;
+    if (header.magic != CONFIG_CACHE_MAGIC || header.version != CONFIG_CACHE_VERSION ||
+        header.file_bytes != file_bytes) {
+        LOG_INFO("Config cache", path, "is from another version, rebuilding");
+    } else if (header.source_bytes != source.size() ||
+               header.source_hash != hash(source.data(), source.size())) {
+        LOG_INFO("Configuration changed since", path, "was built, rebuilding");
+    } else if (header.checksum != hash(file + sizeof(header), file_bytes - sizeof(header)) ||
+               header.config > file_bytes || header.config_bytes > file_bytes - header.config ||
+               !validFilters(header, file)) {
+        LOG_WARNING("Config cache", path, "is corrupt, rebuilding");
+    } else {
+        Config decoded;
+        Decoder decoder(file + header.config, header.config_bytes);
+        visit(decoder, decoded);
+        if (!decoder.finished() || decoded.systems.empty()) {
+            LOG_WARNING("Config cache", path, "does not decode, rebuilding");
+        } else {
+            const ConfigCacheFilter* table =
+                reinterpret_cast<const ConfigCacheFilter*>(file + header.filters);
+            filters.clear();
+            for (uint32_t i = 0; i < header.filter_count; i++) {
+                const float* taps = reinterpret_cast<const float*>(file + table[i].taps);
+                filters.push_back({table[i].sample_rate, table[i].cutoff,
+                                   std::vector<float>(taps, taps + table[i].num_taps)});
+            }
+            config = std::move(decoded);
+            loaded = true;
+        }
+    }
+
+    munmap(mapping, file_bytes);
+    return loaded;
+}
+
+bool ConfigCache::store(const std::string& path, const std::string& source,
+                        const Config& config, const std::vector<FilterDesign>& filters) {
+    Encoder encoder;
+    // The encoder only reads; the field lists are shared with the decoder
+    visit(encoder, const_cast<Config&>(config));
+
+    ConfigCacheHeader header = ConfigCacheHeader();
+    header.magic = CONFIG_CACHE_MAGIC;
+    header.version = CONFIG_CACHE_VERSION;
+    header.source_bytes = source.size();
+    header.source_hash = hash(source.data(), source.size());
+    header.config = align8(sizeof(header));
+    header.config_bytes = encoder.bytes.size();
+    header.filters = align8(header.config + header.config_bytes);
+    header.filter_count = filters.size();
+
+    std::vector<ConfigCacheFilter> table(filters.size());
+    size_t offset = align8(header.filters + table.size() * sizeof(ConfigCacheFilter));
+    for (size_t i = 0; i < filters.size(); i++) {
+        table[i].sample_rate = filters[i].sample_rate;
+        table[i].cutoff = filters[i].cutoff;
+        table[i].taps = offset;
+        table[i].num_taps = filters[i].taps.size();
+        offset = align8(offset + filters[i].taps.size() * sizeof(float));
+    }
+    header.file_bytes = offset;
+
+    // Assembled in memory so the checksum can go in the header
+    std::vector<uint8_t> file(header.file_bytes, 0);
+    std::memcpy(file.data() + header.config, encoder.bytes.data(), encoder.bytes.size());
+    std::memcpy(file.data() + header.filters, table.data(), table.size() * sizeof(ConfigCacheFilter));
+    for (size_t i = 0; i < filters.size(); i++) {
+        std::memcpy(file.data() + table[i].taps, filters[i].taps.data(),
+                    filters[i].taps.size() * sizeof(float));
+    }
+    header.checksum = hash(file.data() + sizeof(header), file.size() - sizeof(header));
+    std::memcpy(file.data(), &header, sizeof(header));
+
+    // Write beside the cache and rename so a crash never leaves half of one
+    std::string temp_path = path + ".tmp";
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            LOG_WARNING("Failed to write config cache", temp_path);
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(file.data()), file.size());
+        if (!out) {
+            LOG_WARNING("Failed to write config cache", temp_path);
+            std::remove(temp_path.c_str());
+            return false;
+        }
+    }
+
+    if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        LOG_WARNING("Failed to replace config cache", path);
+        std::remove(temp_path.c_str());
+        return false;
+    }
+
+    LOG_INFO("Config cache written:", path, "(", filters.size(), "filter designs )");
+    return true;
+}
+
+} // namespace TrunkSDR
@@ -0,0 +1,64 @@
+#ifndef CONFIG_CACHE_H
+#define CONFIG_CACHE_H
+
+#include "config_parser.h"
+#include <string>
+#include <vector>
+
+namespace TrunkSDR {
+
+// Compiled form of a JSON configuration, so a restart skips parsing it
+// and designing the channel filters.
+//
+// The cache remembers the size and FNV-1a hash of the JSON it was built
+// from and is used only while the JSON is byte for byte the same. It is
+// mapped read-only and checked (magic, version, checksum over the body)
+// before anything is taken from it; any mismatch falls back to the JSON.
+//
+// Layout (host byte order): ConfigCacheHeader, the encoded Config, the
+// filter table (ConfigCacheFilter per design), then the taps as floats,
+// each section 8-byte aligned.
+struct ConfigCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t source_bytes;      // JSON the cache was compiled from
+    uint64_t source_hash;
+    uint64_t config;            // File offset of the encoded Config
+    uint64_t config_bytes;
+    uint64_t filters;           // File offset of ConfigCacheFilter[filter_count]
+    uint32_t filter_count;
+    uint32_t reserved;
+    uint64_t file_bytes;
+    uint64_t checksum;          // FNV-1a over everything after the header
+};
+
+struct ConfigCacheFilter {
+    uint32_t sample_rate;
+    float cutoff;
+    uint64_t taps;              // File offset of float[num_taps]
+    uint32_t num_taps;
+    uint32_t reserved;
+};
+
+constexpr uint32_t CONFIG_CACHE_MAGIC = 0x43435354;    // "TSCC"
+
+// Bump whenever Config gains or loses a field, or the filter design
+// changes
+constexpr uint32_t CONFIG_CACHE_VERSION = 3;
+
+class ConfigCache {
+public:
+    // False (and config untouched) unless path holds a valid cache of
+    // exactly this JSON
+    static bool load(const std::string& path, const std::string& source,
+                     Config& config, std::vector<FilterDesign>& filters);
+
+    static bool store(const std::string& path, const std::string& source,
+                      const Config& config, const std::vector<FilterDesign>& filters);
+
+    static uint64_t hash(const void* data, size_t size);
+};
+
+} // namespace TrunkSDR
+
+#endif // CONFIG_CACHE_H
@@ -1,11 +1,15 @@
 #include "config_parser.h"
+#include "config_cache.h"
 #include "logger.h"
+#include <chrono>
 #include <fstream>
 #include <sstream>
 
 namespace TrunkSDR {
 
-bool ConfigParser::loadFromFile(const std::string& filename) {
+bool ConfigParser::loadFromFile(const std::string& filename, const std::string& cache_file) {
+    auto start = std::chrono::steady_clock::now();
+
     std::ifstream file(filename);
     if (!file.is_open()) {
         LOG_ERROR("Failed to open config file:", filename);
@@ -14,8 +18,40 @@ bool ConfigParser::loadFromFile(const std::string& filename) {
 
     std::stringstream buffer;
     buffer << file.rdbuf();
+    source_ = buffer.str();
+    cache_file_ = cache_file;
+    cached_filters_.clear();
+    from_cache_ = false;
+
+    auto elapsed_us = [&start]() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    };
+
+    if (!cache_file_.empty() && ConfigCache::load(cache_file_, source_, config_, cached_filters_)) {
+        from_cache_ = true;
+        LOG_INFO("Configuration loaded from cache", cache_file_, "in", elapsed_us(), "us (",
+                 config_.systems.size(), "system(s),", cached_filters_.size(), "filter designs )");
+        return true;
+    }
 
-    return loadFromString(buffer.str());
+    if (!loadFromString(source_)) {
+        return false;
+    }
+    LOG_INFO("Configuration parsed in", elapsed_us(), "us");
+    return true;
+}
+
+bool ConfigParser::saveCache(const std::vector<FilterDesign>& filters) {
+    if (cache_file_.empty() || (from_cache_ && filters.size() <= cached_filters_.size())) {
+        return true;
+    }
+    if (!ConfigCache::store(cache_file_, source_, config_, filters)) {
+        return false;
+    }
+    from_cache_ = true;
+    cached_filters_ = filters;
+    return true;
 }
 
 bool ConfigParser::loadFromString(const std::string& json_str) {
@@ -37,14 +73,42 @@ bool ConfigParser::parseJSON(const Json::Value& root) {
         return false;
     }
 
-    if (!parseSystemConfig(root["system"])) {
-        return false;
+    // One "system", or a "systems" list decoded from the same capture
+    config_.systems.clear();
+    const Json::Value& systems = root["systems"];
+    if (systems.isArray() && !systems.empty()) {
+        for (const auto& system_node : systems) {
+            SystemInfo system;
+            if (!parseSystemConfig(system_node, system)) {
+                return false;
+            }
+            config_.systems.push_back(system);
+        }
+    } else {
+        SystemInfo system;
+        if (!parseSystemConfig(root["system"], system)) {
+            return false;
+        }
+        config_.systems.push_back(system);
     }
+    config_.system = config_.systems.front();
 
     if (!parseAudioConfig(root["audio"])) {
         return false;
     }
 
+    if (!parseReceiverConfig(root["receivers"])) {
+        return false;
+    }
+
+    if (!parseDistributedConfig(root["distributed"])) {
+        return false;
+    }
+
+    if (!parseCaptureConfig(root["capture"])) {
+        return false;
+    }
+
     if (!parseTalkgroupConfig(root["talkgroups"])) {
         return false;
     }
@@ -61,6 +125,11 @@ bool ConfigParser::parseSDRConfig(const Json::Value& sdr_node) {
     config_.sdr.device_index = sdr_node.get("device_index", 0).asUInt();
     config_.sdr.sample_rate = sdr_node.get("sample_rate", DEFAULT_SAMPLE_RATE).asUInt();
     config_.sdr.ppm_correction = sdr_node.get("ppm_correction", 0).asInt();
+    config_.sdr.center_frequency = sdr_node.get("center_frequency", 0).asDouble();
+    config_.sdr.dsp_threads = sdr_node.get("dsp_threads", 0).asUInt();
+    config_.sdr.source = sdr_node.get("source", "rtlsdr").asString();
+    config_.sdr.publish = sdr_node.get("publish", "").asString();
+    config_.sdr.publish_channels = sdr_node.get("publish_channels", false).asBool();
 
     std::string gain_str = sdr_node.get("gain", "auto").asString();
     if (gain_str == "auto") {
@@ -77,35 +146,84 @@ bool ConfigParser::parseSDRConfig(const Json::Value& sdr_node) {
     return true;
 }
 
-bool ConfigParser::parseSystemConfig(const Json::Value& system_node) {
+bool ConfigParser::parseSystemConfig(const Json::Value& system_node, SystemInfo& system) {
     if (system_node.isNull()) {
         LOG_ERROR("Missing system configuration");
         return false;
     }
 
     std::string type_str = system_node.get("type", "p25").asString();
-    config_.system.type = stringToSystemType(type_str);
+    system.type = stringToSystemType(type_str);
 
-    config_.system.system_id = system_node.get("system_id", 0).asUInt();
-    config_.system.nac = system_node.get("nac", 0).asUInt();
-    config_.system.wacn = system_node.get("wacn", 0).asUInt();
-    config_.system.name = system_node.get("name", "Unknown").asString();
+    system.system_id = system_node.get("system_id", 0).asUInt();
+    system.nac = system_node.get("nac", 0).asUInt();
+    system.wacn = system_node.get("wacn", 0).asUInt();
+    system.name = system_node.get("name", "Unknown").asString();
 
     // Parse control channels
     const Json::Value& channels = system_node["control_channels"];
     if (channels.isArray()) {
         for (const auto& ch : channels) {
-            config_.system.control_channels.push_back(ch.asDouble());
+            system.control_channels.push_back(ch.asDouble());
         }
     }
 
-    if (config_.system.control_channels.empty()) {
+    if (system.control_channels.empty()) {
         LOG_ERROR("No control channels configured");
         return false;
     }
 
-    LOG_INFO("System config:", systemTypeToString(config_.system.type),
-             "control channels =", config_.system.control_channels.size());
+    // DMR trunking parameters
+    system.color_code = system_node.get("color_code", 1).asUInt() & 0x0F;
+    system.trunking = system_node.get("trunking", "").asString();
+
+    // NXDN: RAN shares the color code slot (0 accepts any RAN)
+    if (system.type == SystemType::NXDN ||
+        system.type == SystemType::NXDN_NEXEDGE) {
+        system.color_code = system_node.get("ran", 0).asUInt() & 0x3F;
+    }
+
+    // TETRA: 6-bit colour code (0 accepts any cell) and the number of
+    // traffic carriers that can be followed at once (0 = default)
+    if (system.type == SystemType::TETRA ||
+        system.type == SystemType::TETRA_EMERGENCY) {
+        system.color_code = system_node.get("color_code", 0).asUInt() & 0x3F;
+    }
+
+    // dPMR: 24-bit colour code word (0 learns it from the first header)
+    if (system.type == SystemType::DPMR ||
+        system.type == SystemType::DPMR_MODE2) {
+        system.color_code = system_node.get("color_code", 0).asUInt() & 0xFFFFFF;
+    }
+    system.traffic_carriers = system_node.get("traffic_carriers", 0).asUInt();
+
+    // Control channel rate where a protocol has variants: NXDN48/96
+    // (2400/4800), EDACS wide/narrow (9600/4800). 0 = protocol default.
+    system.symbol_rate = system_node.get("symbol_rate",
+                                                 system_node.get("baud_rate", 0)).asUInt();
+
+    // SmartNet bandplan; VHF/UHF (OBT) sites also need the base frequency
+    system.bandplan = system_node.get("bandplan", "800_standard").asString();
+    system.bandplan_base = system_node.get("bandplan_base", 0).asDouble();
+    system.bandplan_spacing = system_node.get("bandplan_spacing", 0).asDouble();
+    system.bandplan_offset = system_node.get("bandplan_offset", 0).asUInt();
+
+    // P25 identifier and site tables are cached here between runs
+    system.site_cache_file = system_node.get("site_cache_file", "").asString();
+
+    // Sites of one network, whose simulcast grants are one call
+    system.network = system_node.get("network", "").asString();
+
+    // Logical channel number -> frequency map ({"1": 167850000, ...})
+    const Json::Value& channel_map = system_node["channels"];
+    if (channel_map.isObject()) {
+        for (const auto& lcn : channel_map.getMemberNames()) {
+            system.channels[std::stoul(lcn)] = channel_map[lcn].asDouble();
+        }
+    }
+
+    LOG_INFO("System config:", systemTypeToString(system.type),
+             "control channels =", system.control_channels.size());
 
     return true;
 }
@@ -118,6 +236,8 @@ bool ConfigParser::parseAudioConfig(const Json::Value& audio_node) {
         config_.audio.sample_rate = AUDIO_SAMPLE_RATE;
         config_.audio.record_calls = false;
         config_.audio.recording_path = "/tmp";
+        config_.audio.codec_threads = 0;
+        config_.audio.call_log.clear();
         return true;
     }
 
@@ -125,6 +245,8 @@ bool ConfigParser::parseAudioConfig(const Json::Value& audio_node) {
     config_.audio.sample_rate = audio_node.get("sample_rate", AUDIO_SAMPLE_RATE).asUInt();
     config_.audio.record_calls = audio_node.get("record_calls", false).asBool();
     config_.audio.recording_path = audio_node.get("recording_path", "/tmp").asString();
+    config_.audio.codec_threads = audio_node.get("codec_threads", 0).asUInt();
+    config_.audio.call_log = audio_node.get("call_log", "").asString();
 
     std::string codec_str = audio_node.get("codec", "imbe").asString();
     config_.audio.codec = stringToCodecType(codec_str);
@@ -135,6 +257,97 @@ bool ConfigParser::parseAudioConfig(const Json::Value& audio_node) {
     return true;
 }
 
+bool ConfigParser::parseReceiverConfig(const Json::Value& receivers_node) {
+    config_.receivers.voice_receivers = 0;
+    config_.receivers.simulcast_window_ms = 3000;
+    config_.receivers.hold_time_ms = 0;
+    config_.receivers.preempt_priority = 8;
+    if (receivers_node.isNull()) {
+        return true;
+    }
+
+    config_.receivers.voice_receivers = receivers_node.get("voice_receivers", 0).asUInt();
+    config_.receivers.simulcast_window_ms = receivers_node.get("simulcast_window_ms", 3000).asUInt();
+    config_.receivers.hold_time_ms = receivers_node.get("hold_time_ms", 0).asUInt();
+    config_.receivers.preempt_priority = receivers_node.get("preempt_priority", 8).asUInt();
+
+    LOG_INFO("Receiver config: voice_receivers =", config_.receivers.voice_receivers,
+             "simulcast_window_ms =", config_.receivers.simulcast_window_ms);
+
+    return true;
+}
+
+bool ConfigParser::parseDistributedConfig(const Json::Value& distributed_node) {
+    config_.distributed.workers.clear();
+    config_.distributed.sample_format = "cs16";
+    if (distributed_node.isNull()) {
+        return true;
+    }
+
+    const Json::Value& workers = distributed_node["workers"];
+    if (workers.isArray()) {
+        for (const auto& worker : workers) {
+            config_.distributed.workers.push_back(worker.asString());
+        }
+    }
+    config_.distributed.sample_format = distributed_node.get("sample_format", "cs16").asString();
+
+    if (config_.distributed.sample_format != "cs16" && config_.distributed.sample_format != "cs8") {
+        LOG_ERROR("Unknown sample format:", config_.distributed.sample_format);
+        return false;
+    }
+
+    LOG_INFO("Distributed config:", config_.distributed.workers.size(), "decode worker(s),",
+             config_.distributed.sample_format);
+
+    return true;
+}
+
+bool ConfigParser::parseCaptureConfig(const Json::Value& capture_node) {
+    CaptureConfig& capture = config_.capture;
+    capture.directory.clear();
+    capture.format = "cu8";
+    capture.pre_trigger_ms = 5000;
+    capture.post_trigger_ms = 5000;
+    capture.max_capture_ms = 60000;
+    capture.on_sync_loss = true;
+    capture.on_emergency = true;
+    capture.on_priority = 0;
+    capture.crc_errors = 0;
+    capture.crc_window_ms = 1000;
+    if (capture_node.isNull()) {
+        return true;
+    }
+
+    capture.directory = capture_node.get("directory", "").asString();
+    capture.format = capture_node.get("format", "cu8").asString();
+    capture.pre_trigger_ms = capture_node.get("pre_trigger_ms", 5000).asUInt();
+    capture.post_trigger_ms = capture_node.get("post_trigger_ms", 5000).asUInt();
+    capture.max_capture_ms = capture_node.get("max_capture_ms", 60000).asUInt();
+
+    const Json::Value& triggers = capture_node["triggers"];
+    if (!triggers.isNull()) {
+        capture.on_sync_loss = triggers.get("sync_loss", true).asBool();
+        capture.on_emergency = triggers.get("emergency", true).asBool();
+        capture.on_priority = triggers.get("priority", 0).asUInt();
+        capture.crc_errors = triggers.get("crc_errors", 0).asUInt();
+        capture.crc_window_ms = triggers.get("crc_window_ms", 1000).asUInt();
+    }
+
+    if (capture.format != "cu8" && capture.format != "cf32") {
+        LOG_ERROR("Unknown capture format:", capture.format);
+        return false;
+    }
+
+    if (!capture.directory.empty()) {
+        LOG_INFO("Capture config:", capture.directory, capture.format,
+                 "pre_trigger_ms =", capture.pre_trigger_ms,
+                 "post_trigger_ms =", capture.post_trigger_ms);
+    }
+
+    return true;
+}
+
 bool ConfigParser::parseTalkgroupConfig(const Json::Value& tg_node) {
     if (tg_node.isNull()) {
         // No talkgroup filtering - allow all
@@ -169,6 +382,8 @@ bool ConfigParser::parseTalkgroupConfig(const Json::Value& tg_node) {
         }
     }
 
+    config_.talkgroups.alias_db = tg_node.get("alias_db", "").asString();
+
     LOG_INFO("Talkgroup config: enabled =", config_.talkgroups.enabled.size());
 
     return true;
@@ -182,7 +397,14 @@ SystemType ConfigParser::stringToSystemType(const std::string& str) {
     if (str == "edacs") return SystemType::EDACS;
     if (str == "ltr") return SystemType::LTR;
     if (str == "dmr") return SystemType::DMR;
+    if (str == "dmr_tier2") return SystemType::DMR_TIER2;
+    if (str == "dmr_tier3") return SystemType::DMR_TIER3;
     if (str == "nxdn") return SystemType::NXDN;
+    if (str == "nexedge") return SystemType::NXDN_NEXEDGE;
+    if (str == "dpmr") return SystemType::DPMR;
+    if (str == "dpmr_mode2") return SystemType::DPMR_MODE2;
+    if (str == "tetra") return SystemType::TETRA;
+    if (str == "tetra_emergency") return SystemType::TETRA_EMERGENCY;
     return SystemType::UNKNOWN;
 }
 
@@ -205,7 +427,14 @@ std::string ConfigParser::systemTypeToString(SystemType type) {
         case SystemType::EDACS: return "EDACS";
         case SystemType::LTR: return "LTR";
         case SystemType::DMR: return "DMR";
+        case SystemType::DMR_TIER2: return "DMR Tier II";
+        case SystemType::DMR_TIER3: return "DMR Tier III";
         case SystemType::NXDN: return "NXDN";
+        case SystemType::NXDN_NEXEDGE: return "NEXEDGE";
+        case SystemType::DPMR: return "dPMR";
+        case SystemType::DPMR_MODE2: return "dPMR Mode 2";
+        case SystemType::TETRA: return "TETRA";
+        case SystemType::TETRA_EMERGENCY: return "TETRA (emergency services)";
         default: return "Unknown";
     }
 }
@@ -14,18 +14,52 @@ struct AudioConfig {
     uint32_t sample_rate;
     bool record_calls;
     std::string recording_path;
+    uint32_t codec_threads;  // Vocoder worker threads (0 = auto)
+    std::string call_log;    // Binary call history file (empty = none)
+};
+
+struct ReceiverConfig {
+    uint32_t voice_receivers;      // Voice chains shared by all systems (0 = one per trunked system)
+    uint32_t simulcast_window_ms;  // Same talkgroup and source on another site within this is one call
+    uint32_t hold_time_ms;         // Receiver kept for a talkgroup after its call ends
+    Priority preempt_priority;     // Calls at or above this interrupt lower ones (0 = never)
+};
+
+struct DistributedConfig {
+    std::vector<std::string> workers;   // Decode workers, "unix:<path>" or "tcp:<host>:<port>"
+    std::string sample_format;          // "cs16" or "cs8"
+};
+
+struct CaptureConfig {
+    std::string directory;          // Raw IQ captures (empty = off)
+    std::string format;             // "cu8" or "cf32"
+    uint32_t pre_trigger_ms;        // Kept in memory ahead of every trigger
+    uint32_t post_trigger_ms;
+    uint32_t max_capture_ms;        // Cap on a capture extended by later triggers
+
+    // What triggers one
+    bool on_sync_loss;              // A control channel loses lock
+    bool on_emergency;              // An emergency call starts
+    Priority on_priority;           // A call at or above this starts (0 = never)
+    uint32_t crc_errors;            // Control CRC errors within crc_window_ms (0 = never)
+    uint32_t crc_window_ms;
 };
 
 struct TalkgroupConfig {
     std::vector<TalkgroupID> enabled;
     std::map<TalkgroupID, Priority> priorities;
     std::map<TalkgroupID, std::string> labels;
+    std::string alias_db;               // Compiled talkgroup/radio aliases (alias_db_build)
 };
 
 struct Config {
     SDRConfig sdr;
-    SystemInfo system;
+    SystemInfo system;                  // First entry of 'systems'
+    std::vector<SystemInfo> systems;    // Every system decoded from the capture
     AudioConfig audio;
+    ReceiverConfig receivers;
+    DistributedConfig distributed;
+    CaptureConfig capture;
     TalkgroupConfig talkgroups;
 };
 
@@ -33,11 +67,21 @@ class ConfigParser {
 public:
     ConfigParser() = default;
 
-    bool loadFromFile(const std::string& filename);
+    // With a cache file, a cache built from the same JSON is used instead
+    // of parsing it (ConfigCache)
+    bool loadFromFile(const std::string& filename, const std::string& cache_file = "");
     bool loadFromString(const std::string& json_str);
 
     const Config& getConfig() const { return config_; }
 
+    // Filter designs that came with the cache, for FilterTapCache
+    const std::vector<FilterDesign>& getCachedFilters() const { return cached_filters_; }
+    bool isFromCache() const { return from_cache_; }
+
+    // Writes the cache after a parse, or when filters has designs the
+    // cache lacked; a no-op without a cache file
+    bool saveCache(const std::vector<FilterDesign>& filters);
+
     static SystemType stringToSystemType(const std::string& str);
     static CodecType stringToCodecType(const std::string& str);
     static std::string systemTypeToString(SystemType type);
@@ -45,11 +89,19 @@ public:
 private:
     bool parseJSON(const Json::Value& root);
     bool parseSDRConfig(const Json::Value& sdr_node);
-    bool parseSystemConfig(const Json::Value& system_node);
+    bool parseSystemConfig(const Json::Value& system_node, SystemInfo& system);
     bool parseAudioConfig(const Json::Value& audio_node);
+    bool parseReceiverConfig(const Json::Value& receivers_node);
+    bool parseDistributedConfig(const Json::Value& distributed_node);
+    bool parseCaptureConfig(const Json::Value& capture_node);
     bool parseTalkgroupConfig(const Json::Value& tg_node);
 
     Config config_;
+
+    std::string source_;                // JSON as read, the cache key
+    std::string cache_file_;
+    std::vector<FilterDesign> cached_filters_;
+    bool from_cache_ = false;
 };
 
 } // namespace TrunkSDR
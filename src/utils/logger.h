@@ -59,26 +59,31 @@ public:
 
     template<typename... Args>
     void debug(Args&&... args) {
+        if (LogLevel::DEBUG < log_level_) return;
         log(LogLevel::DEBUG, formatMessage(std::forward<Args>(args)...));
     }
 
     template<typename... Args>
     void info(Args&&... args) {
+        if (LogLevel::INFO < log_level_) return;
         log(LogLevel::INFO, formatMessage(std::forward<Args>(args)...));
     }
 
     template<typename... Args>
     void warning(Args&&... args) {
+        if (LogLevel::WARNING < log_level_) return;
         log(LogLevel::WARNING, formatMessage(std::forward<Args>(args)...));
     }
 
     template<typename... Args>
     void error(Args&&... args) {
+        if (LogLevel::ERROR < log_level_) return;
         log(LogLevel::ERROR, formatMessage(std::forward<Args>(args)...));
     }
 
     template<typename... Args>
     void critical(Args&&... args) {
+        if (LogLevel::CRITICAL < log_level_) return;
         log(LogLevel::CRITICAL, formatMessage(std::forward<Args>(args)...));
     }
 
@@ -1,8 +1,10 @@
 #ifndef TYPES_H
 #define TYPES_H
 
+#include <array>
 #include <cstdint>
 #include <complex>
+#include <map>
 #include <vector>
 #include <string>
 #include <memory>
@@ -79,9 +81,6 @@ enum class CodecType {
     IMBE,
     AMBE,
     AMBE_PLUS2,
-    ACELP,
-    ACELP_4567,
-    ACELP_7200,
     PROVOICE,
     DMR_CODEC,
     CODEC2,
@@ -93,9 +92,20 @@ struct SystemInfo {
     SystemType type;
     SystemID system_id;
     uint16_t nac;  // P25 NAC (Network Access Code)
-    uint16_t wacn; // P25 WACN (Wide Area Communications Network)
+    uint32_t wacn; // P25 WACN (Wide Area Communications Network), 20 bits
     std::vector<Frequency> control_channels;
     std::string name;
+    uint32_t color_code;   // DMR color code / NXDN RAN / TETRA / dPMR (24 bits)
+    std::string trunking;  // DMR trunking variant (capacity_plus, connect_plus, tier3)
+    std::map<uint32_t, Frequency> channels;  // Logical channel number -> frequency
+    uint32_t symbol_rate;  // 0 = protocol default
+    std::string bandplan;  // SmartNet: 800_standard, 800_splinter, 800_reband, 900, vhf, uhf
+    Frequency bandplan_base;     // SmartNet VHF/UHF: first outbound channel
+    Frequency bandplan_spacing;
+    uint32_t bandplan_offset;    // SmartNet VHF/UHF: channel number of bandplan_base
+    std::string site_cache_file; // P25: learned identifier/site tables ("" = off)
+    uint32_t traffic_carriers;   // TETRA: carriers followed at once (0 = default)
+    std::string network;         // Sites naming the same network share calls ("" = by identity)
 };
 
 // Call grant information
@@ -103,19 +113,26 @@ struct CallGrant {
     TalkgroupID talkgroup;
     RadioID radio_id;
     Frequency frequency;
+    uint8_t slot;  // TDMA timeslot (1-based, 0 for FDMA channels)
     CallType type;
     Priority priority;
     uint64_t timestamp;
     bool encrypted;
 };
 
-// Audio frame structure
-struct AudioFrame {
-    AudioBuffer samples;
+// A call is its talkgroup on the system that granted it. One capture can
+// carry unrelated systems whose talkgroup numbers overlap; 'site' is the
+// system's position in the configuration.
+struct CallKey {
+    uint16_t site;
     TalkgroupID talkgroup;
-    RadioID radio_id;
-    uint64_t timestamp;
-    double rssi; // Received Signal Strength Indicator
+
+    bool operator<(const CallKey& other) const {
+        return site != other.site ? site < other.site : talkgroup < other.talkgroup;
+    }
+    bool operator==(const CallKey& other) const {
+        return site == other.site && talkgroup == other.talkgroup;
+    }
 };
 
 // SDR configuration
@@ -125,6 +142,18 @@ struct SDRConfig {
     double gain;
     int32_t ppm_correction;
     bool auto_gain;
+    Frequency center_frequency;  // Multi-system capture centre (0 = middle of the systems)
+    uint32_t dsp_threads;        // Channel group threads, SDR thread included (0 = auto)
+    std::string source;          // "rtlsdr" or "shm:<stream>" (another process's capture)
+    std::string publish;         // Shared IQ stream name for other processes ("" = off)
+    bool publish_channels;       // Also publish control and voice channel basebands
+};
+
+// Windowed-sinc low-pass taps (FIRFilter::createLowPassTaps)
+struct FilterDesign {
+    uint32_t sample_rate;
+    float cutoff;                // Hz
+    std::vector<float> taps;
 };
 
 // European-specific encryption types
@@ -175,6 +204,24 @@ constexpr uint32_t DEFAULT_SAMPLE_RATE = 2048000;  // 2.048 MSPS
 constexpr uint32_t AUDIO_SAMPLE_RATE = 8000;       // 8 kHz audio output
 constexpr size_t AUDIO_BUFFER_FRAMES = 160;        // 20ms at 8kHz
 
+// Fixed 20 ms PCM block. Blocks come from AudioFramePool and return to it
+// when the owning PooledPCM is destroyed.
+using PCMFrame = std::array<AudioSample, AUDIO_BUFFER_FRAMES>;
+
+struct PCMFrameDeleter {
+    void operator()(PCMFrame* frame) const;  // Defined in audio_frame_pool.cpp
+};
+using PooledPCM = std::unique_ptr<PCMFrame, PCMFrameDeleter>;
+
+// Audio frame structure (move-only; owns its pooled PCM block)
+struct AudioFrame {
+    PooledPCM samples;
+    TalkgroupID talkgroup;
+    RadioID radio_id;
+    uint64_t timestamp;
+    double rssi; // Received Signal Strength Indicator
+};
+
 // European protocol constants
 constexpr uint32_t TETRA_SYMBOL_RATE = 18000;     // 18 ksps
 constexpr uint32_t DMR_SYMBOL_RATE = 4800;        // 4800 sps
@@ -0,0 +1,288 @@
+/**
+ * Distributed decode protocol tests
+ *
+ * Round-trips message headers, block floating point baseband in both
+ * sample formats and voice frame batches, checks that a batch claiming
+ * more frames or bytes than a VoiceFrameBatch holds is refused, and runs
+ * an EDACS control channel through a decode worker on a Unix socket until
+ * it sends back a grant.
+ *
+ * Author: TrunkSDR Project
+ * License: MIT
+ */
+
+#include "net/decode_protocol.h"
+#include "net/decode_link.h"
+#include "net/decode_worker.h"
+#include "decoders/edacs_decoder.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace TrunkSDR;
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const char* what) {
+    if (!condition) {
+        std::fprintf(stderr, "FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+void testHeader() {
+    MessageHeader header{MessageType::VOICE_FRAMES, 2, 0xBEEF, 0x01020304, 0x0123456789ABCDEFULL};
+    uint8_t bytes[sizeof(MessageHeader)];
+    encodeHeader(header, bytes);
+
+    check(bytes[0] == static_cast<uint8_t>(MessageType::VOICE_FRAMES), "header type is byte 0");
+    check(bytes[2] == 0xEF && bytes[3] == 0xBE, "header channel is little-endian");
+    check(bytes[4] == 0x04 && bytes[7] == 0x01, "header length is little-endian");
+    check(bytes[8] == 0xEF && bytes[15] == 0x01, "header timestamp is little-endian");
+
+    MessageHeader decoded = decodeHeader(bytes);
+    check(decoded.type == header.type && decoded.format == header.format &&
+          decoded.channel == header.channel && decoded.length == header.length &&
+          decoded.timestamp == header.timestamp, "header round trip");
+}
+
+void testSamples(SampleFormat format, const char* what) {
+    std::vector<Complex> samples;
+    for (size_t i = 0; i < 1000; i++) {
+        float amplitude = 0.8f * static_cast<float>(i % 97) / 96.0f;
+        samples.emplace_back(amplitude * std::cos(0.01f * i), -amplitude * std::sin(0.03f * i));
+    }
+
+    MessageWriter writer;
+    writer.begin(MessageType::SAMPLES, 1, 0, static_cast<uint8_t>(format));
+    writeSamples(writer, format, samples.data(), samples.size());
+    const uint8_t* data = writer.data();
+
+    MessageReader reader(data + sizeof(MessageHeader), writer.size() - sizeof(MessageHeader));
+    std::vector<Complex> received;
+    bool ok = readSamples(reader, format, received);
+    check(ok && received.size() == samples.size(), what);
+
+    // Rounding to the nearest step: half a step of peak / full scale
+    float peak = 0.0f;
+    for (const Complex& s : samples) {
+        peak = std::max(peak, std::max(std::abs(s.real()), std::abs(s.imag())));
+    }
+    float full_scale = format == SampleFormat::CS8 ? 127.0f : 32767.0f;
+    float bound = 0.5f * peak / full_scale * 1.001f;
+
+    float worst = 0.0f;
+    for (size_t i = 0; i < received.size() && i < samples.size(); i++) {
+        worst = std::max(worst, std::abs(received[i].real() - samples[i].real()));
+        worst = std::max(worst, std::abs(received[i].imag() - samples[i].imag()));
+    }
+    check(worst <= bound, what);
+}
+
+// A VOICE_FRAMES payload with arbitrary counts
+std::vector<uint8_t> voicePayload(uint8_t frame_count, uint8_t frame_bytes, size_t data_bytes) {
+    MessageWriter writer;
+    writer.begin(MessageType::VOICE_FRAMES, 1, 0);
+    writer.put8(static_cast<uint8_t>(CodecType::IMBE));
+    writer.put32(1234);
+    writer.put32(5678);
+    writer.put8(0);
+    writer.put8(frame_count);
+    writer.put8(frame_bytes);
+    writer.put32(0);
+    for (size_t i = 0; i < data_bytes; i++) {
+        writer.put8(static_cast<uint8_t>(i));
+    }
+    const uint8_t* data = writer.data();
+    return std::vector<uint8_t>(data + sizeof(MessageHeader), data + writer.size());
+}
+
+bool readsVoice(const std::vector<uint8_t>& payload, VoiceFrameBatch& batch) {
+    MessageReader reader(payload.data(), payload.size());
+    return readVoiceFrames(reader, batch);
+}
+
+void testVoiceFrames() {
+    VoiceFrameBatch batch;
+    batch.codec = CodecType::IMBE;
+    batch.talkgroup = 1234;
+    batch.radio_id = 5678;
+    batch.slot = 1;
+    batch.frame_count = 3;
+    batch.frame_bytes = 11;
+    batch.bit_errors = 7;
+    for (size_t i = 0; i < batch.data.size(); i++) {
+        batch.data[i] = static_cast<uint8_t>(i * 13);
+    }
+
+    MessageWriter writer;
+    writer.begin(MessageType::VOICE_FRAMES, 1, 0);
+    writeVoiceFrames(writer, batch);
+    const uint8_t* data = writer.data();
+    MessageReader reader(data + sizeof(MessageHeader), writer.size() - sizeof(MessageHeader));
+
+    VoiceFrameBatch decoded;
+    bool ok = readVoiceFrames(reader, decoded);
+    check(ok && decoded.talkgroup == 1234 && decoded.radio_id == 5678 && decoded.slot == 1 &&
+          decoded.frame_count == 3 && decoded.frame_bytes == 11 && decoded.bit_errors == 7,
+          "voice batch round trip");
+    check(std::equal(decoded.data.begin(), decoded.data.begin() + 33, batch.data.begin()),
+          "voice batch frames round trip");
+
+    const uint8_t max_frames = static_cast<uint8_t>(MAX_VOICE_FRAMES_PER_BATCH);
+    const uint8_t max_bytes = static_cast<uint8_t>(MAX_VOICE_FRAME_BYTES);
+    check(readsVoice(voicePayload(max_frames, max_bytes, max_frames * max_bytes), decoded),
+          "largest voice batch is accepted");
+    check(!readsVoice(voicePayload(max_frames + 1, max_bytes, (max_frames + 1) * max_bytes), decoded),
+          "oversized frame_count is rejected");
+    check(!readsVoice(voicePayload(max_frames, max_bytes + 1, max_frames * (max_bytes + 1)), decoded),
+          "oversized frame_bytes is rejected");
+    check(!readsVoice(voicePayload(255, 255, 64), decoded),
+          "oversized batch with a short payload is rejected");
+    check(!readsVoice(voicePayload(2, 11, 21), decoded), "truncated frames are rejected");
+}
+
+// EDACS control channel at 9600 baud
+constexpr uint32_t WORKER_SAMPLE_RATE = 48000;
+constexpr uint32_t EDACS_BAUD = 9600;
+constexpr uint32_t GRANT_LCN = 5;
+constexpr uint32_t GRANT_GROUP = 0x155;
+constexpr Frequency GRANT_FREQUENCY = 854.2375e6;
+
+uint64_t edacsMessage(uint8_t command, uint32_t lcn, uint32_t group) {
+    uint64_t word = ((static_cast<uint64_t>(command) << 20) | (lcn << 15) | group) << EDACS_BCH_PARITY_BITS;
+    uint64_t remainder = word;
+    for (size_t bit = EDACS_MESSAGE_BITS; bit-- > EDACS_BCH_PARITY_BITS;) {
+        if ((remainder >> bit) & 1) {
+            remainder ^= static_cast<uint64_t>(EDACS_BCH_GENERATOR) << (bit - EDACS_BCH_PARITY_BITS);
+        }
+    }
+    return word | remainder;
+}
+
+std::vector<uint8_t> edacsBits() {
+    const uint64_t mask = (1ULL << EDACS_MESSAGE_BITS) - 1;
+    uint64_t grant = edacsMessage(static_cast<uint8_t>(EDACSCommand::GROUP_VOICE_ASSIGN),
+                                  GRANT_LCN, GRANT_GROUP);
+    uint64_t idle = edacsMessage(static_cast<uint8_t>(EDACSCommand::IDLE), 0, 0);
+
+    std::vector<uint8_t> bits;
+    auto append = [&bits](uint64_t value, size_t count) {
+        for (size_t i = count; i-- > 0;) {
+            bits.push_back((value >> i) & 1);
+        }
+    };
+    append(0xAAAAAAAAAAAAULL, 48);
+    for (int frame = 0; frame < 8; frame++) {
+        append(EDACS_SYNC, 48);
+        for (uint64_t message : {idle, grant}) {
+            append(message, EDACS_MESSAGE_BITS);
+            append(~message & mask, EDACS_MESSAGE_BITS);
+            append(message, EDACS_MESSAGE_BITS);
+        }
+    }
+    return bits;
+}
+
+// Continuous-phase binary FSK at +/-2.4 kHz
+std::vector<Complex> fskBaseband(const std::vector<uint8_t>& bits) {
+    const size_t samples_per_bit = WORKER_SAMPLE_RATE / EDACS_BAUD;
+    std::vector<Complex> samples;
+    double phase = 0.0;
+    for (uint8_t bit : bits) {
+        double step = 2.0 * M_PI * (bit ? 2400.0 : -2400.0) / WORKER_SAMPLE_RATE;
+        for (size_t i = 0; i < samples_per_bit; i++) {
+            phase += step;
+            samples.emplace_back(static_cast<float>(0.5 * std::cos(phase)),
+                                 static_cast<float>(0.5 * std::sin(phase)));
+        }
+    }
+    return samples;
+}
+
+void testWorkerGrant() {
+    SystemInfo system{};
+    system.type = SystemType::EDACS;
+    system.name = "test";
+    system.control_channels = {851.0125e6};
+    system.channels = {{GRANT_LCN, GRANT_FREQUENCY}};
+    system.symbol_rate = EDACS_BAUD;
+
+    Config config;
+    config.system = system;
+    config.systems = {system};
+
+    std::string address = "unix:/tmp/trunksdr_decode_protocol_test_" + std::to_string(getpid()) + ".sock";
+    DecodeWorker worker;
+    bool listening = worker.initialize(config, address) && worker.start();
+    check(listening, "worker listens on a Unix socket");
+    if (!listening) {
+        return;
+    }
+
+    DecodeLink link;
+    bool connected = link.initialize({address}, SampleFormat::CS16);
+    check(connected, "front end connects to the worker");
+    if (!connected) {
+        return;
+    }
+
+    ChannelOpen open{0, ChannelRole::CONTROL, WORKER_SAMPLE_RATE, system.control_channels[0]};
+    std::shared_ptr<RemoteChannel> channel = link.openChannel(open);
+    check(channel != nullptr, "channel opens on the worker");
+    if (!channel) {
+        return;
+    }
+
+    std::vector<Complex> samples = fskBaseband(edacsBits());
+    channel->sendSamples(samples.data(), samples.size());
+
+    // The worker answers asynchronously; give it a few seconds
+    bool granted = false;
+    bool locked = false;
+    CallGrant grant{};
+    std::vector<RemoteChannel::Event> events;
+    for (int wait = 0; wait < 500 && !(granted && locked); wait++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        channel->takeEvents(events);
+        for (const RemoteChannel::Event& event : events) {
+            if (event.type == MessageType::GRANT && !granted) {
+                granted = true;
+                grant = event.grant;
+            } else if (event.type == MessageType::LOCK) {
+                locked = locked || event.locked;
+            }
+        }
+    }
+
+    check(granted, "worker returns a grant");
+    check(grant.talkgroup == GRANT_GROUP, "grant names the talkgroup");
+    check(grant.frequency == GRANT_FREQUENCY, "grant maps the LCN to its frequency");
+    check(locked, "worker reports control channel lock");
+
+    channel->close();
+    link.stop();
+    worker.stop();
+}
+
+} // anonymous namespace
+
+int main() {
+    testHeader();
+    testSamples(SampleFormat::CS8, "cs8 samples round trip within half a step");
+    testSamples(SampleFormat::CS16, "cs16 samples round trip within half a step");
+    testVoiceFrames();
+    testWorkerGrant();
+
+    if (failures == 0) {
+        std::printf("decode_protocol_test: all tests passed\n");
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,370 @@
+/**
+ * DMR two-slot framer tests
+ *
+ * Builds a base station stream of whole timeslots (CACH with the TACT,
+ * then the burst) and feeds it to the decoder. Slot 1 carries a voice call
+ * joined by late entry: voice superframes only, with the talkgroup in the
+ * embedded LC of bursts B-E. Slot 2 carries a call opened by a voice LC
+ * header and closed by a terminator. Both are checked for their
+ * talkgroups, frame counts and slot separation. A second run puts slot 2
+ * on a foreign colour code, which must be dropped.
+ *
+ * Author: TrunkSDR Project
+ * License: MIT
+ */
+
+#include "european/dmr/dmr_decoder.h"
+#include <cstdio>
+#include <map>
+#include <vector>
+
+using namespace TrunkSDR;
+using namespace TrunkSDR::European;
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const char* what) {
+    if (!condition) {
+        std::fprintf(stderr, "FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+// DMR dibit to the FSK4Demodulator symbol the decoder maps back
+constexpr float DIBIT_TO_SYMBOL[4] = {2, 3, 1, 0};
+
+constexpr size_t TACT_POSITIONS[7] = {0, 4, 8, 12, 14, 18, 22};
+
+// Hamming(15,11) syndrome of each data bit; Hamming(13,9) is the same
+// code shortened by the first two
+constexpr uint8_t HAMMING_15_11_SYNDROMES[11] = {
+    0x9, 0xB, 0xF, 0x7, 0xE, 0x5, 0xA, 0xD, 0x3, 0x6, 0xC
+};
+
+constexpr uint8_t SLOT_FILL[2] = {0xA5, 0x3C};  // AMBE+2 payload per slot
+
+using Bits = std::vector<uint8_t>;
+
+void putBits(Bits& bits, size_t offset, uint64_t value, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        bits[offset + i] = (value >> (count - 1 - i)) & 1;
+    }
+}
+
+// Full LC: PF(1) R(1) FLCO(6) FID(8) service options(8) dest(24) source(24)
+Bits fullLC(uint32_t talkgroup, uint32_t source) {
+    Bits lc(DMR_LC_BITS, 0);
+    putBits(lc, 24, talkgroup, 24);
+    putBits(lc, 48, source, 24);
+    return lc;
+}
+
+uint32_t lcOctet(const Bits& lc, size_t index) {
+    uint32_t value = 0;
+    for (size_t i = 0; i < 8; i++) {
+        value = (value << 1) | lc[index * 8 + i];
+    }
+    return value;
+}
+
+// RS(12,9) parity over GF(2^8) (field polynomial 0x11D), MSB octet first
+uint32_t rsParity(const Bits& lc) {
+    auto multiply = [](uint8_t a, uint8_t b) {
+        uint8_t product = 0;
+        while (b) {
+            if (b & 1) {
+                product ^= a;
+            }
+            a = static_cast<uint8_t>((a << 1) ^ ((a & 0x80) ? 0x1D : 0));
+            b >>= 1;
+        }
+        return product;
+    };
+
+    uint8_t parity[3] = {0, 0, 0};
+    for (size_t i = 0; i < 9; i++) {
+        uint8_t feedback = static_cast<uint8_t>(lcOctet(lc, i)) ^ parity[2];
+        parity[2] = parity[1] ^ multiply(0x0E, feedback);
+        parity[1] = parity[0] ^ multiply(0x38, feedback);
+        parity[0] = multiply(0x40, feedback);
+    }
+    return (static_cast<uint32_t>(parity[2]) << 16) | (parity[1] << 8) | parity[0];
+}
+
+// BPTC(196,96): 13x15 product matrix after a reserved bit, interleaved
+Bits bptcEncode(const Bits& data) {
+    constexpr size_t COLUMNS = 15;
+    Bits matrix(13 * COLUMNS, 0);
+    for (size_t i = 0; i < DMR_BPTC_DATA_BITS; i++) {
+        size_t bit = i + 3;
+        matrix[(bit / 11) * COLUMNS + bit % 11] = data[i];
+    }
+
+    for (size_t row = 0; row < 9; row++) {
+        uint8_t syndrome = 0;
+        for (size_t col = 0; col < 11; col++) {
+            if (matrix[row * COLUMNS + col]) {
+                syndrome ^= HAMMING_15_11_SYNDROMES[col];
+            }
+        }
+        for (size_t p = 0; p < 4; p++) {
+            matrix[row * COLUMNS + 11 + p] = (syndrome >> p) & 1;
+        }
+    }
+    for (size_t col = 0; col < COLUMNS; col++) {
+        uint8_t syndrome = 0;
+        for (size_t row = 0; row < 9; row++) {
+            if (matrix[row * COLUMNS + col]) {
+                syndrome ^= HAMMING_15_11_SYNDROMES[row + 2];
+            }
+        }
+        for (size_t p = 0; p < 4; p++) {
+            matrix[(9 + p) * COLUMNS + col] = (syndrome >> p) & 1;
+        }
+    }
+
+    Bits info(DMR_INFO_BITS, 0);
+    for (size_t i = 0; i < DMR_INFO_BITS; i++) {
+        info[(i * 181) % DMR_INFO_BITS] = i == 0 ? 0 : matrix[i - 1];
+    }
+    return info;
+}
+
+// Golay(20,8) slot type: data(8) | remainder of data * x^11 mod 0xC75 |
+// even parity
+uint32_t slotType(uint8_t color_code, DMRDataType type) {
+    uint32_t data = (color_code << 4) | static_cast<uint32_t>(type);
+    uint32_t remainder = data << 11;
+    for (int bit = 18; bit >= 11; bit--) {
+        if (remainder & (1u << bit)) {
+            remainder ^= 0xC75u << (bit - 11);
+        }
+    }
+    uint32_t parity = (__builtin_popcount(data) + __builtin_popcount(remainder)) & 1;
+    return (data << 12) | (remainder << 1) | parity;
+}
+
+// One timeslot: CACH naming 'slot', then the 264-bit burst
+Bits timeslot(uint8_t slot, const Bits& burst) {
+    // TACT: AT(1) TC(1) LCSS(2) + Hamming(7,4)
+    uint8_t d = static_cast<uint8_t>(0x8 | (slot << 2));
+    uint8_t d0 = (d >> 3) & 1, d1 = (d >> 2) & 1, d2 = (d >> 1) & 1, d3 = d & 1;
+    uint8_t tact = static_cast<uint8_t>((d << 3) | ((d0 ^ d1 ^ d2) << 2) |
+                                        ((d1 ^ d2 ^ d3) << 1) | (d0 ^ d1 ^ d3));
+
+    Bits bits(DMR_CACH_BITS, 0);
+    for (size_t i = 0; i < 7; i++) {
+        bits[TACT_POSITIONS[i]] = (tact >> (6 - i)) & 1;
+    }
+    bits.insert(bits.end(), burst.begin(), burst.end());
+    return bits;
+}
+
+Bits dataBurst(uint8_t color_code, DMRDataType type, const Bits& info) {
+    Bits burst(DMR_FRAME_BITS, 0);
+    uint32_t slot_type = slotType(color_code, type);
+    for (size_t i = 0; i < DMR_SLOT_TYPE_OFFSET_1; i++) {
+        burst[i] = info[i];
+        burst[DMR_SLOT_TYPE_OFFSET_2 + DMR_SLOT_TYPE_BITS / 2 + i] = info[DMR_SLOT_TYPE_OFFSET_1 + i];
+    }
+    putBits(burst, DMR_SLOT_TYPE_OFFSET_1, slot_type >> 10, 10);
+    putBits(burst, DMR_SYNC_OFFSET, DMR_SYNC_BS_DATA, DMR_SYNC_PATTERN_BITS);
+    putBits(burst, DMR_SLOT_TYPE_OFFSET_2, slot_type & 0x3FF, 10);
+    return burst;
+}
+
+Bits lcBurst(uint8_t color_code, DMRDataType type, uint32_t mask, uint32_t talkgroup, uint32_t source) {
+    Bits data = fullLC(talkgroup, source);
+    data.resize(DMR_BPTC_DATA_BITS, 0);
+    putBits(data, DMR_LC_BITS, rsParity(data) ^ mask, 24);
+    return dataBurst(color_code, type, bptcEncode(data));
+}
+
+// The embedded LC of bursts B-E: 8x16 matrix sent a column at a time
+Bits embeddedFragments(uint32_t talkgroup, uint32_t source) {
+    Bits lc = fullLC(talkgroup, source);
+    uint32_t checksum = 0;
+    for (size_t i = 0; i < 9; i++) {
+        checksum += lcOctet(lc, i);
+    }
+    checksum %= 31;
+
+    Bits matrix(DMR_EMBEDDED_LC_BITS, 0);
+    size_t in = 0;
+    for (size_t row = 0; row < 7; row++) {
+        size_t width = row < 2 ? 11 : 10;
+        for (size_t col = 0; col < width; col++) {
+            matrix[row * 16 + col] = lc[in++];
+        }
+        if (row >= 2) {
+            matrix[row * 16 + 10] = (checksum >> (6 - row)) & 1;
+        }
+        // Hamming(16,11,4) row parity
+        const uint8_t* d = &matrix[row * 16];
+        matrix[row * 16 + 11] = d[0] ^ d[1] ^ d[2] ^ d[3] ^ d[5] ^ d[7] ^ d[8];
+        matrix[row * 16 + 12] = d[1] ^ d[2] ^ d[3] ^ d[4] ^ d[6] ^ d[8] ^ d[9];
+        matrix[row * 16 + 13] = d[2] ^ d[3] ^ d[4] ^ d[5] ^ d[7] ^ d[9] ^ d[10];
+        matrix[row * 16 + 14] = d[0] ^ d[1] ^ d[2] ^ d[4] ^ d[6] ^ d[7] ^ d[10];
+        matrix[row * 16 + 15] = d[0] ^ d[2] ^ d[5] ^ d[6] ^ d[8] ^ d[9] ^ d[10];
+    }
+    for (size_t col = 0; col < 16; col++) {
+        uint8_t parity = 0;
+        for (size_t row = 0; row < 7; row++) {
+            parity ^= matrix[row * 16 + col];
+        }
+        matrix[7 * 16 + col] = parity;
+    }
+
+    Bits fragments(DMR_EMBEDDED_LC_BITS);
+    for (size_t i = 0; i < DMR_EMBEDDED_LC_BITS - 1; i++) {
+        fragments[i] = matrix[(i * 16) % (DMR_EMBEDDED_LC_BITS - 1)];
+    }
+    fragments[DMR_EMBEDDED_LC_BITS - 1] = matrix[DMR_EMBEDDED_LC_BITS - 1];
+    return fragments;
+}
+
+// Voice burst 'index' (A = 0 ... F = 5) of a superframe
+Bits voiceBurst(uint8_t slot, size_t index, uint8_t color_code, const Bits& fragments) {
+    Bits burst(DMR_FRAME_BITS, 0);
+    for (size_t i = 0; i < DMR_FRAME_BITS; i++) {
+        burst[i] = (SLOT_FILL[slot] >> (7 - i % 8)) & 1;
+    }
+
+    if (index == 0) {
+        putBits(burst, DMR_SYNC_OFFSET, DMR_SYNC_BS_VOICE, DMR_SYNC_PATTERN_BITS);
+        return burst;
+    }
+
+    // EMB: CC(4) PI(1) LCSS(2), QR parity not checked by the decoder;
+    // LCSS 1 = first, 3 = continuation, 2 = last fragment, 0 = none
+    static constexpr uint8_t LCSS[6] = {0, 1, 3, 3, 2, 0};
+    uint8_t emb = static_cast<uint8_t>((color_code << 4) | (LCSS[index] << 1));
+    for (size_t i = DMR_SYNC_OFFSET; i < DMR_SYNC_OFFSET + DMR_SYNC_PATTERN_BITS; i++) {
+        burst[i] = 0;
+    }
+    putBits(burst, DMR_SYNC_OFFSET, emb, 8);
+    if (index <= 4) {
+        for (size_t i = 0; i < DMR_EMBEDDED_FRAGMENT_BITS; i++) {
+            burst[DMR_SYNC_OFFSET + DMR_EMB_HALF_BITS + i] =
+                fragments[(index - 1) * DMR_EMBEDDED_FRAGMENT_BITS + i];
+        }
+    }
+    return burst;
+}
+
+constexpr uint32_t SLOT1_TALKGROUP = 1001;
+constexpr uint32_t SLOT1_SOURCE = 2001;
+constexpr uint32_t SLOT2_TALKGROUP = 1002;
+constexpr uint32_t SLOT2_SOURCE = 2002;
+constexpr size_t SUPERFRAMES = 2;
+
+// Slot 1: late entry call ended by idle; slot 2: voice LC header call
+// ended by a terminator
+std::vector<float> buildStream(uint8_t slot2_color_code) {
+    const uint8_t cc1 = 1;
+    Bits idle_info(DMR_INFO_BITS, 0);
+    Bits fragments1 = embeddedFragments(SLOT1_TALKGROUP, SLOT1_SOURCE);
+    Bits fragments2 = embeddedFragments(SLOT2_TALKGROUP, SLOT2_SOURCE);
+
+    std::vector<Bits> slots;
+    slots.push_back(timeslot(0, dataBurst(cc1, DMRDataType::IDLE, idle_info)));
+    slots.push_back(timeslot(1, lcBurst(slot2_color_code, DMRDataType::VOICE_LC_HEADER,
+                                        DMR_RS_MASK_VOICE_LC_HEADER, SLOT2_TALKGROUP, SLOT2_SOURCE)));
+    for (size_t superframe = 0; superframe < SUPERFRAMES; superframe++) {
+        for (size_t index = 0; index < DMR_VOICE_SUPERFRAME_BURSTS; index++) {
+            slots.push_back(timeslot(0, voiceBurst(0, index, cc1, fragments1)));
+            slots.push_back(timeslot(1, voiceBurst(1, index, slot2_color_code, fragments2)));
+        }
+    }
+    slots.push_back(timeslot(0, dataBurst(cc1, DMRDataType::IDLE, idle_info)));
+    slots.push_back(timeslot(1, lcBurst(slot2_color_code, DMRDataType::VOICE_TERMINATOR,
+                                        DMR_RS_MASK_TERMINATOR, SLOT2_TALKGROUP, SLOT2_SOURCE)));
+
+    std::vector<float> symbols;
+    for (const Bits& bits : slots) {
+        for (size_t i = 0; i < bits.size(); i += 2) {
+            symbols.push_back(DIBIT_TO_SYMBOL[(bits[i] << 1) | bits[i + 1]]);
+        }
+    }
+    return symbols;
+}
+
+struct SlotResult {
+    size_t frames = 0;
+    bool wrong_fill = false;
+    std::vector<uint32_t> talkgroups;
+};
+
+struct RunResult {
+    SlotResult slots[2];
+    std::vector<uint32_t> ended;
+    size_t crc_errors = 0;
+};
+
+RunResult run(uint8_t slot2_color_code) {
+    DMRDecoder decoder;
+    decoder.initialize();
+    decoder.setColorCode(1);
+
+    RunResult result;
+    decoder.setVoiceFrameCallback([&result](const VoiceFrameBatch& batch) {
+        if (batch.slot < 1 || batch.slot > 2) {
+            return;
+        }
+        SlotResult& slot = result.slots[batch.slot - 1];
+        slot.frames += batch.frame_count;
+        if (slot.talkgroups.empty() || slot.talkgroups.back() != batch.talkgroup) {
+            slot.talkgroups.push_back(batch.talkgroup);
+        }
+        for (size_t f = 0; f < batch.frame_count; f++) {
+            if (batch.frame(f)[0] != SLOT_FILL[batch.slot - 1]) {
+                slot.wrong_fill = true;
+            }
+        }
+    });
+    decoder.setCallEndCallback([&result](TalkgroupID talkgroup) {
+        result.ended.push_back(talkgroup);
+    });
+
+    std::vector<float> symbols = buildStream(slot2_color_code);
+    decoder.processSymbols(symbols.data(), symbols.size());
+    result.crc_errors = decoder.getCRCErrors();
+    return result;
+}
+
+} // anonymous namespace
+
+int main() {
+    const size_t frames_per_superframe = DMR_VOICE_SUPERFRAME_BURSTS * DMR_VOICE_FRAMES_PER_BURST;
+
+    RunResult both = run(1);
+
+    // Late entry: voice is held until burst E completes the embedded LC
+    const SlotResult& slot1 = both.slots[0];
+    check(slot1.talkgroups == std::vector<uint32_t>{SLOT1_TALKGROUP}, "slot 1 talkgroup from embedded LC");
+    check(slot1.frames == 2 * DMR_VOICE_FRAMES_PER_BURST + (SUPERFRAMES - 1) * frames_per_superframe,
+          "slot 1 late entry frame count");
+    check(!slot1.wrong_fill, "slot 1 carries only slot 1 voice");
+
+    const SlotResult& slot2 = both.slots[1];
+    check(slot2.talkgroups == std::vector<uint32_t>{SLOT2_TALKGROUP}, "slot 2 talkgroup from voice LC header");
+    check(slot2.frames == SUPERFRAMES * frames_per_superframe, "slot 2 frame count");
+    check(!slot2.wrong_fill, "slot 2 carries only slot 2 voice");
+
+    check(both.ended.size() == 2, "both calls end");
+    check(both.crc_errors == 0, "header, terminator and embedded LCs pass their checks");
+
+    // Slot 2 on a co-channel repeater's colour code is dropped whole
+    RunResult foreign = run(7);
+    check(foreign.slots[0].frames == slot1.frames, "slot 1 unaffected by foreign slot 2");
+    check(foreign.slots[1].frames == 0, "foreign colour code voice is dropped");
+    check(foreign.ended.size() == 1 && foreign.ended[0] == SLOT1_TALKGROUP,
+          "foreign colour code starts no call");
+
+    if (failures == 0) {
+        std::printf("dmr_framer_test: all tests passed\n");
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,69 @@
+/**
+ * dPMR frame sync tests
+ *
+ * Feeds FS2 through the late-entry acquire path, clean and with channel
+ * bit errors up to DPMR_FS2_ACQUIRE_ERRORS.
+ *
+ * Author: TrunkSDR Project
+ * License: MIT
+ */
+
+#include "european/dpmr/dpmr_decoder.h"
+#include <cstdio>
+#include <vector>
+
+using namespace TrunkSDR;
+using namespace TrunkSDR::European;
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const char* what) {
+    if (!condition) {
+        std::fprintf(stderr, "FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+// dPMR dibit to the FSK4Demodulator symbol the decoder maps back
+constexpr float DIBIT_TO_SYMBOL[4] = {2, 3, 1, 0};
+
+// Idle dibits, then the 24-bit pattern, MSB first
+std::vector<float> symbolsFor(uint32_t pattern) {
+    std::vector<float> symbols(48, DIBIT_TO_SYMBOL[0]);
+    for (int shift = 22; shift >= 0; shift -= 2) {
+        symbols.push_back(DIBIT_TO_SYMBOL[(pattern >> shift) & 0x3]);
+    }
+    return symbols;
+}
+
+bool acquires(uint32_t pattern) {
+    DPMRDecoder decoder;
+    decoder.initialize();
+    std::vector<float> symbols = symbolsFor(pattern);
+    decoder.processSymbols(symbols.data(), symbols.size());
+    return decoder.isLocked();
+}
+
+} // anonymous namespace
+
+int main() {
+    const uint32_t fs2 = static_cast<uint32_t>(DPMR_FS2);
+
+    // EN/TS 102 490 FS2: 113333131331 with +1 = 01 and +3 = 11
+    check(fs2 == 0x5FF77D, "FS2 constant matches the standard pattern");
+
+    check(acquires(fs2), "clean FS2 acquires");
+    check(acquires(fs2 ^ 0x000001), "FS2 with 1 bit error acquires");
+    check(acquires(fs2 ^ 0x800000), "FS2 with 1 bit error in the first dibit acquires");
+    check(acquires(fs2 ^ 0x010100), "FS2 with 2 bit errors acquires");
+    check(acquires(fs2 ^ 0x400002), "FS2 with 2 spread bit errors acquires");
+    check(!acquires(fs2 ^ 0x010101), "FS2 with 3 bit errors is rejected");
+    check(!acquires(0), "idle channel does not acquire");
+
+    if (failures == 0) {
+        std::printf("dpmr_sync_test: all tests passed\n");
+    }
+    return failures == 0 ? 0 : 1;
+}
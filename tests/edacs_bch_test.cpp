@@ -0,0 +1,136 @@
+/**
+ * EDACS BCH(40,28) tests
+ *
+ * Sends control channel frames through the decoder: a valid codeword, a
+ * single-bit error in one copy that the 2-of-3 vote corrects, and a word
+ * with the same error in every copy, which survives the vote and must be
+ * rejected by the BCH check.
+ *
+ * Author: TrunkSDR Project
+ * License: MIT
+ */
+
+#include "decoders/edacs_decoder.h"
+#include <cstdio>
+#include <vector>
+
+using namespace TrunkSDR;
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const char* what) {
+    if (!condition) {
+        std::fprintf(stderr, "FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+constexpr uint32_t GRANT_LCN = 3;
+constexpr uint32_t GRANT_GROUP = 0x2A5;
+constexpr Frequency GRANT_FREQUENCY = 851.0125e6;
+
+// Remainder of a polynomial over GF(2) divided by 'generator'
+uint64_t polyMod(uint64_t value, uint64_t generator) {
+    int degree = 63 - __builtin_clzll(generator);
+    for (int bit = 63; bit >= degree; bit--) {
+        if ((value >> bit) & 1) {
+            value ^= generator << (bit - degree);
+        }
+    }
+    return value;
+}
+
+// Command(8) | LCN(5) | Status(4) | Group(11) | BCH(12)
+uint64_t encodeMessage(uint8_t command, uint32_t lcn, uint32_t group) {
+    uint64_t data = (static_cast<uint64_t>(command) << 20) | (lcn << 15) | group;
+    uint64_t shifted = data << EDACS_BCH_PARITY_BITS;
+    return shifted | polyMod(shifted, EDACS_BCH_GENERATOR);
+}
+
+void appendBits(std::vector<float>& symbols, uint64_t value, size_t count) {
+    for (size_t i = count; i-- > 0;) {
+        symbols.push_back(static_cast<float>((value >> i) & 1));
+    }
+}
+
+// Idle, sync, then each message as normal, inverted, normal. 'errors'
+// holds a per-copy XOR for the first message.
+std::vector<float> frameFor(uint64_t m1, uint64_t m2, const uint64_t errors[3]) {
+    const uint64_t mask = (1ULL << EDACS_MESSAGE_BITS) - 1;
+    std::vector<float> symbols(64, 0.0f);
+    appendBits(symbols, EDACS_SYNC, 48);
+    appendBits(symbols, m1 ^ errors[0], EDACS_MESSAGE_BITS);
+    appendBits(symbols, ~(m1 ^ errors[1]) & mask, EDACS_MESSAGE_BITS);
+    appendBits(symbols, m1 ^ errors[2], EDACS_MESSAGE_BITS);
+    appendBits(symbols, m2, EDACS_MESSAGE_BITS);
+    appendBits(symbols, ~m2 & mask, EDACS_MESSAGE_BITS);
+    appendBits(symbols, m2, EDACS_MESSAGE_BITS);
+    return symbols;
+}
+
+struct Result {
+    size_t grants;
+    TalkgroupID talkgroup;
+    Frequency frequency;
+    size_t messages;
+    size_t bch_errors;
+};
+
+Result decode(const uint64_t errors[3]) {
+    EDACSDecoder decoder;
+    decoder.initialize();
+    decoder.setChannelMap({{GRANT_LCN, GRANT_FREQUENCY}});
+
+    Result result{0, 0, 0, 0, 0};
+    decoder.setGrantCallback([&result](const CallGrant& grant) {
+        result.grants++;
+        result.talkgroup = grant.talkgroup;
+        result.frequency = grant.frequency;
+    });
+
+    uint64_t grant = encodeMessage(static_cast<uint8_t>(EDACSCommand::GROUP_VOICE_ASSIGN),
+                                   GRANT_LCN, GRANT_GROUP);
+    uint64_t idle = encodeMessage(static_cast<uint8_t>(EDACSCommand::IDLE), 0, 0);
+    std::vector<float> symbols = frameFor(grant, idle, errors);
+    decoder.processSymbols(symbols.data(), symbols.size());
+
+    result.messages = decoder.getMessagesDecoded();
+    result.bch_errors = decoder.getCRCErrors();
+    return result;
+}
+
+} // anonymous namespace
+
+int main() {
+    // The BCH(63,51) generator must divide x^63 + 1
+    check(polyMod((1ULL << 63) | 1, EDACS_BCH_GENERATOR) == 0,
+          "generator divides x^63 + 1");
+
+    const uint64_t clean[3] = {0, 0, 0};
+    Result valid = decode(clean);
+    check(valid.grants == 1, "valid codeword gives a grant");
+    check(valid.talkgroup == GRANT_GROUP, "valid codeword decodes the group");
+    check(valid.frequency == GRANT_FREQUENCY, "valid codeword maps the LCN");
+    check(valid.messages == 2 && valid.bch_errors == 0, "valid frame has no BCH errors");
+
+    // One copy with a bit error: outvoted before the BCH check
+    const uint64_t one_copy[3] = {0, 1ULL << 20, 0};
+    Result voted = decode(one_copy);
+    check(voted.grants == 1 && voted.talkgroup == GRANT_GROUP,
+          "single-bit error in one copy is corrected by the vote");
+    check(voted.bch_errors == 0, "corrected copy is not a BCH error");
+
+    // The same error in every copy survives the vote
+    const uint64_t every_copy[3] = {1ULL << 20, 1ULL << 20, 1ULL << 20};
+    Result rejected = decode(every_copy);
+    check(rejected.grants == 0, "uncorrectable word gives no grant");
+    check(rejected.bch_errors == 1, "uncorrectable word is counted as a BCH error");
+    check(rejected.messages == 1, "second message of the frame still decodes");
+
+    if (failures == 0) {
+        std::printf("edacs_bch_test: all tests passed\n");
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,118 @@
+/**
+ * LTR sub-audible FSK tests
+ *
+ * Synthesizes 300 baud data at +/-100 Hz deviation under a 1 kHz voice
+ * tone at 3 kHz deviation and checks that the sub-audible demodulator
+ * recovers every bit. The generic FSK filter lets the tone through and
+ * gets about half the bits wrong on this signal.
+ *
+ * Author: TrunkSDR Project
+ * License: MIT
+ */
+
+#include "dsp/fsk_demod.h"
+#include "decoders/ltr_decoder.h"
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace TrunkSDR;
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const char* what) {
+    if (!condition) {
+        std::fprintf(stderr, "FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+constexpr uint32_t SAMPLE_RATE = 48000;
+constexpr double DATA_DEVIATION = 100.0;
+constexpr double VOICE_DEVIATION = 3000.0;
+constexpr double VOICE_TONE = 1000.0;
+constexpr size_t TEST_BITS = 1900;
+
+// Output symbols skipped while the filters and symbol clock settle
+constexpr size_t SETTLE_SYMBOLS = 16;
+
+std::vector<uint8_t> testBits() {
+    // Fixed LCG so the pattern is the same on every run
+    std::vector<uint8_t> bits(TEST_BITS);
+    uint32_t state = 0x2545F491;
+    for (size_t i = 0; i < TEST_BITS; i++) {
+        state = state * 1664525u + 1013904223u;
+        bits[i] = (state >> 31) & 1;
+    }
+    return bits;
+}
+
+// FM baseband: the data's frequency offset plus the voice tone's
+std::vector<Complex> modulate(const std::vector<uint8_t>& bits, double voice_deviation) {
+    const size_t samples_per_bit = SAMPLE_RATE / LTR_SYMBOL_RATE;
+    std::vector<Complex> samples;
+    samples.reserve(bits.size() * samples_per_bit);
+
+    double phase = 0.0;
+    size_t n = 0;
+    for (uint8_t bit : bits) {
+        for (size_t i = 0; i < samples_per_bit; i++, n++) {
+            double t = static_cast<double>(n) / SAMPLE_RATE;
+            double frequency = (bit ? DATA_DEVIATION : -DATA_DEVIATION) +
+                               voice_deviation * std::sin(2.0 * M_PI * VOICE_TONE * t);
+            phase += 2.0 * M_PI * frequency / SAMPLE_RATE;
+            samples.emplace_back(static_cast<float>(std::cos(phase)),
+                                 static_cast<float>(std::sin(phase)));
+        }
+    }
+    return samples;
+}
+
+// Bit errors at the best alignment of the recovered symbols
+size_t bitErrors(const std::vector<uint8_t>& sent, const std::vector<float>& received) {
+    size_t best = sent.size();
+    for (size_t lag = 0; lag < 2 * SETTLE_SYMBOLS; lag++) {
+        size_t errors = 0;
+        size_t compared = 0;
+        for (size_t i = SETTLE_SYMBOLS; i + lag < received.size() && i < sent.size(); i++) {
+            errors += (received[i + lag] > 0.5f ? 1 : 0) != sent[i];
+            compared++;
+        }
+        // The demodulator holds back its last partial block of symbols
+        if (compared >= sent.size() * 9 / 10 && errors < best) {
+            best = errors;
+        }
+    }
+    return best;
+}
+
+size_t demodulate(const std::vector<uint8_t>& bits, double voice_deviation) {
+    FSKDemodulator demod(LTR_SYMBOL_RATE, 2);
+    demod.setSubAudible(true);
+    demod.initialize(SAMPLE_RATE);
+
+    std::vector<float> received;
+    demod.setSymbolCallback([&received](const float* symbols, size_t count) {
+        received.insert(received.end(), symbols, symbols + count);
+    });
+
+    std::vector<Complex> samples = modulate(bits, voice_deviation);
+    demod.process(samples.data(), samples.size());
+    return bitErrors(bits, received);
+}
+
+} // anonymous namespace
+
+int main() {
+    std::vector<uint8_t> bits = testBits();
+
+    check(demodulate(bits, 0.0) == 0, "data alone is recovered without errors");
+    check(demodulate(bits, VOICE_DEVIATION) == 0, "data under a voice tone is recovered without errors");
+
+    if (failures == 0) {
+        std::printf("ltr_subaudible_test: all tests passed\n");
+    }
+    return failures == 0 ? 0 : 1;
+}
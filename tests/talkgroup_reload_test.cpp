@@ -0,0 +1,193 @@
+/**
+ * Talkgroup reload race tests
+ *
+ * Reader threads look up talkgroup settings and aliases while the main
+ * thread reloads the call manager's talkgroup configuration back and
+ * forth between two settings, each with its own alias database. Every
+ * lookup must answer from one whole configuration or the other: a torn
+ * snapshot or an alias database unmapped under a reader shows up as a
+ * mixed or garbled answer (or a crash).
+ *
+ * Author: TrunkSDR Project
+ * License: MIT
+ */
+
+#include "audio/call_manager.h"
+#include "utils/logger.h"
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace TrunkSDR;
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const char* what) {
+    if (!condition) {
+        std::fprintf(stderr, "FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+constexpr TalkgroupID TALKGROUPS = 64;
+constexpr size_t RELOADS = 1000;
+constexpr size_t READERS = 2;
+
+// Configuration 'name' ("A" or "B"): follows one half of the talkgroups,
+// gives every talkgroup one priority, labels a quarter of them and names
+// the rest from its own alias database
+struct Setting {
+    std::string name;
+    TalkgroupID first_enabled;
+    Priority priority;
+    TalkgroupID first_label;
+    std::string alias_db;
+};
+
+std::string expectedAlias(const Setting& setting, TalkgroupID talkgroup) {
+    if (talkgroup >= setting.first_label && talkgroup < setting.first_label + TALKGROUPS / 4) {
+        return "Label " + setting.name + std::to_string(talkgroup);
+    }
+    return setting.name + std::to_string(talkgroup);
+}
+
+std::string expectedRadio(const Setting& setting, RadioID radio) {
+    return "R" + setting.name + std::to_string(radio);
+}
+
+bool writeAliasDB(const Setting& setting) {
+    AliasDBBuilder builder;
+    for (TalkgroupID talkgroup = 1; talkgroup <= TALKGROUPS; talkgroup++) {
+        builder.addTalkgroup(talkgroup, setting.name + std::to_string(talkgroup));
+        builder.addRadio(talkgroup, expectedRadio(setting, talkgroup));
+    }
+    return builder.write(setting.alias_db);
+}
+
+TalkgroupConfig configFor(const Setting& setting) {
+    TalkgroupConfig config;
+    for (TalkgroupID talkgroup = 1; talkgroup <= TALKGROUPS; talkgroup++) {
+        if (talkgroup >= setting.first_enabled && talkgroup < setting.first_enabled + TALKGROUPS / 2) {
+            config.enabled.push_back(talkgroup);
+        }
+        config.priorities[talkgroup] = setting.priority;
+        if (talkgroup >= setting.first_label && talkgroup < setting.first_label + TALKGROUPS / 4) {
+            config.labels[talkgroup] = "Label " + setting.name + std::to_string(talkgroup);
+        }
+    }
+    config.alias_db = setting.alias_db;
+    return config;
+}
+
+struct ReaderResult {
+    size_t lookups = 0;
+    size_t bad_priority = 0;
+    size_t bad_alias = 0;
+    size_t bad_radio = 0;
+};
+
+void reader(const CallManager& manager, const Setting settings[2],
+            const std::atomic<bool>& done, ReaderResult& result) {
+    while (!done.load(std::memory_order_relaxed)) {
+        for (TalkgroupID talkgroup = 1; talkgroup <= TALKGROUPS; talkgroup++) {
+            Priority priority = manager.getTalkgroupPriority(talkgroup);
+            if (priority != settings[0].priority && priority != settings[1].priority) {
+                result.bad_priority++;
+            }
+
+            std::string alias = manager.getTalkgroupAlias(talkgroup);
+            if (alias != expectedAlias(settings[0], talkgroup) &&
+                alias != expectedAlias(settings[1], talkgroup)) {
+                result.bad_alias++;
+            }
+
+            std::string radio = manager.getRadioAlias(talkgroup);
+            if (radio != expectedRadio(settings[0], talkgroup) &&
+                radio != expectedRadio(settings[1], talkgroup)) {
+                result.bad_radio++;
+            }
+            result.lookups++;
+        }
+    }
+}
+
+} // anonymous namespace
+
+int main() {
+    // Every reload reopens a database and says so
+    Logger::instance().setLogLevel(LogLevel::WARNING);
+
+    std::string prefix = "/tmp/trunksdr_talkgroup_reload_test_" + std::to_string(getpid());
+    const Setting settings[2] = {
+        {"A", 1, 2, 1, prefix + "_a.db"},
+        {"B", TALKGROUPS / 2 + 1, 8, TALKGROUPS / 2 + 1, prefix + "_b.db"},
+    };
+    check(writeAliasDB(settings[0]) && writeAliasDB(settings[1]), "alias databases are written");
+
+    const TalkgroupConfig configs[2] = {configFor(settings[0]), configFor(settings[1])};
+
+    CallManager manager;
+    check(manager.applyTalkgroupConfig(configs[0]), "first configuration applies");
+
+    std::atomic<bool> done{false};
+    std::vector<ReaderResult> results(READERS);
+    std::vector<std::thread> readers;
+    for (size_t i = 0; i < READERS; i++) {
+        readers.emplace_back(reader, std::cref(manager), settings, std::cref(done), std::ref(results[i]));
+    }
+
+    // Every reload swaps the followed half and reopens the other database
+    size_t failed = 0;
+    size_t wrong_changes = 0;
+    for (size_t i = 1; i <= RELOADS; i++) {
+        TalkgroupChanges changes;
+        if (!manager.applyTalkgroupConfig(configs[i % 2], &changes)) {
+            failed++;
+            continue;
+        }
+        if (changes.enabled.size() != TALKGROUPS / 2 || changes.disabled.size() != TALKGROUPS / 2 ||
+            changes.priorities.size() != TALKGROUPS || !changes.alias_db) {
+            wrong_changes++;
+        }
+    }
+    done = true;
+    for (std::thread& thread : readers) {
+        thread.join();
+    }
+
+    check(failed == 0, "every reload applies");
+    check(wrong_changes == 0, "every reload reports the whole swap");
+
+    ReaderResult total;
+    for (const ReaderResult& result : results) {
+        total.lookups += result.lookups;
+        total.bad_priority += result.bad_priority;
+        total.bad_alias += result.bad_alias;
+        total.bad_radio += result.bad_radio;
+    }
+    check(total.lookups > 0, "readers ran during the reloads");
+    check(total.bad_priority == 0, "priorities come from one configuration");
+    check(total.bad_alias == 0, "talkgroup aliases come from one configuration");
+    check(total.bad_radio == 0, "radio aliases come from a mapped database");
+
+    // The last reload (an even count) left configuration A
+    const Setting& last = settings[RELOADS % 2];
+    check(manager.isTalkgroupEnabled(last.first_enabled) &&
+          !manager.isTalkgroupEnabled(settings[(RELOADS + 1) % 2].first_enabled),
+          "the last reload is the one in effect");
+    check(manager.getTalkgroupAlias(TALKGROUPS) == expectedAlias(last, TALKGROUPS),
+          "the last reload's aliases are in effect");
+
+    unlink(settings[0].alias_db.c_str());
+    unlink(settings[1].alias_db.c_str());
+
+    if (failures == 0) {
+        std::printf("talkgroup_reload_test: all tests passed\n");
+    }
+    return failures == 0 ? 0 : 1;
+}